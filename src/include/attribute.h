@@ -552,6 +552,7 @@ extern int set_max_job_sequence_id(attribute *pattr, void *pobj, int actmode);
 extern int set_cred_renew_enable(attribute *pattr, void *pobject, int actmode);
 extern int set_cred_renew_period(attribute *pattr, void *pobject, int actmode);
 extern int set_cred_renew_cache_period(attribute *pattr, void *pobject, int actmode);
+extern int set_job_save_delay(attribute *pattr, void *pobject, int actmode);
 
 
 /* Extern functions from sched_attr_def*/
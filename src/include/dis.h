@@ -221,10 +221,14 @@ typedef struct pbs_tcp_auth_data {
 	auth_def_t *def;
 } pbs_tcp_auth_data_t;
 
+/* request extension asking for the compact binary encoding on a connection */
+#define DIS_BINARY_EXTEND "dis_binary"
+
 typedef struct pbs_tcp_chan {
 	pbs_dis_buf_t readbuf;
 	pbs_dis_buf_t writebuf;
 	int is_old_client; /* This is just for backward compatibility */
+	int is_binary; /* compact binary integer encoding negotiated */
 	pbs_tcp_auth_data_t auths[2];
 } pbs_tcp_chan_t;
 
@@ -234,6 +238,8 @@ int disr_skip(int, size_t);
 int dis_getc(int);
 int dis_gets(int, char *, size_t);
 int dis_puts(int, const char *, size_t);
+size_t dis_write_mark(int);
+char *dis_write_copy(int, size_t, size_t *);
 int dis_flush(int);
 void dis_setup_chan(int, pbs_tcp_chan_t * (*)(int));
 void dis_destroy_chan(int);
@@ -244,6 +250,8 @@ void transport_chan_set_authctx(int, void *, int);
 void * transport_chan_get_authctx(int, int);
 void transport_chan_set_authdef(int, auth_def_t *, int);
 auth_def_t * transport_chan_get_authdef(int, int);
+void transport_chan_set_binary(int, int);
+int transport_chan_is_binary(int);
 int transport_send_pkt(int, int, void *, size_t);
 int transport_recv_pkt(int, int *, void **, size_t *);
 
@@ -281,6 +281,23 @@ typedef struct hook hook;
 
 #define	PBS_HOOK_CONFIG_FILE	"PBS_HOOK_CONFIG_FILE"
 
+/*
+ * Persistent hook interpreter of MoM, "pbs_python --hook-server".
+ * MoM talks to it over a SOCK_SEQPACKET socket on its stdin.  An event is
+ * one message: a hook_server_req followed by hr_nstr NUL terminated
+ * strings, the working directory, the PBS_HOOK_CONFIG_FILE value ("" for
+ * none) and the arguments of "pbs_python --hook".  The socket on which to
+ * return the wait status of the run comes along as SCM_RIGHTS.
+ */
+#define	HOOK_SERVER_MODE	"--hook-server"
+#define	HOOK_SERVER_VERSION	1
+#define	HOOK_SERVER_MSGMAX	(64 * 1024)
+
+struct hook_server_req {
+	int	hr_version;
+	int	hr_nstr;
+};
+
 /* default import statement printed out on a "print hook" request */
 #define PRINT_HOOK_IMPORT_CALL  "import hook %s application/x-python base64 -\n"
 #define PRINT_HOOK_IMPORT_CONFIG  "import hook %s application/x-config base64 -\n"
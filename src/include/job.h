@@ -92,6 +92,8 @@ struct depend {
 	short	  dp_released;	/* This job released to run (syncwith)   */
 	short	  dp_numrun;    /* num jobs supposed to run		 */
 	pbs_list_head dp_jobs;	/* list of related jobs  (all)           */
+	void	 *dp_idx;	/* index of dp_jobs by job id, if long   */
+	int	  dp_idxdups;	/* jobs left out of dp_idx as repeats    */
 };
 
 /*
@@ -105,6 +107,7 @@ struct depend_job {
 	long	dc_cost;	/* cost of this child (syncct)		 */
 	char	dc_child[PBS_MAXSVRJOBID+1]; /* child (dependent) job	 */
 	char	dc_svr[PBS_MAXSERVERNAME+1]; /* server owning job	 */
+	struct depend *dc_depend; /* dependency set holding this job	 */
 };
 
 /*
@@ -337,14 +340,18 @@ typedef struct	noderes {
  * specific structures for Job Array attributes
  */
 
-/* individual entries in array job index table */
+/*
+ * individual entries in array job index table, one per subjob, so kept
+ * packed: the substates recorded here (finished, failed, terminated) and
+ * the stageout status (-1, 0 or 1) fit in a char
+ */
 struct ajtrk {
-	char trk_status;		 /* status */
-	int trk_error;		 /* error code */
-	int trk_exitstat;	 /* if executed and exitstat set */
-	int trk_substate;	 /* sub state */
-	int trk_stgout;		 /* stageout status */
-	struct job *trk_psubjob; /* pointer to instantiated subjob */
+	struct job *trk_psubjob;   /* pointer to instantiated subjob */
+	int trk_error;		   /* error code */
+	char trk_status;	   /* status */
+	unsigned char trk_substate; /* sub state */
+	signed char trk_stgout;	   /* stageout status */
+	char trk_exitstat;	   /* if executed and exitstat set */
 };
 
 /* subjob index table */
@@ -456,6 +463,7 @@ struct job {
 	time_t ji_chkpttime;			    /* periodic checkpoint time */
 	time_t ji_chkptnext;			    /* next checkpoint time */
 	time_t ji_sampletim;			    /* last usage sample time, irix only */
+	char *ji_cgroup;			    /* cgroup v2 directory of the job, for usage */
 	time_t ji_polltime;			    /* last poll from mom superior */
 	time_t ji_actalarm;			    /* time of site callout alarm */
 	time_t ji_joinalarm;			    /* time of job's sister join job alarm, also, time obit sent, all */
@@ -511,6 +519,9 @@ struct job {
 	int ji_discarding;		   /* discarding job */
 	struct batch_request *ji_prunreq;  /* outstanding runjob request */
 	pbs_list_head ji_svrtask;	   /* links to svr work_task list */
+	pbs_list_link ji_dirtyjobs;	   /* links to jobs with a deferred save */
+	struct brp_cache *ji_statcache;	   /* encoded status records, see stat_job.c */
+	char *ji_packed;		   /* history job: packed attribute values, see svr_histjob_pack() */
 	struct pbs_queue *ji_qhdr;	   /* current queue header */
 	struct resc_resv *ji_myResv;	   /* !=0 job belongs to a reservation, see also, attribute JOB_ATR_myResv */
 
@@ -1077,6 +1088,9 @@ extern int job_save_fs(job *);
 
 extern job *job_recov_db(char *, job *pjob);
 extern int job_save_db(job *);
+extern void job_save_flush(void);
+extern void job_statcache_free(job *);
+extern void job_statcache_nofill(void);
 
 #define job_save  job_save_db
 #define job_recov job_recov_db
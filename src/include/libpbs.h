@@ -148,6 +148,14 @@ struct brp_status {
 	int brp_objtype;
 	char brp_objname[(PBS_MAXSVRJOBID > PBS_MAXDEST ? PBS_MAXSVRJOBID : PBS_MAXDEST) + 1];
 	pbs_list_head brp_attr; /* head of svrattrlist */
+	struct brp_cache *brp_cache; /* encoded brp_attr kept by the object, may be NULL */
+};
+
+/* wire encoding of a status object's attribute list, kept between replies */
+struct brp_cache {
+	int bc_key;	/* privilege and encoding the data was built for */
+	size_t bc_len;	/* length of bc_data */
+	char *bc_data;	/* NULL until filled by the next reply */
 };
 
 /* reply to Resource Query Request */
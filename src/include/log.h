@@ -70,6 +70,11 @@
  */
 #define LOG_BUF_SIZE 4352
 
+/* overflow policies of asynchronous logging, see log_async_start() */
+#define LOG_ASYNC_OFF	0	/* log synchronously */
+#define LOG_ASYNC_BLOCK	1	/* wait for room in the log buffer */
+#define LOG_ASYNC_DROP	2	/* drop records while the buffer is full */
+
 /* The following macro assist in sharing code between the Server and Mom */
 #define LOG_EVENT log_event
 
@@ -118,6 +123,7 @@ extern void log_suspect_file(const char *func, const char *text, const char *fil
 extern int  log_open(char *name, char *directory);
 extern int  log_open_main(char *name, char *directory, int silent);
 extern void log_record(int type, int objclass, int severity, const char *objname, const char *text);
+extern int  log_async_start(int policy);
 extern char log_buffer[LOG_BUF_SIZE];
 extern int log_level_2_etype(int level);
 
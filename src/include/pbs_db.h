@@ -298,6 +298,10 @@ typedef void (*query_cb_t)(pbs_db_obj_info_t *, int *);
 #define PBS_DB_CONTROL_START	"start"
 #define PBS_DB_CONTROL_STOP	"stop"
 
+/* how to end a transaction */
+#define PBS_DB_COMMIT	0
+#define PBS_DB_ROLLBACK	1
+
 /**
  * @brief
  *	Initialize a database connection handle
@@ -331,6 +335,34 @@ int pbs_db_connect(void **conn, char *host, int port, int timeout);
  */
 int pbs_db_disconnect(void *conn);
 
+/**
+ * @brief
+ *	Start a transaction. Transactions nest, only the outermost
+ *	begin/end pair reaches the database.
+ *
+ * @param[in]   conn - Connected database handle
+ *
+ * @return      int
+ * @retval      -1  - Failure
+ * @retval       0  - success
+ *
+ */
+int pbs_db_begin_trx(void *conn);
+
+/**
+ * @brief
+ *	End a transaction started by pbs_db_begin_trx
+ *
+ * @param[in]   conn - Connected database handle
+ * @param[in]   commit - PBS_DB_COMMIT or PBS_DB_ROLLBACK
+ *
+ * @return      int
+ * @retval      -1  - Failure
+ * @retval       0  - success
+ *
+ */
+int pbs_db_end_trx(void *conn, int commit);
+
 /**
  * @brief
  *	Insert a new object into the database
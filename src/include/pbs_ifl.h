@@ -330,6 +330,7 @@ extern "C" {
 #define ATTR_cred_renew_tool	"cred_renew_tool"
 #define ATTR_cred_renew_period	"cred_renew_period"
 #define ATTR_cred_renew_cache_period "cred_renew_cache_period"
+#define ATTR_job_save_delay "job_save_delay"
 #define ATTR_attr_update_period "attr_update_period"
 
 /**
@@ -252,9 +252,13 @@ struct pbs_config
 	char *pbs_comm_routers;		/* for this router, the optional list of other routers to talk to */
 	long  pbs_comm_log_events;      /* log_events for pbs_comm process, default 0 */
 	unsigned int pbs_comm_threads;	/* number of threads for router, default 4 */
+	unsigned int pbs_comm_mcast_fanout; /* routers a pbs_comm forwards a multicast to, default 16 */
 	char *pbs_mom_node_name;	/* mom short name used for natural node, default NULL */
 	char *pbs_lr_save_path;		/* path to store undo live recordings */
 	unsigned int pbs_log_highres_timestamp; /* high resolution logging */
+	unsigned int pbs_log_async;	/* asynchronous logging policy, LOG_ASYNC_* */
+	unsigned int pbs_acct_flush_interval; /* seconds between accounting flushes, 0 writes each record */
+	unsigned int pbs_acct_json;	/* also write accounting records as JSON lines */
 	unsigned int pbs_sched_threads;	/* number of threads for scheduler */
 	char *pbs_daemon_service_user; /* user the scheduler runs as */
 	char current_user[PBS_MAXUSER+1]; /* current running user */
@@ -294,6 +298,7 @@ extern struct pbs_config pbs_conf;
 #define PBS_CONF_COMM_NAME		     "PBS_COMM_NAME"
 #define PBS_CONF_COMM_ROUTERS		     "PBS_COMM_ROUTERS"
 #define PBS_CONF_COMM_THREADS		     "PBS_COMM_THREADS"
+#define PBS_CONF_COMM_MCAST_FANOUT	     "PBS_COMM_MCAST_FANOUT"
 #define PBS_CONF_COMM_LOG_EVENTS	     "PBS_COMM_LOG_EVENTS"
 #define PBS_CONF_HOME		"PBS_HOME"	 	 /* path to pbs home */
 #define PBS_CONF_EXEC		"PBS_EXEC"		 /* path to pbs exec */
@@ -322,6 +327,9 @@ extern struct pbs_config pbs_conf;
 #define PBS_CONF_MOM_NODE_NAME	"PBS_MOM_NODE_NAME"
 #define PBS_CONF_LR_SAVE_PATH	"PBS_LR_SAVE_PATH"
 #define PBS_CONF_LOG_HIGHRES_TIMESTAMP	"PBS_LOG_HIGHRES_TIMESTAMP"
+#define PBS_CONF_LOG_ASYNC	"PBS_LOG_ASYNC"
+#define PBS_CONF_ACCT_FLUSH_INTERVAL	"PBS_ACCT_FLUSH_INTERVAL"
+#define PBS_CONF_ACCT_JSON	"PBS_ACCT_JSON"
 #define PBS_CONF_SCHED_THREADS	"PBS_SCHED_THREADS"
 #define PBS_CONF_DAEMON_SERVICE_USER "PBS_DAEMON_SERVICE_USER"
 #ifdef WIN32
@@ -82,10 +82,29 @@ struct JsonNode {
 	} value;
 };
 
+/* a member of a JSON object, its key and value as JSON text */
+typedef struct JsonMember {
+	char *key;
+	char *value;
+} JsonMember;
+
+typedef struct JsonObject {
+	JsonMember *members;
+	int count;
+	int size;
+} JsonObject;
+
 JsonNode *add_json_node(JsonNodeType ntype, JsonValueType vtype, JsonEscapeType esc_type, char *key, void *value);
 char *strdup_escape(JsonEscapeType esc_type, const char *str);
 int generate_json(FILE *stream);
 void free_json_node_list();
+JsonObject *json_object_parse(const char *str, char *msg, size_t msg_len);
+int json_object_merge(JsonObject *dest, JsonObject *src);
+char *json_object_dump(JsonObject *obj);
+void json_object_free(JsonObject *obj);
+const char *json_object_get(JsonObject *obj, const char *name);
+char *json_string_decode(const char *text);
+char **json_array_parse(const char *str, char *msg, size_t msg_len);
 
 #ifdef	__cplusplus
 }
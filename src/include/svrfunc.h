@@ -202,6 +202,9 @@ extern int subjob_index_to_offset(job *, char *);
 #ifndef PBS_MOM
 extern void svr_setjob_histinfo(job *, histjob_type);
 extern void svr_histjob_update(job *, char, int);
+extern int svr_histjob_pack(job *);
+extern int svr_histjob_unpack(job *);
+extern int svr_histjob_borrow(job *);
 extern char *form_attr_comment(const char *, const char *);
 extern void complete_running(job *);
 extern void am_jobs_add(job *);
@@ -114,6 +114,7 @@ struct tpp_config {
 	int    node_type; /* leaf, proxy */
 	char   **routers; /* other proxy names (and backups) to connect to */
 	int    numthreads;
+	int    mcast_fanout; /* routers a multicast is forwarded to, less than 2 for all */
 	char   *node_name; /* list of comma separated node names */
 	int    compress;
 	int    tcp_keepalive; /* use keepalive? */
@@ -136,6 +137,8 @@ extern void DIS_tpp_funcs();
 extern int tpp_open(char *, unsigned int);
 extern int tpp_close(int);
 extern int tpp_eom(int);
+extern int tpp_send(int, void *, int);
+extern int tpp_recv(int, void *, int);
 extern int tpp_bind(unsigned int);
 extern int tpp_poll(void);
 extern void tpp_terminate(void);
@@ -147,6 +150,16 @@ extern char *tpp_parse_hostname(char *, int *);
 extern int tpp_init_router(struct tpp_config *);
 extern void tpp_router_shutdown(void);
 
+/* counters of one of the TPP object pools */
+struct tpp_pool_stats {
+	char *name;
+	unsigned long hits;	/* allocations served from the pool */
+	unsigned long misses;	/* allocations that had to malloc a batch */
+	unsigned long released;	/* objects released with free() */
+	int depot;		/* objects held in the shared depot */
+};
+extern int tpp_get_pool_stats(struct tpp_pool_stats *, int);
+
 /* special tpp only multicast function prototypes */
 extern int tpp_mcast_open(void);
 extern int tpp_mcast_add_strm(int, int);
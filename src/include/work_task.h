@@ -88,12 +88,15 @@ struct work_task  {
 	void		*wt_parm3;	/* used to store reply for deferred cmds TPP */
 	int		 wt_aux;	/* optional info: e.g. child status */
 	int		 wt_aux2;	/* optional info 2: e.g. *real* child pid (windows), tpp msgid etc */
+	int		 wt_heapidx;	/* slot in the timed task heap, -1 if not there */
+	int		 wt_indexed;	/* set if task is in the parm1 index */
 };
 
 extern struct work_task *set_task(enum work_type, long event, void (*func)(), void *param);
 extern void clear_task(struct work_task *ptask);
 extern void dispatch_task(struct work_task *);
 extern void delete_task(struct work_task *);
+extern void set_task_time(struct work_task *ptask, long when);
 extern void delete_task_by_parm1_func(void *parm1, void (*func)(struct work_task *), enum wtask_delete_option option);
 extern int  has_task_by_parm1(void *parm1);
 extern time_t default_next_task(void);
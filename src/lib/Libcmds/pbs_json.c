@@ -39,6 +39,8 @@
 
 #include <stdlib.h>
 #include <ctype.h>
+#include <math.h>
+#include <stddef.h>
 #include "pbs_json.h"
 #include "libutil.h"
 #define ARRAY_NESTING_LEVEL 500 /* describes the nesting level of a JSON array*/
@@ -464,3 +466,992 @@ generate_json(FILE * stream) {
 	fprintf(stream, "\n}\n");
 	return 0;
 }
+
+/*
+ * JSON objects, as in the values of string resources set by hooks, parsed
+ * to be merged and written back, or in the configuration files of hooks
+ * read by MoM.  Each member keeps its key and value as JSON text in the
+ * form json.dumps() writes it, so that merging is done on the keys and the
+ * result reads the same as from the Python json module.  A value is looked
+ * at by parsing its text again, with json_object_parse(), json_array_parse()
+ * or json_string_decode().
+ */
+
+#define JSON_MAX_DEPTH ARRAY_NESTING_LEVEL /* deepest nesting of values parsed */
+
+typedef struct JsonParser {
+	const char *start;	/* text being parsed */
+	const char *p;		/* next character */
+	const char *err;	/* what went wrong */
+	int depth;		/* nesting level of the current value */
+} JsonParser;
+
+typedef struct JsonBuf {
+	char *buf;
+	size_t len;
+	size_t size;
+} JsonBuf;
+
+static JsonObject *json_parse_object(JsonParser *ps);
+
+/**
+ * @brief
+ *	Append 'len' bytes of 'str' to a JSON text buffer.
+ *
+ * @param[in,out] jb - buffer
+ * @param[in] str - bytes to append
+ * @param[in] len - number of bytes
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	out of memory
+ */
+static int
+json_buf_add(JsonBuf *jb, const char *str, size_t len)
+{
+	char *tmp;
+	size_t size;
+
+	if (jb->len + len + 1 > jb->size) {
+		size = (jb->size == 0) ? 64 : jb->size;
+		while (jb->len + len + 1 > size)
+			size *= 2;
+		if ((tmp = realloc(jb->buf, size)) == NULL)
+			return -1;
+		jb->buf = tmp;
+		jb->size = size;
+	}
+	memcpy(jb->buf + jb->len, str, len);
+	jb->len += len;
+	jb->buf[jb->len] = '\0';
+	return 0;
+}
+
+/**
+ * @brief
+ *	Append a code point to a JSON string, escaped as json.dumps() does,
+ *	i.e. anything outside of printable ASCII as \\uXXXX.
+ *
+ * @param[in,out] jb - buffer
+ * @param[in] cp - Unicode code point
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	out of memory
+ */
+static int
+json_buf_add_cp(JsonBuf *jb, unsigned long cp)
+{
+	char esc[32];
+	char c;
+
+	switch (cp) {
+		case '"':  return json_buf_add(jb, "\\\"", 2);
+		case '\\': return json_buf_add(jb, "\\\\", 2);
+		case '\n': return json_buf_add(jb, "\\n", 2);
+		case '\r': return json_buf_add(jb, "\\r", 2);
+		case '\t': return json_buf_add(jb, "\\t", 2);
+		case '\b': return json_buf_add(jb, "\\b", 2);
+		case '\f': return json_buf_add(jb, "\\f", 2);
+	}
+	if (cp >= 0x20 && cp <= 0x7e) {
+		c = (char) cp;
+		return json_buf_add(jb, &c, 1);
+	}
+	if (cp < 0x10000)
+		snprintf(esc, sizeof(esc), "\\u%04lx", cp);
+	else {
+		cp -= 0x10000;
+		snprintf(esc, sizeof(esc), "\\u%04lx\\u%04lx",
+			0xd800 | (cp >> 10), 0xdc00 | (cp & 0x3ff));
+	}
+	return json_buf_add(jb, esc, strlen(esc));
+}
+
+/**
+ * @brief
+ *	Skip the white space allowed between JSON tokens.
+ *
+ * @param[in,out] ps - parser
+ */
+static void
+json_skip_ws(JsonParser *ps)
+{
+	while (*ps->p == ' ' || *ps->p == '\t' || *ps->p == '\n' || *ps->p == '\r')
+		ps->p++;
+}
+
+/**
+ * @brief
+ *	Read the 4 hex digits of a \\u escape.
+ *
+ * @param[in] s - the digits
+ *
+ * @return	long
+ * @retval	the value
+ * @retval	-1	not 4 hex digits
+ */
+static long
+json_hex4(const char *s)
+{
+	long v = 0;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		if (!isxdigit((unsigned char) s[i]))
+			return -1;
+		v = (v << 4) | (isdigit((unsigned char) s[i]) ? s[i] - '0' : (tolower((unsigned char) s[i]) - 'a' + 10));
+	}
+	return v;
+}
+
+/**
+ * @brief
+ *	Decode the UTF-8 sequence at 's', which must be valid as Python
+ *	would not take it otherwise.
+ *
+ * @param[in] s - first byte, not ASCII
+ * @param[out] pcp - code point
+ *
+ * @return	int
+ * @retval	length of the sequence
+ * @retval	0	invalid UTF-8
+ */
+static int
+json_utf8(const unsigned char *s, unsigned long *pcp)
+{
+	unsigned long cp;
+	int n;
+	int i;
+
+	if (s[0] >= 0xc2 && s[0] <= 0xdf) {
+		n = 2;
+		cp = s[0] & 0x1f;
+	} else if (s[0] >= 0xe0 && s[0] <= 0xef) {
+		n = 3;
+		cp = s[0] & 0x0f;
+	} else if (s[0] >= 0xf0 && s[0] <= 0xf4) {
+		n = 4;
+		cp = s[0] & 0x07;
+	} else
+		return 0;
+	for (i = 1; i < n; i++) {
+		if ((s[i] & 0xc0) != 0x80)
+			return 0;
+		cp = (cp << 6) | (s[i] & 0x3f);
+	}
+	/* no overlong forms, surrogates or code points past U+10FFFF */
+	if ((n == 3 && cp < 0x800) || (n == 4 && cp < 0x10000) ||
+		(cp >= 0xd800 && cp <= 0xdfff) || cp > 0x10ffff)
+		return 0;
+	*pcp = cp;
+	return n;
+}
+
+/**
+ * @brief
+ *	Parse a JSON string and append it to 'out' as json.dumps() writes it.
+ *
+ * @param[in,out] ps - parser, at the opening quote
+ * @param[in,out] out - buffer
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	error, ps->err set
+ */
+static int
+json_parse_string(JsonParser *ps, JsonBuf *out)
+{
+	const unsigned char *s = (const unsigned char *) ps->p + 1;
+	unsigned long cp;
+	long lo;
+	int n;
+
+	if (json_buf_add(out, "\"", 1) != 0)
+		goto nomem;
+	for (;;) {
+		if (*s == '"')
+			break;
+		if (*s == '\0') {
+			ps->err = "unterminated string";
+			return -1;
+		}
+		if (*s < 0x20) {
+			ps->err = "invalid control character in string";
+			return -1;
+		}
+		if (*s == '\\') {
+			s++;
+			switch (*s) {
+				case '"':  cp = '"'; break;
+				case '\\': cp = '\\'; break;
+				case '/':  cp = '/'; break;
+				case 'b':  cp = '\b'; break;
+				case 'f':  cp = '\f'; break;
+				case 'n':  cp = '\n'; break;
+				case 'r':  cp = '\r'; break;
+				case 't':  cp = '\t'; break;
+				case 'u':
+					if ((lo = json_hex4((const char *) s + 1)) == -1) {
+						ps->err = "invalid \\uXXXX escape";
+						return -1;
+					}
+					cp = lo;
+					s += 4;
+					/* a surrogate pair is one code point, a lone surrogate stays as is */
+					if (cp >= 0xd800 && cp <= 0xdbff && s[1] == '\\' && s[2] == 'u' &&
+						(lo = json_hex4((const char *) s + 3)) >= 0xdc00 && lo <= 0xdfff) {
+						cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+						s += 6;
+					}
+					break;
+				default:
+					ps->err = "invalid escape";
+					return -1;
+			}
+			s++;
+		} else if (*s < 0x80)
+			cp = *s++;
+		else if ((n = json_utf8(s, &cp)) == 0) {
+			ps->err = "invalid UTF-8";
+			return -1;
+		} else
+			s += n;
+		if (json_buf_add_cp(out, cp) != 0)
+			goto nomem;
+	}
+	ps->p = (const char *) s + 1;
+	if (json_buf_add(out, "\"", 1) != 0)
+		goto nomem;
+	return 0;
+
+nomem:
+	ps->err = "out of memory";
+	return -1;
+}
+
+/**
+ * @brief
+ *	Write a double the way Python's repr() does, as used by json.dumps():
+ *	the shortest digits that read back the same, in fixed notation for
+ *	exponents from -4 to 15 and with at least one decimal.
+ *
+ * @param[in] d - the number
+ * @param[out] buf - output buffer
+ * @param[in] len - size of 'buf', at least 32
+ */
+static void
+json_float_repr(double d, char *buf, size_t len)
+{
+	char tmp[32];
+	char digits[20];
+	char *p;
+	char *e;
+	int ndigits = 0;
+	int exp;
+	int prec;
+	int i;
+	size_t n = 0;
+
+	if (isnan(d)) {
+		snprintf(buf, len, "NaN");
+		return;
+	}
+	if (isinf(d)) {
+		snprintf(buf, len, "%sInfinity", (d < 0) ? "-" : "");
+		return;
+	}
+	for (prec = 1; prec < 17; prec++) {
+		snprintf(tmp, sizeof(tmp), "%.*e", prec - 1, d);
+		if (strtod(tmp, NULL) == d)
+			break;
+	}
+	if (prec == 17)
+		snprintf(tmp, sizeof(tmp), "%.16e", d);
+
+	/* split "-d.ddde+XX" into its sign, digits and exponent */
+	p = tmp;
+	if (*p == '-')
+		buf[n++] = *p++;
+	e = strchr(p, 'e');
+	exp = atoi(e + 1);
+	for (; p < e; p++) {
+		if (isdigit((unsigned char) *p))
+			digits[ndigits++] = *p;
+	}
+	while (ndigits > 1 && digits[ndigits - 1] == '0')
+		ndigits--;
+
+	if (exp >= 16 || exp < -4) {
+		buf[n++] = digits[0];
+		if (ndigits > 1) {
+			buf[n++] = '.';
+			for (i = 1; i < ndigits; i++)
+				buf[n++] = digits[i];
+		}
+		snprintf(buf + n, len - n, "e%+03d", exp);
+		return;
+	}
+	if (exp < 0) {
+		buf[n++] = '0';
+		buf[n++] = '.';
+		for (i = exp; i < -1; i++)
+			buf[n++] = '0';
+		for (i = 0; i < ndigits; i++)
+			buf[n++] = digits[i];
+	} else {
+		for (i = 0; i <= exp; i++)
+			buf[n++] = (i < ndigits) ? digits[i] : '0';
+		buf[n++] = '.';
+		if (ndigits > exp + 1) {
+			for (i = exp + 1; i < ndigits; i++)
+				buf[n++] = digits[i];
+		} else
+			buf[n++] = '0';
+	}
+	buf[n] = '\0';
+}
+
+/**
+ * @brief
+ *	Write a number in plain decimal notation the way Python's repr() does,
+ *	without going through a double, when it can be done: with at most 15
+ *	significant digits (DBL_DIG) the digits are the shortest that read back
+ *	the same, so it is only a matter of dropping the trailing zeros.
+ *
+ * @param[in] num - the number, "-?int.frac" as checked by the parser
+ * @param[in] len - length of 'num'
+ * @param[out] buf - output buffer of at least 32 bytes
+ *
+ * @return	int
+ * @retval	1	written to 'buf'
+ * @retval	0	use json_float_repr()
+ */
+static int
+json_float_fast(const char *num, size_t len, char *buf)
+{
+	const char *dot = memchr(num, '.', len);
+	const char *end = num + len;
+	const char *p;
+	int sig = 0;
+	int lead = 0;
+
+	if (dot == NULL || memchr(num, 'e', len) != NULL || memchr(num, 'E', len) != NULL)
+		return 0;
+	p = (*num == '-') ? num + 1 : num;
+	if (dot - p > 16)
+		return 0;
+	while (end > dot + 2 && end[-1] == '0')
+		end--;
+	if (*p == '0') {
+		/* below 1, as 1e-05 from an exponent under -4 */
+		for (p = dot + 1; p < end && *p == '0'; p++)
+			lead++;
+		if (p == end)
+			lead = 0;	/* zero itself */
+		else if (lead > 3)
+			return 0;
+		sig = end - p;
+	} else
+		sig = (dot - p) + (end - dot - 1);
+	if (sig > 15)
+		return 0;
+	memcpy(buf, num, end - num);
+	buf[end - num] = '\0';
+	return 1;
+}
+
+/**
+ * @brief
+ *	Parse a JSON number and append it to 'out' as json.dumps() writes it.
+ *	Integers keep their digits, whatever their size, like Python ints.
+ *
+ * @param[in,out] ps - parser, at the number
+ * @param[in,out] out - buffer
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	error, ps->err set
+ */
+static int
+json_parse_number(JsonParser *ps, JsonBuf *out)
+{
+	const char *s = ps->p;
+	const char *start = s;
+	char fbuf[32];
+	char *num;
+	int isfloat = 0;
+	int rc;
+
+	if (*s == '-')
+		s++;
+	if (*s == '0')
+		s++;
+	else if (*s >= '1' && *s <= '9') {
+		while (isdigit((unsigned char) *s))
+			s++;
+	} else {
+		ps->err = "expecting value";
+		return -1;
+	}
+	/* as Python, stop at what does not make a number, it is then extra data */
+	if (*s == '.' && isdigit((unsigned char) s[1])) {
+		isfloat = 1;
+		for (s++; isdigit((unsigned char) *s); s++)
+			;
+	}
+	if ((*s == 'e' || *s == 'E') &&
+		(isdigit((unsigned char) s[1]) ||
+		((s[1] == '+' || s[1] == '-') && isdigit((unsigned char) s[2])))) {
+		isfloat = 1;
+		for (s += 2; isdigit((unsigned char) *s); s++)
+			;
+	}
+	ps->p = s;
+
+	if (!isfloat) {
+		if (s - start == 2 && start[0] == '-' && start[1] == '0')
+			start++;
+		rc = json_buf_add(out, start, s - start);
+	} else if (s - start < (ptrdiff_t) sizeof(fbuf) && json_float_fast(start, s - start, fbuf))
+		rc = json_buf_add(out, fbuf, strlen(fbuf));
+	else {
+		if ((num = malloc(s - start + 1)) == NULL) {
+			ps->err = "out of memory";
+			return -1;
+		}
+		memcpy(num, start, s - start);
+		num[s - start] = '\0';
+		json_float_repr(strtod(num, NULL), fbuf, sizeof(fbuf));
+		free(num);
+		rc = json_buf_add(out, fbuf, strlen(fbuf));
+	}
+	if (rc != 0) {
+		ps->err = "out of memory";
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Parse a JSON value and append it to 'out' as json.dumps() writes it.
+ *
+ * @param[in,out] ps - parser, at the value
+ * @param[in,out] out - buffer
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	error, ps->err set
+ */
+static int
+json_parse_value(JsonParser *ps, JsonBuf *out)
+{
+	static const char *literals[] = {"true", "false", "null", "NaN", "Infinity", "-Infinity", NULL};
+	JsonObject *obj;
+	char *text;
+	int i;
+	int rc;
+
+	switch (*ps->p) {
+		case '"':
+			return json_parse_string(ps, out);
+
+		case '{':
+			if ((obj = json_parse_object(ps)) == NULL)
+				return -1;
+			text = json_object_dump(obj);
+			json_object_free(obj);
+			if (text == NULL || json_buf_add(out, text, strlen(text)) != 0) {
+				free(text);
+				ps->err = "out of memory";
+				return -1;
+			}
+			free(text);
+			return 0;
+
+		case '[':
+			if (++ps->depth > JSON_MAX_DEPTH) {
+				ps->err = "nested too deep";
+				return -1;
+			}
+			ps->p++;
+			json_skip_ws(ps);
+			if (json_buf_add(out, "[", 1) != 0)
+				goto nomem;
+			if (*ps->p != ']') {
+				for (;;) {
+					if (json_parse_value(ps, out) != 0)
+						return -1;
+					json_skip_ws(ps);
+					if (*ps->p == ']')
+						break;
+					if (*ps->p != ',') {
+						ps->err = "expecting ',' delimiter";
+						return -1;
+					}
+					ps->p++;
+					json_skip_ws(ps);
+					if (json_buf_add(out, ", ", 2) != 0)
+						goto nomem;
+				}
+			}
+			ps->p++;
+			ps->depth--;
+			if (json_buf_add(out, "]", 1) != 0)
+				goto nomem;
+			return 0;
+	}
+
+	for (i = 0; literals[i] != NULL; i++) {
+		if (strncmp(ps->p, literals[i], strlen(literals[i])) == 0) {
+			ps->p += strlen(literals[i]);
+			rc = json_buf_add(out, literals[i], strlen(literals[i]));
+			if (rc != 0)
+				goto nomem;
+			return 0;
+		}
+	}
+	return json_parse_number(ps, out);
+
+nomem:
+	ps->err = "out of memory";
+	return -1;
+}
+
+/**
+ * @brief
+ *	Set a member of a JSON object, replacing the value of an existing key
+ *	in place as a Python dict does.  Takes over 'key' and 'value'.
+ *
+ * @param[in,out] obj - object
+ * @param[in] key - JSON text of the key
+ * @param[in] value - JSON text of the value
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	out of memory, 'key' and 'value' freed
+ */
+static int
+json_object_set(JsonObject *obj, char *key, char *value)
+{
+	JsonMember *tmp;
+	int i;
+
+	for (i = 0; i < obj->count; i++) {
+		if (strcmp(obj->members[i].key, key) == 0) {
+			free(key);
+			free(obj->members[i].value);
+			obj->members[i].value = value;
+			return 0;
+		}
+	}
+	if (obj->count == obj->size) {
+		tmp = realloc(obj->members, (obj->size + 8) * sizeof(JsonMember));
+		if (tmp == NULL) {
+			free(key);
+			free(value);
+			return -1;
+		}
+		obj->members = tmp;
+		obj->size += 8;
+	}
+	obj->members[obj->count].key = key;
+	obj->members[obj->count].value = value;
+	obj->count++;
+	return 0;
+}
+
+/**
+ * @brief
+ *	Parse a JSON object.
+ *
+ * @param[in,out] ps - parser, at the opening brace
+ *
+ * @return	JsonObject *
+ * @retval	the object, to be freed with json_object_free()
+ * @retval	NULL	error, ps->err set
+ */
+static JsonObject *
+json_parse_object(JsonParser *ps)
+{
+	JsonObject *obj;
+	JsonBuf key = {0};
+	JsonBuf value = {0};
+
+	if (++ps->depth > JSON_MAX_DEPTH) {
+		ps->err = "nested too deep";
+		return NULL;
+	}
+	if ((obj = calloc(1, sizeof(JsonObject))) == NULL) {
+		ps->err = "out of memory";
+		return NULL;
+	}
+	ps->p++;
+	json_skip_ws(ps);
+	if (*ps->p == '}') {
+		ps->p++;
+		ps->depth--;
+		return obj;
+	}
+	for (;;) {
+		if (*ps->p != '"') {
+			ps->err = "expecting property name enclosed in double quotes";
+			goto err;
+		}
+		if (json_parse_string(ps, &key) != 0)
+			goto err;
+		json_skip_ws(ps);
+		if (*ps->p != ':') {
+			ps->err = "expecting ':' delimiter";
+			goto err;
+		}
+		ps->p++;
+		json_skip_ws(ps);
+		if (json_parse_value(ps, &value) != 0)
+			goto err;
+		if (json_object_set(obj, key.buf, value.buf) != 0) {
+			key.buf = value.buf = NULL;
+			ps->err = "out of memory";
+			goto err;
+		}
+		memset(&key, 0, sizeof(key));
+		memset(&value, 0, sizeof(value));
+		json_skip_ws(ps);
+		if (*ps->p == '}')
+			break;
+		if (*ps->p != ',') {
+			ps->err = "expecting ',' delimiter";
+			goto err;
+		}
+		ps->p++;
+		json_skip_ws(ps);
+	}
+	ps->p++;
+	ps->depth--;
+	return obj;
+
+err:
+	free(key.buf);
+	free(value.buf);
+	json_object_free(obj);
+	return NULL;
+}
+
+/**
+ * @brief
+ *	Parse a string holding a JSON object, as json.loads() would.
+ *
+ * @param[in] str - JSON text
+ * @param[out] msg - error message buffer, may be NULL
+ * @param[in] msg_len - size of 'msg'
+ *
+ * @return	JsonObject *
+ * @retval	the object, to be freed with json_object_free()
+ * @retval	NULL	not JSON or not an object, 'msg' filled
+ */
+JsonObject *
+json_object_parse(const char *str, char *msg, size_t msg_len)
+{
+	JsonParser ps = {0};
+	JsonObject *obj = NULL;
+
+	if (msg != NULL && msg_len > 0)
+		msg[0] = '\0';
+	if (str == NULL)
+		return NULL;
+
+	ps.start = ps.p = str;
+	json_skip_ws(&ps);
+	if (*ps.p != '{')
+		ps.err = "value is not a dictionary";
+	else if ((obj = json_parse_object(&ps)) != NULL) {
+		json_skip_ws(&ps);
+		if (*ps.p != '\0') {
+			ps.err = "extra data";
+			json_object_free(obj);
+			obj = NULL;
+		}
+	}
+	if (obj == NULL && msg != NULL && msg_len > 0)
+		snprintf(msg, msg_len, "%s at char %ld", ps.err, (long) (ps.p - ps.start));
+	return obj;
+}
+
+/**
+ * @brief
+ *	Merge the members of 'src' into 'dest', those of 'src' winning on the
+ *	same key, as dict.update().
+ *
+ * @param[in,out] dest - object merged into
+ * @param[in] src - object merged
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	out of memory
+ */
+int
+json_object_merge(JsonObject *dest, JsonObject *src)
+{
+	char *key;
+	char *value;
+	int i;
+
+	for (i = 0; i < src->count; i++) {
+		key = strdup(src->members[i].key);
+		value = strdup(src->members[i].value);
+		if (key == NULL || value == NULL) {
+			free(key);
+			free(value);
+			return -1;
+		}
+		if (json_object_set(dest, key, value) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Write a JSON object as json.dumps() does.
+ *
+ * @param[in] obj - object
+ *
+ * @return	char *
+ * @retval	malloc-ed JSON text
+ * @retval	NULL	out of memory
+ */
+char *
+json_object_dump(JsonObject *obj)
+{
+	JsonBuf out = {0};
+	int i;
+	int rc;
+
+	rc = json_buf_add(&out, "{", 1);
+	for (i = 0; rc == 0 && i < obj->count; i++) {
+		if (i > 0)
+			rc = json_buf_add(&out, ", ", 2);
+		if (rc == 0)
+			rc = json_buf_add(&out, obj->members[i].key, strlen(obj->members[i].key));
+		if (rc == 0)
+			rc = json_buf_add(&out, ": ", 2);
+		if (rc == 0)
+			rc = json_buf_add(&out, obj->members[i].value, strlen(obj->members[i].value));
+	}
+	if (rc == 0)
+		rc = json_buf_add(&out, "}", 1);
+	if (rc != 0) {
+		free(out.buf);
+		return NULL;
+	}
+	return out.buf;
+}
+
+/**
+ * @brief
+ *	Free a JSON object.
+ *
+ * @param[in] obj - object, may be NULL
+ */
+void
+json_object_free(JsonObject *obj)
+{
+	int i;
+
+	if (obj == NULL)
+		return;
+	for (i = 0; i < obj->count; i++) {
+		free(obj->members[i].key);
+		free(obj->members[i].value);
+	}
+	free(obj->members);
+	free(obj);
+}
+
+/**
+ * @brief
+ *	Find the value of a member of a JSON object.
+ *
+ * @param[in] obj - object, may be NULL
+ * @param[in] name - member name, in printable ASCII without quotes or
+ *		     backslashes, as such names need no escaping
+ *
+ * @return	const char *
+ * @retval	JSON text of the value, owned by 'obj'
+ * @retval	NULL	no such member
+ */
+const char *
+json_object_get(JsonObject *obj, const char *name)
+{
+	size_t len = strlen(name);
+	char *key;
+	int i;
+
+	if (obj == NULL)
+		return NULL;
+	for (i = 0; i < obj->count; i++) {
+		key = obj->members[i].key;
+		if (key[0] == '"' && strncmp(key + 1, name, len) == 0 &&
+			key[len + 1] == '"' && key[len + 2] == '\0')
+			return obj->members[i].value;
+	}
+	return NULL;
+}
+
+/**
+ * @brief
+ *	Decode a JSON string value, as found in a parsed object, to UTF-8.
+ *
+ * @param[in] text - JSON text of the value, may be NULL
+ *
+ * @return	char *
+ * @retval	malloc-ed string
+ * @retval	NULL	not a string or out of memory
+ */
+char *
+json_string_decode(const char *text)
+{
+	JsonBuf out = {0};
+	const char *s;
+	unsigned long cp;
+	long lo;
+	char utf[4];
+	int n;
+
+	if (text == NULL || *text != '"' || json_buf_add(&out, "", 0) != 0)
+		return NULL;
+	for (s = text + 1; *s != '"'; s++) {
+		if (*s == '\0')
+			goto err;
+		if (*s != '\\') {
+			if (json_buf_add(&out, s, 1) != 0)
+				goto err;
+			continue;
+		}
+		switch (*++s) {
+			case 'b':  cp = '\b'; break;
+			case 'f':  cp = '\f'; break;
+			case 'n':  cp = '\n'; break;
+			case 'r':  cp = '\r'; break;
+			case 't':  cp = '\t'; break;
+			case 'u':
+				if ((lo = json_hex4(s + 1)) == -1)
+					goto err;
+				cp = lo;
+				s += 4;
+				if (cp >= 0xd800 && cp <= 0xdbff && s[1] == '\\' && s[2] == 'u' &&
+					(lo = json_hex4(s + 3)) >= 0xdc00 && lo <= 0xdfff) {
+					cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+					s += 6;
+				}
+				break;
+			case '\0':
+				goto err;
+			default:
+				cp = (unsigned char) *s;
+				break;
+		}
+		if (cp < 0x80) {
+			utf[0] = (char) cp;
+			n = 1;
+		} else if (cp < 0x800) {
+			utf[0] = (char) (0xc0 | (cp >> 6));
+			utf[1] = (char) (0x80 | (cp & 0x3f));
+			n = 2;
+		} else if (cp < 0x10000) {
+			utf[0] = (char) (0xe0 | (cp >> 12));
+			utf[1] = (char) (0x80 | ((cp >> 6) & 0x3f));
+			utf[2] = (char) (0x80 | (cp & 0x3f));
+			n = 3;
+		} else {
+			utf[0] = (char) (0xf0 | (cp >> 18));
+			utf[1] = (char) (0x80 | ((cp >> 12) & 0x3f));
+			utf[2] = (char) (0x80 | ((cp >> 6) & 0x3f));
+			utf[3] = (char) (0x80 | (cp & 0x3f));
+			n = 4;
+		}
+		if (json_buf_add(&out, utf, n) != 0)
+			goto err;
+	}
+	return out.buf;
+
+err:
+	free(out.buf);
+	return NULL;
+}
+
+/**
+ * @brief
+ *	Parse a string holding a JSON array, as json.loads() would.
+ *
+ * @param[in] str - JSON text
+ * @param[out] msg - error message buffer, may be NULL
+ * @param[in] msg_len - size of 'msg'
+ *
+ * @return	char **
+ * @retval	the JSON text of each element, NULL terminated, to be freed
+ *		with free_string_array()
+ * @retval	NULL	not JSON or not an array, 'msg' filled
+ */
+char **
+json_array_parse(const char *str, char *msg, size_t msg_len)
+{
+	JsonParser ps = {0};
+	JsonBuf value = {0};
+	char **arr;
+	char **tmp;
+	int n = 0;
+
+	if (msg != NULL && msg_len > 0)
+		msg[0] = '\0';
+	if (str == NULL)
+		return NULL;
+	if ((arr = calloc(1, sizeof(char *))) == NULL)
+		return NULL;
+
+	ps.start = ps.p = str;
+	json_skip_ws(&ps);
+	if (*ps.p != '[') {
+		ps.err = "value is not a list";
+		goto err;
+	}
+	ps.depth++;
+	ps.p++;
+	json_skip_ws(&ps);
+	while (*ps.p != ']') {
+		if (n > 0) {
+			if (*ps.p != ',') {
+				ps.err = "expecting ',' delimiter";
+				goto err;
+			}
+			ps.p++;
+			json_skip_ws(&ps);
+		}
+		if (json_parse_value(&ps, &value) != 0)
+			goto err;
+		if ((tmp = realloc(arr, (n + 2) * sizeof(char *))) == NULL) {
+			ps.err = "out of memory";
+			goto err;
+		}
+		arr = tmp;
+		arr[n++] = value.buf;
+		arr[n] = NULL;
+		memset(&value, 0, sizeof(value));
+		json_skip_ws(&ps);
+	}
+	ps.p++;
+	json_skip_ws(&ps);
+	if (*ps.p != '\0') {
+		ps.err = "extra data";
+		goto err;
+	}
+	return arr;
+
+err:
+	free(value.buf);
+	free_string_array(arr);
+	if (msg != NULL && msg_len > 0)
+		snprintf(msg, msg_len, "%s at char %ld", ps.err, (long) (ps.p - ps.start));
+	return NULL;
+}
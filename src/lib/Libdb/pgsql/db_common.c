@@ -170,10 +170,15 @@ db_initialize_state(void *conn, query_cb_t query_cb)
 	db_query_state_t *state = malloc(sizeof(db_query_state_t));
 	if (!state)
 		return NULL;
+	state->conn = conn;
 	state->count = -1;
 	state->res = NULL;
 	state->row = -1;
 	state->query_cb = query_cb;
+	state->cursor = NULL;
+	state->batch = NULL;
+	state->prefetch = NULL;
+	state->batch_free = NULL;
 	return state;
 }
 
@@ -191,9 +196,18 @@ static void
 db_destroy_state(void *st)
 {
 	db_query_state_t *state = st;
+	char sql[MAX_SQL_LENGTH];
+
 	if (state) {
+		if (state->batch_free)
+			state->batch_free(state);
 		if (state->res)
 			PQclear(state->res);
+		if (state->cursor) {
+			snprintf(sql, sizeof(sql), "close %s", state->cursor);
+			db_execute_str(state->conn, sql);
+			pbs_db_end_trx(state->conn, PBS_DB_COMMIT);
+		}
 		free(state);
 	}
 }
@@ -270,6 +284,12 @@ db_cursor_next(void *conn, void *st, pbs_db_obj_info_t *obj)
 	db_query_state_t *state = (db_query_state_t *)st;
 	int ret;
 
+	/* a full batch from a cursor means there may be more rows */
+	if (state->cursor && state->row >= state->count && state->count == PBS_DB_FETCH_SIZE) {
+		if (db_cursor_fetch(conn, state) != 0)
+			return -1;
+	}
+
 	if (state->row < state->count) {
 		ret = db_fn_arr[obj->pbs_db_obj_type].pbs_db_next_obj(conn, st, obj);
 		state->row++;
@@ -387,6 +407,48 @@ db_execute_str(void *conn, char *sql)
 	return 0;
 }
 
+/**
+ * @brief
+ *	Fetch the next batch of rows from the server side cursor of a query state.
+ *	The previous batch is released.
+ *
+ * @param[in]	conn - Connected database handle
+ * @param[in]	state - The query state, with cursor set
+ *
+ * @return      Error code
+ * @retval	-1  - Error
+ * @retval       0  - success
+ *
+ */
+int
+db_cursor_fetch(void *conn, db_query_state_t *state)
+{
+	char sql[MAX_SQL_LENGTH];
+
+	if (state->batch_free)
+		state->batch_free(state);
+	if (state->res)
+		PQclear(state->res);
+	state->count = 0;
+	state->row = 0;
+
+	snprintf(sql, sizeof(sql), "fetch %d from %s", PBS_DB_FETCH_SIZE, state->cursor);
+	state->res = PQexecParams((PGconn *)conn, sql, 0, NULL, NULL, NULL, NULL, 1);
+	if (PQresultStatus(state->res) != PGRES_TUPLES_OK) {
+		char *sql_error = PQresultErrorField(state->res, PG_DIAG_SQLSTATE);
+		db_set_error(conn, &errmsg_cache, "Fetch from cursor", sql, sql_error);
+		PQclear(state->res);
+		state->res = NULL;
+		return -1;
+	}
+	state->count = PQntuples(state->res);
+
+	if (state->count > 0 && state->prefetch && state->prefetch(state) != 0)
+		return -1;
+
+	return 0;
+}
+
 /**
  * @brief
  *	Function to start/stop the database service/daemons
@@ -871,6 +933,70 @@ pbs_db_disconnect(void *conn)
 	return 0;
 }
 
+/**
+ * @brief
+ *	Start a transaction. Transactions nest, only the outermost
+ *	begin/end pair reaches the database.
+ *
+ * @param[in]   conn - Connected database handle
+ *
+ * @return      Error code
+ * @retval       0  - success
+ * @retval      -1  - Failure
+ *
+ */
+int
+pbs_db_begin_trx(void *conn)
+{
+	if (!conn || !conn_trx)
+		return -1;
+
+	if (conn_trx->conn_trx_nest == 0) {
+		if (db_execute_str(conn, "BEGIN") == -1)
+			return -1;
+		conn_trx->conn_trx_rollback = 0;
+	}
+	conn_trx->conn_trx_nest++;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *	End a transaction started by pbs_db_begin_trx. If any nested
+ *	transaction asked for a rollback, the outermost one rolls back.
+ *
+ * @param[in]   conn - Connected database handle
+ * @param[in]   commit - PBS_DB_COMMIT or PBS_DB_ROLLBACK
+ *
+ * @return      Error code
+ * @retval       0  - success
+ * @retval      -1  - Failure
+ *
+ */
+int
+pbs_db_end_trx(void *conn, int commit)
+{
+	int rc = 0;
+
+	if (!conn || !conn_trx || conn_trx->conn_trx_nest == 0)
+		return -1;
+
+	if (commit == PBS_DB_ROLLBACK)
+		conn_trx->conn_trx_rollback = 1;
+
+	if (--conn_trx->conn_trx_nest > 0)
+		return 0;
+
+	if (conn_trx->conn_trx_rollback)
+		rc = db_execute_str(conn, "ROLLBACK");
+	else
+		rc = db_execute_str(conn, "COMMIT");
+	conn_trx->conn_trx_rollback = 0;
+
+	return (rc == -1 ? -1 : 0);
+}
+
 /**
  * @brief
  *	Saves a new object into the database
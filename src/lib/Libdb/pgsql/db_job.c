@@ -44,9 +44,28 @@
  */
 
 #include <pbs_config.h>   /* the master config generated by configure */
+#include <pthread.h>
+#include <unistd.h>
 #include "pbs_db.h"
 #include "db_postgres.h"
 
+#define JOBS_CURSOR "pbs_jobs_cur"
+
+/* a row of a fetched batch, converted ahead of pbs_db_next_job() */
+typedef struct db_job_row {
+	pbs_db_job_info_t job;
+	int rc;
+} db_job_row_t;
+
+/* work given to each batch conversion thread */
+typedef struct db_job_batch_work {
+	db_query_state_t *state;
+	int first;
+	int step;
+} db_job_batch_work_t;
+
+static int load_job(const PGresult *res, pbs_db_job_info_t *pj, int row);
+
 /**
  * @brief
  *	Prepare all the job related sqls. Typically called after connect
@@ -440,6 +459,167 @@ pbs_db_load_job(void *conn, pbs_db_obj_info_t *obj)
 	return rc;
 }
 
+/**
+ * @brief
+ *	Thread routine converting every step'th row of a fetched batch,
+ *	starting at row first
+ *
+ * @param[in]	arg - the db_job_batch_work_t to do
+ *
+ * @return	NULL
+ */
+static void *
+convert_job_rows(void *arg)
+{
+	db_job_batch_work_t *work = arg;
+	db_query_state_t *state = work->state;
+	db_job_row_t *rows = state->batch;
+	int i;
+
+	for (i = work->first; i < state->count; i += work->step)
+		rows[i].rc = load_job(state->res, &rows[i].job, i);
+
+	return NULL;
+}
+
+/**
+ * @brief
+ *	Free the rows of a fetched batch, and whatever attributes were not
+ *	handed out by pbs_db_next_job()
+ *
+ * @param[in]	state - query state holding the batch
+ */
+static void
+free_job_batch(db_query_state_t *state)
+{
+	db_job_row_t *rows = state->batch;
+	svrattrl *pal;
+	int i;
+
+	if (rows == NULL)
+		return;
+
+	for (i = 0; i < state->count; i++) {
+		while ((pal = (svrattrl *) GET_NEXT(rows[i].job.db_attr_list.attrs)) != NULL) {
+			delete_link(&pal->al_link);
+			free(pal);
+		}
+	}
+	free(rows);
+	state->batch = NULL;
+}
+
+/**
+ * @brief
+ *	Convert all rows of a newly fetched batch of jobs, spreading the
+ *	work over up to PBS_DB_DECODE_THREADS threads. Converting a row only
+ *	reads the result set and allocates the row's own attribute list, so
+ *	the rows are independent of each other.
+ *
+ * @param[in]	state - query state holding the fetched result
+ *
+ * @return      Error code
+ * @retval	-1 - Failure
+ * @retval	 0 - Success
+ */
+static int
+prefetch_job_batch(db_query_state_t *state)
+{
+	pthread_t tids[PBS_DB_DECODE_THREADS];
+	db_job_batch_work_t work[PBS_DB_DECODE_THREADS];
+	db_job_row_t *rows;
+	long ncpus;
+	int nthreads;
+	int started = 0;
+	int i;
+
+	rows = calloc(state->count, sizeof(db_job_row_t));
+	if (rows == NULL)
+		return -1;
+	for (i = 0; i < state->count; i++)
+		CLEAR_HEAD(rows[i].job.db_attr_list.attrs);
+	state->batch = rows;
+
+	/* the first row sets up load_job's cached column numbers */
+	rows[0].rc = load_job(state->res, &rows[0].job, 0);
+
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	nthreads = (ncpus > PBS_DB_DECODE_THREADS) ? PBS_DB_DECODE_THREADS : (int) ncpus;
+	if (nthreads < 1 || state->count < 1000)
+		nthreads = 1;
+
+	for (i = 0; i < nthreads; i++) {
+		work[i].state = state;
+		work[i].first = i + 1;
+		work[i].step = nthreads;
+	}
+	for (i = 1; i < nthreads; i++) {
+		if (pthread_create(&tids[i], NULL, convert_job_rows, &work[i]) != 0)
+			break;
+		started++;
+	}
+	/* this thread takes the first share, and any share a thread could not */
+	convert_job_rows(&work[0]);
+	for (i = started + 1; i < nthreads; i++)
+		convert_job_rows(&work[i]);
+	for (i = 1; i <= started; i++)
+		pthread_join(tids[i], NULL);
+
+	return 0;
+}
+
+/**
+ * @brief
+ *	Start streaming all jobs, ordered by qrank, through a server side
+ *	cursor so that only PBS_DB_FETCH_SIZE rows are held at a time.
+ *
+ * @param[in]	conn - Connection handle
+ * @param[out]  state - The cursor state variable updated by this query
+ *
+ * @return      Error code
+ * @retval	-1 - Failure
+ * @retval	 0 - Success
+ * @retval	 1 -  Success but no rows found
+ */
+static int
+find_jobs_by_cursor(void *conn, db_query_state_t *state)
+{
+	if (pbs_db_begin_trx(conn) != 0)
+		return -1;
+
+	if (db_execute_str(conn, "declare " JOBS_CURSOR " no scroll cursor for select "
+		"ji_jobid,"
+		"ji_state,"
+		"ji_substate,"
+		"ji_svrflags,"
+		"ji_stime,"
+		"ji_queue,"
+		"ji_destin,"
+		"ji_un_type,"
+		"ji_exitstat,"
+		"ji_quetime,"
+		"ji_rteretry,"
+		"ji_fromsock,"
+		"ji_fromaddr,"
+		"ji_jid,"
+		"ji_credtype,"
+		"ji_qrank,"
+		"hstore_to_array(attributes) as attributes "
+		"from pbs.job order by ji_qrank") == -1) {
+		pbs_db_end_trx(conn, PBS_DB_ROLLBACK);
+		return -1;
+	}
+
+	state->cursor = JOBS_CURSOR;
+	state->prefetch = prefetch_job_batch;
+	state->batch_free = free_job_batch;
+
+	if (db_cursor_fetch(conn, state) != 0)
+		return -1;
+
+	return (state->count > 0) ? 0 : 1;
+}
+
 /**
  * @brief
  *	Find jobs
@@ -469,7 +649,10 @@ pbs_db_find_job(void *conn, void *st, pbs_db_obj_info_t *obj,
 	if (!state)
 		return -1;
 
-	if (opts != NULL && opts->flags == FIND_JOBS_BY_QUE) {
+	if (opts == NULL)
+		return (find_jobs_by_cursor(conn, state));
+
+	if (opts->flags == FIND_JOBS_BY_QUE) {
 		SET_PARAM_STR(conn_data, pdjob->ji_queue, 0);
 		params=1;
 		strcpy(conn_sql, STMT_FINDJOBS_BYQUE_ORDBY_QRANK);
@@ -505,8 +688,19 @@ int
 pbs_db_next_job(void *conn, void *st, pbs_db_obj_info_t *obj)
 {
 	db_query_state_t *state = (db_query_state_t *) st;
+	pbs_db_job_info_t *pj = obj->pbs_db_un.pbs_db_job;
+	db_job_row_t *prow;
+
+	if (state->batch == NULL)
+		return load_job(state->res, pj, state->row);
 
-	return load_job(state->res, obj->pbs_db_un.pbs_db_job, state->row);
+	prow = (db_job_row_t *) state->batch + state->row;
+	if (prow->rc != 0)
+		return -1;
+
+	*pj = prow->job;
+	list_move(&prow->job.db_attr_list.attrs, &pj->db_attr_list.attrs);
+	return 0;
 }
 
 /**
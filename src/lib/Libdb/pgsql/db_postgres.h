@@ -206,15 +206,28 @@ extern pg_conn_trx_t *conn_trx;
  *  last returned to the caller). The count field contains the total number of
  *  rows that are available in the resultset.
  *
+ *  If cursor is set, the rows come from a server side cursor, PBS_DB_FETCH_SIZE
+ *  rows at a time, and res only holds the current batch. An object type may
+ *  then set prefetch, which is called on every new batch (e.g. to convert all
+ *  its rows up front), and batch_free, which releases whatever prefetch made.
+ *
  */
 struct db_query_state {
+	void *conn;
 	PGresult *res;
 	int row;
 	int count;
 	query_cb_t query_cb;
+	char *cursor;
+	void *batch;
+	int (*prefetch)(struct db_query_state *);
+	void (*batch_free)(struct db_query_state *);
 };
 typedef struct db_query_state db_query_state_t;
 
+#define PBS_DB_FETCH_SIZE	10000	/* rows fetched from a cursor at a time */
+#define PBS_DB_DECODE_THREADS	8	/* max threads converting a fetched batch */
+
 /**
  * @brief
  * Each database object type supports most of the following 6 operations:
@@ -412,6 +425,20 @@ int pbs_db_del_attr_node(void *conn, void *obj_id, pbs_db_attr_list_t *attr_list
  */
 int db_execute_str(void *conn, char *sql);
 
+/**
+ * @brief
+ *	Fetch the next batch of rows from the server side cursor of a query state
+ *
+ * @param[in]	conn - Connected database handle
+ * @param[in]	state - The query state, with cursor set
+ *
+ * @return      int
+ * @retval      -1  - Error
+ * @retval       0  - success
+ *
+ */
+int db_cursor_fetch(void *conn, db_query_state_t *state);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -66,6 +66,9 @@ disrsl_(int stream, int *negate, unsigned long *value,
 	unsigned long count, int recursv);
 int disrsll_(int stream,  int  *negate,  u_Long *value, unsigned long count, int recursv);
 int diswui_(int stream, unsigned value);
+int disw_binary(int stream, int negate, u_Long value);
+int disr_binary(int stream, int *negate, u_Long *value, u_Long max);
+int dis_fast_rsnum(int fd, int *negate, u_Long *value, const char *max, unsigned maxdigs);
 
 extern unsigned dis_dmx10;
 extern double *dis_dp10;
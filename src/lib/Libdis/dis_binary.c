@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 1994-2020 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "dis.h"
+#include "dis_.h"
+
+/**
+ * @file	dis_binary.c
+ *
+ * @brief
+ *	Compact binary encoding of DIS integers.
+ *
+ * @par
+ *	Once both ends of a tcp channel have agreed on it during
+ *	authentication, integers (and hence the counts of counted strings)
+ *	are written as a length prefixed sequence of bytes instead of decimal
+ *	text.  The first byte carries the sign in bit 6 and the low 6 bits of
+ *	the magnitude, following bytes carry 7 bits each.  Bit 7 of every byte
+ *	is set if another byte follows.  String data is copied as is, so a
+ *	counted string is a short length followed by a plain memcpy.
+ */
+
+#define DIS_BIN_MORE	0x80
+#define DIS_BIN_NEG	0x40
+#define DIS_BIN_MAXLEN	10	/* 6 + 9 * 7 bits covers 64 bits */
+
+/**
+ * @brief
+ *	Write an integer in the compact binary encoding.
+ *
+ * @param[in] stream - socket descriptor
+ * @param[in] negate - TRUE if the value is negative
+ * @param[in] value - magnitude of the value
+ *
+ * @return	int
+ * @retval	DIS_SUCCESS	success
+ * @retval	DIS_PROTO	error
+ *
+ */
+int
+disw_binary(int stream, int negate, u_Long value)
+{
+	char buf[DIS_BIN_MAXLEN];
+	int len = 0;
+
+	assert(stream >= 0);
+
+	buf[len] = (char) (value & 0x3f);
+	if (negate)
+		buf[len] |= DIS_BIN_NEG;
+	value >>= 6;
+	while (value) {
+		buf[len++] |= DIS_BIN_MORE;
+		buf[len] = (char) (value & 0x7f);
+		value >>= 7;
+	}
+	len++;
+	if (dis_puts(stream, buf, (size_t) len) != len)
+		return (DIS_PROTO);
+	return (DIS_SUCCESS);
+}
+
+/**
+ * @brief
+ *	Read one raw byte of a binary encoded integer.
+ *
+ * @param[in] stream - socket descriptor
+ * @param[out] c - byte read
+ *
+ * @return	int
+ * @retval	DIS_SUCCESS	success
+ * @retval	DIS_EOD		no data
+ * @retval	DIS_EOF		stream closed
+ *
+ */
+static int
+disr_binary_byte(int stream, unsigned char *c)
+{
+	switch (dis_gets(stream, (char *) c, 1)) {
+		case 1:
+			return (DIS_SUCCESS);
+		case -2:
+			return (DIS_EOF);
+		default:
+			return (DIS_EOD);
+	}
+}
+
+/**
+ * @brief
+ *	Read an integer in the compact binary encoding.
+ *
+ * @param[in] stream - socket descriptor
+ * @param[out] negate - set TRUE if the value is negative
+ * @param[out] value - magnitude of the value
+ * @param[in] max - largest magnitude the caller can hold
+ *
+ * @return	int
+ * @retval	DIS_SUCCESS	success
+ * @retval	DIS_OVERFLOW	magnitude larger than max, value set to max
+ * @retval	DIS_PROTO	malformed encoding
+ * @retval	DIS_EOD		no data
+ * @retval	DIS_EOF		stream closed
+ *
+ */
+int
+disr_binary(int stream, int *negate, u_Long *value, u_Long max)
+{
+	unsigned char c;
+	int i;
+	int rc;
+	int shift = 6;
+	u_Long val;
+
+	assert(negate != NULL);
+	assert(value != NULL);
+	assert(stream >= 0);
+
+	if ((rc = disr_binary_byte(stream, &c)) != DIS_SUCCESS)
+		return (rc);
+	*negate = (c & DIS_BIN_NEG) != 0;
+	val = c & 0x3f;
+	for (i = 1; c & DIS_BIN_MORE; i++) {
+		if (i >= DIS_BIN_MAXLEN)
+			return (DIS_PROTO);
+		if ((rc = disr_binary_byte(stream, &c)) != DIS_SUCCESS)
+			return (rc);
+		/* the last byte may only fill the remaining 2 bits */
+		if (shift > 57 && ((u_Long) (c & 0x7f) >> (64 - shift)) != 0)
+			return (DIS_PROTO);
+		val |= (u_Long) (c & 0x7f) << shift;
+		shift += 7;
+	}
+	if (val > max) {
+		*negate = FALSE;
+		*value = max;
+		return (DIS_OVERFLOW);
+	}
+	*value = val;
+	return (DIS_SUCCESS);
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 1994-2020 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "dis.h"
+#include "dis_.h"
+
+/**
+ * @file	dis_float_test.c
+ *
+ * @brief
+ *	Round trip of DIS floating point numbers, zero in particular, through
+ *	a socket pair in DIS text and in the compact binary encoding, each
+ *	followed by an integer that must still read back right ("make check").
+ */
+
+static const double values[] = {0.0, -0.0, 1.5, -0.375, 3.0e12};
+
+static pbs_tcp_chan_t *chans[2];	/* channels of the socket pair */
+static int sockets[2];
+
+/* a bare transport over the socket pair, without the connection table */
+static pbs_tcp_chan_t *
+test_get_chan(int fd)
+{
+	return (fd == sockets[0]) ? chans[0] : ((fd == sockets[1]) ? chans[1] : NULL);
+}
+
+static int
+test_set_chan(int fd, pbs_tcp_chan_t *chan)
+{
+	chans[(fd == sockets[0]) ? 0 : 1] = chan;
+	return 0;
+}
+
+static int
+test_recv(int fd, void *data, int len)
+{
+	int	i;
+	int	amt = 0;
+
+	while (amt < len) {
+		if ((i = read(fd, (char *) data + amt, len - amt)) == 0)
+			return -2;
+		if (i < 0)
+			return -1;
+		amt += i;
+	}
+	return amt;
+}
+
+static int
+test_send(int fd, void *data, int len)
+{
+	return (write(fd, data, len) == len) ? len : -1;
+}
+
+/**
+ * @brief
+ *	Write the test values with diswf(), diswd() and diswl(), each followed
+ *	by a marker integer, and read them back.
+ *
+ * @param[in] binary - whether the channel uses the binary encoding
+ *
+ * @return	int
+ * @retval	0	all values read back
+ * @retval	1	failure, reported on stderr
+ */
+static int
+round_trip(int binary)
+{
+	int	*sv = sockets;
+	int	i;
+	int	rc;
+	int	bad = 0;
+	int	n = sizeof(values) / sizeof(values[0]);
+	double	d;
+	int	marker;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+		perror("socketpair");
+		return 1;
+	}
+	chans[0] = chans[1] = NULL;
+	for (i = 0; i < 2; i++) {
+		dis_setup_chan(sv[i], test_get_chan);
+		transport_chan_set_binary(sv[i], binary);
+	}
+
+	for (i = 0; i < n; i++) {
+		if (diswf(sv[0], values[i]) != DIS_SUCCESS ||
+			diswd(sv[0], values[i]) != DIS_SUCCESS ||
+			diswl(sv[0], values[i]) != DIS_SUCCESS ||
+			diswsi(sv[0], 1000 + i) != DIS_SUCCESS) {
+			fprintf(stderr, "%s: write of %g failed\n", binary ? "binary" : "text", values[i]);
+			return 1;
+		}
+	}
+	if (dis_flush(sv[0]) != 0) {
+		fprintf(stderr, "%s: flush failed\n", binary ? "binary" : "text");
+		return 1;
+	}
+
+	for (i = 0; i < n; i++) {
+		d = disrf(sv[1], &rc);
+		if (rc != DIS_SUCCESS || d != (float) values[i])
+			bad++;
+		d = disrd(sv[1], &rc);
+		if (rc != DIS_SUCCESS || d != values[i])
+			bad++;
+		d = (double) disrl(sv[1], &rc);
+		if (rc != DIS_SUCCESS || d != values[i])
+			bad++;
+		marker = disrsi(sv[1], &rc);
+		if (rc != DIS_SUCCESS || marker != 1000 + i)
+			bad++;
+		if (bad) {
+			fprintf(stderr, "%s: %g did not read back (rc %d)\n",
+				binary ? "binary" : "text", values[i], rc);
+			return 1;
+		}
+	}
+
+	dis_destroy_chan(sv[0]);
+	dis_destroy_chan(sv[1]);
+	close(sv[0]);
+	close(sv[1]);
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	dis_init_tables();
+	pfn_transport_get_chan = test_get_chan;
+	pfn_transport_set_chan = test_set_chan;
+	pfn_transport_recv = test_recv;
+	pfn_transport_send = test_send;
+	if (round_trip(0) != 0 || round_trip(1) != 0)
+		return 1;
+	printf("dis float round trip: ok\n");
+	return 0;
+}
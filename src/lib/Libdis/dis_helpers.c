@@ -40,9 +40,12 @@
 #include <arpa/inet.h>
 #include <assert.h>
 #include <errno.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include "auth.h"
 #include "dis.h"
+#include "dis_.h"
 #include "pbs_error.h"
 #include "pbs_internal.h"
 
@@ -217,6 +220,59 @@ transport_chan_get_authdef(int fd, int for_encrypt)
 	return chan->auths[for_encrypt].def;
 }
 
+/**
+ * @brief
+ * 	transport_chan_set_binary - switch integer encoding of the connection
+ *	between DIS text and the compact binary encoding
+ *
+ * @param[in] fd - file descriptor
+ * @param[in] binary - 1 for binary, 0 for DIS text
+ *
+ * @return void
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+void
+transport_chan_set_binary(int fd, int binary)
+{
+	pbs_tcp_chan_t *chan = transport_get_chan(fd);
+
+	if (chan == NULL)
+		return;
+	chan->is_binary = binary;
+}
+
+/**
+ * @brief
+ * 	transport_chan_is_binary - does the connection use the compact binary encoding?
+ *
+ * @param[in] fd - file descriptor
+ *
+ * @return int
+ *
+ * @retval 0 - DIS text
+ * @retval 1 - binary
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+int
+transport_chan_is_binary(int fd)
+{
+	pbs_tcp_chan_t *chan = transport_get_chan(fd);
+
+	if (chan == NULL)
+		return 0;
+	return chan->is_binary;
+}
+
 /**
  * @brief
  * 	transport_chan_is_encrypted - is chan assosiated with given fd is encrypted?
@@ -731,6 +787,127 @@ dis_gets(int fd, char *str, size_t ct)
 	return (int) ct;
 }
 
+/**
+ * @brief
+ * 	dis_fast_digits - convert a run of decimal digits to a value
+ *
+ * @par
+ *	Eight digits at a time are converted with SWAR arithmetic on a 64 bit
+ *	word, the tail is converted one digit at a time.  The caller ensures
+ *	that the result cannot overflow.
+ *
+ * @param[in] cp - pointer to the first digit
+ * @param[in] ct - number of digits
+ * @param[out] value - converted value
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	a non digit character was found
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static int
+dis_fast_digits(const char *cp, size_t ct, u_Long *value)
+{
+	u_Long val = 0;
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	while (ct >= 8) {
+		uint64_t w;
+
+		memcpy(&w, cp, sizeof(w));
+		/* every byte must be in '0'..'9' */
+		if (((w & 0xF0F0F0F0F0F0F0F0ULL) |
+			(((w + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) !=
+			0x3333333333333333ULL)
+			return -1;
+		w = ((w & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+		w = ((w & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+		w = ((w & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+		val = val * 100000000 + (u_Long) w;
+		cp += 8;
+		ct -= 8;
+	}
+#endif
+	while (ct--) {
+		unsigned d = (unsigned char) *cp++ - '0';
+
+		if (d > 9)
+			return -1;
+		val = 10 * val + d;
+	}
+	*value = val;
+	return 0;
+}
+
+/**
+ * @brief
+ * 	dis_fast_rsnum - decode a complete DIS signed integer directly from
+ *	the read buffer.
+ *
+ * @par
+ *	This is the fast path for disrsi_(), disrsl_() and disrsll_().  The
+ *	count prefixes and the digits are parsed in place without a call per
+ *	byte.  Nothing is consumed unless the whole integer is present in the
+ *	buffer and is well formed; otherwise the caller falls back to the
+ *	byte at a time path, which reads more data and reports the exact error.
+ *
+ * @param[in] fd - file descriptor
+ * @param[out] negate - set TRUE if the value is negative
+ * @param[out] value - decoded magnitude
+ * @param[in] max - decimal string of the largest value allowed
+ * @param[in] maxdigs - number of digits in max
+ *
+ * @return	int
+ * @retval	DIS_SUCCESS	value decoded and consumed
+ * @retval	-1		use the slow path, nothing consumed
+ *
+ * @par MT-safe: Yes
+ *
+ */
+int
+dis_fast_rsnum(int fd, int *negate, u_Long *value, const char *max, unsigned maxdigs)
+{
+	pbs_dis_buf_t *tp = dis_get_readbuf(fd);
+	const char *cp;
+	const char *end;
+	u_Long count = 1;
+	u_Long val;
+	int recursv;
+
+	if (tp == NULL || tp->tdis_len == 0 || max == NULL || maxdigs == 0)
+		return -1;
+	cp = tp->tdis_pos;
+	end = cp + tp->tdis_len;
+
+	for (recursv = 0; recursv < DIS_RECURSIVE_LIMIT; recursv++) {
+		if (count > maxdigs || count >= (u_Long) (end - cp))
+			return -1;
+		if (*cp == '+' || *cp == '-') {
+			if (count == maxdigs && memcmp(cp + 1, max, maxdigs) > 0)
+				return -1;
+			if (dis_fast_digits(cp + 1, count, &val) != 0)
+				return -1;
+			*negate = *cp == '-';
+			*value = val;
+			cp += count + 1;
+			tp->tdis_len -= cp - tp->tdis_pos;
+			tp->tdis_pos = (char *) cp;
+			return DIS_SUCCESS;
+		}
+		if (*cp < '1' || *cp > '9')
+			return -1;
+		if (count == maxdigs && memcmp(cp, max, maxdigs) > 0)
+			return -1;
+		if (dis_fast_digits(cp, count, &val) != 0)
+			return -1;
+		cp += count;
+		count = val;
+	}
+	return -1;
+}
+
 /**
  * @brief
  * 	dis_puts - dis support routine to put a counted string of characters
@@ -774,6 +951,73 @@ dis_puts(int fd, const char *str, size_t ct)
 	return ct;
 }
 
+/**
+ * @brief
+ * 	dis_write_mark - offset in the write buffer at which the next
+ *	dis_puts() will place its data
+ *
+ * @param[in] fd - file descriptor
+ *
+ * @return	size_t
+ *
+ * @retval	offset, to be given to dis_write_copy()
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+size_t
+dis_write_mark(int fd)
+{
+	pbs_dis_buf_t *tp = dis_get_writebuf(fd);
+
+	if (tp == NULL || tp->tdis_len == 0)
+		return PKT_HDR_SZ; /* dis_puts() starts a new packet */
+	return tp->tdis_len;
+}
+
+/**
+ * @brief
+ * 	dis_write_copy - copy out what has been written to the write buffer
+ *	since dis_write_mark() was called, so that it can be replayed later
+ *	with dis_puts()
+ *
+ * @param[in] fd - file descriptor
+ * @param[in] mark - offset returned by dis_write_mark()
+ * @param[out] len - length of the copy
+ *
+ * @return	char *
+ *
+ * @retval	malloc'ed copy of the data
+ * @retval	NULL if nothing was written or on malloc failure
+ *
+ * @note
+ *	The buffer must not have been flushed since the mark was taken.
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+char *
+dis_write_copy(int fd, size_t mark, size_t *len)
+{
+	pbs_dis_buf_t *tp = dis_get_writebuf(fd);
+	char *data;
+
+	*len = 0;
+	if (tp == NULL || tp->tdis_len <= mark)
+		return NULL;
+	if ((data = malloc(tp->tdis_len - mark)) == NULL)
+		return NULL;
+	*len = tp->tdis_len - mark;
+	memcpy(data, tp->tdis_data + mark, *len);
+	return data;
+}
+
 /**
  * @brief
  *	flush dis write buffer
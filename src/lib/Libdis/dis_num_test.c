@@ -0,0 +1,282 @@
+/*
+ * Copyright (C) 1994-2020 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "dis.h"
+#include "dis_.h"
+
+/**
+ * @file	dis_num_test.c
+ *
+ * @brief
+ *	Decode DIS text integers with the in place parse of dis_fast_rsnum()
+ *	and with the byte at a time path, check that both read back the same
+ *	values and print the time each takes ("make check").  The byte path
+ *	is reached by calling disrsi_() and disrsl_() one recursion level
+ *	down, which skips the fast path.  The time to decode strings is
+ *	printed next to it for comparison.
+ */
+
+#define	BATCH	2000	/* values per flush, well within the socket buffer */
+#define	ROUNDS	100
+
+static pbs_tcp_chan_t *chans[2];	/* channels of the socket pair */
+static int sockets[2];
+
+static long values[BATCH];
+
+/* a bare transport over the socket pair, without the connection table */
+static pbs_tcp_chan_t *
+test_get_chan(int fd)
+{
+	return (fd == sockets[0]) ? chans[0] : ((fd == sockets[1]) ? chans[1] : NULL);
+}
+
+static int
+test_set_chan(int fd, pbs_tcp_chan_t *chan)
+{
+	chans[(fd == sockets[0]) ? 0 : 1] = chan;
+	return 0;
+}
+
+static int
+test_recv(int fd, void *data, int len)
+{
+	int	i;
+
+	if ((i = read(fd, data, len)) == 0)
+		return -2;
+	return i;
+}
+
+static int
+test_send(int fd, void *data, int len)
+{
+	return (write(fd, data, len) == len) ? len : -1;
+}
+
+static double
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief
+ *	Write one batch of values, as int or as long, and time reading it back.
+ *
+ * @param[in] wide - decode with disrsl_() rather than disrsi_()
+ * @param[in] slow - take the byte at a time path
+ * @param[in,out] ns - time spent decoding
+ *
+ * @return	int
+ * @retval	0	all values read back
+ * @retval	1	failure, reported on stderr
+ */
+static int
+decode_batch(int wide, int slow, double *ns)
+{
+	int		i;
+	int		rc;
+	int		negate;
+	unsigned	uval;
+	unsigned long	ulval;
+	long		val;
+	double		start;
+
+	for (i = 0; i < BATCH; i++) {
+		if (diswsl(sockets[0], wide ? values[i] : (int) values[i]) != DIS_SUCCESS) {
+			fprintf(stderr, "write of %ld failed\n", values[i]);
+			return 1;
+		}
+	}
+	if (dis_flush(sockets[0]) != 0) {
+		fprintf(stderr, "flush failed\n");
+		return 1;
+	}
+
+	start = now_ns();
+	for (i = 0; i < BATCH; i++) {
+		if (wide) {
+			rc = disrsl_(sockets[1], &negate, &ulval, 1, slow);
+			val = negate ? -(long) ulval : (long) ulval;
+			if (rc != DIS_SUCCESS || val != values[i])
+				break;
+		} else {
+			rc = disrsi_(sockets[1], &negate, &uval, 1, slow);
+			val = negate ? -(long) uval : (long) uval;
+			if (rc != DIS_SUCCESS || val != (int) values[i])
+				break;
+		}
+	}
+	*ns += now_ns() - start;
+	if (i < BATCH) {
+		fprintf(stderr, "%s %s: %ld read back as %ld (rc %d)\n",
+			slow ? "byte path" : "fast path", wide ? "long" : "int",
+			values[i], val, rc);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Write one batch of strings of a given length and time reading it back.
+ *
+ * @param[in] len - string length
+ * @param[in,out] ns - time spent decoding
+ *
+ * @return	int
+ * @retval	0	all strings read back
+ * @retval	1	failure, reported on stderr
+ */
+static int
+decode_strings(size_t len, double *ns)
+{
+	char	str[257];
+	char	*got;
+	int	i;
+	int	rc;
+	int	bad = 0;
+	double	start;
+
+	memset(str, 'x', len);
+	str[len] = '\0';
+	for (i = 0; i < BATCH / 10; i++) {
+		if (diswst(sockets[0], str) != DIS_SUCCESS) {
+			fprintf(stderr, "write of string failed\n");
+			return 1;
+		}
+	}
+	if (dis_flush(sockets[0]) != 0) {
+		fprintf(stderr, "flush failed\n");
+		return 1;
+	}
+
+	start = now_ns();
+	for (i = 0; i < BATCH / 10; i++) {
+		got = disrst(sockets[1], &rc);
+		if (rc != DIS_SUCCESS || got == NULL || strcmp(got, str) != 0)
+			bad++;
+		free(got);
+	}
+	*ns += now_ns() - start;
+	if (bad) {
+		fprintf(stderr, "%d strings of %zu bytes did not read back\n", bad, len);
+		return 1;
+	}
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	static const size_t lens[] = {16, 256};
+	double	ns[2][2];	/* [wide][slow] */
+	double	sns[2];
+	int	i;
+	int	r;
+	int	wide;
+	int	slow;
+	int	ndigs;
+	long	v;
+
+	dis_init_tables();
+	pfn_transport_get_chan = test_get_chan;
+	pfn_transport_set_chan = test_set_chan;
+	pfn_transport_recv = test_recv;
+	pfn_transport_send = test_send;
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == -1) {
+		perror("socketpair");
+		return 1;
+	}
+	for (i = 0; i < 2; i++)
+		dis_setup_chan(sockets[i], test_get_chan);
+
+	/* signed values of 1 to 18 digits, the mix of ids, sizes and times */
+	srandom(1);
+	for (i = 0; i < BATCH; i++) {
+		ndigs = 1 + i % 18;
+		for (v = 1 + random() % 9; --ndigs > 0; )
+			v = v * 10 + random() % 10;
+		values[i] = (i & 1) ? -v : v;
+	}
+	values[0] = 0;
+	values[1] = 2147483647;
+	values[2] = -2147483647;
+
+	memset(ns, 0, sizeof(ns));
+	memset(sns, 0, sizeof(sns));
+	for (r = 0; r < ROUNDS; r++) {
+		/* alternate the paths so that both see the same machine state */
+		for (wide = 0; wide < 2; wide++)
+			for (slow = 0; slow < 2; slow++)
+				if (decode_batch(wide, slow, &ns[wide][slow]) != 0)
+					return 1;
+		for (i = 0; i < 2; i++)
+			if (decode_strings(lens[i], &sns[i]) != 0)
+				return 1;
+	}
+
+	for (wide = 0; wide < 2; wide++)
+		printf("dis %-4s decode: fast path %.1f ns, byte path %.1f ns\n",
+			wide ? "long" : "int",
+			ns[wide][0] / (ROUNDS * BATCH), ns[wide][1] / (ROUNDS * BATCH));
+	for (i = 0; i < 2; i++)
+		printf("dis string decode, %zu bytes: %.1f ns\n",
+			lens[i], sns[i] / (ROUNDS * BATCH / 10));
+
+	dis_destroy_chan(sockets[0]);
+	dis_destroy_chan(sockets[1]);
+	close(sockets[0]);
+	close(sockets[1]);
+	printf("dis integer decode: ok\n");
+	return 0;
+}
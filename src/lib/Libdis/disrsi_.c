@@ -75,6 +75,20 @@ disrsi_(int stream, int *negate, unsigned *value, unsigned count, int recursv)
 
 	if (++recursv > DIS_RECURSIVE_LIMIT)
 		return (DIS_PROTO);
+	/* try to decode the whole integer straight from the read buffer */
+	if (recursv == 1 && count == 1) {
+		u_Long fastval;
+
+		if (transport_chan_is_binary(stream)) {
+			c = disr_binary(stream, negate, &fastval, UINT_MAX);
+			*value = (unsigned) fastval;
+			return (c);
+		}
+		if (dis_fast_rsnum(stream, negate, &fastval, dis_umax, dis_umaxd) == DIS_SUCCESS) {
+			*value = (unsigned) fastval;
+			return (DIS_SUCCESS);
+		}
+	}
 	/* dis_umaxd would be initialized by prior call to dis_init_tables */
 	switch (c = dis_getc(stream)) {
 		case '-':
@@ -77,6 +77,20 @@ disrsl_(int stream, int *negate, unsigned long *value, unsigned long count, int
 
 	if (++recursv > DIS_RECURSIVE_LIMIT)
 		return (DIS_PROTO);
+	/* try to decode the whole integer straight from the read buffer */
+	if (recursv == 1 && count == 1) {
+		u_Long fastval;
+
+		if (transport_chan_is_binary(stream)) {
+			c = disr_binary(stream, negate, &fastval, ULONG_MAX);
+			*value = (unsigned long) fastval;
+			return (c);
+		}
+		if (dis_fast_rsnum(stream, negate, &fastval, ulmax, ulmaxdigs) == DIS_SUCCESS) {
+			*value = (unsigned long) fastval;
+			return (DIS_SUCCESS);
+		}
+	}
 
 	switch (c = dis_getc(stream)) {
 		case '-':
@@ -94,6 +94,13 @@ disrsll_(int stream, int *negate, u_Long *value, unsigned long count, int recurs
 
 	if (++recursv > DIS_RECURSIVE_LIMIT)
 		return (DIS_PROTO);
+	/* try to decode the whole integer straight from the read buffer */
+	if (recursv == 1 && count == 1) {
+		if (transport_chan_is_binary(stream))
+			return (disr_binary(stream, negate, value, UlONG_MAX));
+		if (dis_fast_rsnum(stream, negate, value, ulmax, ulmaxdigs) == DIS_SUCCESS)
+			return (DIS_SUCCESS);
+	}
 
 	/* ulmaxdigs  would be initialized from dis_init_tables */
 	switch (c = dis_getc(stream)) {
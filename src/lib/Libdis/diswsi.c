@@ -103,6 +103,9 @@ diswsi(int stream, int value)
 		uval = value;
 		c = '+';
 	}
+	if (transport_chan_is_binary(stream))
+		return (disw_binary(stream, c == '-', uval));
+
 	cp = discui_(&dis_buffer[DIS_BUFSIZ], uval, &ndigs);
 	*--cp = c;
 	while (ndigs > 1)
@@ -103,6 +103,9 @@ diswsl(int stream, long value)
 		ulval = value;
 		c = '+';
 	}
+	if (transport_chan_is_binary(stream))
+		return (disw_binary(stream, c == '-', ulval));
+
 	cp = discul_(&dis_buffer[DIS_BUFSIZ], ulval, &ndigs);
 	*--cp = c;
 	while (ndigs > 1)
@@ -69,6 +69,9 @@ diswui_(int stream, unsigned value)
 
 	assert(stream >= 0);
 
+	if (transport_chan_is_binary(stream))
+		return (disw_binary(stream, FALSE, value));
+
 	cp = discui_(&dis_buffer[DIS_BUFSIZ], value, &ndigs);
 	*--cp = '+';
 	while (ndigs > 1)
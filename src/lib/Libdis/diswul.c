@@ -93,6 +93,9 @@ diswul(int stream, unsigned long value)
 	char		*cp;
 
 	assert(stream >= 0);
+	if (transport_chan_is_binary(stream))
+		return (disw_binary(stream, FALSE, value));
+
 	cp = discul_(&dis_buffer[DIS_BUFSIZ], value, &ndigs);
 	*--cp = '+';
 	while (ndigs > 1)
@@ -97,6 +97,9 @@ diswull(int stream, u_Long value)
 	assert(stream >= 0);
 
 
+	if (transport_chan_is_binary(stream))
+		return (disw_binary(stream, FALSE, value));
+
 	cp = discull_(&dis_buffer[DIS_BUFSIZ], value, &ndigs);
 	*--cp = '+';
 	while (ndigs > 1)
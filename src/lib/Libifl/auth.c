@@ -362,8 +362,12 @@ tcp_send_auth_req(int sock, unsigned int port, char *user, char *auth_method, ch
 		return -1;
 	}
 
+	/*
+	 * Ask for the binary encoding only when authenticating this
+	 * connection itself, pbs_iff authenticates on behalf of another one.
+	 */
 	if (diswui(sock, port) ||  /* port (only used in resvport auth) */
-		encode_DIS_ReqExtend(sock, NULL)) {
+		encode_DIS_ReqExtend(sock, port == 0 ? DIS_BINARY_EXTEND : NULL)) {
 		pbs_errno = PBSE_SYSTEM;
 		return -1;
 	}
@@ -388,6 +392,12 @@ tcp_send_auth_req(int sock, unsigned int port, char *user, char *auth_method, ch
 		return -1;
 	}
 
+	/* the server echoes the extension back if it agreed to binary */
+	if (reply->brp_choice == BATCH_REPLY_CHOICE_Text &&
+		reply->brp_un.brp_txt.brp_str != NULL &&
+		strcmp(reply->brp_un.brp_txt.brp_str, DIS_BINARY_EXTEND) == 0)
+		transport_chan_set_binary(sock, 1);
+
 	PBSD_FreeReply(reply);
 
 	return 0;
@@ -82,6 +82,7 @@ encode_DIS_reply_inner(int sock, struct batch_reply *reply)
 	int i;
 	struct brp_select *psel;
 	struct brp_status *pstat;
+	struct brp_cache *pcache;
 	svrattrl *psvrl;
 	preempt_job_info *ppj;
 
@@ -138,9 +139,20 @@ encode_DIS_reply_inner(int sock, struct batch_reply *reply)
 				if ((rc = diswui(sock, pstat->brp_objtype)) || (rc = diswst(sock, pstat->brp_objname)))
 					return rc;
 
-				psvrl = (svrattrl *) GET_NEXT(pstat->brp_attr);
-				if ((rc = encode_DIS_svrattrl(sock, psvrl)) != 0)
-					return rc;
+				pcache = pstat->brp_cache;
+				if (pcache != NULL && pcache->bc_data != NULL) {
+					/* attribute list already encoded by an earlier reply */
+					if (dis_puts(sock, pcache->bc_data, pcache->bc_len) != (int) pcache->bc_len)
+						return DIS_PROTO;
+				} else {
+					size_t mark = dis_write_mark(sock);
+
+					psvrl = (svrattrl *) GET_NEXT(pstat->brp_attr);
+					if ((rc = encode_DIS_svrattrl(sock, psvrl)) != 0)
+						return rc;
+					if (pcache != NULL)
+						pcache->bc_data = dis_write_copy(sock, mark, &pcache->bc_len);
+				}
 				pstat = (struct brp_status *) GET_NEXT(pstat->brp_stlink);
 			}
 			break;
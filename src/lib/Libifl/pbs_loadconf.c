@@ -124,9 +124,13 @@ struct pbs_config pbs_conf = {
 	NULL,					/* for router, default communication routers list */
 	0,					/* default comm logevent mask */
 	4,					/* default number of threads */
+	16,					/* default multicast fan-out between routers */
 	NULL,					/* mom short name override */
 	NULL,					/* pbs_lr_save_path */
 	0,					/* high resolution timestamp logging */
+	0,					/* asynchronous logging */
+	0,					/* accounting records written as they come */
+	0,					/* no JSON accounting records */
 	0,					/* number of scheduler threads */
 	NULL,					/* default scheduler user */
 	{'\0'}					/* current running user */
@@ -533,6 +537,10 @@ __pbs_loadconf(int reload)
 				if (sscanf(conf_value, "%u", &uvalue) == 1)
 					pbs_conf.pbs_comm_threads = uvalue;
 			}
+			else if (!strcmp(conf_name, PBS_CONF_COMM_MCAST_FANOUT)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_comm_mcast_fanout = uvalue;
+			}
 			else if (!strcmp(conf_name, PBS_CONF_COMM_LOG_EVENTS)) {
 				if (sscanf(conf_value, "%u", &uvalue) == 1)
 					pbs_conf.pbs_comm_log_events = uvalue;
@@ -629,6 +637,18 @@ __pbs_loadconf(int reload)
 				if (sscanf(conf_value, "%u", &uvalue) == 1)
 					pbs_conf.pbs_log_highres_timestamp = ((uvalue > 0) ? 1 : 0);
 			}
+			else if (!strcmp(conf_name, PBS_CONF_LOG_ASYNC)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_log_async = uvalue;
+			}
+			else if (!strcmp(conf_name, PBS_CONF_ACCT_FLUSH_INTERVAL)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_acct_flush_interval = uvalue;
+			}
+			else if (!strcmp(conf_name, PBS_CONF_ACCT_JSON)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_acct_json = ((uvalue > 0) ? 1 : 0);
+			}
 			else if (!strcmp(conf_name, PBS_CONF_SCHED_THREADS)) {
 				if (sscanf(conf_value, "%u", &uvalue) == 1)
 					pbs_conf.pbs_sched_threads = uvalue;
@@ -835,6 +855,10 @@ __pbs_loadconf(int reload)
 		if (sscanf(gvalue, "%u", &uvalue) == 1)
 			pbs_conf.pbs_comm_threads = uvalue;
 	}
+	if ((gvalue = getenv(PBS_CONF_COMM_MCAST_FANOUT)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_comm_mcast_fanout = uvalue;
+	}
 	if ((gvalue = getenv(PBS_CONF_COMM_LOG_EVENTS)) != NULL) {
 		if (sscanf(gvalue, "%u", &uvalue) == 1)
 			pbs_conf.pbs_comm_log_events = uvalue;
@@ -881,6 +905,18 @@ __pbs_loadconf(int reload)
 		if (sscanf(gvalue, "%u", &uvalue) == 1)
 			pbs_conf.pbs_log_highres_timestamp = ((uvalue > 0) ? 1 : 0);
 	}
+	if ((gvalue = getenv(PBS_CONF_LOG_ASYNC)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_log_async = uvalue;
+	}
+	if ((gvalue = getenv(PBS_CONF_ACCT_FLUSH_INTERVAL)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_acct_flush_interval = uvalue;
+	}
+	if ((gvalue = getenv(PBS_CONF_ACCT_JSON)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_acct_json = ((uvalue > 0) ? 1 : 0);
+	}
 	if ((gvalue = getenv(PBS_CONF_SCHED_THREADS)) != NULL) {
 		if (sscanf(gvalue, "%u", &uvalue) == 1)
 			pbs_conf.pbs_sched_threads = uvalue;
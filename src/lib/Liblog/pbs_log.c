@@ -113,6 +113,25 @@ static volatile int  log_opened = 0;
 static int	     syslogopen = 0;
 #endif	/* SYSLOG */
 
+#ifndef WIN32
+/*
+ * Asynchronous logging, see log_async_start().  Records are formatted by
+ * the logging thread and copied into log_abuf under log_mutex; a writer
+ * thread swaps log_abuf with log_abuf_spare and writes the whole batch
+ * without holding the mutex.  Memory is bounded by the two buffers.
+ */
+#define LOG_ASYNC_BUFSZ	(1024 * 1024)
+static int	     log_async = LOG_ASYNC_OFF;	/* overflow policy, or off */
+static char	    *log_abuf;		/* records waiting to be written */
+static char	    *log_abuf_spare;	/* batch being written */
+static size_t	     log_alen;		/* bytes in log_abuf */
+static int	     log_awriting;	/* writer is writing out a batch */
+static unsigned long log_adropped;	/* records dropped while full */
+static pthread_cond_t log_acond;	/* records waiting */
+static pthread_cond_t log_aspace;	/* buffer space or batch written */
+static void log_async_drain(void);
+#endif
+
 /*
  * the order of these names MUST match the defintions of
  * PBS_EVENTCLASS_* in log.h
@@ -381,8 +400,189 @@ log_atfork_parent()
 void
 log_atfork_child()
 {
+	/*
+	 * There is no writer thread in the child and the records still
+	 * queued are the parent's to write, so the child logs synchronously.
+	 */
+	log_async = LOG_ASYNC_OFF;
+	log_alen = 0;
+	log_awriting = 0;
 	log_mutex_unlock();
 }
+
+/**
+ * @brief
+ *	write a buffer out completely
+ *
+ * @param[in] fd - file descriptor
+ * @param[in] buf - data to write
+ * @param[in] len - length of data
+ *
+ */
+static void
+log_write_all(int fd, const char *buf, size_t len)
+{
+	ssize_t n;
+
+	while (len > 0) {
+		n = write(fd, buf, len);
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			return;
+		}
+		buf += n;
+		len -= n;
+	}
+}
+
+/**
+ * @brief
+ *	thread which writes out the records queued by log_record() in
+ *	asynchronous mode
+ *
+ * @param[in] arg - unused
+ *
+ * @return void *
+ *
+ */
+static void *
+log_async_writer(void *arg)
+{
+	sigset_t all;
+	char *batch;
+	size_t len;
+	unsigned long dropped;
+	int fd;
+	char notice[256];
+	time_t now;
+	struct tm ltm;
+
+	/* leave signal handling to the main thread */
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, NULL);
+
+	log_mutex_lock();
+	for (;;) {
+		while (log_alen == 0 && log_adropped == 0)
+			pthread_cond_wait(&log_acond, &log_mutex);
+
+		batch = log_abuf;
+		len = log_alen;
+		log_abuf = log_abuf_spare;
+		log_abuf_spare = batch;
+		log_alen = 0;
+		dropped = log_adropped;
+		log_adropped = 0;
+		fd = fileno(logfile);
+		log_awriting = 1;
+		pthread_cond_broadcast(&log_aspace);
+		log_mutex_unlock();
+
+		log_write_all(fd, batch, len);
+		if (dropped > 0) {
+			now = time(NULL);
+			localtime_r(&now, &ltm);
+			len = snprintf(notice, sizeof(notice),
+				"%02d/%02d/%04d %02d:%02d:%02d;%04x;%s;%s;Log;%lu log records dropped, log buffer full\n",
+				ltm.tm_mon + 1, ltm.tm_mday, ltm.tm_year + 1900,
+				ltm.tm_hour, ltm.tm_min, ltm.tm_sec,
+				PBSEVENT_SYSTEM, msg_daemonname,
+				class_names[PBS_EVENTCLASS_SERVER], dropped);
+			log_write_all(fd, notice, len);
+		}
+
+		log_mutex_lock();
+		log_awriting = 0;
+		pthread_cond_broadcast(&log_aspace);
+	}
+	return NULL;
+}
+
+/**
+ * @brief
+ *	write out every queued record before returning.  Called on log
+ *	close, at exit and for critical records.
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static void
+log_async_drain(void)
+{
+	int locked;
+
+	if (log_abuf == NULL)
+		return;
+	locked = (log_mutex_lock() == 0);	/* may already hold it */
+	while (log_awriting)
+		pthread_cond_wait(&log_aspace, &log_mutex);
+	if (log_alen > 0 && log_opened == 1) {
+		log_write_all(fileno(logfile), log_abuf, log_alen);
+		log_alen = 0;
+		pthread_cond_broadcast(&log_aspace);
+	}
+	if (locked)
+		log_mutex_unlock();
+}
+
+/**
+ * @brief
+ *	log_async_start - switch the daemon to asynchronous logging.
+ *	Records are queued in memory and written in batches by a separate
+ *	thread, so that logging does not wait on the disk.
+ *
+ * @param[in] policy - what to do when the queue is full:
+ *			LOG_ASYNC_BLOCK to wait for the writer,
+ *			LOG_ASYNC_DROP to drop the record and count it,
+ *			LOG_ASYNC_OFF to stay synchronous.
+ *
+ * @return int
+ * @retval 0 - success, or nothing to do
+ * @retval -1 - failure, logging stays synchronous
+ *
+ * @note
+ *	Must be called after the daemon has forked into the background, as
+ *	a forked child goes back to synchronous logging.  Records of severity
+ *	LOG_CRIT and above are written out before log_record() returns.
+ *
+ */
+int
+log_async_start(int policy)
+{
+	pthread_t tid;
+	pthread_attr_t attr;
+
+	if (policy != LOG_ASYNC_BLOCK && policy != LOG_ASYNC_DROP)
+		return 0;
+	if (log_async != LOG_ASYNC_OFF || log_opened != 1)
+		return 0;
+
+	if (log_abuf == NULL) {
+		log_abuf = malloc(LOG_ASYNC_BUFSZ);
+		log_abuf_spare = malloc(LOG_ASYNC_BUFSZ);
+		if (log_abuf == NULL || log_abuf_spare == NULL) {
+			free(log_abuf);
+			free(log_abuf_spare);
+			log_abuf = log_abuf_spare = NULL;
+			return -1;
+		}
+		pthread_cond_init(&log_acond, NULL);
+		pthread_cond_init(&log_aspace, NULL);
+		atexit(log_async_drain);
+	}
+
+	if (pthread_attr_init(&attr) != 0)
+		return -1;
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	if (pthread_create(&tid, &attr, log_async_writer, NULL) != 0) {
+		pthread_attr_destroy(&attr);
+		return -1;
+	}
+	pthread_attr_destroy(&attr);
+	log_async = policy;
+	return 0;
+}
 #endif
 
 /**
@@ -955,6 +1155,8 @@ log_record(int eventtype, int objclass, int sev, const char *objname, const char
 	struct tm ltm;
 	sigset_t block_mask;
 	sigset_t old_mask;
+	char arec[LOG_BUF_SIZE * 2];
+	int alen = -1;
 
 	/* Block all signals to the process to make the function async-safe */
 	sigfillset(&block_mask);
@@ -990,6 +1192,18 @@ log_record(int eventtype, int objclass, int sev, const char *objname, const char
 	ptm = localtime(&now);
 #else
 	ptm = localtime_r(&now, &ltm);
+
+	/* in asynchronous mode format the record before taking the lock */
+	if (log_async != LOG_ASYNC_OFF && (locallog != 0 || syslogfac == 0)) {
+		alen = snprintf(arec, sizeof(arec),
+				"%02d/%02d/%04d %02d:%02d:%02d%s;%04x;%s;%s;%s;%s\n",
+				ptm->tm_mon + 1, ptm->tm_mday, ptm->tm_year + 1900,
+				ptm->tm_hour, ptm->tm_min, ptm->tm_sec, microsec_buf,
+				eventtype & ~PBSEVENT_FORCE, msg_daemonname,
+				class_names[objclass], objname, text);
+		if (alen >= (int)sizeof(arec))
+			alen = -1;	/* too long, write it synchronously */
+	}
 #endif
 
 	/* lock the log mutex */
@@ -1013,7 +1227,26 @@ log_record(int eventtype, int objclass, int sev, const char *objname, const char
 		goto sigunblock;
 	}
 
+#ifndef WIN32
+	if (alen >= 0 && log_async != LOG_ASYNC_OFF) {
+		while (log_alen + alen > LOG_ASYNC_BUFSZ && log_async == LOG_ASYNC_BLOCK)
+			pthread_cond_wait(&log_aspace, &log_mutex);
+		if (log_alen + alen > LOG_ASYNC_BUFSZ) {
+			log_adropped++;
+		} else {
+			memcpy(log_abuf + log_alen, arec, alen);
+			log_alen += alen;
+		}
+		pthread_cond_signal(&log_acond);
+		if (sev <= LOG_CRIT)
+			log_async_drain();
+	} else if (locallog != 0 || syslogfac == 0) {
+		/* keep the order with records queued earlier */
+		if (log_alen > 0 || log_awriting)
+			log_async_drain();
+#else
 	if (locallog != 0 || syslogfac == 0) {
+#endif
 		rc = fprintf(logfile,
 			     "%02d/%02d/%04d %02d:%02d:%02d%s;%04x;%s;%s;%s;%s\n",
 			     ptm->tm_mon + 1, ptm->tm_mday, ptm->tm_year + 1900,
@@ -1077,6 +1310,9 @@ log_close(int msg)
 			log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER,
 				LOG_INFO, "Log", "Log closed");
 		}
+#ifndef WIN32
+		log_async_drain();
+#endif
 		(void)fclose(logfile);
 		log_opened = 0;
 	}
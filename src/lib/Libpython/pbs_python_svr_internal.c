@@ -3569,6 +3569,7 @@ _pps_helper_get_job(job *pjob_o, const char *jobid, const char *qname, char *per
 	job *pjob;
 	int tmp_rc = -1;
 	int t;
+	int packed;
 	char	perf_action[MAXBUFLEN];
 
 	if (pjob_o != NULL) {
@@ -3607,6 +3608,10 @@ _pps_helper_get_job(job *pjob_o, const char *jobid, const char *qname, char *per
 		log_err(PBSE_INTERNAL, __func__, log_buffer);
 		return py_job;
 	}
+	/* a history job listed by the job iterator may still be packed */
+	packed = pjob->ji_packed != NULL;
+	if (svr_histjob_unpack(pjob) != 0)
+		return py_job;
 
 	/*
 	 * First things first create a Python queue  object.
@@ -3637,6 +3642,8 @@ _pps_helper_get_job(job *pjob_o, const char *jobid, const char *qname, char *per
 		pjob->ji_wattr,
 		job_attr_def,
 		JOB_ATR_LAST, perf_label, perf_action);
+	if (packed)
+		(void)svr_histjob_pack(pjob);
 
 	if (tmp_rc == -1) {
 		log_err(PBSE_INTERNAL, __func__,
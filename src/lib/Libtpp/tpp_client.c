@@ -249,6 +249,8 @@ typedef struct {
 
 	short num_unacked_pkts;   /* IO thread - number of unacked packets on wire */
 
+	unsigned char peer_cmpr_caps; /* codecs the peer can decode, IO thread sets, APP thread reads */
+
 	tpp_addr_t src_addr;  /* address of the source host */
 	tpp_addr_t dest_addr; /* address of destination host - set by APP thread, read-only by IO thread */
 
@@ -683,35 +685,38 @@ connect_router(tpp_router_t *r)
 /**
  * @brief
  *	tpp leaf atfork prepare handler
- *  It acquires all (currently only strmarray_lock) before fork
+ *  It acquires all (strmarray_lock and the object pool locks) before fork
  */
 void
 tpp_client_prefork()
 {
 	tpp_lock(&strmarray_lock);
+	tpp_pool_prefork();
 }
 
 /**
  * @brief
  *	tpp leaf postfork parent handler
- *  It releases all (currently only strmarray_lock) after fork in the parent process
+ *  It releases all (strmarray_lock and the object pool locks) after fork in the parent process
  */
 void
 tpp_client_postfork_parent()
 {
+	tpp_pool_postfork_parent();
 	tpp_unlock(&strmarray_lock);
 }
 
 /**
  * @brief
  *	tpp leaf postfork child handler
- *  Initialize a new strmarray_lock for the child and
- *  then call tpp_terminate()
+ *  Initialize a new strmarray_lock and object pool locks for the child
+ *  and then call tpp_terminate()
  */
 void
 tpp_client_postfork_child()
 {
 	tpp_init_lock(&strmarray_lock);
+	tpp_pool_postfork_child();
 	tpp_terminate();
 }
 
@@ -1113,6 +1118,41 @@ get_active_router(int index)
 	return -1;
 }
 
+/**
+ * @brief
+ *	Pick the compression codec to use for data sent on a stream
+ *
+ * @par Functionality:
+ *	The lz codec is used when the peer advertised it can decode it, or for
+ *	a multicast stream, when every member peer did. Otherwise fall back to
+ *	zlib, which every leaf understands.
+ *
+ * @param[in] strm - The stream data is sent on
+ *
+ * @return - codec id (enum tpp_codec_id)
+ *
+ * @par MT-safe: No
+ *
+ */
+static int
+get_strm_codec(stream_t *strm)
+{
+	stream_t *m;
+	int i;
+
+	if (strm->strm_type != TPP_STRM_MCAST)
+		return (strm->peer_cmpr_caps & TPP_CMPR_CAP_LZ) ? TPP_CODEC_LZ : TPP_CODEC_ZLIB;
+
+	if (!strm->mcast_data)
+		return TPP_CODEC_ZLIB;
+	for (i = 0; i < strm->mcast_data->num_fds; i++) {
+		m = get_strm_atomic(strm->mcast_data->strms[i]);
+		if (!m || !(m->peer_cmpr_caps & TPP_CMPR_CAP_LZ))
+			return TPP_CODEC_ZLIB;
+	}
+	return TPP_CODEC_LZ;
+}
+
 /**
  * @brief
  *	Sends data to a stream
@@ -1142,8 +1182,10 @@ tpp_send(int sd, void *data, int len)
 	void *p;
 	unsigned int cmprsd_len = 0;
 	tpp_packet_t *pkt = NULL;
+	stream_t *strm;
+	int codec;
 
-	if (!get_strm(sd)) {
+	if (!(strm = get_strm(sd))) {
 		TPP_DBPRT(("Bad sd %d", sd));
 		return -1;
 	}
@@ -1153,20 +1195,22 @@ tpp_send(int sd, void *data, int len)
 	if ((tpp_conf->compress == 1) && (len > TPP_COMPR_SIZE)) {
 		void *outbuf;
 
-		outbuf = tpp_deflate(data, len, &cmprsd_len);
-		if (outbuf == NULL) {
-			tpp_log_func(LOG_CRIT, __func__, "tpp deflate failed");
-			return -1;
-		}
-		pkt = tpp_cr_pkt(outbuf, cmprsd_len, 0);
-		if (pkt == NULL) {
-			free(outbuf);
-			return -1;
+		codec = get_strm_codec(strm);
+		if (tpp_compr_wanted(codec, len) &&
+			(outbuf = tpp_compress(codec, data, len, &cmprsd_len)) != NULL) {
+			pkt = tpp_cr_pkt(outbuf, cmprsd_len, 0);
+			if (pkt == NULL) {
+				free(outbuf);
+				return -1;
+			}
 		}
+	}
 
+	if (pkt) {
 		p = pkt->data;
 		to_send = cmprsd_len;
 	} else {
+		/* not compressed, or compression did not make it smaller */
 		p = data;
 		cmprsd_len = len;
 		to_send = len;
@@ -1240,6 +1284,7 @@ tpp_send_inner(int sd, void *data, int len, int full_len, int cmprsd_len)
 
 	dhdr.ack_seq = htonl(UNINITIALIZED_INT);
 	dhdr.dup = 0;
+	dhdr.cmpr_caps = TPP_CMPR_CAPS;
 	dhdr.cmprsd_len = htonl(cmprsd_len);
 	dhdr.totlen = htonl(full_len);
 	memcpy(&dhdr.src_addr, &strm->src_addr, sizeof(tpp_addr_t));
@@ -2238,6 +2283,10 @@ tpp_mcast_send(int mtfd, void *data, unsigned int len, unsigned int full_len, un
 	chunks[0].len = sizeof(tpp_mcast_pkt_hdr_t);
 	totlen = chunks[0].len;
 
+	/*
+	 * The member info is read by the routers, which do not advertise
+	 * codecs like leaves do, so it stays on zlib whatever the data uses
+	 */
 	if (tpp_conf->compress == 1 && minfo_len > TPP_COMPR_SIZE) {
 		def_ctx = tpp_multi_deflate_init(minfo_len);
 		if (def_ctx == NULL)
@@ -2841,6 +2890,7 @@ shelve_mcast_pkt(tpp_mcast_pkt_hdr_t *mcast_hdr, int sd, int seq, tpp_packet_t *
 
 	indiv_dhdr.ack_seq = htonl(UNINITIALIZED_INT);
 	indiv_dhdr.dup = 1;
+	indiv_dhdr.cmpr_caps = TPP_CMPR_CAPS;
 
 	indiv_dhdr.cmprsd_len = mcast_hdr->data_cmprsd_len;
 	indiv_dhdr.totlen = mcast_hdr->totlen;
@@ -2949,6 +2999,7 @@ send_ack_packet(ack_info_t *ack)
 	dhdr.seq_no = htonl(ack->seq_no); /* seq no to ack */
 	dhdr.ack_seq = dhdr.seq_no; /* same as seq_no */
 	dhdr.dup = 0;
+	dhdr.cmpr_caps = TPP_CMPR_CAPS;
 	memcpy(&dhdr.src_addr, &strm->src_addr, sizeof(tpp_addr_t));
 	memcpy(&dhdr.dest_addr, &strm->dest_addr, sizeof(tpp_addr_t));
 
@@ -3032,6 +3083,7 @@ send_retry_packet(tpp_packet_t *pkt)
 			return -1;
 
 		pkt->data = p;
+		pkt->data_pool = -1; /* realloc'd, no longer fits its pool */
 		pkt->pos = pkt->data + pkt->len;
 		pkt->len = totlen;
 		totlen = htonl(pkt->len - sizeof(int)); /* the length of the whole packet without the leading int */
@@ -3376,6 +3428,7 @@ leaf_timer_handler(time_t now)
 	check_pending_acks(now);
 	check_retries(now);
 	act_strm(now, 0);
+	tpp_pool_log_stats(now);
 
 	return leaf_next_event_expiry(now);
 }
@@ -3576,7 +3629,7 @@ add_part_packet(stream_t *strm, void *data, int sz)
 			tpp_packet_t *tmp = obj;
 			void *uncmpr_data;
 
-			if ((uncmpr_data = tpp_inflate(tmp->data, cmprsd_len, totlen))) {
+			if ((uncmpr_data = tpp_decompress(tmp->data, cmprsd_len, totlen))) {
 				obj = tpp_cr_pkt(uncmpr_data, totlen, 0);
 				if (!obj)
 					free(uncmpr_data);
@@ -3680,6 +3733,7 @@ send_spl_packet(stream_t *strm, int type)
 
 	dhdr.ack_seq = htonl(UNINITIALIZED_INT);
 	dhdr.dup = 0;
+	dhdr.cmpr_caps = TPP_CMPR_CAPS;
 	memcpy(&dhdr.src_addr, &strm->src_addr, sizeof(tpp_addr_t));
 	memcpy(&dhdr.dest_addr, &strm->dest_addr, sizeof(tpp_addr_t));
 
@@ -3973,8 +4027,7 @@ leaf_pkt_presend_handler(int tfd, tpp_packet_t *pkt, void *extra)
 		newpktlen = len_out + sizeof(int) + 1;
 		pktdata = malloc(newpktlen);
 		if (pktdata != NULL) {
-			free(pkt->data);
-			pkt->data = pktdata;
+			tpp_pkt_set_data(pkt, pktdata);
 		} else {
 			free(data_out);
 			tpp_log_func(LOG_CRIT, __func__, "malloc failure");
@@ -4039,8 +4092,7 @@ leaf_pkt_postsend_handler(int tfd, tpp_packet_t *pkt, void *extra)
 			return -1;
 		}
 
-		free(pkt->data);
-		pkt->data = authdata->cleartext;
+		tpp_pkt_set_data(pkt, authdata->cleartext);
 		pkt->len = authdata->cleartext_len;
 		pkt->pos = pkt->data;
 
@@ -4552,6 +4604,13 @@ leaf_pkt_handler(int tfd, void *data, int len, void *ctx, void *extra)
 			strm->dest_sd = src_sd; /* next time outgoing will have dest_fd */
 			strm->dest_magic = src_magic; /* used for matching next time onwards */
 
+			/*
+			 * packets the router fans out from a multicast carry no
+			 * capabilities, keep what the peer itself told us
+			 */
+			if (p->cmpr_caps)
+				strm->peer_cmpr_caps = p->cmpr_caps;
+
 			seq_no_expected = strm->seq_no_expected;
 			TPP_DBPRT(("sequence_no expected = %u", seq_no_expected));
 
@@ -1108,7 +1108,7 @@ tpp_mbox_read(tpp_mbox_t *mbox, unsigned int *tfd, int *cmdval, void **data)
 	*cmdval = cmd->cmdval;
 	*data = cmd->data;
 
-	free(cmd);
+	tpp_pool_put(TPP_POOL_CMD, cmd);
 	return 0;
 }
 
@@ -1147,7 +1147,7 @@ tpp_mbox_clear(tpp_mbox_t *mbox, tpp_que_elem_t **n, unsigned int tfd, int *cmdv
 			*n = tpp_que_del_elem(&mbox->mbox_queue, *n);
 			*cmdval = cmd->cmdval;
 			*data = cmd->data;
-			free(cmd);
+			tpp_pool_put(TPP_POOL_CMD, cmd);
 			ret = 0;
 			break;
 		}
@@ -1189,7 +1189,7 @@ tpp_mbox_post(tpp_mbox_t *mbox, unsigned int tfd, int cmdval, void *data)
 #endif
 
 	errno = 0;
-	cmd = malloc(sizeof(tpp_cmd_t));
+	cmd = tpp_pool_get(TPP_POOL_CMD);
 	if (!cmd) {
 		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Out of memory in em_mbox_post");
 		tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
@@ -1203,6 +1203,7 @@ tpp_mbox_post(tpp_mbox_t *mbox, unsigned int tfd, int cmdval, void *data)
 	tpp_lock(&mbox->mbox_mutex);
 	if (tpp_enque(&mbox->mbox_queue, cmd) == NULL) {
 		tpp_unlock(&mbox->mbox_mutex);
+		tpp_pool_put(TPP_POOL_CMD, cmd);
 		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Out of memory in em_mbox_post");
 		tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
 		return -1;
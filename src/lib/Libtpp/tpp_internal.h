@@ -49,6 +49,9 @@ extern "C" {
 #include <pthread.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#ifndef WIN32
+#include <sys/uio.h>
+#endif
 #include "log.h"
 
 #include "tpp.h"
@@ -67,6 +70,7 @@ extern "C" {
 #define tpp_sock_connect(a, b, c)      connect(a, b, c)
 #define tpp_sock_recv(a, b, c, d)       recv(a, b, c, d)
 #define tpp_sock_send(a, b, c, d)       send(a, b, c, d)
+#define tpp_sock_writev(a, b, c)        writev(a, b, c)
 #define tpp_sock_select(a, b, c, d, e)   select(a, b, c, d, e)
 #define tpp_sock_close(a)            close(a)
 #define tpp_sock_getsockopt(a, b, c, d, e)   getsockopt(a, b, c, d, e)
@@ -89,6 +93,11 @@ int tpp_sock_bind(int, const struct sockaddr *, int);
 int tpp_sock_connect(int, const struct sockaddr *, int);
 int tpp_sock_recv(int, char *, int, int);
 int tpp_sock_send(int, const char *, int, int);
+struct iovec {
+	void *iov_base;
+	size_t iov_len;
+};
+int tpp_sock_writev(int, const struct iovec *, int);
 int tpp_sock_select(int, fd_set *, fd_set *, fd_set *, const struct timeval *);
 int tpp_sock_close(int);
 int tpp_sock_getsockopt(int, int, int, int *, int *);
@@ -145,6 +154,7 @@ typedef struct {
 	char *pos;	/* current position - till which data is consumed */
 	void *extra_data;	/* any additional data */
 	int ref_count;	/* number of accessors */
+	int data_pool;	/* pool the data buffer came from, -1 if malloc'd */
 } tpp_packet_t;
 
 /*
@@ -208,6 +218,7 @@ typedef struct {
 typedef struct {
 	unsigned char type;        /* type of the packet - TPP_DATA, JOIN etc */
 	unsigned char dup;         /* Is this a duplicate packet? */
+	unsigned char cmpr_caps;   /* compression codecs the sender can decode */
 
 	unsigned int src_magic;    /* magic id of source stream */
 	unsigned int cmprsd_len;   /* length of compressed data, 0 if not compressed */
@@ -238,6 +249,13 @@ typedef struct {
 	tpp_addr_t src_addr;     /* source host address */
 } tpp_mcast_pkt_hdr_t;
 
+/*
+ * hop of a multicast packet that a relaying pbs_comm sends back to the
+ * pbs_comm it came from, with the members it has no route to. The sender
+ * splits these flat, without relaying them again.
+ */
+#define TPP_MCAST_HOP_RETURN	2
+
 /*
  * Structure describing information about each member stream.
  * The overall packet includes a mcast header and multiple member stream
@@ -285,6 +303,31 @@ enum TPP_MSG_TYPES {
 #define TPP_MIN_WAIT            2
 #define TPP_SEND_SIZE           8192
 #define TPP_COMPR_SIZE          8192
+#define TPP_COMPR_MAX_SIZE      (64 * 1024 * 1024)
+#define TPP_COMPR_PROBE         32   /* compress every Nth message under the threshold */
+#define TPP_COMPR_MIN_GAIN      125  /* bytes saved per usec of cpu that make compression worth it */
+
+/*
+ * Compression codecs. Data is compressed end to end between leaves, so
+ * the codec is picked per stream from the capabilities the peer
+ * advertises in cmpr_caps of its data packets. A peer that advertises
+ * nothing is an older leaf and only understands zlib.
+ */
+enum tpp_codec_id {
+	TPP_CODEC_ZLIB = 0,
+	TPP_CODEC_LZ,
+	TPP_CODEC_MAX
+};
+
+#define TPP_CMPR_CAP_ZLIB       0x1
+#define TPP_CMPR_CAP_LZ         0x2
+#ifdef PBS_COMPRESSION_ENABLED
+#define TPP_CMPR_CAPS           (TPP_CMPR_CAP_ZLIB | TPP_CMPR_CAP_LZ)
+#else
+#define TPP_CMPR_CAPS           TPP_CMPR_CAP_LZ
+#endif
+
+#define TPP_LZ_MAGIC            0x4c /* first byte of lz data, never a zlib header */
 
 /* tpp cmds used internally by the layer to notify messages between threads */
 #define TPP_CMD_SEND            1
@@ -301,6 +344,7 @@ enum TPP_MSG_TYPES {
 
 #define TPP_DEF_ROUTER_PORT     17001
 #define TPP_SCRATCHSIZE         8192
+#define TPP_SEND_IOVCNT         64	/* max pkts gathered into one send */
 
 #define TPP_ROUTER_STATE_DISCONNECTED	0   /* Leaf not connected to router */
 #define TPP_ROUTER_STATE_CONNECTING		1   /* Leaf is connecting to router */
@@ -391,6 +435,37 @@ typedef struct {
 #endif
 } tpp_mbox_t;
 
+/*
+ * Object pools recycling the packets, packet data buffers, queue elements
+ * and mbox commands that would otherwise be malloc'd and freed for every
+ * message. Each thread caches free objects in its TLS, and moves them in
+ * batches to and from a depot shared by all threads.
+ */
+enum tpp_pool_id {
+	TPP_POOL_PKT = 0,	/* tpp_packet_t */
+	TPP_POOL_QUE_ELEM,	/* tpp_que_elem_t */
+	TPP_POOL_CMD,		/* tpp_cmd_t */
+	TPP_POOL_DATA_SMALL,	/* packet data, smallest size class */
+	TPP_POOL_DATA_MEDIUM,
+	TPP_POOL_DATA_LARGE,	/* packet data, largest size class */
+	TPP_POOL_MAX
+};
+
+typedef struct {
+	void *free_list;	/* free objects cached by this thread */
+	int count;		/* number of objects in free_list */
+	unsigned long hits;	/* allocations served from the pool */
+	unsigned long misses;	/* allocations that had to malloc a batch */
+} tpp_pool_cache_t;
+
+#define TPP_POOL_STATS_INTERVAL	300 /* seconds between pool stats logs */
+
+typedef struct {
+	unsigned int threshold;	/* compress messages larger than this */
+	unsigned int gain;	/* average bytes saved per usec of cpu */
+	unsigned int skipped;	/* messages under the threshold since the last probe */
+} tpp_compr_stat_t;
+
 
 /* quickie macros to work with queues */
 #define TPP_QUE_CLEAR(q)   (q)->head = NULL; (q)->tail = NULL
@@ -403,6 +478,8 @@ typedef struct {
 	void *td;
 	char tpplogbuf[TPP_LOGBUF_SZ];
 	char tppstaticbuf[TPP_LOGBUF_SZ];
+	tpp_pool_cache_t pool_cache[TPP_POOL_MAX];
+	tpp_compr_stat_t compr_stat[TPP_CODEC_MAX];
 } tpp_tls_t;
 
 typedef struct {
@@ -438,6 +515,13 @@ char *tpp_get_logbuf(void);
 char *mk_hostname(char *, int);
 struct sockaddr_in* tpp_localaddr(int);
 tpp_packet_t *tpp_cr_pkt(void *, int, int);
+void tpp_pkt_set_data(tpp_packet_t *, void *);
+void *tpp_pool_get(int);
+void tpp_pool_put(int, void *);
+void tpp_pool_log_stats(time_t);
+void tpp_pool_prefork(void);
+void tpp_pool_postfork_parent(void);
+void tpp_pool_postfork_child(void);
 
 void tpp_router_terminate(void);
 void tpp_free_tls(void);
@@ -493,6 +577,9 @@ int tpp_set_keep_alive(int, struct tpp_config *);
 
 void *tpp_deflate(void *, unsigned int, unsigned int *);
 void *tpp_inflate(void *, unsigned int, unsigned int);
+int tpp_compr_wanted(int, unsigned int);
+void *tpp_compress(int, void *, unsigned int, unsigned int *);
+void *tpp_decompress(void *, unsigned int, unsigned int);
 void *tpp_multi_deflate_init(int);
 int tpp_multi_deflate_do(void *, int, void *, unsigned int);
 void *tpp_multi_deflate_done(void *, unsigned int *);
@@ -372,6 +372,30 @@ tpp_sock_send(int s, const char *buf, int len, int flags)
 	return ret;
 }
 
+/*
+ * emulate writev() with windows send(), stopping at the
+ * first buffer that could not be sent out completely
+ */
+int
+tpp_sock_writev(int s, const struct iovec *iov, int iovcnt)
+{
+	int i;
+	int ret;
+	int total = 0;
+
+	for (i = 0; i < iovcnt; i++) {
+		if (iov[i].iov_len == 0)
+			continue;
+		ret = tpp_sock_send(s, iov[i].iov_base, (int) iov[i].iov_len, 0);
+		if (ret == -1)
+			return (total > 0) ? total : -1;
+		total += ret;
+		if (ret < (int) iov[i].iov_len)
+			break;
+	}
+	return total;
+}
+
 /*
  * wrapper to call windows select() and map windows
  * error code to errno and massage the return value
@@ -107,7 +107,6 @@ static int router_pkt_presend_handler(int tfd, tpp_packet_t *pkt, void *extra);
 static int router_pkt_handler(int phy_fd, void *data, int len, void *c, void *extra);
 static int router_close_handler(int phy_con, int error, void *c, void *extra);
 static int send_leaves_to_router(tpp_router_t *parent, tpp_router_t *target);
-static tpp_router_t *get_preferred_router(tpp_leaf_t *l, tpp_router_t *this_router, int *fd);
 static int add_route_to_leaf(tpp_leaf_t *l, tpp_router_t *r, int index);
 static tpp_router_t *del_router_from_leaf(tpp_leaf_t *l, int tfd);
 static int leaf_get_router_index(tpp_leaf_t *l, tpp_router_t *r);
@@ -117,6 +116,404 @@ static int router_post_connect_handler(int tfd, void *data, void *c, void *extra
 /* structure identifying this router */
 static tpp_router_t *this_router = NULL;
 
+/*
+ * Hashed routing table used by the forwarding path. It maps each address
+ * in cluster_leaves_idx to its leaf, and is read by the IO threads without
+ * taking router_lock. Writers hold router_lock and follow RCU rules: a
+ * route is linked in only once complete, and a route, leaf, route list or
+ * table that is unlinked is retired rather than freed. Retired memory is
+ * freed once no IO thread is in a lookup that started before it was
+ * unlinked. Each IO thread publishes the epoch at which its current lookup
+ * started, or 0 when it is not in a lookup.
+ */
+typedef struct leaf_route {
+	tpp_addr_t addr;		/* address of the leaf */
+	tpp_leaf_t *leaf;
+	struct leaf_route *next;	/* next route in the hash bucket */
+} leaf_route_t;
+
+typedef struct {
+	unsigned int size;		/* number of buckets, a power of 2 */
+	unsigned int count;		/* number of routes */
+	leaf_route_t **buckets;
+} leaf_route_tbl_t;
+
+typedef struct {
+	unsigned long epoch;		/* epoch the lookup started at, 0 if none */
+	char pad[64 - sizeof(unsigned long)]; /* one cache line per thread */
+} route_reader_t;
+
+typedef struct route_retired {
+	void *ptr;
+	void (*free_func)(void *);
+	unsigned long epoch;		/* epoch at which ptr was unlinked */
+	struct route_retired *next;
+} route_retired_t;
+
+#define ROUTE_TBL_INIT_SIZE 1024
+
+#define ROUTE_LOAD(p)		__atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define ROUTE_STORE(p, v)	__atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+static leaf_route_tbl_t *leaf_routes = NULL;
+static route_reader_t *route_readers = NULL;
+static int route_num_readers = 0;
+static unsigned long route_epoch = 1;
+static route_retired_t *route_retired = NULL;
+
+/**
+ * @brief
+ *	Hash a leaf address into the routing table
+ *
+ * @param[in] - addr - The address
+ *
+ * @return	FNV-1a hash of the address
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static unsigned int
+route_hash(tpp_addr_t *addr)
+{
+	unsigned char *p = (unsigned char *) addr;
+	unsigned int h = 2166136261u;
+	size_t i;
+
+	for (i = 0; i < sizeof(tpp_addr_t); i++) {
+		h ^= p[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/**
+ * @brief
+ *	Allocate an empty routing table
+ *
+ * @param[in] - size - Number of buckets, a power of 2
+ *
+ * @return	The table
+ * @retval	NULL - Out of memory
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static leaf_route_tbl_t *
+route_tbl_alloc(unsigned int size)
+{
+	leaf_route_tbl_t *tbl;
+
+	if ((tbl = malloc(sizeof(leaf_route_tbl_t))) == NULL)
+		return NULL;
+	if ((tbl->buckets = calloc(size, sizeof(leaf_route_t *))) == NULL) {
+		free(tbl);
+		return NULL;
+	}
+	tbl->size = size;
+	tbl->count = 0;
+	return tbl;
+}
+
+/**
+ * @brief
+ *	Free a routing table and the routes in it
+ *
+ * @param[in] - p - The table
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+route_tbl_free(void *p)
+{
+	leaf_route_tbl_t *tbl = p;
+	leaf_route_t *e;
+	unsigned int i;
+
+	for (i = 0; i < tbl->size; i++) {
+		while ((e = tbl->buckets[i]) != NULL) {
+			tbl->buckets[i] = e->next;
+			free(e);
+		}
+	}
+	free(tbl->buckets);
+	free(tbl);
+}
+
+/**
+ * @brief
+ *	Free a retired leaf, along with its list of routers
+ *
+ * @param[in] - p - The leaf
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+route_free_leaf(void *p)
+{
+	tpp_leaf_t *l = p;
+
+	free(l->r);
+	free_leaf(l);
+}
+
+/**
+ * @brief
+ *	Free a retired router
+ *
+ * @param[in] - p - The router
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+route_free_router(void *p)
+{
+	free_router((tpp_router_t *) p);
+}
+
+/**
+ * @brief
+ *	Free the retired memory that no lookup can still see.
+ *	Must be called with router_lock held.
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+route_reclaim(void)
+{
+	route_retired_t *rt;
+	route_retired_t **prev;
+	unsigned long oldest = 0;
+	unsigned long e;
+	int i;
+
+	if (route_retired == NULL)
+		return;
+
+	for (i = 0; i < route_num_readers; i++) {
+		e = __atomic_load_n(&route_readers[i].epoch, __ATOMIC_SEQ_CST);
+		if (e != 0 && (oldest == 0 || e < oldest))
+			oldest = e;
+	}
+
+	prev = &route_retired;
+	while ((rt = *prev) != NULL) {
+		if (oldest == 0 || rt->epoch < oldest) {
+			*prev = rt->next;
+			rt->free_func(rt->ptr);
+			free(rt);
+		} else
+			prev = &rt->next;
+	}
+}
+
+/**
+ * @brief
+ *	Retire memory that was unlinked from the routing table, to be freed
+ *	once no lookup can still see it. Must be called with router_lock held.
+ *
+ * @param[in] - ptr - The memory
+ * @param[in] - free_func - Function to free it with
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+route_retire(void *ptr, void (*free_func)(void *))
+{
+	route_retired_t *rt;
+
+	if ((rt = malloc(sizeof(route_retired_t))) == NULL) {
+		tpp_log_func(LOG_CRIT, __func__, "Out of memory retiring route, leaking it");
+		return;
+	}
+	rt->ptr = ptr;
+	rt->free_func = free_func;
+	rt->epoch = route_epoch;
+	rt->next = route_retired;
+	route_retired = rt;
+
+	/* lookups starting from now on cannot see ptr */
+	__atomic_store_n(&route_epoch, route_epoch + 1, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief
+ *	Add a route to a leaf address, growing the table if it has become
+ *	crowded. Must be called with router_lock held.
+ *
+ * @param[in] - addr - The address of the leaf
+ * @param[in] - l - The leaf
+ *
+ * @return	Error code
+ * @retval	-1 - Out of memory
+ * @retval	 0 - Success
+ *
+ * @par MT-safe: No
+ *
+ */
+static int
+route_add(tpp_addr_t *addr, tpp_leaf_t *l)
+{
+	leaf_route_tbl_t *tbl = leaf_routes;
+	leaf_route_tbl_t *ntbl;
+	leaf_route_t *e;
+	leaf_route_t *ne;
+	unsigned int h;
+	unsigned int i;
+
+	if (tbl->count >= tbl->size * 2) {
+		/* build a bigger table aside, since routes in use cannot move */
+		if ((ntbl = route_tbl_alloc(tbl->size * 4)) != NULL) {
+			for (i = 0; i < tbl->size; i++) {
+				for (e = tbl->buckets[i]; e; e = e->next) {
+					if ((ne = malloc(sizeof(leaf_route_t))) == NULL)
+						break;
+					*ne = *e;
+					h = route_hash(&ne->addr) & (ntbl->size - 1);
+					ne->next = ntbl->buckets[h];
+					ntbl->buckets[h] = ne;
+					ntbl->count++;
+				}
+				if (e)
+					break;
+			}
+			if (i == tbl->size) {
+				ROUTE_STORE(&leaf_routes, ntbl);
+				route_retire(tbl, route_tbl_free);
+				tbl = ntbl;
+			} else
+				route_tbl_free(ntbl); /* stay with the crowded table */
+		}
+	}
+
+	if ((e = malloc(sizeof(leaf_route_t))) == NULL)
+		return -1;
+	memcpy(&e->addr, addr, sizeof(tpp_addr_t));
+	e->leaf = l;
+	h = route_hash(addr) & (tbl->size - 1);
+	e->next = tbl->buckets[h];
+	ROUTE_STORE(&tbl->buckets[h], e);
+	tbl->count++;
+	return 0;
+}
+
+/**
+ * @brief
+ *	Remove the route to a leaf address. Must be called with router_lock
+ *	held.
+ *
+ * @param[in] - addr - The address of the leaf
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+route_del(tpp_addr_t *addr)
+{
+	leaf_route_tbl_t *tbl = leaf_routes;
+	leaf_route_t **prev;
+	leaf_route_t *e;
+
+	prev = &tbl->buckets[route_hash(addr) & (tbl->size - 1)];
+	while ((e = *prev) != NULL) {
+		if (memcmp(&e->addr, addr, sizeof(tpp_addr_t)) == 0) {
+			ROUTE_STORE(prev, e->next);
+			tbl->count--;
+			route_retire(e, free);
+			return;
+		}
+		prev = &e->next;
+	}
+}
+
+/**
+ * @brief
+ *	Find the connection to forward data for a leaf address on, without
+ *	taking router_lock when called by an IO thread.
+ *	If the leaf is directly connected to this router, its conn_fd is used.
+ *	If not, its list of routers is searched from index 0 (since it is
+ *	sorted on preference) for a router that is still connected.
+ *
+ * @param[in] - addr - The address of the leaf
+ * @param[out] - target - The router to forward via, NULL if none connected
+ * @param[out] - fd - The connection to forward on
+ *
+ * @return	Error code
+ * @retval	-1 - No leaf with this address
+ * @retval	 0 - Leaf found
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static int
+route_find(tpp_addr_t *addr, tpp_router_t **target, int *fd)
+{
+	route_reader_t *rd = NULL;
+	leaf_route_tbl_t *tbl;
+	leaf_route_t *e;
+	tpp_router_t **rl;
+	tpp_router_t *r;
+	tpp_leaf_t *l = NULL;
+	unsigned long epoch;
+	int thrd_index;
+	int tot;
+	int i;
+
+	*target = NULL;
+	*fd = -1;
+
+	thrd_index = tpp_get_thrd_index();
+	if (thrd_index >= 0 && thrd_index < route_num_readers) {
+		rd = &route_readers[thrd_index];
+		/*
+		 * Publish the epoch, then check it is still current. Memory
+		 * retired between loading and publishing it could otherwise be
+		 * reclaimed as if this thread were not in a lookup.
+		 */
+		do {
+			epoch = __atomic_load_n(&route_epoch, __ATOMIC_SEQ_CST);
+			__atomic_store_n(&rd->epoch, epoch, __ATOMIC_SEQ_CST);
+			__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		} while (__atomic_load_n(&route_epoch, __ATOMIC_SEQ_CST) != epoch);
+	} else
+		tpp_lock(&router_lock); /* not an IO thread */
+
+	tbl = ROUTE_LOAD(&leaf_routes);
+	for (e = ROUTE_LOAD(&tbl->buckets[route_hash(addr) & (tbl->size - 1)]); e; e = ROUTE_LOAD(&e->next)) {
+		if (memcmp(&e->addr, addr, sizeof(tpp_addr_t)) == 0) {
+			l = e->leaf;
+			break;
+		}
+	}
+
+	if (l) {
+		if ((*fd = ROUTE_LOAD(&l->conn_fd)) != -1) {
+			*target = this_router;
+		} else {
+			tot = ROUTE_LOAD(&l->tot_routers);
+			rl = ROUTE_LOAD(&l->r);
+			for (i = 0; rl && i < tot; i++) {
+				r = ROUTE_LOAD(&rl[i]);
+				if (r && (*fd = ROUTE_LOAD(&r->conn_fd)) != -1) {
+					*target = r;
+					break;
+				}
+			}
+		}
+	}
+
+	if (rd)
+		__atomic_store_n(&rd->epoch, 0, __ATOMIC_RELEASE);
+	else
+		tpp_unlock(&router_lock);
+
+	return (l ? 0 : -1);
+}
+
 static tpp_router_t *
 alloc_router(char *name, tpp_addr_t *address)
 {
@@ -680,7 +1077,7 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 		}
 
 		if (hop == 1) {
-			l->conn_fd = -1; /* reset my direct connection fd to -1 since its closing */
+			ROUTE_STORE(&l->conn_fd, -1); /* reset my direct connection fd to -1 since its closing */
 		}
 
 		if (l->num_routers > 0) {
@@ -693,6 +1090,7 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 
 		/* delete all of this leaf's addresses from the search tree */
 		for (i = 0; i < l->num_addrs; i++) {
+			route_del(&l->leaf_addrs[i]);
 			if (pbs_idx_delete(cluster_leaves_idx, &l->leaf_addrs[i]) != PBS_IDX_RET_OK) {
 				snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "tfd=%d, Failed to delete address %s from cluster leaves", tfd, tpp_netaddr(&l->leaf_addrs[i]));
 				tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
@@ -721,7 +1119,9 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 		 */
 		broadcast_to_my_leaves(chunks, 2, tfd, 0);
 
-		free_leaf(l);
+		tpp_lock(&router_lock);
+		route_retire(l, route_free_leaf);
+		tpp_unlock(&router_lock);
 
 		return 0;
 
@@ -776,6 +1176,7 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 				}
 
 				for (i = 0; i < l->num_addrs; i++) {
+					route_del(&l->leaf_addrs[i]);
 					if (pbs_idx_delete(cluster_leaves_idx, &l->leaf_addrs[i]) != PBS_IDX_RET_OK) {
 						snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
 							"tfd=%d, Failed to delete address %s",
@@ -810,7 +1211,7 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 			 * because the del_router_from_leaf function above matches
 			 * with the routers conn_fd
 			 */
-			r->conn_fd = -1;
+			ROUTE_STORE(&r->conn_fd, -1);
 			r->state = TPP_ROUTER_STATE_DISCONNECTED;
 
 			tpp_unlock(&router_lock);
@@ -838,7 +1239,9 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 				 * a IO call (inside this function).
 				 */
 				broadcast_to_my_leaves(chunks, 2, tfd, 0);
-				free_leaf(l);
+				tpp_lock(&router_lock);
+				route_retire(l, route_free_leaf);
+				tpp_unlock(&router_lock);
 			}
 		}
 
@@ -884,13 +1287,14 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 			 **/
 			tpp_lock(&router_lock);
 			pbs_idx_delete(routers_idx, &r->router_addr);
-			tpp_unlock(&router_lock);
 
 			/*
 			 * context will be freed and deleted by router_close_handler
-			 * so just free router structure itself
+			 * so just free router structure itself, once no lookup
+			 * can still see it
 			 */
-			free_router(r);
+			route_retire(r, route_free_router);
+			tpp_unlock(&router_lock);
 		}
 
 		return 0;
@@ -985,6 +1389,7 @@ router_timer_handler(time_t now)
 	int ret = -1;
 
 	tpp_lock(&router_lock);
+	route_reclaim();
 	if (router_last_leaf_joined > 0) {
 		if ((now - router_last_leaf_joined) < 3) {
 			ret = 3; /* time not yet over, retry in the next 3 seconds */
@@ -995,6 +1400,8 @@ router_timer_handler(time_t now)
 	}
 	tpp_unlock(&router_lock);
 
+	tpp_pool_log_stats(now);
+
 	if (send_update == 1) {
 		int len;
 
@@ -1074,8 +1481,7 @@ router_pkt_presend_handler(int tfd, tpp_packet_t *pkt, void *extra)
 		newpktlen = len_out + sizeof(int) + 1;
 		pktdata = malloc(newpktlen);
 		if (pktdata != NULL) {
-			free(pkt->data);
-			pkt->data = pktdata;
+			tpp_pkt_set_data(pkt, pktdata);
 		} else {
 			free(data_out);
 			tpp_log_func(LOG_CRIT, __func__, "malloc failure");
@@ -1352,7 +1758,7 @@ router_pkt_handler(int tfd, void *data, int len, void *c, void *extra)
 						return -1;
 					}
 				}
-				r->conn_fd = tfd;
+				ROUTE_STORE(&r->conn_fd, tfd);
 				r->initiator = 0;
 				r->state = TPP_ROUTER_STATE_CONNECTED;
 
@@ -1476,7 +1882,7 @@ router_pkt_handler(int tfd, void *data, int len, void *c, void *extra)
 							free(data_out);
 						return -1;
 					}
-					l->conn_fd = tfd;
+					ROUTE_STORE(&l->conn_fd, tfd);
 
 					/*
 					 * Set a context only if the JOIN came from a direct connection
@@ -1529,7 +1935,14 @@ router_pkt_handler(int tfd, void *data, int len, void *c, void *extra)
 					 * since this is the primary "routing table"
 					 */
 					for (i = 0; i < l->num_addrs; i++) {
-						if (pbs_idx_insert(cluster_leaves_idx, &l->leaf_addrs[i], l) != PBS_IDX_RET_OK) {
+						if (pbs_idx_insert(cluster_leaves_idx, &l->leaf_addrs[i], l) == PBS_IDX_RET_OK) {
+							if (route_add(&l->leaf_addrs[i], l) != 0) {
+								sprintf(tpp_get_logbuf(), "tfd=%d, Failed to add route to address %s",
+										tfd, tpp_netaddr(&l->leaf_addrs[i]));
+								tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
+								fatal++;
+							}
+						} else {
 							void *unused;
 							void *pleaf_addr = &l->leaf_addrs[i];
 							if (pbs_idx_find(cluster_leaves_idx, &pleaf_addr, &unused, NULL) == PBS_IDX_RET_OK) {
@@ -1690,6 +2103,7 @@ router_pkt_handler(int tfd, void *data, int len, void *c, void *extra)
 			typedef struct {
 				int target_fd; /* target comm fd */
 				int num_streams; /* actual number of destination streams */
+				int num_routers; /* routers the target comm relays to, itself included */
 				char *router_name;
 				void *cmpr_ctx;
 				void *minfo_buf; /* allocate size for total members */
@@ -1698,6 +2112,14 @@ router_pkt_handler(int tfd, void *data, int len, void *c, void *extra)
 			target_comm_struct_t *rlist = NULL;
 			int rsize = 0;
 			int csize = 0;
+			int *seen = NULL; /* fds of the target comms, in the order found */
+			int seen_size = 0;
+			int nseen = 0;
+			int fanout = tpp_conf->mcast_fanout;
+			int relayed = 0; /* a relaying pbs_comm sent us members to split */
+			void *back_buf = NULL; /* members to return to that pbs_comm */
+			int nback = 0;
+			int rc;
 			void *tmp;
 			tpp_chunk_t mchunks[3]; /* mcast packet has 3 chunks */
 
@@ -1725,6 +2147,13 @@ router_pkt_handler(int tfd, void *data, int len, void *c, void *extra)
 
 			src_host = &mhdr->src_addr;
 			orig_hop = mhdr->hop;
+			if (orig_hop == 0 && ctx != NULL && ctx->type == TPP_ROUTER_NODE)
+				relayed = 1;
+			else if (orig_hop == TPP_MCAST_HOP_RETURN) {
+				/* a relay could not reach these, send each to its own comm */
+				orig_hop = 0;
+				fanout = 0;
+			}
 
 			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
 				"tfd=%d, MCAST packet from %s, %u member streams, cmprsd_len=%d, info_len=%d, len=%d",
@@ -1767,7 +2196,6 @@ router_pkt_handler(int tfd, void *data, int len, void *c, void *extra)
 			for (k = num_streams - 1; k >= 0; k--) {
 				tpp_addr_t *dest_host;
 				unsigned int src_sd;
-				tpp_leaf_t *l = NULL;
 
 				minfo = (tpp_mcast_pkt_info_t *)(((char *) minfo_base) + k * sizeof(tpp_mcast_pkt_info_t));
 
@@ -1776,21 +2204,35 @@ router_pkt_handler(int tfd, void *data, int len, void *c, void *extra)
 
 				TPP_DBPRT(("MCAST data on fd=%u", src_sd));
 
-				tpp_lock(&router_lock);
-				pbs_idx_find(cluster_leaves_idx, (void **)&dest_host, (void **)&l, NULL);
-				if (l == NULL) {
+				/* find a router that is still connected */
+				rc = route_find(dest_host, &target_router, &target_fd);
+
+				/*
+				 * A comm only knows the leaves of the comms next to it, so a
+				 * relayed member may be out of our reach though the sender
+				 * reaches it. Return such members to the sender.
+				 */
+				if (relayed && (rc != 0 || target_router == NULL || target_fd == tfd)) {
+					if (back_buf == NULL) {
+						back_buf = malloc(sizeof(tpp_mcast_pkt_info_t) * num_streams);
+						if (!back_buf) {
+							tpp_log_func(LOG_CRIT, __func__, "Out of memory allocating mcast return buffer");
+							goto mcast_err;
+						}
+					}
+					memcpy((char *) back_buf + nback * sizeof(tpp_mcast_pkt_info_t), minfo, sizeof(tpp_mcast_pkt_info_t));
+					nback++;
+					continue;
+				}
+
+				if (rc != 0) {
 					char msg[TPP_LOGBUF_SZ];
-					tpp_unlock(&router_lock);
 					snprintf(msg, TPP_LOGBUF_SZ, "pbs_comm:%s: Dest not found at pbs_comm", tpp_netaddr(&this_router->router_addr));
 					log_noroute(src_host, dest_host, src_sd, msg);
 					tpp_send_ctl_msg(tfd, TPP_MSG_NOROUTE, src_host, dest_host, src_sd, 0, msg);
 					continue;
 				}
 
-				/* find a router that is still connected */
-				target_router = get_preferred_router(l, this_router, &target_fd);
-				tpp_unlock(&router_lock);
-
 				if (target_router == NULL) {
 					char msg[TPP_LOGBUF_SZ];
 					snprintf(msg, TPP_LOGBUF_SZ, "pbs_comm:%s: No target pbs_comm found", tpp_netaddr(&this_router->router_addr));
@@ -1816,6 +2258,8 @@ router_pkt_handler(int tfd, void *data, int len, void *c, void *extra)
 						tpp_transport_close(target_fd);
 						if (rlist)
 							free(rlist);
+						free(seen);
+						free(back_buf);
 						if (cmprsd_len > 0)
 							free(minfo_base);
 						if (data_out)
@@ -1832,14 +2276,41 @@ router_pkt_handler(int tfd, void *data, int len, void *c, void *extra)
 					 * Might be able to use a hash here for faster search
 					 **/
 					int found = -1;
-					for (i = csize - 1; i >= 0; i--) {
-						if (rlist[i].target_fd == target_fd) {
+					for (i = nseen - 1; i >= 0; i--) {
+						if (seen[i] == target_fd) {
 							found = i;
 							break;
 						}
 					}
 
 					if (found == -1) {
+						if (nseen == seen_size) {
+							tmp = realloc(seen, sizeof(int) * (seen_size + RLIST_INC));
+							if (!tmp) {
+								tpp_log_func(LOG_CRIT, __func__, "Out of memory resizing pbs_comm list");
+								goto mcast_err;
+							}
+							seen_size += RLIST_INC;
+							seen = tmp;
+						}
+						found = nseen;
+						seen[nseen++] = target_fd;
+
+						/*
+						 * Past the fan-out, the members of a comm are sent
+						 * to one of the first fanout comms found, which
+						 * relays them on, or returns those it cannot reach.
+						 * The relaying comm gets fewer members than we did,
+						 * so the tree always ends.
+						 */
+						if (fanout > 1)
+							found %= fanout;
+						if (found < csize)
+							rlist[found].num_routers++;
+					} else if (fanout > 1)
+						found %= fanout;
+
+					if (found == csize) {
 						int c_minfo_len;
 						if (csize == rsize) {
 							/* got to add, but no space */
@@ -1856,10 +2327,12 @@ router_pkt_handler(int tfd, void *data, int len, void *c, void *extra)
 						found = csize++; /* the last index, and increment post */
 						memset(&rlist[found], 0, sizeof(target_comm_struct_t));
 						rlist[found].target_fd = target_fd; /* add this fd to the list of fds to send to */
+						rlist[found].num_routers = 1;
 						rlist[found].router_name = target_router->router_name; /* keep a pointer to the router name */
 
 						/* allocate minfo_buf for this target comm */
 						c_minfo_len = sizeof(tpp_mcast_pkt_info_t) * num_streams;
+						/* member info between routers stays on zlib, see tpp_mcast_send() */
 						if (tpp_conf->compress == 1 && c_minfo_len > TPP_COMPR_SIZE) {
 							rlist[found].cmpr_ctx = tpp_multi_deflate_init(c_minfo_len);
 							if (rlist[found].cmpr_ctx == NULL)
@@ -1910,6 +2383,8 @@ router_pkt_handler(int tfd, void *data, int len, void *c, void *extra)
 					void *t_minfo_buf = NULL;
 					unsigned int t_minfo_len = 0;
 
+					/* a comm that relays to others gets the packet as if from a leaf */
+					t_mhdr.hop = (rlist[k].num_routers > 1) ? 0 : 1;
 					t_mhdr.num_streams = htonl(rlist[k].num_streams);
 					t_minfo_len = rlist[k].num_streams * sizeof(tpp_mcast_pkt_info_t);
 					t_mhdr.info_len = htonl(t_minfo_len);
@@ -1931,7 +2406,8 @@ router_pkt_handler(int tfd, void *data, int len, void *c, void *extra)
 					mchunks[1].data = t_minfo_buf;
 					mchunks[1].len = t_minfo_len;
 
-					snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Sending MCAST packet to %s, num_streams=%d", rlist[k].router_name, rlist[k].num_streams);
+					snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Sending MCAST packet to %s, num_streams=%d, num_comms=%d",
+						rlist[k].router_name, rlist[k].num_streams, rlist[k].num_routers);
 					tpp_log_func(LOG_INFO, __func__, tpp_get_logbuf());
 					if (tpp_transport_vsend(rlist[k].target_fd, mchunks, 3) != 0) {
 						snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "send failed: errno = %d", errno);
@@ -1939,6 +2415,31 @@ router_pkt_handler(int tfd, void *data, int len, void *c, void *extra)
 					}
 				}
 			}
+
+			if (nback > 0) {
+				tpp_mcast_pkt_hdr_t b_mhdr;
+
+				memcpy(&b_mhdr, mhdr, sizeof(tpp_mcast_pkt_hdr_t));
+				b_mhdr.hop = TPP_MCAST_HOP_RETURN;
+				b_mhdr.num_streams = htonl(nback);
+				b_mhdr.info_len = htonl(nback * sizeof(tpp_mcast_pkt_info_t));
+				b_mhdr.info_cmprsd_len = 0;
+
+				mchunks[0].data = &b_mhdr;
+				mchunks[0].len = sizeof(tpp_mcast_pkt_hdr_t);
+				mchunks[1].data = back_buf;
+				mchunks[1].len = nback * sizeof(tpp_mcast_pkt_info_t);
+				mchunks[2].data = payload;
+				mchunks[2].len = payload_len;
+
+				snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Returning MCAST packet to %s, num_streams=%d",
+					tpp_netaddr(&connected_host), nback);
+				tpp_log_func(LOG_INFO, __func__, tpp_get_logbuf());
+				if (tpp_transport_vsend(tfd, mchunks, 3) != 0) {
+					snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "send failed: errno = %d", errno);
+					tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
+				}
+			}
 mcast_err:
 			if (cmprsd_len > 0)
 				free(minfo_base);
@@ -1948,6 +2449,8 @@ mcast_err:
 					free(rlist[k].minfo_buf);
 				free(rlist);
 			}
+			free(seen);
+			free(back_buf);
 
 			tpp_log_func(LOG_INFO, NULL, "mcast done");
 
@@ -1960,7 +2463,6 @@ mcast_err:
 
 		case TPP_DATA:
 		case TPP_CLOSE_STRM: {
-			tpp_leaf_t *l = NULL;
 			tpp_addr_t *src_host, *dest_host;
 			unsigned int src_sd;
 			tpp_data_pkt_hdr_t *dhdr = (tpp_data_pkt_hdr_t *) data;
@@ -1969,12 +2471,9 @@ mcast_err:
 			dest_host = &dhdr->dest_addr;
 			src_sd = ntohl(dhdr->src_sd);
 
-			tpp_lock(&router_lock);
-
-			pbs_idx_find(cluster_leaves_idx, (void **)&dest_host, (void **)&l, NULL);
-			if (l == NULL) {
+			/* find a router that is still connected */
+			if (route_find(dest_host, &target_router, &target_fd) != 0) {
 				char msg[TPP_LOGBUF_SZ];
-				tpp_unlock(&router_lock);
 
 				snprintf(msg, TPP_LOGBUF_SZ, "tfd=%d, pbs_comm:%s: Dest not found", tfd, tpp_netaddr(&this_router->router_addr));
 				log_noroute(src_host, dest_host, src_sd, msg);
@@ -1983,11 +2482,6 @@ mcast_err:
 					free(data_out);
 				return 0;
 			}
-
-			/* find a router that is still connected */
-			target_router = get_preferred_router(l, this_router, &target_fd);
-
-			tpp_unlock(&router_lock);
 			if (target_router == NULL) {
 				char msg[TPP_LOGBUF_SZ];
 				snprintf(msg, TPP_LOGBUF_SZ, "tfd=%d, pbs_comm:%s: No target pbs_comm found", tfd, tpp_netaddr(&this_router->router_addr));
@@ -2026,7 +2520,6 @@ mcast_err:
 
 		case TPP_CTL_MSG: {
 			tpp_ctl_pkt_hdr_t *ehdr = (tpp_ctl_pkt_hdr_t *) data;
-			tpp_leaf_t *l = NULL;
 			int subtype = ehdr->code;
 
 			if (subtype == TPP_MSG_NOROUTE) {
@@ -2040,19 +2533,11 @@ mcast_err:
 				tpp_log_func(LOG_WARNING, __func__, tpp_get_logbuf());
 
 				/* find the fd to forward to via the associated router */
-				tpp_lock(&router_lock);
-
-				pbs_idx_find(cluster_leaves_idx, (void **)&dest_host, (void **)&l, NULL);
-				if (l == NULL) {
-					tpp_unlock(&router_lock);
+				if (route_find(dest_host, &target_router, &target_fd) != 0) {
 					if (data_out)
 						free(data_out);
 					return 0;
 				}
-				/* find a router that is still connected */
-				target_router = get_preferred_router(l, this_router, &target_fd);
-
-				tpp_unlock(&router_lock);
 				if (target_router == NULL) {
 					snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "tfd=%d, No connections to send TPP_CTL_NOROUTE", tfd);
 					tpp_log_func(LOG_WARNING, NULL, tpp_get_logbuf());
@@ -2090,61 +2575,6 @@ mcast_err:
 	return -1;
 }
 
-/**
- * @brief
- *	Convenience function to get the most preferred route to reach a leaf
- *	If the leaf is directly connected to this router, then the l->conn_fd is
- *	already set, so just use it.
- *	If not, then search in the list of routes for the leaf starting from index
- *	0 (since its sorted on preference), finding a router that is still
- *	connected, i.e., r[i]->conn_fd is not -1.
- *
- * @param[in] - l 	- Pointer to the leaf for which to find route
- * @param[in] - this_router - Pointer to the local router
- * @param[out] - fd - fd of the chosen router
- *
- * @return	Router to be used
- * @retval	NULL  - Could not find a connected router
- * @retval	!NULL  - Success (The router is returned).
- *
- * @par Side Effects:
- *	None
- *
- * @par MT-safe: Yes
- *
- */
-static tpp_router_t *
-get_preferred_router(tpp_leaf_t *l, tpp_router_t *this_router, int *fd)
-{
-	int i;
-	tpp_router_t *r = NULL;
-
-	*fd = -1;
-
-	if (l->conn_fd != -1) {
-		r = this_router;
-		*fd = l->conn_fd;
-	} else {
-
-		/*
-		 * not directly connected to me, so search for a router
-		 * to which it is connected
-		 */
-		if (l->r) {
-			for (i = 0; i < l->tot_routers; i++) {
-				if (l->r[i]) {
-					if (l->r[i]->conn_fd != -1) {
-						r = l->r[i];
-						*fd = r->conn_fd;
-						break;
-					}
-				}
-			}
-		}
-	}
-	return r;
-}
-
 /**
  * @brief
  *	Convenience function to delete a route from a leaf's list of routers at the
@@ -2175,10 +2605,16 @@ del_router_from_leaf(tpp_leaf_t *l, int tfd)
 			(l->conn_fd == tfd && l->r[i]->conn_fd == -1))) {
 			TPP_DBPRT(("Removing pbs_comm %s from leaf %s", l->r[i]->router_name, tpp_netaddr(&l->leaf_addrs[0])));
 			r = l->r[i];
-			l->r[i] = NULL;
+			ROUTE_STORE(&l->r[i], NULL);
 			l->num_routers--;
-			if (l->num_routers == 0)
-				free(l->r);
+			if (l->num_routers == 0) {
+				/* lookups read tot_routers before r */
+				tpp_router_t **rl = l->r;
+
+				ROUTE_STORE(&l->tot_routers, 0);
+				ROUTE_STORE(&l->r, NULL);
+				route_retire(rl, free);
+			}
 			TPP_DBPRT(("pbs_comm count for leaf=%s is %d", tpp_netaddr(&l->leaf_addrs[0]), l->num_routers));
 			return r;
 		}
@@ -2219,17 +2655,26 @@ add_route_to_leaf(tpp_leaf_t *l, tpp_router_t *r, int index)
 		return -1; /* error - index must be set before calling add route */
 
 	if (index >= l->tot_routers) {
+		tpp_router_t **rl;
 		int sz;
 		int i;
 
+		/*
+		 * lookups may be reading the current list, so build a new one
+		 * and publish it before the size that goes with it
+		 */
 		sz = index + 3;
-		l->r = realloc(l->r, sz * sizeof(tpp_router_t *));
-		for (i = l->tot_routers; i < sz; i++)
-			l->r[i] = NULL;
-		l->tot_routers = sz;
+		if ((rl = malloc(sz * sizeof(tpp_router_t *))) == NULL)
+			return -1;
+		for (i = 0; i < sz; i++)
+			rl[i] = (i < l->tot_routers) ? l->r[i] : NULL;
+		if (l->r)
+			route_retire(l->r, free);
+		ROUTE_STORE(&l->r, rl);
+		ROUTE_STORE(&l->tot_routers, sz);
 	}
 
-	l->r[index] = r;
+	ROUTE_STORE(&l->r[index], r);
 	l->num_routers++;
 
 #ifdef DEBUG
@@ -2338,6 +2783,14 @@ tpp_init_router(struct tpp_config *cnf)
 		return -1;
 	}
 
+	leaf_routes = route_tbl_alloc(ROUTE_TBL_INIT_SIZE);
+	route_readers = calloc(tpp_conf->numthreads, sizeof(route_reader_t));
+	if (leaf_routes == NULL || route_readers == NULL) {
+		tpp_log_func(LOG_CRIT, __func__, "Failed to create leaf routing table");
+		return -1;
+	}
+	route_num_readers = tpp_conf->numthreads;
+
 	r = alloc_router(tpp_conf->node_name, NULL);
 	if (!r)
 		return -1; /* error already logged */
@@ -186,6 +186,7 @@ typedef struct {
 
 	unsigned long send_queue_size;  /* total bytes waiting on send queue */
 	tpp_que_t send_queue;      /* queue of pkts to send */
+	int send_ready;            /* pkts at head of send_queue already through the presend handler */
 	tpp_packet_t scratch;      /* scratch to work on incoming data */
 	thrd_data_t *td;                  /* connections controller thread */
 
@@ -719,6 +720,7 @@ alloc_conn(int tfd)
 	}
 	conn->sock_fd = tfd;
 	conn->send_queue_size = 0;
+	conn->send_ready = 0;
 	conn->extra = NULL;
 	TPP_QUE_CLEAR(&conn->send_queue);
 	/* initialize the send queue to empty */
@@ -2085,9 +2087,19 @@ add_pkts(phy_conn_t *conn)
 
 /**
  * @brief
- *	Loop over the list of queued data and send out packet by packet
+ *	Loop over the list of queued data and send it out, gathering up to
+ *	TPP_SEND_IOVCNT packets into a single writev() call.
  *	Stop if sending would block.
  *
+ * @par Functionality
+ *	The presend handler is called once for each packet as it is gathered;
+ *	conn->send_ready counts the packets at the head of the send queue that
+ *	have already been through it, so that a packet left partly or wholly
+ *	unsent by a short write is not handed to the handler again.
+ *	A packet encrypted by the presend handler keeps its cleartext in the
+ *	connection until the postsend handler runs, so no packet is gathered
+ *	after such a packet.
+ *
  * @param[in] conn - The physical connection
  *
  * @par Side Effects:
@@ -2099,10 +2111,15 @@ add_pkts(phy_conn_t *conn)
 static void
 send_data(phy_conn_t *conn)
 {
+	struct iovec iov[TPP_SEND_IOVCNT];
 	tpp_packet_t *p = NULL;
-	int rc;
-	int can_send_more;
 	tpp_que_elem_t *n;
+	tpp_que_elem_t *next;
+	int cnt;
+	int tosend;
+	int totsend;
+	int len;
+	int rc;
 #ifdef NAS /* localmod 149 */
 	time_t curr;
 	int rc_iflag;
@@ -2116,207 +2133,227 @@ send_data(phy_conn_t *conn)
 	if (conn->net_state == TPP_CONN_CONNECTING || conn->net_state == TPP_CONN_INITIATING)
 		return;
 
-	n = TPP_QUE_HEAD(&conn->send_queue);
-	p = TPP_QUE_DATA(n);
-
 	if (conn->can_send == 0)
 		return;
 
-	can_send_more = 1;
-
-	while (p && can_send_more) {
-		int tosend;
-
-		tosend = p->len - (p->pos - p->data);
-		if (p->pos == p->data) {
-			if (the_pkt_presend_handler) {
-				if (the_pkt_presend_handler(conn->sock_fd, p, conn->extra) != 0) {
-					/* handler asked not to send data, skip packet */
-					conn->send_queue_size -= tosend;
-					(void) tpp_que_del_elem(&conn->send_queue, n);
-					n = TPP_QUE_HEAD(&conn->send_queue);
-					p = TPP_QUE_DATA(n);
-					continue;
+	while (TPP_QUE_HEAD(&conn->send_queue)) {
+		cnt = 0;
+		totsend = 0;
+		n = TPP_QUE_HEAD(&conn->send_queue);
+		while (n && cnt < TPP_SEND_IOVCNT) {
+			p = TPP_QUE_DATA(n);
+			next = n->next;
+			if (cnt >= conn->send_ready) {
+				if (the_pkt_presend_handler) {
+					len = p->len;
+					if (the_pkt_presend_handler(conn->sock_fd, p, conn->extra) != 0) {
+						/* handler asked not to send data, skip packet */
+						conn->send_queue_size -= len;
+						(void) tpp_que_del_elem(&conn->send_queue, n);
+						n = next;
+						continue;
+					}
 				}
-				/* the_pkt_presend_handler could change the pkt size*/
-				tosend = p->len;
+				conn->send_ready++;
 			}
+			tosend = p->len - (p->pos - p->data);
+			iov[cnt].iov_base = p->pos;
+			iov[cnt].iov_len = tosend;
+			totsend += tosend;
+			cnt++;
+			n = next;
+
+			/* the_pkt_presend_handler could have encrypted the pkt */
+			if (the_pkt_postsend_handler && p->len > (int) sizeof(int) &&
+				*(p->data + sizeof(int)) == TPP_ENCRYPTED_DATA)
+				break;
 		}
+		if (cnt == 0)
+			break;
 
-		while (tosend > 0) {
-			rc = tpp_sock_send(conn->sock_fd, p->pos, tosend, 0);
+		rc = tpp_sock_writev(conn->sock_fd, iov, cnt);
 #ifdef NAS /* localmod 149 */
-			if (rc > 0) {
-				curr = time(0);
-
-				conn->td->nas_kb_sent_A += ((double) rc) / 1024.0;
-				conn->td->nas_kb_sent_B += ((double) rc) / 1024.0;
-				conn->td->nas_kb_sent_C += ((double) rc) / 1024.0;
+		if (rc > 0) {
+			curr = time(0);
 
-				if (tosend > TPP_SCRATCHSIZE) {
-					conn->td->nas_num_lrg_sends_A++;
-					conn->td->nas_lrg_send_sum_kb_A += ((double) tosend) / 1024.0;
+			conn->td->nas_kb_sent_A += ((double) rc) / 1024.0;
+			conn->td->nas_kb_sent_B += ((double) rc) / 1024.0;
+			conn->td->nas_kb_sent_C += ((double) rc) / 1024.0;
 
-					if (rc != tosend) {
-						conn->td->nas_num_qual_lrg_sends_A++;
-					}
+			if (totsend > TPP_SCRATCHSIZE) {
+				conn->td->nas_num_lrg_sends_A++;
+				conn->td->nas_lrg_send_sum_kb_A += ((double) totsend) / 1024.0;
 
-					if (tosend > conn->td->nas_max_bytes_lrg_send_A) {
-						conn->td->nas_max_bytes_lrg_send_A = tosend;
-					}
+				if (rc != totsend) {
+					conn->td->nas_num_qual_lrg_sends_A++;
+				}
 
-					if (tosend < conn->td->nas_min_bytes_lrg_send_A) {
-						conn->td->nas_min_bytes_lrg_send_A = tosend;
-					}
+				if (totsend > conn->td->nas_max_bytes_lrg_send_A) {
+					conn->td->nas_max_bytes_lrg_send_A = totsend;
+				}
 
+				if (totsend < conn->td->nas_min_bytes_lrg_send_A) {
+					conn->td->nas_min_bytes_lrg_send_A = totsend;
+				}
 
 
-					conn->td->nas_num_lrg_sends_B++;
-					conn->td->nas_lrg_send_sum_kb_B += ((double) tosend) / 1024.0;
 
-					if (rc != tosend) {
-						conn->td->nas_num_qual_lrg_sends_B++;
-					}
+				conn->td->nas_num_lrg_sends_B++;
+				conn->td->nas_lrg_send_sum_kb_B += ((double) totsend) / 1024.0;
 
-					if (tosend > conn->td->nas_max_bytes_lrg_send_B) {
-						conn->td->nas_max_bytes_lrg_send_B = tosend;
-					}
+				if (rc != totsend) {
+					conn->td->nas_num_qual_lrg_sends_B++;
+				}
 
-					if (tosend < conn->td->nas_min_bytes_lrg_send_B) {
-						conn->td->nas_min_bytes_lrg_send_B = tosend;
-					}
+				if (totsend > conn->td->nas_max_bytes_lrg_send_B) {
+					conn->td->nas_max_bytes_lrg_send_B = totsend;
+				}
 
+				if (totsend < conn->td->nas_min_bytes_lrg_send_B) {
+					conn->td->nas_min_bytes_lrg_send_B = totsend;
+				}
 
 
-					conn->td->nas_num_lrg_sends_C++;
-					conn->td->nas_lrg_send_sum_kb_C += ((double) tosend) / 1024.0;
 
-					if (rc != tosend) {
-						conn->td->nas_num_qual_lrg_sends_C++;
-					}
+				conn->td->nas_num_lrg_sends_C++;
+				conn->td->nas_lrg_send_sum_kb_C += ((double) totsend) / 1024.0;
 
-					if (tosend > conn->td->nas_max_bytes_lrg_send_C) {
-						conn->td->nas_max_bytes_lrg_send_C = tosend;
-					}
+				if (rc != totsend) {
+					conn->td->nas_num_qual_lrg_sends_C++;
+				}
 
-					if (tosend < conn->td->nas_min_bytes_lrg_send_C) {
-						conn->td->nas_min_bytes_lrg_send_C = tosend;
-					}
+				if (totsend > conn->td->nas_max_bytes_lrg_send_C) {
+					conn->td->nas_max_bytes_lrg_send_C = totsend;
 				}
 
-				if (curr > (conn->td->nas_last_time_A + conn->td->NAS_TPP_LOG_PERIOD_A)) {
-					rc_iflag = access(tpp_instr_flag_file, F_OK);
-					if (rc_iflag != 0) {
-						conn->td->nas_tpp_log_enabled = 0;
-					} else {
-						conn->td->nas_tpp_log_enabled = 1;
-					}
+				if (totsend < conn->td->nas_min_bytes_lrg_send_C) {
+					conn->td->nas_min_bytes_lrg_send_C = totsend;
+				}
+			}
 
-					if (conn->td->nas_tpp_log_enabled) {
-						snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
-							 "tpp_instr period_A %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
-							 conn->td->NAS_TPP_LOG_PERIOD_A,
-							 (int) (curr - conn->td->nas_last_time_A),
-							 conn->td->nas_kb_sent_A / 1024.0,
-							 (conn->td->nas_kb_sent_A / 1024.0) / (((double) (curr - conn->td->nas_last_time_A)) / 60.0),
-							 TPP_SCRATCHSIZE,
-							 conn->td->nas_num_lrg_sends_A,
-							 conn->td->nas_num_qual_lrg_sends_A,
-							 conn->td->nas_num_lrg_sends_A > 0 ? conn->td->nas_min_bytes_lrg_send_A : 0,
-							 conn->td->nas_max_bytes_lrg_send_A,
-							 conn->td->nas_num_lrg_sends_A > 0 ? conn->td->nas_lrg_send_sum_kb_A / ((double) conn->td->nas_num_lrg_sends_A) : 0.0);
-						tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
-					}
+			if (curr > (conn->td->nas_last_time_A + conn->td->NAS_TPP_LOG_PERIOD_A)) {
+				rc_iflag = access(tpp_instr_flag_file, F_OK);
+				if (rc_iflag != 0) {
+					conn->td->nas_tpp_log_enabled = 0;
+				} else {
+					conn->td->nas_tpp_log_enabled = 1;
+				}
 
-					conn->td->nas_last_time_A = curr;
-					conn->td->nas_kb_sent_A = 0.0;
-					conn->td->nas_num_lrg_sends_A = 0;
-					conn->td->nas_num_qual_lrg_sends_A = 0;
-					conn->td->nas_max_bytes_lrg_send_A = 0;
-					conn->td->nas_min_bytes_lrg_send_A = INT_MAX - 1;
-					conn->td->nas_lrg_send_sum_kb_A = 0.0;
+				if (conn->td->nas_tpp_log_enabled) {
+					snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
+						 "tpp_instr period_A %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
+						 conn->td->NAS_TPP_LOG_PERIOD_A,
+						 (int) (curr - conn->td->nas_last_time_A),
+						 conn->td->nas_kb_sent_A / 1024.0,
+						 (conn->td->nas_kb_sent_A / 1024.0) / (((double) (curr - conn->td->nas_last_time_A)) / 60.0),
+						 TPP_SCRATCHSIZE,
+						 conn->td->nas_num_lrg_sends_A,
+						 conn->td->nas_num_qual_lrg_sends_A,
+						 conn->td->nas_num_lrg_sends_A > 0 ? conn->td->nas_min_bytes_lrg_send_A : 0,
+						 conn->td->nas_max_bytes_lrg_send_A,
+						 conn->td->nas_num_lrg_sends_A > 0 ? conn->td->nas_lrg_send_sum_kb_A / ((double) conn->td->nas_num_lrg_sends_A) : 0.0);
+					tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
 				}
 
-				if (curr > (conn->td->nas_last_time_B + conn->td->NAS_TPP_LOG_PERIOD_B)) {
-					if (conn->td->nas_tpp_log_enabled) {
-						snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
-							 "tpp_instr period_B %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
-							 conn->td->NAS_TPP_LOG_PERIOD_B,
-							 (int) (curr - conn->td->nas_last_time_B),
-							 conn->td->nas_kb_sent_B / 1024.0,
-							 (conn->td->nas_kb_sent_B / 1024.0) / (((double) (curr - conn->td->nas_last_time_B)) / 60.0),
-							 TPP_SCRATCHSIZE,
-							 conn->td->nas_num_lrg_sends_B,
-							 conn->td->nas_num_qual_lrg_sends_B,
-							 conn->td->nas_num_lrg_sends_B > 0 ? conn->td->nas_min_bytes_lrg_send_B : 0,
-							 conn->td->nas_max_bytes_lrg_send_B,
-							 conn->td->nas_num_lrg_sends_B > 0 ? conn->td->nas_lrg_send_sum_kb_B / ((double) conn->td->nas_num_lrg_sends_B) : 0.0);
-						tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
-					}
+				conn->td->nas_last_time_A = curr;
+				conn->td->nas_kb_sent_A = 0.0;
+				conn->td->nas_num_lrg_sends_A = 0;
+				conn->td->nas_num_qual_lrg_sends_A = 0;
+				conn->td->nas_max_bytes_lrg_send_A = 0;
+				conn->td->nas_min_bytes_lrg_send_A = INT_MAX - 1;
+				conn->td->nas_lrg_send_sum_kb_A = 0.0;
+			}
 
-					conn->td->nas_last_time_B = curr;
-					conn->td->nas_kb_sent_B = 0.0;
-					conn->td->nas_num_lrg_sends_B = 0;
-					conn->td->nas_num_qual_lrg_sends_B = 0;
-					conn->td->nas_max_bytes_lrg_send_B = 0;
-					conn->td->nas_min_bytes_lrg_send_B = INT_MAX - 1;
-					conn->td->nas_lrg_send_sum_kb_B = 0.0;
+			if (curr > (conn->td->nas_last_time_B + conn->td->NAS_TPP_LOG_PERIOD_B)) {
+				if (conn->td->nas_tpp_log_enabled) {
+					snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
+						 "tpp_instr period_B %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
+						 conn->td->NAS_TPP_LOG_PERIOD_B,
+						 (int) (curr - conn->td->nas_last_time_B),
+						 conn->td->nas_kb_sent_B / 1024.0,
+						 (conn->td->nas_kb_sent_B / 1024.0) / (((double) (curr - conn->td->nas_last_time_B)) / 60.0),
+						 TPP_SCRATCHSIZE,
+						 conn->td->nas_num_lrg_sends_B,
+						 conn->td->nas_num_qual_lrg_sends_B,
+						 conn->td->nas_num_lrg_sends_B > 0 ? conn->td->nas_min_bytes_lrg_send_B : 0,
+						 conn->td->nas_max_bytes_lrg_send_B,
+						 conn->td->nas_num_lrg_sends_B > 0 ? conn->td->nas_lrg_send_sum_kb_B / ((double) conn->td->nas_num_lrg_sends_B) : 0.0);
+					tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
 				}
 
-				if (curr > (conn->td->nas_last_time_C + conn->td->NAS_TPP_LOG_PERIOD_C)) {
-					if (conn->td->nas_tpp_log_enabled) {
-						snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
-							 "tpp_instr period_C %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
-							conn->td->NAS_TPP_LOG_PERIOD_C,
-							(int) (curr - conn->td->nas_last_time_C),
-							conn->td->nas_kb_sent_C / 1024.0,
-							(conn->td->nas_kb_sent_C / 1024.0) / (((double) (
-							curr - conn->td->nas_last_time_C)) / 60.0),
-							TPP_SCRATCHSIZE,
-							conn->td->nas_num_lrg_sends_C,
-							conn->td->nas_num_qual_lrg_sends_C,
-							conn->td->nas_num_lrg_sends_C > 0 ? conn->td->nas_min_bytes_lrg_send_C : 0,
-							conn->td->nas_max_bytes_lrg_send_C,
-							conn->td->nas_num_lrg_sends_C > 0 ? conn->td->nas_lrg_send_sum_kb_C / ((double) conn->td->nas_num_lrg_sends_C) : 0.0);
-						tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
-					}
+				conn->td->nas_last_time_B = curr;
+				conn->td->nas_kb_sent_B = 0.0;
+				conn->td->nas_num_lrg_sends_B = 0;
+				conn->td->nas_num_qual_lrg_sends_B = 0;
+				conn->td->nas_max_bytes_lrg_send_B = 0;
+				conn->td->nas_min_bytes_lrg_send_B = INT_MAX - 1;
+				conn->td->nas_lrg_send_sum_kb_B = 0.0;
+			}
 
-					conn->td->nas_last_time_C = curr;
-					conn->td->nas_kb_sent_C = 0.0;
-					conn->td->nas_num_lrg_sends_C = 0;
-					conn->td->nas_num_qual_lrg_sends_C = 0;
-					conn->td->nas_max_bytes_lrg_send_C = 0;
-					conn->td->nas_min_bytes_lrg_send_C = INT_MAX - 1;
-					conn->td->nas_lrg_send_sum_kb_C = 0.0;
+			if (curr > (conn->td->nas_last_time_C + conn->td->NAS_TPP_LOG_PERIOD_C)) {
+				if (conn->td->nas_tpp_log_enabled) {
+					snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
+						 "tpp_instr period_C %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
+						conn->td->NAS_TPP_LOG_PERIOD_C,
+						(int) (curr - conn->td->nas_last_time_C),
+						conn->td->nas_kb_sent_C / 1024.0,
+						(conn->td->nas_kb_sent_C / 1024.0) / (((double) (
+						curr - conn->td->nas_last_time_C)) / 60.0),
+						TPP_SCRATCHSIZE,
+						conn->td->nas_num_lrg_sends_C,
+						conn->td->nas_num_qual_lrg_sends_C,
+						conn->td->nas_num_lrg_sends_C > 0 ? conn->td->nas_min_bytes_lrg_send_C : 0,
+						conn->td->nas_max_bytes_lrg_send_C,
+						conn->td->nas_num_lrg_sends_C > 0 ? conn->td->nas_lrg_send_sum_kb_C / ((double) conn->td->nas_num_lrg_sends_C) : 0.0);
+					tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
 				}
+
+				conn->td->nas_last_time_C = curr;
+				conn->td->nas_kb_sent_C = 0.0;
+				conn->td->nas_num_lrg_sends_C = 0;
+				conn->td->nas_num_qual_lrg_sends_C = 0;
+				conn->td->nas_max_bytes_lrg_send_C = 0;
+				conn->td->nas_min_bytes_lrg_send_C = INT_MAX - 1;
+				conn->td->nas_lrg_send_sum_kb_C = 0.0;
 			}
+		}
 #endif /* localmod 149 */
 
-			if (rc < 0) {
-				if (errno == EWOULDBLOCK || errno == EAGAIN) {
-					/* set this socket in POLLOUT */
-					if (tpp_em_mod_fd(conn->td->em_context, conn->sock_fd,
-						EM_IN | EM_OUT | EM_HUP | EM_ERR)	== -1) {
-						tpp_log_func(LOG_ERR, __func__, "Multiplexing failed");
-						return;
-					}
-
-					/* set to cannot send data any more */
-					conn->can_send = 0;
-				} else {
-					handle_disconnect(conn);
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EWOULDBLOCK || errno == EAGAIN) {
+				/* set this socket in POLLOUT */
+				if (tpp_em_mod_fd(conn->td->em_context, conn->sock_fd,
+					EM_IN | EM_OUT | EM_HUP | EM_ERR)	== -1) {
+					tpp_log_func(LOG_ERR, __func__, "Multiplexing failed");
 					return;
 				}
-				can_send_more = 0;
-				break;
+
+				/* set to cannot send data any more */
+				conn->can_send = 0;
+			} else {
+				handle_disconnect(conn);
 			}
-			TPP_DBPRT(("tfd=%d, sending out %d bytes", conn->sock_fd, rc));
-			p->pos += rc;
-			tosend -= rc;
+			return;
 		}
+		TPP_DBPRT(("tfd=%d, sending out %d bytes in %d pkts", conn->sock_fd, rc, cnt));
 
-		if (tosend == 0) {
+		/*
+		 * retire the packets that went out completely, and note how far
+		 * the first one that did not got
+		 */
+		while (cnt-- > 0) {
+			n = TPP_QUE_HEAD(&conn->send_queue);
+			p = TPP_QUE_DATA(n);
+			tosend = p->len - (p->pos - p->data);
+			if (rc < tosend) {
+				p->pos += rc;
+				break;
+			}
+			rc -= tosend;
 			conn->send_queue_size -= p->len;
+			conn->send_ready--;
 
 			if (the_pkt_postsend_handler)
 				the_pkt_postsend_handler(conn->sock_fd, p, conn->extra);
@@ -2329,8 +2366,6 @@ send_data(phy_conn_t *conn)
 			 * delete this node and get next node in queue
 			 */
 			(void)tpp_que_del_elem(&conn->send_queue, n);
-			n = TPP_QUE_HEAD(&conn->send_queue);
-			p = TPP_QUE_DATA(n);
 		}
 	}
 }
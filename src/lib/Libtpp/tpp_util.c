@@ -53,6 +53,8 @@
 #endif
 
 #include <stdio.h>
+#include <limits.h>
+#include <time.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -94,6 +96,39 @@ void (*tpp_log_func)(int level, const char *id, char *mess) = NULL;
 
 #define PBS_TCP_KEEPALIVE "PBS_TCP_KEEPALIVE" /* environment string to search for */
 
+/*
+ * The object pools. A thread that runs out of cached objects takes up to
+ * half of cache_max of them from the depot, and a thread whose cache is
+ * full gives half of it back. Objects that do not fit in the depot are
+ * released with free().
+ */
+typedef struct {
+	char *name;
+	size_t size;		/* size of each object */
+	int cache_max;		/* max objects cached by a thread */
+	int depot_max;		/* max objects held in the depot */
+	pthread_mutex_t lock;	/* protects the depot and the counters */
+	void *depot;		/* free objects shared by all threads */
+	int depot_count;
+	unsigned long hits;	/* allocations served from the pool */
+	unsigned long misses;	/* allocations that had to malloc a batch */
+	unsigned long released;	/* objects released with free() */
+} tpp_pool_t;
+
+static tpp_pool_t tpp_pools[TPP_POOL_MAX] = {
+	{"pkt", sizeof(tpp_packet_t), 256, 8192},
+	{"que_elem", sizeof(tpp_que_elem_t), 512, 16384},
+	{"cmd", sizeof(tpp_cmd_t), 256, 8192},
+	{"data_256", 256, 256, 8192},
+	{"data_2k", 2048, 64, 1024},
+	{"data_16k", 16384, 16, 128}
+};
+static pthread_once_t tpp_pool_once_ctrl = PTHREAD_ONCE_INIT;
+static time_t tpp_pool_stats_logged = 0;
+
+/* fold the counters of a thread cache into the pool after this many calls */
+#define TPP_POOL_FOLD_CNT 4096
+
 /* extern functions called from this file into the tpp_transport.c */
 static pbs_tcp_chan_t * tppdis_get_user_data(int sd);
 
@@ -334,6 +369,7 @@ set_tpp_config(void (*log_fn)(int, const char *, char *), struct pbs_config *pbs
 	tpp_conf->node_name = formatted_names;
 	tpp_conf->node_type = TPP_LEAF_NODE;
 	tpp_conf->numthreads = 1;
+	tpp_conf->mcast_fanout = pbs_conf->pbs_comm_mcast_fanout;
 
 	tpp_conf->auth_config = make_auth_config(pbs_conf->auth_method,
 							pbs_conf->encrypt_method,
@@ -641,6 +677,346 @@ tpp_handle_auth_handshake(int tfd, int conn_fd, conn_auth_t *authdata, int for_e
 	return 1;
 }
 
+/**
+ * @brief
+ *	Initialize the locks of the object pools
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+tpp_pool_init_once(void)
+{
+	int i;
+
+	for (i = 0; i < TPP_POOL_MAX; i++)
+		tpp_init_lock(&tpp_pools[i].lock);
+}
+
+/**
+ * @brief
+ *	Add the counters of a thread cache to those of its pool.
+ *	Must be called with the pool locked.
+ *
+ * @param[in] - pool - The pool
+ * @param[in] - c - The thread cache of the pool
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static void
+tpp_pool_fold(tpp_pool_t *pool, tpp_pool_cache_t *c)
+{
+	pool->hits += c->hits;
+	pool->misses += c->misses;
+	c->hits = 0;
+	c->misses = 0;
+}
+
+/**
+ * @brief
+ *	Get an object from a pool, from the cache of the calling thread if
+ *	possible, else from the depot, else from a batch allocated with malloc().
+ *
+ * @param[in] - id - The pool, one of enum tpp_pool_id
+ *
+ * @return	The object
+ * @retval	NULL - Failure (Out of memory)
+ * @retval	!NULL - Address of the object
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+void *
+tpp_pool_get(int id)
+{
+	tpp_pool_t *pool = &tpp_pools[id];
+	tpp_pool_cache_t *c;
+	tpp_tls_t *tls;
+	void *obj;
+	int n;
+
+	if ((tls = tpp_get_tls()) == NULL)
+		return malloc(pool->size);
+	pthread_once(&tpp_pool_once_ctrl, tpp_pool_init_once);
+
+	c = &tls->pool_cache[id];
+	if (c->count == 0 || c->hits + c->misses >= TPP_POOL_FOLD_CNT) {
+		tpp_lock(&pool->lock);
+		for (n = 0; c->count == 0 && n < pool->cache_max / 2 && pool->depot; n++) {
+			obj = pool->depot;
+			pool->depot = *(void **) obj;
+			*(void **) obj = c->free_list;
+			c->free_list = obj;
+		}
+		pool->depot_count -= n;
+		c->count += n;
+		tpp_pool_fold(pool, c);
+		tpp_unlock(&pool->lock);
+	}
+
+	if (c->count > 0) {
+		c->hits++;
+	} else {
+		/* the depot is empty, allocate a batch rather than one */
+		for (n = 0; n < pool->cache_max / 2; n++) {
+			if ((obj = malloc(pool->size)) == NULL)
+				break;
+			*(void **) obj = c->free_list;
+			c->free_list = obj;
+			c->count++;
+		}
+		c->misses++;
+	}
+
+	if ((obj = c->free_list) != NULL) {
+		c->free_list = *(void **) obj;
+		c->count--;
+	}
+	return obj;
+}
+
+/**
+ * @brief
+ *	Return an object to its pool
+ *
+ * @param[in] - id - The pool, one of enum tpp_pool_id
+ * @param[in] - obj - The object, got from tpp_pool_get() for the same pool
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+void
+tpp_pool_put(int id, void *obj)
+{
+	tpp_pool_t *pool = &tpp_pools[id];
+	tpp_pool_cache_t *c;
+	tpp_tls_t *tls;
+	void *release = NULL;
+	void *p;
+	int n;
+
+	if ((tls = tpp_get_tls()) == NULL) {
+		free(obj);
+		return;
+	}
+	pthread_once(&tpp_pool_once_ctrl, tpp_pool_init_once);
+
+	c = &tls->pool_cache[id];
+	if (c->count >= pool->cache_max) {
+		tpp_lock(&pool->lock);
+		for (n = 0; n < pool->cache_max / 2; n++) {
+			p = c->free_list;
+			c->free_list = *(void **) p;
+			if (pool->depot_count < pool->depot_max) {
+				*(void **) p = pool->depot;
+				pool->depot = p;
+				pool->depot_count++;
+			} else {
+				*(void **) p = release;
+				release = p;
+				pool->released++;
+			}
+		}
+		c->count -= n;
+		tpp_pool_fold(pool, c);
+		tpp_unlock(&pool->lock);
+
+		while ((p = release) != NULL) {
+			release = *(void **) p;
+			free(p);
+		}
+	}
+
+	*(void **) obj = c->free_list;
+	c->free_list = obj;
+	c->count++;
+}
+
+/**
+ * @brief
+ *	Get the counters of the object pools. Allocations served from the
+ *	cache of a thread are counted once that cache next goes to the depot.
+ *
+ * @param[out] stats - array to fill, one entry per pool
+ * @param[in] max - number of entries in stats
+ *
+ * @return - number of entries filled
+ *
+ * @par MT-safe: Yes
+ *
+ */
+int
+tpp_get_pool_stats(struct tpp_pool_stats *stats, int max)
+{
+	tpp_pool_t *pool;
+	int i;
+
+	pthread_once(&tpp_pool_once_ctrl, tpp_pool_init_once);
+
+	for (i = 0; i < TPP_POOL_MAX && i < max; i++) {
+		pool = &tpp_pools[i];
+		tpp_lock(&pool->lock);
+		stats[i].name = pool->name;
+		stats[i].hits = pool->hits;
+		stats[i].misses = pool->misses;
+		stats[i].released = pool->released;
+		stats[i].depot = pool->depot_count;
+		tpp_unlock(&pool->lock);
+	}
+	return i;
+}
+
+/**
+ * @brief
+ *	Log the counters of the object pools, at most once every
+ *	TPP_POOL_STATS_INTERVAL seconds.
+ *
+ * @param[in] - now - Current time
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+void
+tpp_pool_log_stats(time_t now)
+{
+	struct tpp_pool_stats stats[TPP_POOL_MAX];
+	int n;
+	int i;
+
+	pthread_once(&tpp_pool_once_ctrl, tpp_pool_init_once);
+
+	tpp_lock(&tpp_pools[0].lock);
+	if (tpp_pool_stats_logged == 0)
+		tpp_pool_stats_logged = now;
+	if (now - tpp_pool_stats_logged < TPP_POOL_STATS_INTERVAL) {
+		tpp_unlock(&tpp_pools[0].lock);
+		return;
+	}
+	tpp_pool_stats_logged = now;
+	tpp_unlock(&tpp_pools[0].lock);
+
+	n = tpp_get_pool_stats(stats, TPP_POOL_MAX);
+	for (i = 0; i < n; i++) {
+		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
+			"pool %s: hits=%lu, misses=%lu, released=%lu, depot=%d",
+			stats[i].name, stats[i].hits, stats[i].misses, stats[i].released, stats[i].depot);
+		tpp_log_func(LOG_INFO, __func__, tpp_get_logbuf());
+	}
+}
+
+/**
+ * @brief
+ *	Lock the object pools before a fork, so that the child does not
+ *	inherit a depot in the middle of an update
+ *
+ * @par MT-safe: Yes
+ *
+ */
+void
+tpp_pool_prefork(void)
+{
+	int i;
+
+	pthread_once(&tpp_pool_once_ctrl, tpp_pool_init_once);
+	for (i = 0; i < TPP_POOL_MAX; i++)
+		tpp_lock(&tpp_pools[i].lock);
+}
+
+/**
+ * @brief
+ *	Unlock the object pools in the parent after a fork
+ *
+ * @par MT-safe: Yes
+ *
+ */
+void
+tpp_pool_postfork_parent(void)
+{
+	int i;
+
+	for (i = TPP_POOL_MAX - 1; i >= 0; i--)
+		tpp_unlock(&tpp_pools[i].lock);
+}
+
+/**
+ * @brief
+ *	Initialize new locks for the object pools in the child after a fork
+ *
+ * @par MT-safe: No
+ *
+ */
+void
+tpp_pool_postfork_child(void)
+{
+	int i;
+
+	for (i = 0; i < TPP_POOL_MAX; i++)
+		tpp_init_lock(&tpp_pools[i].lock);
+}
+
+/**
+ * @brief
+ *	Find the pool holding packet data buffers of a given length
+ *
+ * @param[in] - len - Length of the data buffer
+ *
+ * @return	The pool
+ * @retval	-1 - Too long for any of the pools
+ * @retval	!-1 - One of the TPP_POOL_DATA_* pools
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static int
+tpp_pool_data_id(int len)
+{
+	int i;
+
+	for (i = TPP_POOL_DATA_SMALL; i <= TPP_POOL_DATA_LARGE; i++) {
+		if (len <= (int) tpp_pools[i].size)
+			return i;
+	}
+	return -1;
+}
+
+/**
+ * @brief
+ *	Replace the data buffer of a packet, releasing the current one.
+ *	Callers must use this rather than free the data themselves, since
+ *	the buffer may belong to a pool.
+ *
+ * @param[in] - pkt - The packet
+ * @param[in] - data - The new malloc'd data buffer
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+void
+tpp_pkt_set_data(tpp_packet_t *pkt, void *data)
+{
+	if (pkt->data && pkt->data != data) {
+		if (pkt->data_pool != -1)
+			tpp_pool_put(pkt->data_pool, pkt->data);
+		else
+			free(pkt->data);
+	}
+	pkt->data = data;
+	pkt->data_pool = -1;
+}
+
 /**
  * @brief
  *	Create a packet structure from the inputs provided
@@ -665,28 +1041,31 @@ tpp_cr_pkt(void *data, int len, int mk_data)
 {
 	tpp_packet_t *pkt;
 
-	if ((pkt = malloc(sizeof(tpp_packet_t))) == NULL) {
+	if ((pkt = tpp_pool_get(TPP_POOL_PKT)) == NULL) {
 		tpp_log_func(LOG_CRIT, __func__, "Out of memory allocating packet");
 		return NULL;
 	}
+	pkt->data_pool = -1;
 	if (mk_data == 0)
 		pkt->data = data;
 	else {
-#ifdef DEBUG
-		/* use calloc() to satisfy valgrind in debug mode */
-		pkt->data = calloc(len, 1);
-#else
-		/* use malloc() in non-debug mode for performance */
-		pkt->data = malloc(len);
-#endif
+		if ((pkt->data_pool = tpp_pool_data_id(len)) != -1)
+			pkt->data = tpp_pool_get(pkt->data_pool);
+		else
+			pkt->data = malloc(len);
 		if (!pkt->data) {
-			free(pkt);
+			tpp_pool_put(TPP_POOL_PKT, pkt);
 			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Out of memory allocating packet data of %d bytes", len);
 			tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
 			return NULL;
 		}
 		if (data)
 			memcpy(pkt->data, data, len);
+#ifdef DEBUG
+		/* clear the buffer to satisfy valgrind in debug mode */
+		else
+			memset(pkt->data, 0, len);
+#endif
 	}
 	pkt->pos = pkt->data;
 	pkt->extra_data = NULL;
@@ -715,11 +1094,10 @@ tpp_free_pkt(tpp_packet_t *pkt)
 		pkt->ref_count--;
 
 		if (pkt->ref_count <= 0) {
-			if (pkt->data)
-				free(pkt->data);
+			tpp_pkt_set_data(pkt, NULL);
 			if (pkt->extra_data)
 				free(pkt->extra_data);
-			free(pkt);
+			tpp_pool_put(TPP_POOL_PKT, pkt);
 		}
 	}
 }
@@ -1224,7 +1602,7 @@ tpp_enque(tpp_que_t *l, void *data)
 {
 	tpp_que_elem_t *nd;
 
-	if ((nd = malloc(sizeof(tpp_que_elem_t))) == NULL) {
+	if ((nd = tpp_pool_get(TPP_POOL_QUE_ELEM)) == NULL) {
 		return NULL;
 	}
 	nd->queue_data = data;
@@ -1280,7 +1658,7 @@ tpp_deque(tpp_que_t *l)
 			l->head->prev = NULL;
 		else
 			l->tail = NULL;
-		free(p);
+		tpp_pool_put(TPP_POOL_QUE_ELEM, p);
 	}
 	return data;
 }
@@ -1335,7 +1713,7 @@ tpp_que_del_elem(tpp_que_t *l, tpp_que_elem_t *n)
 		if (n->prev)
 			p = n->prev;
 		/* else return p as NULL, so list QUE_NEXT starts from head again */
-		free(n);
+		tpp_pool_put(TPP_POOL_QUE_ELEM, n);
 	}
 	return p;
 }
@@ -1373,7 +1751,7 @@ tpp_que_ins_elem(tpp_que_t *l, tpp_que_elem_t *n, void *data, int before)
 	tpp_que_elem_t *nd = NULL;
 
 	if (n) {
-		if ((nd = malloc(sizeof(tpp_que_elem_t))) == NULL) {
+		if ((nd = tpp_pool_get(TPP_POOL_QUE_ELEM)) == NULL) {
 			return NULL;
 		}
 		nd->queue_data = data;
@@ -1949,6 +2327,432 @@ tpp_inflate(void *inbuf, unsigned int inlen, unsigned int totlen)
 }
 #endif
 
+/*
+ * A fast codec writing the LZ4 block format. It only looks for matches
+ * through a small hash of the last positions seen, which trades some
+ * compression ratio for a speed many times that of deflate.
+ */
+#define TPP_LZ_MINMATCH		4
+#define TPP_LZ_LASTLITERALS	5	/* the block always ends in literals */
+#define TPP_LZ_MFLIMIT		12	/* last match starts this far from the end */
+#define TPP_LZ_HASH_LOG		12
+#define TPP_LZ_MAX_DIST		65535
+
+static unsigned int
+tpp_lz_read32(const unsigned char *p)
+{
+	unsigned int v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static unsigned int
+tpp_lz_hash(unsigned int v)
+{
+	return (v * 2654435761U) >> (32 - TPP_LZ_HASH_LOG);
+}
+
+static unsigned char *
+tpp_lz_put_len(unsigned char *op, size_t len)
+{
+	while (len >= 255) {
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = (unsigned char) len;
+	return op;
+}
+
+/**
+ * @brief Compress a block of data into the LZ4 block format
+ *
+ * @param[in] in     - data to compress
+ * @param[in] inlen  - length of data
+ * @param[out] out   - buffer for the compressed data
+ * @param[in] outmax - size of out
+ *
+ * @return - length of the compressed data
+ * @retval  0 - the compressed data would not fit in outmax bytes
+ *
+ * @par MT-safe: Yes
+ **/
+static size_t
+tpp_lz_compress_block(const unsigned char *in, size_t inlen, unsigned char *out, size_t outmax)
+{
+	unsigned int table[1 << TPP_LZ_HASH_LOG];
+	const unsigned char *ip = in;
+	const unsigned char *anchor = in;
+	const unsigned char *iend = in + inlen;
+	const unsigned char *mflimit = iend - TPP_LZ_MFLIMIT;
+	const unsigned char *matchlimit = iend - TPP_LZ_LASTLITERALS;
+	const unsigned char *ref;
+	unsigned char *op = out;
+	unsigned char *oend = out + outmax;
+	unsigned char *token;
+	size_t litlen;
+	size_t mlen;
+	size_t off;
+	unsigned int h;
+
+	memset(table, 0, sizeof(table));
+	if (inlen > TPP_LZ_MFLIMIT) {
+		ip++;
+		while (ip <= mflimit) {
+			h = tpp_lz_hash(tpp_lz_read32(ip));
+			ref = in + table[h];
+			table[h] = ip - in;
+			if ((ip - ref) > TPP_LZ_MAX_DIST || tpp_lz_read32(ref) != tpp_lz_read32(ip)) {
+				/* step faster through data that does not compress */
+				ip += 1 + ((ip - anchor) >> 6);
+				continue;
+			}
+
+			while (ip > anchor && ref > in && ip[-1] == ref[-1]) {
+				ip--;
+				ref--;
+			}
+			mlen = TPP_LZ_MINMATCH;
+			while (ip + mlen < matchlimit && ip[mlen] == ref[mlen])
+				mlen++;
+
+			litlen = ip - anchor;
+			if ((size_t)(oend - op) < 1 + litlen + litlen / 255 + 1 + 2 + mlen / 255 + 1)
+				return 0;
+			token = op++;
+			if (litlen >= 15) {
+				*token = 15 << 4;
+				op = tpp_lz_put_len(op, litlen - 15);
+			} else
+				*token = litlen << 4;
+			memcpy(op, anchor, litlen);
+			op += litlen;
+
+			off = ip - ref;
+			*op++ = off & 0xff;
+			*op++ = (off >> 8) & 0xff;
+
+			mlen -= TPP_LZ_MINMATCH;
+			if (mlen >= 15) {
+				*token |= 15;
+				op = tpp_lz_put_len(op, mlen - 15);
+			} else
+				*token |= mlen;
+
+			ip += mlen + TPP_LZ_MINMATCH;
+			anchor = ip;
+			if (ip <= mflimit)
+				table[tpp_lz_hash(tpp_lz_read32(ip - 2))] = ip - 2 - in;
+		}
+	}
+
+	litlen = iend - anchor;
+	if ((size_t)(oend - op) < 1 + litlen + litlen / 255 + 1)
+		return 0;
+	token = op++;
+	if (litlen >= 15) {
+		*token = 15 << 4;
+		op = tpp_lz_put_len(op, litlen - 15);
+	} else
+		*token = litlen << 4;
+	memcpy(op, anchor, litlen);
+	op += litlen;
+
+	return op - out;
+}
+
+/**
+ * @brief Decompress a block of data in the LZ4 block format
+ *
+ * @param[in] in     - compressed data
+ * @param[in] inlen  - length of compressed data
+ * @param[out] out   - buffer for the data
+ * @param[in] outlen - exact length of the data
+ *
+ * @return - Error code
+ * @retval  0 - Success
+ * @retval -1 - the compressed data is corrupt
+ *
+ * @par MT-safe: Yes
+ **/
+static int
+tpp_lz_decompress_block(const unsigned char *in, size_t inlen, unsigned char *out, size_t outlen)
+{
+	const unsigned char *ip = in;
+	const unsigned char *iend = in + inlen;
+	const unsigned char *ref;
+	unsigned char *op = out;
+	unsigned char *oend = out + outlen;
+	unsigned int token;
+	unsigned int b;
+	size_t len;
+	size_t off;
+
+	while (ip < iend) {
+		token = *ip++;
+
+		len = token >> 4;
+		if (len == 15) {
+			do {
+				if (ip >= iend)
+					return -1;
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+		}
+		if (len > (size_t)(iend - ip) || len > (size_t)(oend - op))
+			return -1;
+		memcpy(op, ip, len);
+		op += len;
+		ip += len;
+		if (ip == iend)
+			break; /* the last sequence has no match */
+
+		if (iend - ip < 2)
+			return -1;
+		off = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (off == 0 || off > (size_t)(op - out))
+			return -1;
+
+		len = token & 15;
+		if (len == 15) {
+			do {
+				if (ip >= iend)
+					return -1;
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+		}
+		len += TPP_LZ_MINMATCH;
+		if (len > (size_t)(oend - op))
+			return -1;
+
+		ref = op - off;
+		if (off >= len) {
+			memcpy(op, ref, len);
+			op += len;
+		} else {
+			/* overlapping match repeats the last off bytes */
+			while (len--)
+				*op++ = *ref++;
+		}
+	}
+	return (op == oend) ? 0 : -1;
+}
+
+/**
+ * @brief Compress data with the lz codec
+ *
+ * @param[in] inbuf   - Ptr to buffer to compress
+ * @param[in] inlen   - The size of input buffer
+ * @param[out] outlen - The size of the compressed data
+ *
+ * @return      - Ptr to the compressed data buffer
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure, or the data did not get smaller
+ *
+ * @par MT-safe: Yes
+ **/
+static void *
+tpp_lz_deflate(void *inbuf, unsigned int inlen, unsigned int *outlen)
+{
+	unsigned char *data;
+	size_t len;
+
+	*outlen = 0;
+	if (inlen < 2)
+		return NULL;
+
+	data = malloc(inlen);
+	if (!data) {
+		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Out of memory allocating deflate buffer %u bytes", inlen);
+		tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
+		return NULL;
+	}
+	data[0] = TPP_LZ_MAGIC;
+	len = tpp_lz_compress_block(inbuf, inlen, data + 1, inlen - 2);
+	if (len == 0) {
+		free(data);
+		return NULL;
+	}
+	*outlen = len + 1;
+	return data;
+}
+
+/**
+ * @brief Decompress data compressed with the lz codec
+ *
+ * @param[in] inbuf  - Ptr to compress data buffer
+ * @param[in] inlen  - The size of input buffer
+ * @param[in] totlen - The total size of the uncompress data
+ *
+ * @return      - Ptr to the uncompressed data buffer
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure
+ *
+ * @par MT-safe: Yes
+ **/
+static void *
+tpp_lz_inflate(void *inbuf, unsigned int inlen, unsigned int totlen)
+{
+	void *outbuf;
+
+	outbuf = malloc(totlen ? totlen : 1);
+	if (!outbuf) {
+		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Out of memory allocating inflate buffer %u bytes", totlen);
+		tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
+		return NULL;
+	}
+	if (inlen < 1 || tpp_lz_decompress_block((unsigned char *) inbuf + 1, inlen - 1, outbuf, totlen) != 0) {
+		free(outbuf);
+		tpp_log_func(LOG_CRIT, __func__, "Decompression of lz data failed");
+		return NULL;
+	}
+	return outbuf;
+}
+
+/*
+ * The codecs data can be compressed with, indexed by enum tpp_codec_id
+ */
+static struct {
+	char *name;
+	void *(*compress)(void *, unsigned int, unsigned int *);
+} tpp_codecs[TPP_CODEC_MAX] = {
+	{"zlib", tpp_deflate},
+	{"lz", tpp_lz_deflate}
+};
+
+/**
+ * @brief Decide whether a message should be compressed
+ *
+ * @par Functionality:
+ *	Messages larger than the codec's threshold are compressed. The
+ *	threshold is adjusted by tpp_compress from what compression of recent
+ *	messages gained. Every TPP_COMPR_PROBE-th message under the threshold
+ *	(but over TPP_COMPR_SIZE) is compressed anyway, so that the threshold
+ *	comes back down when the data starts compressing well again.
+ *
+ * @param[in] codec - codec that would be used
+ * @param[in] len   - length of the message
+ *
+ * @return - whether to compress
+ * @retval  1 - compress the message
+ * @retval  0 - send it as is
+ *
+ * @par MT-safe: Yes
+ **/
+int
+tpp_compr_wanted(int codec, unsigned int len)
+{
+	tpp_tls_t *tls;
+	tpp_compr_stat_t *st;
+
+	if (len <= TPP_COMPR_SIZE)
+		return 0;
+	if ((tls = tpp_get_tls()) == NULL)
+		return 1;
+
+	st = &tls->compr_stat[codec];
+	if (len > (st->threshold ? st->threshold : TPP_COMPR_SIZE))
+		return 1;
+	if (++st->skipped < TPP_COMPR_PROBE)
+		return 0;
+	st->skipped = 0;
+	return 1;
+}
+
+/**
+ * @brief Compress data with the given codec and learn from the result
+ *
+ * @par Functionality:
+ *	Measures the bytes saved per usec of cpu spent and keeps a running
+ *	average of it. While the average stays under TPP_COMPR_MIN_GAIN the
+ *	threshold of the codec doubles (up to TPP_COMPR_MAX_SIZE), and once it
+ *	is back above twice that, the threshold halves (down to TPP_COMPR_SIZE).
+ *
+ * @param[in] codec   - codec to use
+ * @param[in] inbuf   - Ptr to buffer to compress
+ * @param[in] inlen   - The size of input buffer
+ * @param[out] outlen - The size of the compressed data
+ *
+ * @return      - Ptr to the compressed data buffer
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure, or the data did not get smaller, send it as is
+ *
+ * @par MT-safe: Yes
+ **/
+void *
+tpp_compress(int codec, void *inbuf, unsigned int inlen, unsigned int *outlen)
+{
+	struct timespec t0;
+	struct timespec t1;
+	tpp_tls_t *tls;
+	tpp_compr_stat_t *st;
+	unsigned long long usecs;
+	unsigned long long saved;
+	unsigned int gain;
+	void *data;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	data = tpp_codecs[codec].compress(inbuf, inlen, outlen);
+	if (data && *outlen >= inlen) {
+		free(data);
+		data = NULL;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	if ((tls = tpp_get_tls()) == NULL)
+		return data;
+	st = &tls->compr_stat[codec];
+
+	usecs = (t1.tv_sec - t0.tv_sec) * 1000000ULL + (t1.tv_nsec - t0.tv_nsec) / 1000;
+	if (usecs == 0)
+		usecs = 1;
+	saved = data ? inlen - *outlen : 0;
+	gain = (saved / usecs > UINT_MAX / 8) ? UINT_MAX / 8 : saved / usecs;
+	if (st->threshold == 0) {
+		/* first message compressed with this codec */
+		st->threshold = TPP_COMPR_SIZE;
+		st->gain = gain;
+	} else
+		st->gain = (st->gain * 7 + gain) / 8;
+
+	if (st->gain < TPP_COMPR_MIN_GAIN && st->threshold < TPP_COMPR_MAX_SIZE) {
+		st->threshold *= 2;
+		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "%s compression gains %u bytes/usec, threshold raised to %u",
+			tpp_codecs[codec].name, st->gain, st->threshold);
+		tpp_log_func(LOG_DEBUG, NULL, tpp_get_logbuf());
+	} else if (st->gain > 2 * TPP_COMPR_MIN_GAIN && st->threshold > TPP_COMPR_SIZE) {
+		st->threshold /= 2;
+		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "%s compression gains %u bytes/usec, threshold lowered to %u",
+			tpp_codecs[codec].name, st->gain, st->threshold);
+		tpp_log_func(LOG_DEBUG, NULL, tpp_get_logbuf());
+	}
+	return data;
+}
+
+/**
+ * @brief Decompress data compressed by tpp_compress with any codec
+ *
+ * @param[in] inbuf  - Ptr to compress data buffer
+ * @param[in] inlen  - The size of input buffer
+ * @param[in] totlen - The total size of the uncompress data
+ *
+ * @return      - Ptr to the uncompressed data buffer
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure
+ *
+ * @par MT-safe: Yes
+ **/
+void *
+tpp_decompress(void *inbuf, unsigned int inlen, unsigned int totlen)
+{
+	if (inlen > 0 && *(unsigned char *) inbuf == TPP_LZ_MAGIC)
+		return tpp_lz_inflate(inbuf, inlen, totlen);
+	return tpp_inflate(inbuf, inlen, totlen);
+}
+
 /**
  * @brief Convenience function to validate a tpp header
  *
@@ -2045,11 +2849,12 @@ tpp_get_addresses(char *names, int *count)
 
 			for (i = 0; i < tmp_count; i++) {
 				for (j = 0; j < tot_count; j++) {
-					if (memcmp(&addrs[j].ip, &addrs_tmp[i].ip, sizeof(addrs_tmp[i].ip)) == 0)
+					if (memcmp(&addrs[j].ip, &addrs_tmp[i].ip, sizeof(addrs_tmp[i].ip)) == 0 &&
+						addrs[j].port == htons(port))
 						break;
 				}
 
-				/* add if duplicate not found already */
+				/* add if duplicate not found already, names on other ports are other addresses */
 				if (j == tot_count) {
 					memmove(&addrs[tot_count], &addrs_tmp[i], sizeof(tpp_addr_t));
 					addrs[tot_count].port = htons(port);
@@ -46,6 +46,7 @@
 
 #include "portability.h"
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <sys/param.h>
 #include <sys/types.h>
@@ -53,6 +54,7 @@
 #include "server_limits.h"
 #include "list_link.h"
 #include "work_task.h"
+#include "pbs_idx.h"
 
 
 /* Global Data Items: */
@@ -63,12 +65,237 @@ extern pbs_list_head task_list_event; /* list of tasks responding to an event */
 extern int svr_delay_entry;
 extern time_t	time_now;
 
+/*
+ * The timed tasks are kept on task_list_timed in no particular order, and
+ * in a binary min-heap ordered by (wt_event, insertion sequence) so that
+ * adding a task and finding the next one to run do not need a list walk.
+ * The sequence number keeps tasks due at the same time in the order they
+ * were added, as the old sorted list did.
+ */
+typedef struct timed_ent {
+	long		  te_when;
+	unsigned long	  te_seq;
+	struct work_task *te_task;
+} timed_ent;
+
+static timed_ent *timed_heap = NULL;
+static int timed_heap_cnt = 0;
+static int timed_heap_max = 0;
+static unsigned long timed_seq = 0;
+
+/* index of tasks by wt_parm1, for has_task_by_parm1() and friends */
+static void *task_parm1_idx = NULL;
+
+/**
+ * @brief
+ *	Compare two timed heap entries
+ *
+ * @return int
+ * @retval 1 - if 'a' is due before 'b'
+ * @retval 0 - otherwise
+ */
+static int
+timed_before(timed_ent *a, timed_ent *b)
+{
+	if (a->te_when != b->te_when)
+		return (a->te_when < b->te_when);
+	return (a->te_seq < b->te_seq);
+}
+
+/**
+ * @brief
+ *	Put heap entry 'ent' in slot 'i' and record the slot in its task
+ */
+static void
+timed_heap_put(int i, timed_ent *ent)
+{
+	timed_heap[i] = *ent;
+	timed_heap[i].te_task->wt_heapidx = i;
+}
+
+/**
+ * @brief
+ *	Restore the heap property for the entry in slot 'i', moving it
+ *	toward the root or the leaves as needed.
+ *
+ * @param[in]	i	- slot of the entry which may be out of place
+ */
+static void
+timed_heap_fix(int i)
+{
+	timed_ent ent = timed_heap[i];
+	int parent;
+	int child;
+
+	while (i > 0) {
+		parent = (i - 1) / 2;
+		if (!timed_before(&ent, &timed_heap[parent]))
+			break;
+		timed_heap_put(i, &timed_heap[parent]);
+		i = parent;
+	}
+
+	while ((child = 2 * i + 1) < timed_heap_cnt) {
+		if (child + 1 < timed_heap_cnt && timed_before(&timed_heap[child + 1], &timed_heap[child]))
+			child++;
+		if (!timed_before(&timed_heap[child], &ent))
+			break;
+		timed_heap_put(i, &timed_heap[child]);
+		i = child;
+	}
+	timed_heap_put(i, &ent);
+}
+
+/**
+ * @brief
+ *	Add a timed task to the heap
+ *
+ * @param[in]	ptask	- task to add, wt_event holds the time it is due
+ *
+ * @return int
+ * @retval 0	- success
+ * @retval -1	- out of memory
+ */
+static int
+timed_heap_add(struct work_task *ptask)
+{
+	timed_ent ent;
+
+	if (timed_heap_cnt == timed_heap_max) {
+		int newmax = timed_heap_max ? timed_heap_max * 2 : 256;
+		timed_ent *tmp;
+
+		tmp = (timed_ent *) realloc(timed_heap, newmax * sizeof(timed_ent));
+		if (tmp == NULL)
+			return -1;
+		timed_heap = tmp;
+		timed_heap_max = newmax;
+	}
+
+	ent.te_when = ptask->wt_event;
+	ent.te_seq = timed_seq++;
+	ent.te_task = ptask;
+	timed_heap_put(timed_heap_cnt++, &ent);
+	timed_heap_fix(timed_heap_cnt - 1);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Remove a task from the timed heap, if it is there
+ *
+ * @param[in]	ptask	- task to remove
+ */
+static void
+timed_heap_remove(struct work_task *ptask)
+{
+	int i = ptask->wt_heapidx;
+
+	if (i < 0 || i >= timed_heap_cnt || timed_heap[i].te_task != ptask)
+		return;
+
+	ptask->wt_heapidx = -1;
+	if (--timed_heap_cnt > i) {
+		timed_heap_put(i, &timed_heap[timed_heap_cnt]);
+		timed_heap_fix(i);
+	}
+}
+
+/**
+ * @brief
+ *	Add a task to the parm1 index
+ *
+ * @param[in]	ptask	- task to add
+ */
+static void
+task_idx_add(struct work_task *ptask)
+{
+	if (ptask->wt_parm1 == NULL)
+		return;
+
+	if (task_parm1_idx == NULL) {
+		task_parm1_idx = pbs_idx_create(PBS_IDX_DUPS_OK, sizeof(void *));
+		if (task_parm1_idx == NULL)
+			return;
+	}
+	if (pbs_idx_insert(task_parm1_idx, &ptask->wt_parm1, ptask) == PBS_IDX_RET_OK)
+		ptask->wt_indexed = 1;
+}
+
+/**
+ * @brief
+ *	Remove a task from the parm1 index
+ *
+ * @param[in]	ptask	- task to remove
+ */
+static void
+task_idx_remove(struct work_task *ptask)
+{
+	void *idx_ctx = NULL;
+	void **pkey = (void **) &ptask->wt_parm1;
+	struct work_task *pt;
+
+	if (!ptask->wt_indexed)
+		return;
+
+	ptask->wt_indexed = 0;
+	while (pbs_idx_find(task_parm1_idx, (void **) &pkey, (void **) &pt, &idx_ctx) == PBS_IDX_RET_OK) {
+		if (memcmp(pkey, &ptask->wt_parm1, sizeof(void *)) != 0)
+			break;
+		if (pt == ptask) {
+			pbs_idx_delete_byctx(idx_ctx);
+			break;
+		}
+	}
+	pbs_idx_free_ctx(idx_ctx);
+}
+
+/**
+ * @brief
+ *	Find the first task on one of the task lists whose wt_parm1 is 'parm1'
+ *	and, if 'func' is not NULL, whose wt_func is 'func'.
+ *
+ * @note
+ *	Tasks taken off the task lists by their owner (e.g. deferred TPP
+ *	commands which live on the mom's list instead) are skipped, as the
+ *	list based search this replaces would not have seen them either.
+ *
+ * @return struct work_task *
+ * @retval task found
+ * @retval NULL if none
+ */
+static struct work_task *
+task_idx_find(void *parm1, void (*func)(struct work_task *))
+{
+	void *idx_ctx = NULL;
+	void **pkey = &parm1;
+	struct work_task *pt;
+	struct work_task *found = NULL;
+
+	if (task_parm1_idx == NULL)
+		return NULL;
+
+	while (pbs_idx_find(task_parm1_idx, (void **) &pkey, (void **) &pt, &idx_ctx) == PBS_IDX_RET_OK) {
+		if (memcmp(pkey, &parm1, sizeof(void *)) != 0)
+			break;
+		if (pt->wt_linkall.ll_next == &pt->wt_linkall)
+			continue;
+		if ((func != NULL) && (pt->wt_func != func))
+			continue;
+		found = pt;
+		break;
+	}
+	pbs_idx_free_ctx(idx_ctx);
+	return found;
+}
+
 /**
  *
  * @brief
  * 	Creates a task of type 'type', 'event_id', and when task is dispatched,
  *	execute func with argument 'parm'. The task is added to
- *	'task_list_immed' if 'type' is  WORK_Immed; otherwise, task is added
+ *	'task_list_immed' if 'type' is  WORK_Immed, to 'task_list_timed' and the
+ *	timed heap if 'type' is WORK_Timed; otherwise, task is added
  *	'task_list_event'.
  *
  * @param[in]	type - of task
@@ -84,7 +311,6 @@ extern time_t	time_now;
 struct work_task *set_task(enum work_type type, long event_id, void (*func)(struct work_task *) , void *parm)
 {
 	struct work_task *pnew;
-	struct work_task *pold;
 
 	pnew = (struct work_task *)malloc(sizeof(struct work_task));
 	if (pnew == NULL)
@@ -101,26 +327,49 @@ struct work_task *set_task(enum work_type type, long event_id, void (*func)(stru
 	pnew->wt_parm3 = NULL;
 	pnew->wt_aux   = 0;
 	pnew->wt_aux2  = 0;
+	pnew->wt_heapidx = -1;
+	pnew->wt_indexed = 0;
 
 	if (type == WORK_Immed)
 		append_link(&task_list_immed, &pnew->wt_linkall, pnew);
 	else if (type == WORK_Timed) {
-		pold = (struct work_task *)GET_NEXT(task_list_timed);
-		while (pold) {
-			if (pold->wt_event > pnew->wt_event)
-				break;
-			pold = (struct work_task *)GET_NEXT(pold->wt_linkall);
+		if (timed_heap_add(pnew) == -1) {
+			free(pnew);
+			return NULL;
 		}
-		if (pold)
-			insert_link(&pold->wt_linkall, &pnew->wt_linkall, pnew,
-				LINK_INSET_BEFORE);
-		else
-			append_link(&task_list_timed, &pnew->wt_linkall, pnew);
+		append_link(&task_list_timed, &pnew->wt_linkall, pnew);
 	} else
 		append_link(&task_list_event, &pnew->wt_linkall, pnew);
+
+	task_idx_add(pnew);
 	return (pnew);
 }
 
+/**
+ *
+ * @brief
+ * 	Change the time at which a timed task is to be dispatched
+ *
+ * @param[in]	ptask	- the timed task
+ * @param[in]	when	- new time for the task
+ *
+ * @note
+ *	wt_event of a timed task must not be changed directly as the
+ *	task would then be out of place in the timed heap.
+ */
+
+void
+set_task_time(struct work_task *ptask, long when)
+{
+	ptask->wt_event = when;
+	if (ptask->wt_heapidx >= 0 && ptask->wt_heapidx < timed_heap_cnt &&
+		timed_heap[ptask->wt_heapidx].te_task == ptask) {
+		timed_heap[ptask->wt_heapidx].te_when = when;
+		timed_heap[ptask->wt_heapidx].te_seq = timed_seq++;
+		timed_heap_fix(ptask->wt_heapidx);
+	}
+}
+
 /**
  *
  * @brief
@@ -137,6 +386,8 @@ struct work_task *set_task(enum work_type type, long event_id, void (*func)(stru
 void
 dispatch_task(struct work_task *ptask)
 {
+	timed_heap_remove(ptask);
+	task_idx_remove(ptask);
 	delete_link(&ptask->wt_linkall);
 	delete_link(&ptask->wt_linkobj);
 	delete_link(&ptask->wt_linkobj2);
@@ -156,6 +407,8 @@ dispatch_task(struct work_task *ptask)
 void
 delete_task(struct work_task *ptask)
 {
+	timed_heap_remove(ptask);
+	task_idx_remove(ptask);
 	delete_link(&ptask->wt_linkobj);
 	delete_link(&ptask->wt_linkobj2);
 	delete_link(&ptask->wt_linkall);
@@ -188,13 +441,21 @@ delete_task_by_parm1_func(void *parm1, void (*func)(struct work_task *), enum wt
 	if (parm1 == NULL && func == NULL)
 		return;
 
+	if (parm1 != NULL) {
+		/* use the index rather than walking every task */
+		while ((ptask = task_idx_find(parm1, func)) != NULL) {
+			delete_task(ptask);
+			if (option == DELETE_ONE)
+				return;
+		}
+		return;
+	}
+
 	for (i = 0; i < 3; i++) {
 		for (ptask = (struct work_task *) GET_NEXT(task_lists[i]); ptask; ptask = ptask_next) {
 			ptask_next = (struct work_task *) GET_NEXT(ptask->wt_linkall);
 
-			if ((parm1 != NULL) && (ptask->wt_parm1 != parm1))
-				continue;
-			if ((func != NULL) && (ptask->wt_func != func))
+			if (ptask->wt_func != func)
 				continue;
 
 			delete_task(ptask);
@@ -219,34 +480,10 @@ delete_task_by_parm1_func(void *parm1, void (*func)(struct work_task *), enum wt
 int
 has_task_by_parm1(void *parm1)
 {
-	struct work_task  *ptask;
-
-	/* only 1 ptask can be possibly matched */
-	ptask = (struct work_task *)GET_NEXT(task_list_event);
-	while (ptask) {
-		if ((ptask->wt_parm1 != NULL) && (ptask->wt_parm1 == parm1)) {
-			return 1;
-		}
-		ptask = (struct work_task *)GET_NEXT(ptask->wt_linkall);
-	}
+	if (parm1 == NULL)
+		return 0;
 
-	ptask = (struct work_task *)GET_NEXT(task_list_timed);
-	while (ptask) {
-		if ((ptask->wt_parm1 != NULL) && (ptask->wt_parm1 == parm1)) {
-			return 1;
-		}
-		ptask = (struct work_task *)GET_NEXT(ptask->wt_linkall);
-	}
-
-	ptask = (struct work_task *)GET_NEXT(task_list_immed);
-	while (ptask) {
-		if ((ptask->wt_parm1 != NULL) && (ptask->wt_parm1 == parm1)) {
-			return 1;
-		}
-		ptask = (struct work_task *)GET_NEXT(ptask->wt_linkall);
-	}
-
-	return 0;
+	return (task_idx_find(parm1, NULL) != NULL);
 }
 
 /**
@@ -255,7 +492,7 @@ has_task_by_parm1(void *parm1)
  *	1. If svr_delay_entry is set, then a delayed task in the
  *	   task_list_event is ready so find and process it.
  *	2. All items on the immediate list, then
- *	3. All items on the timed task list which have expired times
+ *	3. All items on the timed task heap which have expired times
  *
  * @return time_t
  * @retval The amount of time till next task
@@ -292,7 +529,8 @@ default_next_task(void)
 	while ((ptask=(struct work_task *)GET_NEXT(task_list_immed)) != NULL)
 		dispatch_task(ptask);
 
-	while ((ptask=(struct work_task *)GET_NEXT(task_list_timed))!=NULL) {
+	while (timed_heap_cnt > 0) {
+		ptask = timed_heap[0].te_task;
 		if ((delay = ptask->wt_event - time_now) > 0) {
 			if (tilwhen > delay)
 				tilwhen = delay;
@@ -1233,6 +1233,8 @@ post_alps_cancel_resv(struct work_task *ptask)
 void
 del_job_hw(job *pjob)
 {
+	cgroup_job_delete(pjob);
+
 #if MOM_ALPS
 	int		i;
 	int		j;
@@ -0,0 +1,1004 @@
+/*
+ * Copyright (C) 1994-2020 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file	mom_cgroup.c
+ * @brief
+ * Native cgroup v2 management of jobs.
+ *
+ * With $native_cgroups set, MoM places every job in a cgroup of its own
+ * below <cgroup2 mount>/<cgroup_prefix>.service/jobid/<jobid>, sets its
+ * cpuset and memory limits from the resources assigned on this host, and
+ * removes it when the job is deleted.  The cpu time and memory peak of the
+ * cgroup are then used when sampling the job (see mom_mach.c).
+ *
+ * The settings are read from the same pbs_cgroups.CF used by the cgroups
+ * hook, in mom_priv/hooks, and reread whenever the file changes.  Only the
+ * cpuset, memory and memsw controllers are handled here; devices, hugetlb
+ * and the reserve_* adjustments of the vnode memory remain with the hook.
+ */
+
+#include "pbs_config.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <dirent.h>
+#include <sched.h>
+#include <mntent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+
+#include "pbs_error.h"
+#include "list_link.h"
+#include "server_limits.h"
+#include "attribute.h"
+#include "resource.h"
+#include "job.h"
+#include "log.h"
+#include "work_task.h"
+#include "mom_func.h"
+#include "mom_mach.h"
+#include "libutil.h"
+#include "pbs_json.h"
+
+#define	CGROUP_CONF		"pbs_cgroups.CF"
+#define	CGROUP_RMDIR_TRIES	30	/* attempts to remove a busy cgroup */
+
+/*
+ * Settings taken from pbs_cgroups.CF
+ */
+typedef struct cg_conf {
+	int		cc_enabled;	/* not excluded on this host */
+	char		cc_prefix[MAXPATHLEN + 1];
+	int		cc_use_hyperthreads;
+	int		cc_ncpus_are_cores;
+	int		cc_cpuset;
+	int		cc_mem_fences;
+	cpu_set_t	cc_exclude_cpus;
+	int		cc_memory;
+	int		cc_soft_limit;
+	long long	cc_mem_default;		/* kb */
+	int		cc_memsw;
+	long long	cc_memsw_default;	/* kb */
+} cg_conf_t;
+
+static cg_conf_t	cg_conf;
+static time_t		cg_conf_mtime = -1;	/* mtime of the file read, 0 for defaults */
+static char		*cg_root = NULL;	/* mount point of the cgroup v2 hierarchy */
+static int		cg_no_root_logged = 0;
+
+extern	int	native_cgroups;
+extern	char	*path_hooks;
+extern	char	mom_host[];
+extern	char	mom_short_name[];
+extern	time_t	time_now;
+
+/**
+ * @brief
+ *	Get a section of the configuration, i.e. an object member of an object.
+ *
+ * @param[in] obj - object, may be NULL
+ * @param[in] key - member name
+ *
+ * @return	JsonObject *
+ * @retval	the section, freed with json_object_free()
+ * @retval	NULL	missing or not an object
+ */
+static JsonObject *
+cj_get_obj(JsonObject *obj, char *key)
+{
+	return (json_object_parse(json_object_get(obj, key), NULL, 0));
+}
+
+/**
+ * @brief
+ *	Get a boolean member of an object.
+ *
+ * @param[in] obj - object, may be NULL
+ * @param[in] key - member name
+ * @param[in] dflt - value if the member is missing
+ *
+ * @return	int
+ * @retval	TRUE or FALSE
+ */
+static int
+cj_get_bool(JsonObject *obj, char *key, int dflt)
+{
+	const char	*val = json_object_get(obj, key);
+	char		*end;
+	double		num;
+
+	if (val == NULL)
+		return dflt;
+	if (strcmp(val, "true") == 0)
+		return TRUE;
+	if (strcmp(val, "false") == 0)
+		return FALSE;
+	num = strtod(val, &end);
+	if (end == val || *end != '\0')
+		return dflt;
+	return (num != 0);
+}
+
+/**
+ * @brief
+ *	Get a size member of an object, e.g. "256MB".
+ *
+ * @param[in] obj - object, may be NULL
+ * @param[in] key - member name
+ * @param[in] dflt - value in kb if the member is missing
+ *
+ * @return	long long
+ * @retval	size in kb
+ */
+static long long
+cj_get_size(JsonObject *obj, char *key, long long dflt)
+{
+	const char	*val = json_object_get(obj, key);
+	char		*str;
+	char		*end;
+	long long	size;
+	double		num;
+
+	if (val == NULL)
+		return dflt;
+	if ((str = json_string_decode(val)) != NULL) {
+		size = to_kbsize(str);
+		free(str);
+		return size;
+	}
+	num = strtod(val, &end);
+	if (end == val || *end != '\0')
+		return dflt;
+	return ((long long)num >> 10);
+}
+
+/**
+ * @brief
+ *	Check whether this host is named in a list of host names.
+ *
+ * @param[in] arr - JSON text of each element of the list, may be NULL
+ *
+ * @return	int
+ * @retval	TRUE	this host is in the list
+ * @retval	FALSE	it is not
+ */
+static int
+cj_has_host(char **arr)
+{
+	char	*host;
+	int	found = FALSE;
+	int	i;
+
+	for (i = 0; arr != NULL && arr[i] != NULL && !found; i++) {
+		if ((host = json_string_decode(arr[i])) == NULL)
+			continue;
+		found = (strcasecmp(host, mom_short_name) == 0) ||
+			(strcasecmp(host, mom_host) == 0);
+		free(host);
+	}
+	return found;
+}
+
+/**
+ * @brief
+ *	Check whether this host is named in the "exclude_hosts" list of an
+ *	object.
+ *
+ * @param[in] obj - object, may be NULL
+ *
+ * @return	int
+ * @retval	TRUE	this host is excluded
+ * @retval	FALSE	it is not
+ */
+static int
+cj_excluded(JsonObject *obj)
+{
+	char	**arr;
+	int	rc;
+
+	arr = json_array_parse(json_object_get(obj, "exclude_hosts"), NULL, 0);
+	rc = cj_has_host(arr);
+	free_string_array(arr);
+	return rc;
+}
+
+/**
+ * @brief
+ *	Check whether a controller section is enabled on this host.  As in
+ *	the cgroups hook, a missing section or one without "enabled" is off.
+ *
+ * @param[in] ctl - controller section, may be NULL
+ *
+ * @return	int
+ * @retval	TRUE or FALSE
+ */
+static int
+cj_ctl_enabled(JsonObject *ctl)
+{
+	if (!cj_get_bool(ctl, "enabled", FALSE))
+		return FALSE;
+	return (!cj_excluded(ctl));
+}
+
+/**
+ * @brief
+ *	Parse a cpu list such as "0-3,8,10-11" into a cpu set.
+ *
+ * @param[in] list - cpu list
+ * @param[out] set - cpus of the list, added to what is already set
+ *
+ * @return void
+ */
+static void
+cpulist_parse(char *list, cpu_set_t *set)
+{
+	char	*p = list;
+	char	*end;
+	long	lo;
+	long	hi;
+
+	while (*p != '\0') {
+		lo = strtol(p, &end, 10);
+		if (end == p)
+			break;
+		hi = lo;
+		p = end;
+		if (*p == '-') {
+			hi = strtol(p + 1, &end, 10);
+			p = end;
+		}
+		for (; lo <= hi && lo < CPU_SETSIZE; lo++)
+			CPU_SET(lo, set);
+		while (*p != '\0' && !isdigit((int)*p))
+			p++;
+	}
+}
+
+/**
+ * @brief
+ *	Format a cpu set as a cpu list such as "0-3,8".
+ *
+ * @param[in] set - cpu set
+ * @param[out] buf - buffer for the list
+ * @param[in] len - size of buf
+ *
+ * @return void
+ */
+static void
+cpulist_format(cpu_set_t *set, char *buf, size_t len)
+{
+	size_t	n = 0;
+	int	lo;
+	int	hi;
+
+	buf[0] = '\0';
+	for (lo = 0; lo < CPU_SETSIZE; lo++) {
+		if (!CPU_ISSET(lo, set))
+			continue;
+		for (hi = lo; hi + 1 < CPU_SETSIZE && CPU_ISSET(hi + 1, set); hi++)
+			;
+		if (hi == lo)
+			n += snprintf(buf + n, len - n, "%s%d", n ? "," : "", lo);
+		else
+			n += snprintf(buf + n, len - n, "%s%d-%d", n ? "," : "", lo, hi);
+		if (n >= len) {
+			buf[len - 1] = '\0';
+			return;
+		}
+		lo = hi;
+	}
+}
+
+/**
+ * @brief
+ *	Read the first line of a file, without the newline.
+ *
+ * @param[in] path - file to read
+ * @param[out] buf - buffer for the line
+ * @param[in] len - size of buf
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	Error
+ */
+static int
+cgroup_read_line(char *path, char *buf, size_t len)
+{
+	FILE	*fp;
+
+	if ((fp = fopen(path, "r")) == NULL)
+		return -1;
+	if (fgets(buf, len, fp) == NULL)
+		buf[0] = '\0';
+	fclose(fp);
+	buf[strcspn(buf, "\n")] = '\0';
+	return 0;
+}
+
+/**
+ * @brief
+ *	Format a path into a buffer, refusing one that does not fit rather
+ *	than acting on a truncated path.
+ *
+ * @param[out] buf - buffer for the path
+ * @param[in] len - size of buf
+ * @param[in] fmt - format of the path, followed by its arguments
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	Path too long, logged, errno set to ENAMETOOLONG
+ */
+static int
+cgroup_path(char *buf, size_t len, const char *fmt, ...)
+{
+	va_list	args;
+	int	n;
+
+	va_start(args, fmt);
+	n = vsnprintf(buf, len, fmt, args);
+	va_end(args);
+	if (n < 0 || (size_t)n >= len) {
+		log_errf(ENAMETOOLONG, __func__, "path too long: %s...", buf);
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Write a value to a cgroup interface file.
+ *
+ * @param[in] dir - cgroup directory
+ * @param[in] file - interface file, e.g. "memory.max"
+ * @param[in] val - value to write
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	Error, errno set
+ */
+static int
+cgroup_write(char *dir, char *file, char *val)
+{
+	char	path[MAXPATHLEN + 1];
+	int	fd;
+	ssize_t	len = strlen(val);
+	int	rc = 0;
+
+	if (cgroup_path(path, sizeof(path), "%s/%s", dir, file) == -1)
+		return -1;
+	if ((fd = open(path, O_WRONLY)) == -1)
+		return -1;
+	if (write(fd, val, len) != len)
+		rc = -1;
+	if (close(fd) == -1)
+		rc = -1;
+	return rc;
+}
+
+/**
+ * @brief
+ *	Set the defaults of the cgroups hook configuration: every controller
+ *	disabled and no default memory limit, as in pbs_cgroups.PY.
+ *
+ * @return void
+ */
+static void
+cgroup_conf_defaults(void)
+{
+	memset(&cg_conf, 0, sizeof(cg_conf));
+	cg_conf.cc_enabled = TRUE;
+	strcpy(cg_conf.cc_prefix, "pbs_jobs");
+	cg_conf.cc_mem_fences = TRUE;
+	CPU_ZERO(&cg_conf.cc_exclude_cpus);
+}
+
+/**
+ * @brief
+ *	Read pbs_cgroups.CF from the hooks directory if it changed since it
+ *	was last read.  The defaults are used when there is no such file.
+ *
+ * @return void
+ */
+static void
+cgroup_conf_load(void)
+{
+	char		path[MAXPATHLEN + 1];
+	char		msg[LOG_BUF_SIZE];
+	struct stat	sb;
+	char		*text = NULL;
+	char		*str;
+	char		**arr;
+	JsonObject	*top = NULL;
+	JsonObject	*cgroup = NULL;
+	JsonObject	*ctl = NULL;
+	FILE		*fp = NULL;
+	char		*end;
+	double		num;
+	int		i;
+
+	if (cgroup_path(path, sizeof(path), "%s%s", path_hooks, CGROUP_CONF) == -1)
+		return;
+	if (stat(path, &sb) == -1) {
+		if (cg_conf_mtime != 0) {
+			cgroup_conf_defaults();
+			cg_conf_mtime = 0;
+		}
+		return;
+	}
+	if (sb.st_mtime == cg_conf_mtime)
+		return;
+	cg_conf_mtime = sb.st_mtime;
+	cgroup_conf_defaults();
+
+	if ((text = malloc(sb.st_size + 1)) == NULL ||
+		(fp = fopen(path, "r")) == NULL) {
+		log_err(errno, __func__, path);
+		goto done;
+	}
+	text[fread(text, 1, sb.st_size, fp)] = '\0';
+	if ((top = json_object_parse(text, msg, sizeof(msg))) == NULL) {
+		log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_FILE, LOG_ERR, __func__,
+			"syntax error in " CGROUP_CONF ": %s, using the defaults", msg);
+		goto done;
+	}
+
+	if ((str = json_string_decode(json_object_get(top, "cgroup_prefix"))) != NULL) {
+		if (str[0] != '\0' && strchr(str, '/') == NULL &&
+			strlen(str) < sizeof(cg_conf.cc_prefix))
+			strcpy(cg_conf.cc_prefix, str);
+		free(str);
+	}
+	if (cj_excluded(top))
+		cg_conf.cc_enabled = FALSE;
+	if ((arr = json_array_parse(json_object_get(top, "run_only_on_hosts"), NULL, 0)) != NULL) {
+		if (arr[0] != NULL && !cj_has_host(arr))
+			cg_conf.cc_enabled = FALSE;
+		free_string_array(arr);
+	}
+	cg_conf.cc_use_hyperthreads = cj_get_bool(top, "use_hyperthreads", FALSE);
+	cg_conf.cc_ncpus_are_cores = cj_get_bool(top, "ncpus_are_cores", FALSE);
+
+	cgroup = cj_get_obj(top, "cgroup");
+
+	ctl = cj_get_obj(cgroup, "cpuset");
+	cg_conf.cc_cpuset = cj_ctl_enabled(ctl);
+	cg_conf.cc_mem_fences = cj_get_bool(ctl, "mem_fences", TRUE);
+	if ((arr = json_array_parse(json_object_get(ctl, "exclude_cpus"), NULL, 0)) != NULL) {
+		for (i = 0; arr[i] != NULL; i++) {
+			if ((str = json_string_decode(arr[i])) != NULL) {
+				cpulist_parse(str, &cg_conf.cc_exclude_cpus);
+				free(str);
+				continue;
+			}
+			num = strtod(arr[i], &end);
+			if (end != arr[i] && *end == '\0' && num >= 0 && num < CPU_SETSIZE)
+				CPU_SET((int)num, &cg_conf.cc_exclude_cpus);
+		}
+		free_string_array(arr);
+	}
+	json_object_free(ctl);
+
+	ctl = cj_get_obj(cgroup, "memory");
+	cg_conf.cc_memory = cj_ctl_enabled(ctl);
+	cg_conf.cc_soft_limit = cj_get_bool(ctl, "soft_limit", FALSE);
+	cg_conf.cc_mem_default = cj_get_size(ctl, "default", cg_conf.cc_mem_default);
+	json_object_free(ctl);
+
+	ctl = cj_get_obj(cgroup, "memsw");
+	cg_conf.cc_memsw = cj_ctl_enabled(ctl);
+	cg_conf.cc_memsw_default = cj_get_size(ctl, "default", cg_conf.cc_memsw_default);
+	json_object_free(ctl);
+
+	ctl = cj_get_obj(cgroup, "devices");
+	i = cj_ctl_enabled(ctl);
+	json_object_free(ctl);
+	ctl = cj_get_obj(cgroup, "hugetlb");
+	if (i || cj_ctl_enabled(ctl))
+		log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_FILE, LOG_INFO, __func__,
+			"devices and hugetlb are left to the cgroups hook");
+	json_object_free(ctl);
+
+	snprintf(log_buffer, sizeof(log_buffer),
+		"read %s, prefix %s, cpuset %s, memory %s, memsw %s", path,
+		cg_conf.cc_prefix, cg_conf.cc_cpuset ? "on" : "off",
+		cg_conf.cc_memory ? "on" : "off", cg_conf.cc_memsw ? "on" : "off");
+	log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_FILE, LOG_INFO, __func__, log_buffer);
+
+done:
+	if (fp != NULL)
+		fclose(fp);
+	free(text);
+	json_object_free(cgroup);
+	json_object_free(top);
+}
+
+/**
+ * @brief
+ *	Find the mount point of the cgroup v2 hierarchy.
+ *
+ * @return	char *
+ * @retval	mount point
+ * @retval	NULL	cgroup v2 is not mounted
+ */
+static char *
+cgroup_root(void)
+{
+	struct mntent	*mnt;
+	FILE		*fp;
+
+	if (cg_root != NULL)
+		return cg_root;
+	if ((fp = setmntent("/proc/mounts", "r")) == NULL)
+		return NULL;
+	while ((mnt = getmntent(fp)) != NULL) {
+		if (strcmp(mnt->mnt_type, "cgroup2") == 0) {
+			cg_root = strdup(mnt->mnt_dir);
+			break;
+		}
+	}
+	endmntent(fp);
+	if (cg_root == NULL && !cg_no_root_logged) {
+		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_WARNING, __func__,
+			"no cgroup v2 hierarchy mounted, $native_cgroups ignored");
+		cg_no_root_logged = 1;
+	}
+	return cg_root;
+}
+
+/**
+ * @brief
+ *	Enable the controllers in use for the cgroups below a directory.
+ *
+ * @param[in] dir - cgroup directory
+ *
+ * @return void
+ */
+static void
+cgroup_enable(char *dir)
+{
+	/* one at a time, a controller missing here must not stop the others */
+	(void)cgroup_write(dir, "cgroup.subtree_control", "+cpu");
+	if (cg_conf.cc_cpuset)
+		(void)cgroup_write(dir, "cgroup.subtree_control", "+cpuset");
+	if (cg_conf.cc_memory || cg_conf.cc_memsw)
+		(void)cgroup_write(dir, "cgroup.subtree_control", "+memory");
+}
+
+/**
+ * @brief
+ *	Make the directory holding the job cgroups,
+ *	<mount>/<cgroup_prefix>.service/jobid.
+ *
+ * @param[out] dir - buffer for the directory
+ * @param[in] len - size of dir
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	Error
+ */
+static int
+cgroup_make_parent(char *dir, size_t len)
+{
+	cgroup_enable(cg_root);
+
+	if (cgroup_path(dir, len, "%s/%s.service", cg_root, cg_conf.cc_prefix) == -1)
+		return -1;
+	if (mkdir(dir, 0755) == -1 && errno != EEXIST)
+		goto err;
+	cgroup_enable(dir);
+
+	if (cgroup_path(dir, len, "%s/%s.service/jobid", cg_root, cg_conf.cc_prefix) == -1)
+		return -1;
+	if (mkdir(dir, 0755) == -1 && errno != EEXIST)
+		goto err;
+	cgroup_enable(dir);
+	return 0;
+
+err:
+	log_err(errno, __func__, dir);
+	return -1;
+}
+
+/**
+ * @brief
+ *	Collect the cpus already given to the other job cgroups.
+ *
+ * @param[in] parent - directory holding the job cgroups
+ * @param[in] self - name of the cgroup of the job being placed
+ * @param[out] used - cpus in use
+ *
+ * @return void
+ */
+static void
+cgroup_used_cpus(char *parent, char *self, cpu_set_t *used)
+{
+	DIR		*dir;
+	struct dirent	*pde;
+	char		path[MAXPATHLEN + 1];
+	char		line[4096];
+
+	CPU_ZERO(used);
+	if ((dir = opendir(parent)) == NULL)
+		return;
+	while ((pde = readdir(dir)) != NULL) {
+		if (pde->d_name[0] == '.' || strcmp(pde->d_name, self) == 0)
+			continue;
+		if (cgroup_path(path, sizeof(path), "%s/%s/cpuset.cpus",
+			parent, pde->d_name) == 0 &&
+			cgroup_read_line(path, line, sizeof(line)) == 0)
+			cpulist_parse(line, used);
+	}
+	closedir(dir);
+}
+
+/**
+ * @brief
+ *	Choose the cpus of a job and fence its memory to their NUMA nodes.
+ *	A unit of ncpus is a thread, a whole core with ncpus_are_cores, or
+ *	the first thread of a core when use_hyperthreads is off.
+ *
+ * @param[in] pjob - job pointer
+ * @param[in] parent - directory holding the job cgroups
+ * @param[in] cg - cgroup of the job
+ * @param[in] ncpus - number of cpus assigned on this host
+ *
+ * @return void
+ */
+static void
+cgroup_set_cpuset(job *pjob, char *parent, char *cg, int ncpus)
+{
+	char		path[MAXPATHLEN + 1];
+	char		line[4096];
+	cpu_set_t	avail;
+	cpu_set_t	used;
+	cpu_set_t	mine;
+	cpu_set_t	sibs;
+	cpu_set_t	mems;
+	DIR		*dir;
+	struct dirent	*pde;
+	int		cpu;
+	int		got = 0;
+	int		i;
+
+	if (cgroup_path(path, sizeof(path), "%s/cpuset.cpus.effective", parent) == -1 ||
+		cgroup_read_line(path, line, sizeof(line)) == -1)
+		return;
+	CPU_ZERO(&avail);
+	cpulist_parse(line, &avail);
+	cgroup_used_cpus(parent, pjob->ji_qs.ji_jobid, &used);
+
+	CPU_ZERO(&mine);
+	for (cpu = 0; cpu < CPU_SETSIZE && got < ncpus; cpu++) {
+		if (!CPU_ISSET(cpu, &avail))
+			continue;
+		CPU_ZERO(&sibs);
+		snprintf(path, sizeof(path),
+			"/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+		if (cgroup_read_line(path, line, sizeof(line)) == 0)
+			cpulist_parse(line, &sibs);
+		CPU_SET(cpu, &sibs);
+
+		if (!cg_conf.cc_use_hyperthreads || cg_conf.cc_ncpus_are_cores) {
+			/* cores are handed out from their first thread only */
+			for (i = 0; i < cpu && !CPU_ISSET(i, &sibs); i++)
+				;
+			if (i < cpu)
+				continue;
+		}
+		if (!cg_conf.cc_use_hyperthreads || !cg_conf.cc_ncpus_are_cores) {
+			CPU_ZERO(&sibs);
+			CPU_SET(cpu, &sibs);
+		}
+		for (i = 0; i < CPU_SETSIZE; i++) {
+			if (CPU_ISSET(i, &sibs) && (CPU_ISSET(i, &used) ||
+				CPU_ISSET(i, &cg_conf.cc_exclude_cpus) || !CPU_ISSET(i, &avail)))
+				break;
+		}
+		if (i < CPU_SETSIZE)
+			continue;
+		CPU_OR(&mine, &mine, &sibs);
+		got++;
+	}
+	if (got < ncpus) {
+		snprintf(log_buffer, sizeof(log_buffer),
+			"only %d of %d cpus free, cpuset not set", got, ncpus);
+		log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_WARNING,
+			pjob->ji_qs.ji_jobid, log_buffer);
+		return;
+	}
+
+	cpulist_format(&mine, line, sizeof(line));
+	if (cgroup_write(cg, "cpuset.cpus", line) == -1) {
+		log_joberr(errno, __func__, "cpuset.cpus", pjob->ji_qs.ji_jobid);
+		return;
+	}
+	if (!cg_conf.cc_mem_fences || (dir = opendir("/sys/devices/system/node")) == NULL)
+		return;
+
+	CPU_ZERO(&mems);	/* node numbers, the cpu set is just a bitmap */
+	while ((pde = readdir(dir)) != NULL) {
+		int	node;
+
+		if (sscanf(pde->d_name, "node%d", &node) != 1 ||
+			node < 0 || node >= CPU_SETSIZE)
+			continue;
+		snprintf(path, sizeof(path),
+			"/sys/devices/system/node/%s/cpulist", pde->d_name);
+		if (cgroup_read_line(path, line, sizeof(line)) == -1)
+			continue;
+		CPU_ZERO(&sibs);
+		cpulist_parse(line, &sibs);
+		CPU_AND(&sibs, &sibs, &mine);
+		if (CPU_COUNT(&sibs) > 0)
+			CPU_SET(node, &mems);
+	}
+	closedir(dir);
+	if (CPU_COUNT(&mems) == 0)
+		return;
+	cpulist_format(&mems, line, sizeof(line));
+	if (cgroup_write(cg, "cpuset.mems", line) == -1)
+		log_joberr(errno, __func__, "cpuset.mems", pjob->ji_qs.ji_jobid);
+}
+
+/**
+ * @brief
+ *	Set the memory limits of a job cgroup.
+ *
+ * @param[in] pjob - job pointer
+ * @param[in] cg - cgroup of the job
+ * @param[in] mem - mem assigned on this host in kb, 0 if none
+ * @param[in] vmem - vmem assigned on this host in kb, 0 if none
+ *
+ * @return void
+ */
+static void
+cgroup_set_memory(job *pjob, char *cg, long long mem, long long vmem)
+{
+	char	val[32];
+
+	if (mem <= 0)
+		mem = cg_conf.cc_mem_default;
+	if (cg_conf.cc_memory && mem > 0) {
+		snprintf(val, sizeof(val), "%lld", mem << 10);
+		if (cgroup_write(cg, cg_conf.cc_soft_limit ? "memory.high" : "memory.max", val) == -1)
+			log_joberr(errno, __func__, "memory limit", pjob->ji_qs.ji_jobid);
+	}
+	if (cg_conf.cc_memsw) {
+		/* v2 limits swap on its own, vmem covers memory and swap */
+		if (vmem <= 0)
+			vmem = cg_conf.cc_memsw_default;
+		if (vmem <= 0)
+			return;
+		snprintf(val, sizeof(val), "%lld", (vmem > mem) ? ((vmem - mem) << 10) : 0);
+		if (cgroup_write(cg, "memory.swap.max", val) == -1)
+			log_joberr(errno, __func__, "memory.swap.max", pjob->ji_qs.ji_jobid);
+	}
+}
+
+/**
+ * @brief
+ *	Create the cgroup of a job and set its limits from the resources
+ *	assigned to the job on this host.  Called by MoM before forking the
+ *	first process of the job or of a task on this host; a cgroup made
+ *	earlier is kept as it is.
+ *
+ * @param[in] pjob - job pointer
+ *
+ * @return	int
+ * @retval	0	Success, or native cgroups not in use
+ * @retval	-1	Error, the cgroup could not be made
+ */
+int
+cgroup_job_create(job *pjob)
+{
+	char		parent[MAXPATHLEN + 1];
+	char		cg[MAXPATHLEN + 1];
+	resc_limit_t	*prl = NULL;
+
+	if (!native_cgroups)
+		return 0;
+	cgroup_conf_load();
+	if (!cg_conf.cc_enabled || cgroup_root() == NULL)
+		return 0;
+	if (pjob->ji_cgroup != NULL && access(pjob->ji_cgroup, F_OK) == 0)
+		return 0;
+
+	if (cgroup_make_parent(parent, sizeof(parent)) == -1)
+		return -1;
+	if (cgroup_path(cg, sizeof(cg), "%s/%s", parent, pjob->ji_qs.ji_jobid) == -1)
+		return -1;
+	if (mkdir(cg, 0755) == -1) {
+		if (errno != EEXIST) {
+			log_joberr(errno, __func__, cg, pjob->ji_qs.ji_jobid);
+			return -1;
+		}
+	} else {
+		if (pjob->ji_hosts != NULL && pjob->ji_nodeid >= 0)
+			prl = &pjob->ji_hosts[pjob->ji_nodeid].hn_nrlimit;
+		if (cg_conf.cc_cpuset && prl != NULL && prl->rl_ncpus > 0)
+			cgroup_set_cpuset(pjob, parent, cg, prl->rl_ncpus);
+		cgroup_set_memory(pjob, cg,
+			(prl != NULL) ? prl->rl_mem : 0, (prl != NULL) ? prl->rl_vmem : 0);
+	}
+
+	free(pjob->ji_cgroup);
+	if ((pjob->ji_cgroup = strdup(cg)) == NULL) {
+		log_err(errno, __func__, "strdup");
+		return -1;
+	}
+	log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_DEBUG,
+		pjob->ji_qs.ji_jobid, "created cgroup");
+	return 0;
+}
+
+/**
+ * @brief
+ *	Move the calling process into the cgroup of its job.  Called in the
+ *	child after fork, before it becomes the job.
+ *
+ * @param[in] pjob - job pointer
+ *
+ * @return	int
+ * @retval	0	Success, or the job has no native cgroup
+ * @retval	-1	Error, message in log_buffer
+ */
+int
+cgroup_job_attach(job *pjob)
+{
+	if (!native_cgroups || pjob->ji_cgroup == NULL)
+		return 0;
+	if (cgroup_write(pjob->ji_cgroup, "cgroup.procs", "0") == -1) {
+		snprintf(log_buffer, sizeof(log_buffer),
+			"Unable to join cgroup %s, errno %d", pjob->ji_cgroup, errno);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Kill whatever is left in a cgroup and remove it.
+ *
+ * @param[in] cg - cgroup directory
+ *
+ * @return	int
+ * @retval	0	Success or gone already
+ * @retval	-1	Still busy, errno set
+ */
+static int
+cgroup_remove(char *cg)
+{
+	char	path[MAXPATHLEN + 1];
+	FILE	*fp;
+	int	pid;
+
+	if (rmdir(cg) == 0 || errno == ENOENT)
+		return 0;
+	if (errno != EBUSY)
+		return -1;
+
+	if (cgroup_write(cg, "cgroup.kill", "1") == -1) {
+		/* kernels before 5.14 have no cgroup.kill */
+		if (cgroup_path(path, sizeof(path), "%s/cgroup.procs", cg) == 0 &&
+			(fp = fopen(path, "r")) != NULL) {
+			while (fscanf(fp, "%d", &pid) == 1)
+				(void)kill(pid, SIGKILL);
+			fclose(fp);
+		}
+	}
+	if (rmdir(cg) == 0 || errno == ENOENT)
+		return 0;
+	return -1;
+}
+
+/**
+ * @brief
+ *	Work task retrying the removal of a cgroup whose processes were
+ *	still exiting.
+ *
+ * @param[in] ptask - work task, wt_parm1 the cgroup directory and
+ *		      wt_aux the attempts made
+ *
+ * @return void
+ */
+static void
+cgroup_remove_task(struct work_task *ptask)
+{
+	char			*cg = ptask->wt_parm1;
+	struct work_task	*pnew;
+
+	if (cgroup_remove(cg) == -1 && ptask->wt_aux < CGROUP_RMDIR_TRIES) {
+		pnew = set_task(WORK_Timed, time_now + 1, cgroup_remove_task, cg);
+		if (pnew != NULL) {
+			pnew->wt_aux = ptask->wt_aux + 1;
+			return;
+		}
+	}
+	if (access(cg, F_OK) == 0)
+		log_err(EBUSY, __func__, cg);
+	free(cg);
+}
+
+/**
+ * @brief
+ *	Remove the cgroup of a job that is being deleted, killing any
+ *	process still in it.  The removal is retried from a work task while
+ *	the processes exit.
+ *
+ * @param[in] pjob - job pointer
+ *
+ * @return void
+ */
+void
+cgroup_job_delete(job *pjob)
+{
+	char			cg[MAXPATHLEN + 1];
+	char			*dup;
+	struct work_task	*ptask;
+
+	if (!native_cgroups)
+		return;
+	cgroup_conf_load();
+	if (cgroup_root() == NULL)
+		return;
+
+	/* by name, a MoM restarted since the job began does not know ji_cgroup */
+	if (cgroup_path(cg, sizeof(cg), "%s/%s.service/jobid/%s", cg_root,
+		cg_conf.cc_prefix, pjob->ji_qs.ji_jobid) == -1)
+		return;
+	if (cgroup_remove(cg) == 0)
+		return;
+	if ((dup = strdup(cg)) == NULL ||
+		(ptask = set_task(WORK_Timed, time_now + 1, cgroup_remove_task, dup)) == NULL) {
+		log_joberr(errno, __func__, cg, pjob->ji_qs.ji_jobid);
+		free(dup);
+		return;
+	}
+	ptask->wt_aux = 1;
+}
@@ -68,7 +68,12 @@
 #include <sys/resource.h>
 #include <sys/utsname.h>
 #include <sys/wait.h>
+#include <sys/socket.h>
 #include <signal.h>
+#include <mntent.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
 
 #include "pbs_error.h"
 #include "portability.h"
@@ -86,6 +91,8 @@
 #include "pbs_ifl.h"
 #include "placementsets.h"
 #include "mom_vnode.h"
+#include "pbs_idx.h"
+#include "net_connect.h"
 #ifndef NAS /* localmod 113 */
 #include "hwloc.h"
 #endif /* localmod 113 */
@@ -141,6 +148,31 @@ proc_stat_t	*proc_info = NULL;
 int		nproc = 0;
 int		max_proc = 0;
 
+/*
+ * With $proc_events set, the processes of jobs are followed through the
+ * fork and exit events of the netlink proc connector, and only those are
+ * read each sample instead of every process in /proc.  The resource
+ * monitor queries still look at all of /proc, see mom_get_sample_all().
+ */
+typedef struct proc_track {
+	pid_t	pt_pid;
+	int	pt_leader;	/* session leader of a task, kept until reaped */
+} proc_track_t;
+
+#define	PROC_CONN_RCVBUF	(4 * 1024 * 1024)
+
+#define	PROC_STAT_OK	0
+#define	PROC_STAT_SKIP	1	/* root owned, not counted */
+#define	PROC_STAT_FAIL	-1
+
+static int	proc_sock = -1;		/* netlink proc connector socket */
+static void	*proc_track_idx = NULL;	/* proc_track_t of the followed pids */
+static int	proc_ntracked = 0;
+static int	proc_resync = 1;	/* rebuild the followed pids from a full scan */
+static int	proc_nevents = 0;	/* events drained since the last sample */
+static char	*cgroup2_root = NULL;	/* mount point of the cgroup v2 hierarchy */
+static char	*mom_cgroup = NULL;	/* cgroup of MoM itself */
+
 extern	char	*ret_string;
 extern	char	extra_parm[];
 extern	char	no_parm[];
@@ -153,6 +185,8 @@ extern	time_t	time_now;
  ** external functions and data
  */
 extern  int	nice_val;
+extern	int	proc_events;
+extern	pbs_list_head	svr_alljobs;
 extern	int			rm_errno;
 extern	int			reqnum;
 extern	double	cputfactor;
@@ -174,6 +208,7 @@ static char	*totmem		(struct rm_attribute *attrib);
 static char	*availmem	(struct rm_attribute *attrib);
 static char	*ncpus		(struct rm_attribute *attrib);
 static char	*walltime	(struct rm_attribute *attrib);
+static void	proc_conn_ready	(int sd);
 #ifdef NAS
 /* localmod 005 */
 static void proc_new		(int, int);
@@ -513,6 +548,174 @@ injob(job *pjob, pid_t sid)
 	return FALSE;
 }
 
+/**
+ * @brief
+ *	Get the cgroup v2 path of a process from /proc/<pid>/cgroup.
+ *
+ * @param[in] pid - process id
+ *
+ * @return	char *
+ * @retval	path below the cgroup v2 mount point, freed by the caller
+ * @retval	NULL	process gone or not in a cgroup v2 hierarchy
+ *
+ */
+static char *
+proc_cgroup(pid_t pid)
+{
+	char	path[MAXPATHLEN + 1];
+	char	line[MAXPATHLEN + 1];
+	char	*cg = NULL;
+	FILE	*fp;
+
+	snprintf(path, sizeof(path), "/proc/%d/cgroup", (int)pid);
+	if ((fp = fopen(path, "r")) == NULL)
+		return NULL;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (strncmp(line, "0::", 3) == 0) {
+			line[strcspn(line, "\n")] = '\0';
+			cg = strdup(line + 3);
+			break;
+		}
+	}
+	fclose(fp);
+	return cg;
+}
+
+/**
+ * @brief
+ *	Find the cgroup v2 directory holding the processes of a job.
+ *	It is the cgroup of the session leader of a task, if the cgroup is
+ *	named after the job and is not the one MoM runs in.
+ *
+ * @param[in] pjob - job pointer
+ *
+ * @return	char *
+ * @retval	directory of the cgroup, kept in ji_cgroup
+ * @retval	NULL	the job has no cgroup of its own
+ *
+ */
+static char *
+job_cgroup(job *pjob)
+{
+	task	*ptask;
+	char	*cg;
+	char	path[MAXPATHLEN + 1];
+
+	if (pjob->ji_cgroup != NULL)
+		return (pjob->ji_cgroup);
+	if (cgroup2_root == NULL)
+		return NULL;
+
+	for (ptask = (task *)GET_NEXT(pjob->ji_tasks);
+		ptask != NULL;
+		ptask = (task *)GET_NEXT(ptask->ti_jobtask)) {
+		if (ptask->ti_qs.ti_sid <= 1)
+			continue;
+		if ((cg = proc_cgroup(ptask->ti_qs.ti_sid)) == NULL)
+			continue;
+		if ((mom_cgroup == NULL || strcmp(cg, mom_cgroup) != 0) &&
+			strstr(cg, pjob->ji_qs.ji_jobid) != NULL) {
+			snprintf(path, sizeof(path), "%s%s", cgroup2_root, cg);
+			pjob->ji_cgroup = strdup(path);
+		}
+		free(cg);
+		break;
+	}
+	return (pjob->ji_cgroup);
+}
+
+/**
+ * @brief
+ *	Read a value from an accounting file of a cgroup.
+ *
+ * @param[in] dir - cgroup directory
+ * @param[in] file - file in the directory, e.g. "cpu.stat"
+ * @param[in] key - name of the value in a flat keyed file,
+ *		    NULL for a file holding a single value
+ * @param[out] val - value read
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	Error
+ *
+ */
+static int
+cgroup_read_value(char *dir, char *file, char *key, unsigned long long *val)
+{
+	char	path[MAXPATHLEN + 1];
+	char	line[256];
+	size_t	klen = (key != NULL) ? strlen(key) : 0;
+	FILE	*fp;
+	int	rc = -1;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, file);
+	if ((fp = fopen(path, "r")) == NULL)
+		return -1;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (key == NULL) {
+			if (sscanf(line, "%llu", val) == 1)
+				rc = 0;
+			break;
+		}
+		if ((strncmp(line, key, klen) == 0) && (line[klen] == ' ') &&
+			(sscanf(line + klen, "%llu", val) == 1)) {
+			rc = 0;
+			break;
+		}
+	}
+	fclose(fp);
+	return rc;
+}
+
+/**
+ * @brief
+ *	cpu time used by all the processes ever in the cgroup of a job,
+ *	including those that exited between two samples.
+ *
+ * @param[in] pjob - job pointer
+ *
+ * @return	ulong
+ * @retval	cpu time in seconds, 0 if not known
+ *
+ */
+static ulong
+cgroup_cput(job *pjob)
+{
+	unsigned long long	usec;
+	char			*cg;
+
+	if ((proc_sock == -1 && pjob->ji_cgroup == NULL) ||
+		(cg = job_cgroup(pjob)) == NULL)
+		return 0;
+	if (cgroup_read_value(cg, "cpu.stat", "usage_usec", &usec) != 0)
+		return 0;
+	return ((ulong)(usec / 1000000));
+}
+
+/**
+ * @brief
+ *	Peak memory use recorded for the cgroup of a job.
+ *
+ * @param[in] pjob - job pointer
+ *
+ * @return	ulong
+ * @retval	bytes, 0 if not known
+ *
+ */
+static ulong
+cgroup_mem_peak(job *pjob)
+{
+	unsigned long long	peak;
+	char			*cg;
+
+	if ((proc_sock == -1 && pjob->ji_cgroup == NULL) ||
+		(cg = job_cgroup(pjob)) == NULL)
+		return 0;
+	if (cgroup_read_value(cg, "memory.peak", NULL, &peak) != 0)
+		return 0;
+	return ((ulong)peak);
+}
+
 /**
  * @brief
  * 	Internal session cpu time decoding routine.
@@ -535,6 +738,7 @@ cput_sum(job *pjob)
 	proc_stat_t	*ps;
 	task		*ptask;
 	ulong		pcput,tcput;
+	ulong		cgcput;
 
 	for (ptask = (task *)GET_NEXT(pjob->ji_tasks);
 		ptask != NULL;
@@ -660,6 +864,11 @@ cput_sum(job *pjob)
 	if (nps == 0)
 		pjob->ji_flags |= MOM_NO_PROC;
 
+	/* the cgroup also counts processes that came and went between samples */
+	cgcput = cgroup_cput(pjob);
+	if (cgcput > cputime)
+		cputime = cgcput;
+
 	if (cputime > num_oscpus * (sampletime_ceil + 1 - pjob->ji_qs.ji_stime) * CPUT_POSSIBLE_FACTOR ) {
 				sprintf(log_buffer,
 					"cput for job impossible (%lds > %lds * %d), ignoring",
@@ -945,9 +1154,628 @@ mom_open_poll(void)
 	return (PBSE_NONE);
 }
 
+/**
+ * @brief
+ *	Read /proc/<name>/stat into an entry of the process table.
+ *
+ * @param[in] name - name of the process directory in /proc
+ * @param[out] ps - entry to fill
+ * @param[in] stat_str - scanf format of the stat file
+ *
+ * @return	int
+ * @retval	PROC_STAT_OK	entry filled
+ * @retval	PROC_STAT_SKIP	process gone or owned by root
+ * @retval	PROC_STAT_FAIL	stat file could not be read
+ *
+ */
+static int
+proc_read_stat(char *name, proc_stat_t *ps, char *stat_str)
+{
+	char			path[MAXPATHLEN + 1];
+	char			procname[MAXPATHLEN + 1]; /* space for name plus extra */
+	struct stat		sb;
+	FILE			*fd;
+	unsigned long long	starttime;
+
+	snprintf(procname, sizeof(procname), "/proc/%s", name);
+	if ((stat(procname, &sb) == -1) || (sb.st_uid == 0)) {
+		/* ignore root-owned processes */
+		return PROC_STAT_SKIP;
+	}
+	snprintf(procname, sizeof(procname), "/proc/%s/stat", name);
+
+	if ((fd = fopen(procname, "r")) == NULL)
+		return PROC_STAT_FAIL;
+
+	if (fscanf(fd, stat_str,
+		   &ps->pid,		/* "%d "	1  pid %d The process id */
+		   path,		/* "(%[^)]) "	2  comm %s The filename of the executable */
+		   &ps->state,		/* "%c "	3  state %c "RSDZTW" */
+		   &ps->ppid,		/* "%d "	4  ppid %d The PID of the parent */
+		   &ps->pgrp,		/* "%d "	5  pgrp %d The process group ID */
+		   &ps->session,	/* "%d "	6  session %d The session ID */
+			   		/* "%*d "	7  ignored:  tty_nr */
+ 		   			/* "%*d "	8  ignored:  tpgid */
+		   &ps->flags,		/* "%u or %lu"	9  flags */
+				   	/* "%*lu "	10 ignored:  minflt */
+				   	/* "%*lu "	11 ignored:  cminflt */
+				   	/* "%*lu "	12 ignored:  majflt */
+				   	/* "%*lu "	13 ignored:  cmajflt */
+		   &ps->utime,		/* "%lu "	14 utime %lu */
+		   &ps->stime,		/* "%lu "	15 stime %lu */
+		   &ps->cutime,		/* "%ld "	16 cutime %ld */
+		   &ps->cstime,		/* "%ld "	17 cstime %ld */
+			   		/* "%*ld "	18 ignored:  priority %ld */
+		   			/* "%*ld "	19 ignored:  nice %ld */
+		   			/* "%*ld "	20 ignored:  num_threads %ld */
+		   			/* "%*ld "	21 ignored:  itrealvalue %ld - no longer maintained */
+		   &starttime,		/* "%llu "	22 starttime (was %lu before Linux 2.6 - see proc(5) for conversion details */
+		   &ps->vsize,		/* "%lu "	23 vsize (bytes) */
+		   &ps->rss		/* "%ld "	24 rss (number of pages) */
+		) != 14) {
+		fclose(fd);
+		return PROC_STAT_FAIL;
+	}
+
+	if (fstat(fileno(fd), &sb) == -1) {
+		fclose(fd);
+		return PROC_STAT_FAIL;
+	}
+	ps->uid = sb.st_uid;
+	fclose(fd);
+
+	ps->start_time = linux_time + (starttime / hz);
+	snprintf(ps->comm, sizeof(ps->comm), "%.*s",
+		(int)(sizeof(ps->comm) - 1), path);
+
+	ps->utime = JTOS(ps->utime);
+	ps->stime = JTOS(ps->stime);
+	ps->cutime = JTOS(ps->cutime);
+	ps->cstime = JTOS(ps->cstime);
+	return PROC_STAT_OK;
+}
+
+/**
+ * @brief
+ *	Keep the entry just filled in the process table, growing the table
+ *	when it is full.
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	Out of memory, the table is full and the sample incomplete
+ *
+ */
+static int
+proc_table_add(void)
+{
+	void	*hold;
+
+	if (++nproc < max_proc)
+		return 0;
+	DBPRT(("%s: alloc more proc table space %d\n", __func__, nproc))
+	hold = realloc((void *)proc_info, (max_proc + TBL_INC) * sizeof(proc_stat_t));
+	if (hold == NULL) {
+		log_err(errno, __func__, "realloc");
+		nproc--;		/* keep a free entry to fill */
+		proc_resync = 1;	/* try a full scan next time */
+		return -1;
+	}
+	max_proc += TBL_INC;
+	proc_info = (proc_stat_t *)hold;
+	return 0;
+}
+
+/**
+ * @brief
+ *	Find a followed pid.
+ *
+ * @param[in] pid - process id
+ *
+ * @return	proc_track_t *
+ * @retval	entry of the pid
+ * @retval	NULL	pid is not followed
+ *
+ */
+static proc_track_t *
+proc_track_find(pid_t pid)
+{
+	proc_track_t	*pt = NULL;
+	void		*key = &pid;
+
+	if (pbs_idx_find(proc_track_idx, &key, (void **)&pt, NULL) != PBS_IDX_RET_OK)
+		return NULL;
+	return pt;
+}
+
+/**
+ * @brief
+ *	Start following a pid.
+ *
+ * @param[in] pid - process id
+ * @param[in] leader - the pid is the session leader of a task
+ *
+ * @return	Void
+ *
+ */
+static void
+proc_track_add(pid_t pid, int leader)
+{
+	proc_track_t	*pt;
+
+	if ((pt = proc_track_find(pid)) != NULL) {
+		pt->pt_leader |= leader;
+		return;
+	}
+	if ((pt = (proc_track_t *)malloc(sizeof(proc_track_t))) == NULL) {
+		log_err(errno, __func__, "malloc");
+		proc_resync = 1;
+		return;
+	}
+	pt->pt_pid = pid;
+	pt->pt_leader = leader;
+	if (pbs_idx_insert(proc_track_idx, &pt->pt_pid, pt) != PBS_IDX_RET_OK) {
+		free(pt);
+		proc_resync = 1;
+		return;
+	}
+	proc_ntracked++;
+}
+
+/**
+ * @brief
+ *	Stop following a pid.
+ *
+ * @param[in] pid - process id
+ *
+ * @return	Void
+ *
+ */
+static void
+proc_track_del(pid_t pid)
+{
+	proc_track_t	*pt;
+
+	if ((pt = proc_track_find(pid)) == NULL)
+		return;
+	(void)pbs_idx_delete(proc_track_idx, &pid);
+	free(pt);
+	proc_ntracked--;
+}
+
+/**
+ * @brief
+ *	Stop following all pids.
+ *
+ * @return	Void
+ *
+ */
+static void
+proc_track_clear(void)
+{
+	proc_track_t	*pt;
+	void		*key = NULL;
+	void		*idx_ctx = NULL;
+
+	if (proc_track_idx == NULL)
+		return;
+	while (pbs_idx_find(proc_track_idx, &key, (void **)&pt, &idx_ctx) == PBS_IDX_RET_OK)
+		free(pt);
+	pbs_idx_free_ctx(idx_ctx);
+	pbs_idx_destroy(proc_track_idx);
+	proc_track_idx = NULL;
+	proc_ntracked = 0;
+}
+
+/**
+ * @brief
+ *	Send a multicast control operation to the proc connector.
+ *
+ * @param[in] op - PROC_CN_MCAST_LISTEN or PROC_CN_MCAST_IGNORE
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	Error
+ *
+ */
+static int
+proc_conn_mcast(enum proc_cn_mcast_op op)
+{
+	struct {
+		struct nlmsghdr		nl;
+		struct cn_msg		cn;
+		enum proc_cn_mcast_op	op;
+	} __attribute__((packed)) req;
+
+	memset(&req, 0, sizeof(req));
+	req.nl.nlmsg_len = sizeof(req);
+	req.nl.nlmsg_type = NLMSG_DONE;
+	req.nl.nlmsg_pid = getpid();
+	req.cn.id.idx = CN_IDX_PROC;
+	req.cn.id.val = CN_VAL_PROC;
+	req.cn.len = sizeof(enum proc_cn_mcast_op);
+	req.op = op;
+	if (send(proc_sock, &req, sizeof(req), 0) == -1)
+		return -1;
+	return 0;
+}
+
+/**
+ * @brief
+ *	Subscribe to the fork and exit events of the proc connector and
+ *	find the cgroup v2 hierarchy used for job accounting.
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	Error
+ *
+ */
+static int
+proc_conn_open(void)
+{
+	struct sockaddr_nl	sa;
+	struct mntent		*mnt;
+	FILE			*fp;
+	int			sz = PROC_CONN_RCVBUF;
+
+	proc_sock = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+		NETLINK_CONNECTOR);
+	if (proc_sock == -1) {
+		log_err(errno, __func__, "socket");
+		return -1;
+	}
+	/* room for bursts of events between two polls of the socket */
+	if (setsockopt(proc_sock, SOL_SOCKET, SO_RCVBUFFORCE, &sz, sizeof(sz)) == -1)
+		(void)setsockopt(proc_sock, SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
+
+	memset(&sa, 0, sizeof(sa));
+	sa.nl_family = AF_NETLINK;
+	sa.nl_groups = CN_IDX_PROC;
+	if (bind(proc_sock, (struct sockaddr *)&sa, sizeof(sa)) == -1) {
+		log_err(errno, __func__, "bind");
+		goto err;
+	}
+	if (proc_conn_mcast(PROC_CN_MCAST_LISTEN) == -1) {
+		log_err(errno, __func__, "send");
+		goto err;
+	}
+	if ((proc_track_idx = pbs_idx_create(0, sizeof(pid_t))) == NULL) {
+		log_err(errno, __func__, "pbs_idx_create");
+		goto err;
+	}
+	proc_resync = 1;
+	proc_nevents = 0;
+
+	/* drain the events as they come, not only at samples */
+	if (add_conn(proc_sock, ChildPipe, (pbs_net_t)0, 0, NULL, proc_conn_ready) == NULL)
+		log_event(PBSEVENT_SYSTEM, 0, LOG_WARNING, __func__,
+			"connection table full, proc connector events read at samples only");
+
+	if ((cgroup2_root == NULL) && ((fp = setmntent("/proc/mounts", "r")) != NULL)) {
+		while ((mnt = getmntent(fp)) != NULL) {
+			if (strcmp(mnt->mnt_type, "cgroup2") == 0) {
+				cgroup2_root = strdup(mnt->mnt_dir);
+				mom_cgroup = proc_cgroup(getpid());
+				break;
+			}
+		}
+		endmntent(fp);
+	}
+
+	log_event(PBSEVENT_SYSTEM, 0, LOG_INFO, __func__,
+		"following job processes through proc connector events");
+	return 0;
+
+err:
+	close(proc_sock);
+	proc_sock = -1;
+	return -1;
+}
+
+/**
+ * @brief
+ *	Unsubscribe from the proc connector and forget the followed pids.
+ *	A forked child only closes its copy of the socket, leaving the poll
+ *	set shared with MoM alone.
+ *
+ * @return	Void
+ *
+ */
+static void
+proc_conn_close(void)
+{
+	if (proc_sock == -1)
+		return;
+	if (getpid() == mom_pid) {
+		(void)proc_conn_mcast(PROC_CN_MCAST_IGNORE);
+		close_conn(proc_sock);
+	} else
+		(void)close(proc_sock);
+	proc_sock = -1;
+	proc_track_clear();
+}
+
+/**
+ * @brief
+ *	Read the queued events of the proc connector. Children of MoM and
+ *	of followed processes are followed from their fork on; a process
+ *	is dropped on exit unless it leads a task session, in which case it
+ *	is kept until MoM reaps it.
+ *
+ * @return	int
+ * @retval	number of events read
+ *
+ */
+static int
+proc_conn_drain(void)
+{
+#define	PROC_CONN_BATCH	64
+	static char		bufs[PROC_CONN_BATCH][1024];
+	static struct iovec	iov[PROC_CONN_BATCH];
+	static struct mmsghdr	msgs[PROC_CONN_BATCH];
+	static struct sockaddr_nl from[PROC_CONN_BATCH];
+	struct nlmsghdr		*nlh;
+	struct cn_msg		*cn;
+	struct proc_event	*ev;
+	proc_track_t		*pt;
+	ssize_t			len;
+	int			nevents = 0;
+	int			n;
+	int			i;
+
+	for (;;) {
+		for (i = 0; i < PROC_CONN_BATCH; i++) {
+			iov[i].iov_base = bufs[i];
+			iov[i].iov_len = sizeof(bufs[i]);
+			memset(&msgs[i], 0, sizeof(msgs[i]));
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			msgs[i].msg_hdr.msg_name = &from[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+		}
+		n = recvmmsg(proc_sock, msgs, PROC_CONN_BATCH, MSG_DONTWAIT, NULL);
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			if (errno == ENOBUFS) {
+				/* events were dropped, rebuild from a full scan */
+				proc_resync = 1;
+				continue;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				log_err(errno, __func__, "recvmmsg");
+			break;
+		}
+
+		for (i = 0; i < n; i++) {
+			if (from[i].nl_pid != 0)
+				continue;	/* not from the kernel */
+			len = msgs[i].msg_len;
+			for (nlh = (struct nlmsghdr *)bufs[i]; NLMSG_OK(nlh, len);
+				nlh = NLMSG_NEXT(nlh, len)) {
+				if (nlh->nlmsg_type == NLMSG_NOOP)
+					continue;
+				if ((nlh->nlmsg_type == NLMSG_ERROR) ||
+					(nlh->nlmsg_type == NLMSG_OVERRUN)) {
+					proc_resync = 1;
+					break;
+				}
+				cn = (struct cn_msg *)NLMSG_DATA(nlh);
+				if ((cn->id.idx != CN_IDX_PROC) || (cn->id.val != CN_VAL_PROC))
+					continue;
+				ev = (struct proc_event *)cn->data;
+				nevents++;
+				switch (ev->what) {
+					case PROC_EVENT_FORK:
+						/* threads share the process entry */
+						if (ev->event_data.fork.child_pid !=
+							ev->event_data.fork.child_tgid)
+							break;
+						if ((ev->event_data.fork.parent_tgid == mom_pid) ||
+							(proc_track_find(ev->event_data.fork.parent_tgid) != NULL))
+							proc_track_add(ev->event_data.fork.child_tgid, 0);
+						break;
+
+					case PROC_EVENT_EXIT:
+						if (ev->event_data.exit.process_pid !=
+							ev->event_data.exit.process_tgid)
+							break;
+						pt = proc_track_find(ev->event_data.exit.process_tgid);
+						if ((pt != NULL) && !pt->pt_leader)
+							proc_track_del(pt->pt_pid);
+						break;
+
+					default:
+						break;
+				}
+			}
+		}
+		if (n < PROC_CONN_BATCH)
+			break;
+	}
+	return nevents;
+}
+
+/**
+ * @brief
+ *	Called from the MoM poll loop when proc connector events are queued,
+ *	so the socket buffer does not overflow between two samples.
+ *
+ * @param[in]	sd - the proc connector socket
+ *
+ * @return	Void
+ *
+ */
+static void
+proc_conn_ready(int sd)
+{
+	proc_nevents += proc_conn_drain();
+}
+
+/**
+ * @brief
+ *	Mark the session leaders of the running tasks. A leader that is
+ *	alive but not followed, e.g. a process attached to a job with
+ *	pbs_attach, asks for a full scan to pick up its session.
+ *
+ * @return	Void
+ *
+ */
+static void
+proc_track_sessions(void)
+{
+	job		*pjob;
+	task		*ptask;
+	proc_track_t	*pt;
+
+	for (pjob = (job *)GET_NEXT(svr_alljobs);
+		pjob != NULL;
+		pjob = (job *)GET_NEXT(pjob->ji_alljobs)) {
+		for (ptask = (task *)GET_NEXT(pjob->ji_tasks);
+			ptask != NULL;
+			ptask = (task *)GET_NEXT(ptask->ti_jobtask)) {
+			if (ptask->ti_qs.ti_sid <= 1)
+				continue;
+			if ((pt = proc_track_find(ptask->ti_qs.ti_sid)) != NULL)
+				pt->pt_leader = 1;
+			else if (kill(ptask->ti_qs.ti_sid, 0) == 0)
+				proc_resync = 1;
+		}
+	}
+}
+
+/**
+ * @brief
+ *	qsort and bsearch comparison of pids.
+ */
+static int
+pid_cmp(const void *a, const void *b)
+{
+	pid_t	x = *(const pid_t *)a;
+	pid_t	y = *(const pid_t *)b;
+
+	return ((x > y) - (x < y));
+}
+
+/**
+ * @brief
+ *	Rebuild the followed pids from the process table of a full scan:
+ *	the children of MoM and the processes in the session of a task.
+ *
+ * @return	Void
+ *
+ */
+static void
+proc_track_rebuild(void)
+{
+	job		*pjob;
+	task		*ptask;
+	proc_stat_t	*ps;
+	pid_t		*sids = NULL;
+	pid_t		*hold;
+	int		nsids = 0;
+	int		maxsids = 0;
+	int		i;
+
+	for (pjob = (job *)GET_NEXT(svr_alljobs);
+		pjob != NULL;
+		pjob = (job *)GET_NEXT(pjob->ji_alljobs)) {
+		for (ptask = (task *)GET_NEXT(pjob->ji_tasks);
+			ptask != NULL;
+			ptask = (task *)GET_NEXT(ptask->ti_jobtask)) {
+			if (ptask->ti_qs.ti_sid <= 1)
+				continue;
+			if (nsids == maxsids) {
+				maxsids += TBL_INC;
+				hold = (pid_t *)realloc(sids, maxsids * sizeof(pid_t));
+				if (hold == NULL) {
+					log_err(errno, __func__, "realloc");
+					free(sids);
+					return;
+				}
+				sids = hold;
+			}
+			sids[nsids++] = ptask->ti_qs.ti_sid;
+		}
+	}
+	if (nsids > 1)
+		qsort(sids, nsids, sizeof(pid_t), pid_cmp);
+
+	proc_track_clear();
+	if ((proc_track_idx = pbs_idx_create(0, sizeof(pid_t))) == NULL) {
+		log_err(errno, __func__, "pbs_idx_create");
+		free(sids);
+		return;
+	}
+	proc_resync = 0;
+	for (i = 0; i < nproc; i++) {
+		ps = &proc_info[i];
+		if (ps->pid <= 1)
+			continue;
+		if ((ps->ppid == mom_pid) || ((nsids > 0) &&
+			(bsearch(&ps->session, sids, nsids, sizeof(pid_t), pid_cmp) != NULL)))
+			proc_track_add(ps->pid, ps->pid == ps->session);
+	}
+	free(sids);
+}
+
+/**
+ * @brief
+ *	Fill the process table from the followed pids only.
+ *
+ * @param[in] stat_str - scanf format of the stat file
+ *
+ * @return	int
+ * @retval	number of followed pids found gone
+ *
+ */
+static int
+proc_sample_tracked(char *stat_str)
+{
+	static pid_t	*gone = NULL;
+	static int	maxgone = 0;
+	proc_track_t	*pt;
+	pid_t		*hold;
+	void		*key = NULL;
+	void		*idx_ctx = NULL;
+	char		name[32];
+	int		ngone = 0;
+	int		i;
+
+	while (pbs_idx_find(proc_track_idx, &key, (void **)&pt, &idx_ctx) == PBS_IDX_RET_OK) {
+		snprintf(name, sizeof(name), "%d", (int)pt->pt_pid);
+		if (proc_read_stat(name, &proc_info[nproc], stat_str) == PROC_STAT_OK) {
+			if (proc_table_add() == -1)
+				break;
+			continue;
+		}
+		/* an exit event missed or a reaped session leader */
+		if ((kill(pt->pt_pid, 0) == -1) && (errno == ESRCH)) {
+			if (ngone == maxgone) {
+				hold = (pid_t *)realloc(gone, (maxgone + TBL_INC) * sizeof(pid_t));
+				if (hold == NULL) {
+					/* the full scan rebuilds the followed pids */
+					log_err(errno, __func__, "realloc");
+					proc_resync = 1;
+					continue;
+				}
+				maxgone += TBL_INC;
+				gone = hold;
+			}
+			gone[ngone++] = pt->pt_pid;
+		}
+	}
+	pbs_idx_free_ctx(idx_ctx);
+
+	for (i = 0; i < ngone; i++)
+		proc_track_del(gone[i]);
+	return ngone;
+}
+
 /**
  * @brief
  * 	Declare start of polling loop.
+ *	Fills the process table, from the pids followed through proc
+ *	connector events when $proc_events is set, else from all of /proc.
  *
  * @return	int
  * @retval	PBSE_INTERNAL	Dir pdir in NULL
@@ -958,18 +1786,14 @@ int
 mom_get_sample(void)
 {
 	struct dirent		*dent = NULL;
-	FILE			*fd = NULL;
-	static char		path[MAXPATHLEN + 1];
-	char			procname[MAXPATHLEN + 1]; /* space for dent->d_name plus extra */
-	char			procid[MAXPATHLEN + 1];
-	struct stat		sb;
 	proc_stat_t		*ps = NULL;
 	int			nprocs = 0;
 	int			ncached = 0;
 	int			ncantstat = 0;
 	int			nnomem = 0;
-	unsigned long long 	starttime;
 	int			nskipped = 0;
+	int			nevents;
+	int			ngone;
 	extern time_t		time_last_sample;
 	char			*stat_str = NULL;
 
@@ -981,16 +1805,47 @@ mom_get_sample(void)
 	if (pdir == NULL)
 		return PBSE_INTERNAL;
 
-	rewinddir(pdir);
+	stat_str = choose_procflagsfmt();
+	if (stat_str == NULL) {
+		log_err(errno, __func__, "choose_procflagsfmt allocation failed");
+		return PBSE_INTERNAL;
+	}
+
 	nproc = 0;
-	fd = NULL;
 	if (hz == 0)
 		hz = sysconf(_SC_CLK_TCK);
 	time_last_sample = time(0);
 	sampletime_floor = time_last_sample;
+
+	if (proc_events && (proc_sock == -1) && (proc_conn_open() == -1)) {
+		log_event(PBSEVENT_SYSTEM, 0, LOG_WARNING, __func__,
+			"proc connector not available, $proc_events ignored");
+		proc_events = FALSE;
+	}
+	if (!proc_events && (proc_sock != -1))
+		proc_conn_close();
+
+	if (proc_sock != -1) {
+		nevents = proc_nevents + proc_conn_drain();
+		proc_nevents = 0;
+		proc_track_sessions();
+		if (!proc_resync) {
+			ngone = proc_sample_tracked(stat_str);
+			if (!proc_resync) {
+				sampletime_ceil = time_last_sample;
+				sprintf(log_buffer,
+					"tracked:  %d, events:  %d, gone:  %d",
+					proc_ntracked, nevents, ngone);
+				log_event(PBSEVENT_DEBUG4, 0, LOG_DEBUG, __func__, log_buffer);
+				return (PBSE_NONE);
+			}
+			nproc = 0;	/* out of memory, fall back to the full scan */
+		}
+	}
+
+	rewinddir(pdir);
 	while (errno = 0, (dent = readdir(pdir)) != NULL) {
 		int	nomem = 0;
-		struct	stat	sbuf;
 
 		nprocs++;
 
@@ -1004,62 +1859,16 @@ mom_get_sample(void)
 			} else
 				continue;
 		}
-		snprintf(procid, sizeof(procid), "/proc/%s", dent->d_name);
-		if ((stat(procid, &sbuf) == -1) || (sbuf.st_uid == 0)) {
-			/* ignore root-owned processes */
-			nskipped++;
-			continue;
-		}
-		snprintf(procname, sizeof(procname), "/proc/%s/stat", dent->d_name);
-
-		if ((fd = fopen(procname, "r")) == NULL) {
-			ncantstat++;
-			continue;
-		}
 
 		ps = &proc_info[nproc];
-		stat_str = choose_procflagsfmt();
-		if (stat_str == NULL) {
-			log_err(errno, __func__, "choose_procflagsfmt allocation failed");
-			return PBSE_INTERNAL;
-		}
-		if (fscanf(fd, stat_str,
-			   &ps->pid,		/* "%d "	1  pid %d The process id */
-			   path,		/* "(%[^)]) "	2  comm %s The filename of the executable */
-			   &ps->state,		/* "%c "	3  state %c "RSDZTW" */
-			   &ps->ppid,		/* "%d "	4  ppid %d The PID of the parent */
-			   &ps->pgrp,		/* "%d "	5  pgrp %d The process group ID */
-			   &ps->session,	/* "%d "	6  session %d The session ID */
-				   		/* "%*d "	7  ignored:  tty_nr */
-	 		   			/* "%*d "	8  ignored:  tpgid */
-			   &ps->flags,		/* "%u or %lu"	9  flags */
-					   	/* "%*lu "	10 ignored:  minflt */
-					   	/* "%*lu "	11 ignored:  cminflt */
-					   	/* "%*lu "	12 ignored:  majflt */
-					   	/* "%*lu "	13 ignored:  cmajflt */
-			   &ps->utime,		/* "%lu "	14 utime %lu */
-			   &ps->stime,		/* "%lu "	15 stime %lu */
-			   &ps->cutime,		/* "%ld "	16 cutime %ld */
-			   &ps->cstime,		/* "%ld "	17 cstime %ld */
-				   		/* "%*ld "	18 ignored:  priority %ld */
-			   			/* "%*ld "	19 ignored:  nice %ld */
-			   			/* "%*ld "	20 ignored:  num_threads %ld */
-			   			/* "%*ld "	21 ignored:  itrealvalue %ld - no longer maintained */
-			   &starttime,		/* "%llu "	22 starttime (was %lu before Linux 2.6 - see proc(5) for conversion details */
-			   &ps->vsize,		/* "%lu "	23 vsize (bytes) */
-			   &ps->rss		/* "%ld "	24 rss (number of pages) */
-			) != 14) {
-			ncantstat++;
-			fclose(fd);
-			continue;
-		}
-
-		if (fstat(fileno(fd), &sb) == -1) {
-			fclose(fd);
-			continue;
+		switch (proc_read_stat(dent->d_name, ps, stat_str)) {
+			case PROC_STAT_SKIP:
+				nskipped++;
+				continue;
+			case PROC_STAT_FAIL:
+				ncantstat++;
+				continue;
 		}
-		ps->uid = sb.st_uid;
-		fclose(fd);
 
 		/*
 		 ** A .pid thread shows the memory of the process
@@ -1069,28 +1878,17 @@ mom_get_sample(void)
 			ps->vsize = 0;
 			ps->rss = 0;
 		}
-
-		ps->start_time = linux_time + (starttime / hz);
-		snprintf(ps->comm, sizeof(ps->comm), "%.*s",
-			(int)(sizeof(ps->comm) - 1), path);
-
-		ps->utime = JTOS(ps->utime);
-		ps->stime = JTOS(ps->stime);
-		ps->cutime = JTOS(ps->cutime);
-		ps->cstime = JTOS(ps->cstime);
-		if (++nproc == max_proc) {
-			void	*hold;
-			DBPRT(("%s: alloc more proc table space %d\n", __func__, nproc))
-			max_proc += TBL_INC;
-			hold = realloc((void *)proc_info,
-				max_proc*sizeof(proc_stat_t));
-			assert(hold != NULL);
-			proc_info = (proc_stat_t *)hold;
-		}
+		if (proc_table_add() == -1)
+			break;
 	}
 	if (errno != 0 && errno != ENOENT)
 		log_err(errno, __func__, "readdir");
 	sampletime_ceil = time_last_sample;
+
+	/* the full scan also resynchronizes the followed pids */
+	if (proc_sock != -1)
+		proc_track_rebuild();
+
 	sprintf(log_buffer,
 		"nprocs:  %d, cantstat:  %d, nomem:  %d, skipped:  %d, "
 		"cached:  %d",
@@ -1100,6 +1898,25 @@ mom_get_sample(void)
 	return (PBSE_NONE);
 }
 
+/**
+ * @brief
+ *	Fill the process table from all of /proc, for the resource monitor
+ *	queries and the lookups of a pid, which can be about any process on
+ *	the host and not only the job processes followed with $proc_events.
+ *
+ * @return	int
+ * @retval	PBSE_INTERNAL	Dir pdir in NULL
+ * @retval	PBSE_NONE	Success
+ *
+ */
+static int
+mom_get_sample_all(void)
+{
+	/* the scan also rebuilds the followed pids */
+	proc_resync = 1;
+	return mom_get_sample();
+}
+
 /**
  * @brief
  * 	Update the resources used.<attributes> of a job.
@@ -1222,7 +2039,8 @@ mom_set_use(job *pjob)
 		pres->rs_value.at_val.at_size.atsv_units = ATR_SV_BYTESZ;
 	} else if ((pres->rs_value.at_flags & ATR_VFLAG_HOOK) == 0) {
 		lp_sz = &pres->rs_value.at_val.at_size.atsv_num;
-		lnum_sz = (resi_sum(pjob) + 1023) >> 10; /* as KB */
+		lnum = MAX(resi_sum(pjob), cgroup_mem_peak(pjob));
+		lnum_sz = (lnum + 1023) >> 10; /* as KB */
 		*lp_sz = MAX(*lp_sz, lnum_sz);
 	}
 
@@ -1426,6 +2244,7 @@ int
 mom_close_poll(void)
 {
 	DBPRT(("%s: entered\n", __func__))
+	proc_conn_close();
 	if (pdir) {
 		if (closedir(pdir) != 0) {
 			log_err(errno, __func__, "closedir");
@@ -1490,7 +2309,7 @@ getprocs(void)
 	if (lastproc == reqnum)		/* don't need new proc table */
 		return 1;
 
-	if (mom_get_sample() != PBSE_NONE)
+	if (mom_get_sample_all() != PBSE_NONE)
 		return 0;
 
 	lastproc = reqnum;
@@ -1560,7 +2379,7 @@ cput_proc(pid_t pid)
 	double		cputime;
 	proc_stat_t	*ps = NULL;
 
-	mom_get_sample();
+	mom_get_sample_all();
 	for (i = 0; i < nproc; i++) {
 		ps = &proc_info[i];
 		if (ps->pid == pid)
@@ -1639,7 +2458,7 @@ mem_job(pid_t sid)
 
 	memsize = 0;
 
-	mom_get_sample();
+	mom_get_sample_all();
 	for (i=0; i<nproc; i++) {
 
 		ps = &proc_info[i];
@@ -1676,7 +2495,7 @@ mem_proc(pid_t pid)
 	int		i;
 	proc_stat_t	*ps = NULL;
 
-	mom_get_sample();
+	mom_get_sample_all();
 	for (i = 0; i < nproc; i++) {
 		ps = &proc_info[i];
 		if (ps->pid == pid)
@@ -1754,7 +2573,7 @@ resi_job(pid_t jobid)
 	proc_stat_t	*ps;
 
 	resisize = 0;
-	mom_get_sample();
+	mom_get_sample_all();
 
 	for (i=0; i<nproc; i++) {
 
@@ -1794,7 +2613,7 @@ resi_proc(pid_t pid)
 	proc_stat_t	*ps = NULL;
 
 
-	mom_get_sample();
+	mom_get_sample_all();
 	for (i = 0; i < nproc; i++) {
 		ps = &proc_info[i];
 		if (ps->pid == pid)
@@ -1886,7 +2705,7 @@ sessions(struct rm_attribute *attrib)
 		return NULL;
 	}
 
-	mom_get_sample();
+	mom_get_sample_all();
 
 	/*
 	 ** Search for members of session
@@ -2001,7 +2820,7 @@ pids(struct rm_attribute *attrib)
 		return NULL;
 	}
 
-	mom_get_sample();
+	mom_get_sample_all();
 
 	/*
 	 ** Search for members of session
@@ -2061,7 +2880,7 @@ nusers(struct rm_attribute *attrib)
 		return NULL;
 	}
 
-	mom_get_sample();
+	mom_get_sample_all();
 	for (i=0; i<nproc; i++) {
 		ps = &proc_info[i];
 
@@ -2886,7 +3705,7 @@ walltime(struct rm_attribute *attrib)
 		rm_errno = RM_ERR_SYSTEM;
 		return NULL;
 	}
-	mom_get_sample();
+	mom_get_sample_all();
 
 	start = now;
 	for (i=0; i<nproc; i++) {
@@ -141,6 +141,13 @@ extern void	alps_system_KNL(void);
 extern void	system_to_vnodes_KNL(void);
 #endif	/* MOM_ALPS */
 
+/*
+ *	Native cgroup v2 management of jobs. (mom_cgroup.c)
+ */
+extern int	cgroup_job_create(job *);
+extern int	cgroup_job_attach(job *);
+extern void	cgroup_job_delete(job *);
+
 
 #define	COMSIZE		12
 typedef struct proc_stat {
@@ -469,6 +469,9 @@ set_job(job *pjob, struct startjob_rtn *sjr)
 
 	sjr->sj_session = setsid();
 
+	if (cgroup_job_attach(pjob) == -1)
+		return -2;	/* cgroup_job_attach leaves message in log_buffer */
+
 #if	MOM_ALPS
 	/*
 	 * Now that we have our SID/JID we can request/confirm our
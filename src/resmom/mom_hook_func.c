@@ -49,6 +49,12 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
+#ifndef WIN32
+#include <sys/socket.h>
+#endif
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
 #include <ctype.h>
 #include <errno.h>
 #include <assert.h>
@@ -153,6 +159,16 @@ extern int		server_stream;
 
 extern char **environ;
 
+extern	int		persistent_hooks;
+
+#ifndef WIN32
+#define	HOOK_SERVER_RESTART_DELAY	10	/* seconds between restarts of the hook server */
+
+static int	hook_server_sock = -1;	/* socket to the persistent hook interpreter */
+static pid_t	hook_server_pid = -1;
+static time_t	hook_server_next_start = 0;
+#endif
+
 /**
  * @brief
  * 	Print job data into stream pointed by 'fp'.
@@ -683,6 +699,211 @@ mom_process_hooks_params_t
 	return new_php;
 }
 
+#ifndef WIN32
+/**
+ * @brief
+ *	Work task run when the hook server exits, hooks are run by exec'ing
+ *	pbs_python until it is restarted.
+ *
+ * @param[in]	ptask - work task, wt_aux holds the exit status
+ *
+ * @return void
+ */
+static void
+hook_server_exited(struct work_task *ptask)
+{
+	log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_HOOK, LOG_INFO, __func__,
+		"hook server pid %d exited, status %d", (int) ptask->wt_event, ptask->wt_aux);
+	if ((pid_t) ptask->wt_event != hook_server_pid)
+		return;
+	if (hook_server_sock != -1)
+		close(hook_server_sock);
+	hook_server_sock = -1;
+	hook_server_pid = -1;
+}
+
+/**
+ * @brief
+ *	Stop the hook server, it exits when it sees its socket closed.
+ *
+ * @return void
+ */
+static void
+hook_server_stop(void)
+{
+	if (hook_server_sock != -1)
+		close(hook_server_sock);
+	hook_server_sock = -1;
+}
+
+/**
+ * @brief
+ *	Start "pbs_python --hook-server", the persistent interpreter that runs
+ *	hooks without starting Python and loading the pbs module every time.
+ *	Failures are logged and hooks keep being run by exec'ing pbs_python.
+ *
+ * @return void
+ */
+static void
+hook_server_start(void)
+{
+	int	sv[2];
+	pid_t	pid;
+	char	pypath[MAXPATHLEN + 1];
+	char	logmask[BUFSIZ];
+	char	*arg[7];
+	int	fd;
+
+	if (time_now < hook_server_next_start)
+		return;
+	hook_server_next_start = time_now + HOOK_SERVER_RESTART_DELAY;
+
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) == -1) {
+		log_err(errno, __func__, "socketpair");
+		return;
+	}
+	if ((pid = fork()) == -1) {
+		log_err(errno, __func__, "fork");
+		close(sv[0]);
+		close(sv[1]);
+		return;
+	}
+	if (pid == 0) {
+		tpp_terminate();
+		net_close(-1);
+		(void) setsid();
+#ifdef __linux__
+		/* go away with MoM, even if some child still holds the socket */
+		(void) prctl(PR_SET_PDEATHSIG, SIGTERM);
+#endif
+
+		if (dup2(sv[1], 0) == -1)
+			exit(1);
+		fd = sysconf(_SC_OPEN_MAX);
+		while (--fd > 2)
+			(void) close(fd);
+		if (chdir(path_hooks_workdir) != 0)
+			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK, LOG_WARNING, __func__, "unable to go to hooks tmp directory");
+		if ((pbs_conf.pbs_conf_file != NULL) &&
+			(setenv("PBS_CONF_FILE", pbs_conf.pbs_conf_file, 1) != 0))
+			exit(1);
+
+		snprintf(pypath, sizeof(pypath), "%s/bin/pbs_python", pbs_conf.pbs_exec_path);
+		snprintf(logmask, sizeof(logmask), "%ld", *log_event_mask);
+		arg[0] = pypath;
+		arg[1] = HOOK_SERVER_MODE;
+		arg[2] = "-L";
+		arg[3] = path_log;
+		arg[4] = "-e";
+		arg[5] = logmask;
+		arg[6] = NULL;
+		execve(pypath, arg, environ);
+		log_err(errno, __func__, "execve of hook server");
+		exit(1);
+	}
+
+	close(sv[1]);
+	hook_server_sock = sv[0];
+	hook_server_pid = pid;
+	if (set_task(WORK_Deferred_Child, pid, hook_server_exited, NULL) == NULL)
+		log_err(errno, __func__, msg_err_malloc);
+	log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_HOOK, LOG_INFO, __func__,
+		"started hook server pid %d", pid);
+}
+
+/**
+ * @brief
+ *	Have the hook server run a hook, from the child forked by run_hook()
+ *	in place of exec'ing pbs_python, and exit with the status of the run.
+ *	The event goes as the arguments pbs_python would get, the working
+ *	directory and the hook config file.
+ *
+ * @param[in]	arg - arguments of "pbs_python --hook"
+ * @param[in]	hook_config_path - hook config file, "" if none
+ *
+ * @return void
+ *	Returns only if the event could not be handed over, the caller then
+ *	exec's pbs_python.
+ */
+static void
+hook_server_run(char **arg, char *hook_config_path)
+{
+	static char		buf[HOOK_SERVER_MSGMAX];
+	struct hook_server_req	hr;
+	struct msghdr		msg;
+	struct iovec		iov;
+	struct cmsghdr		*cmsg;
+	union {
+		struct cmsghdr	cm;
+		char		space[CMSG_SPACE(sizeof(int))];
+	} cbuf;
+	char			cwd[MAXPATHLEN + 1];
+	size_t			len = sizeof(hr);
+	size_t			l;
+	int			sv[2];
+	int			st;
+	ssize_t			n;
+	char			*str;
+	int			i;
+
+	if (getcwd(cwd, sizeof(cwd)) == NULL)
+		return;
+
+	hr.hr_version = HOOK_SERVER_VERSION;
+	hr.hr_nstr = 0;
+	for (i = -2; (i < 0) || (arg[i] != NULL); i++) {
+		str = (i == -2) ? cwd : ((i == -1) ? hook_config_path : arg[i]);
+		l = strlen(str) + 1;
+		if (len + l > sizeof(buf))
+			return;
+		memcpy(buf + len, str, l);
+		len += l;
+		hr.hr_nstr++;
+	}
+	memcpy(buf, &hr, sizeof(hr));
+
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) == -1)
+		return;
+
+	memset(&msg, 0, sizeof(msg));
+	memset(&cbuf, 0, sizeof(cbuf));
+	iov.iov_base = buf;
+	iov.iov_len = len;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf.space;
+	msg.msg_controllen = sizeof(cbuf.space);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &sv[1], sizeof(int));
+
+	if (sendmsg(hook_server_sock, &msg, MSG_NOSIGNAL) != (ssize_t) len) {
+		log_err(errno, __func__, "send to hook server");
+		close(sv[0]);
+		close(sv[1]);
+		return;
+	}
+	close(sv[1]);
+	close(hook_server_sock);
+
+	/* from here on the hook may be running, never run it twice */
+	do {
+		n = read(sv[0], &st, sizeof(st));
+	} while ((n == -1) && (errno == EINTR));
+	if (n != sizeof(st)) {
+		log_err(errno, __func__, "no status from hook server");
+		exit(255);
+	}
+	if (WIFSIGNALED(st)) {
+		(void) signal(WTERMSIG(st), SIG_DFL);
+		(void) raise(WTERMSIG(st));
+	}
+	exit(WIFEXITED(st) ? WEXITSTATUS(st) : 255);
+}
+#endif
+
 /**
  * @brief
  *	Runs the hook 'phook' in a child process in response to 'event_type'
@@ -839,6 +1060,11 @@ run_hook(hook *phook, unsigned int event_type, mom_hook_input_t *hook_input,
 		runas_jobuser = 1;
 
 #ifndef WIN32
+	if (persistent_hooks && (hook_server_sock == -1))
+		hook_server_start();
+	else if (!persistent_hooks && (hook_server_sock != -1))
+		hook_server_stop();
+
 	child = fork();
 	if (child > 0) { /* parent */
 
@@ -1306,6 +1532,10 @@ run_hook(hook *phook, unsigned int event_type, mom_hook_input_t *hook_input,
 			}
 		}
 
+		/* hooks run as the job owner are not handed to the root server */
+		if (!runas_jobuser && (hook_server_sock != -1))
+			hook_server_run(arg, hook_config_path);
+
 		execve(pypath, arg, environ);
 run_hook_exit:
 		if (fp != NULL) {
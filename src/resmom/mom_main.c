@@ -284,6 +284,9 @@ int		reject_root_scripts = FALSE;
 int		report_hook_checksums = TRUE;
 int		restart_transmogrify = FALSE;
 int		attach_allow = TRUE;
+int		proc_events = FALSE;	/* follow job processes through proc connector events */
+int		native_cgroups = FALSE;	/* MoM makes the cgroup v2 of each job */
+int		persistent_hooks = FALSE;	/* hooks run in a long lived pbs_python */
 extern double		wallfactor;
 int		suspend_signal;
 int		resume_signal;
@@ -441,6 +444,9 @@ static handler_ret_t	config_verscheck(char *);
 static handler_ret_t	cputmult(char *);
 static handler_ret_t	parse_config(char *);
 static handler_ret_t	prologalarm(char *);
+static handler_ret_t	set_proc_events(char *);
+static handler_ret_t	set_native_cgroups(char *);
+static handler_ret_t	set_persistent_hooks(char *);
 static handler_ret_t	set_joinjob_alarm(char *);
 static handler_ret_t	set_job_launch_delay(char *);
 static handler_ret_t	restricted(char *);
@@ -526,10 +532,13 @@ static struct	specials {
 	{ "max_poll_downtime",		set_max_poll_downtime },
 	{ "min_check_poll",		set_min_check_poll },
 	{ "momname",			set_momname },
+	{ "native_cgroups",		set_native_cgroups },
 #ifdef	WIN32
 	{ "nrun_factor",		set_nrun_factor },
 #endif
+	{ "persistent_hooks",		set_persistent_hooks },
 	{ "port",			set_momport },
+	{ "proc_events",		set_proc_events },
 	{ "prologalarm",		prologalarm },
 	{ "sister_join_job_alarm",	set_joinjob_alarm },
 	{ "job_launch_delay",		set_job_launch_delay },
@@ -1668,6 +1677,59 @@ set_reject_root_scripts(char *value)
 	return (set_boolean(__func__, value, &reject_root_scripts));
 }
 
+/**
+ * @brief
+ *	Set the configuration flag that defines whether the processes of jobs
+ *	are followed through the fork and exit events of the kernel instead
+ *	of scanning all of /proc on each sample.
+ *
+ * @param[in] value - boolean value
+ *
+ * @retval 0 failure
+ * @retval 1 success
+ *
+ */
+static handler_ret_t
+set_proc_events(char *value)
+{
+	return (set_boolean(__func__, value, &proc_events));
+}
+
+/**
+ * @brief
+ *	Set the configuration flag that defines whether MoM makes a cgroup v2
+ *	for each job itself, with the settings of pbs_cgroups.CF.
+ *
+ * @param[in] value - boolean value
+ *
+ * @retval 0 failure
+ * @retval 1 success
+ *
+ */
+static handler_ret_t
+set_native_cgroups(char *value)
+{
+	return (set_boolean(__func__, value, &native_cgroups));
+}
+
+/**
+ * @brief
+ *	Set the configuration flag that defines whether MoM runs its hooks in
+ *	a persistent pbs_python hook server rather than exec'ing pbs_python
+ *	for every event.
+ *
+ * @param[in] value - boolean value
+ *
+ * @retval 0 failure
+ * @retval 1 success
+ *
+ */
+static handler_ret_t
+set_persistent_hooks(char *value)
+{
+	return (set_boolean(__func__, value, &persistent_hooks));
+}
+
 /**
  * @brief
  *	Set the configuration flag that tells the mom to send the checksums
@@ -4230,6 +4292,9 @@ read_config(char *file)
 	report_hook_checksums = TRUE;
 	restart_transmogrify = FALSE;
 	attach_allow	     = TRUE;
+	proc_events	     = FALSE;
+	native_cgroups	     = FALSE;
+	persistent_hooks     = FALSE;
 	max_check_poll	     = MAX_CHECK_POLL_TIME;
 	min_check_poll	     = MIN_CHECK_POLL_TIME;
 	vnode_additive       = 1;	/* keep vnodes on HUP */
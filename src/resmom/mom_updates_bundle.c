@@ -43,7 +43,6 @@
  */
 
 #include <pbs_config.h>   /* the master config generated by configure */
-#include <Python.h>
 #include <time.h>
 #include "resource.h"
 #include "job.h"
@@ -51,6 +50,7 @@
 #include "mom_server.h"
 #include "hook.h"
 #include "tpp.h"
+#include "pbs_json.h"
 
 extern pbs_list_head mom_pending_ruu;
 extern int resc_access_perm;
@@ -59,134 +59,22 @@ extern time_t time_now;
 
 static void bundle_ruu(int *r_cnt, ruu **prused, int *rh_cnt, ruu **prhused, int *o_cnt, ruu **obits);
 static ruu *get_job_update(job *pjob);
-static PyObject *json_loads(char *value, char *msg, size_t msg_len);
-static char *json_dumps(PyObject *py_val, char *msg, size_t msg_len);
+static char *json_dumps(JsonObject *obj, char *msg, size_t msg_len);
+
+/* free a JSON object and clear the pointer to it */
+#define JSON_CLEAR(obj) \
+	do { \
+		json_object_free(obj); \
+		(obj) = NULL; \
+	} while (0)
 static void encode_used(job *pjob, pbs_list_head *phead);
 
-static PyObject *py_json_name = NULL;
-static PyObject *py_json_module = NULL;
-static PyObject *py_json_dict = NULL;
-static PyObject *py_json_func_loads = NULL;
-static PyObject *py_json_func_dumps = NULL;
-
-#ifdef PYTHON
-/**
- * @brief
- * 	Returns the Python dictionary representation of a string
- *	specyfing a JSON object.
- *
- * @param[in]  value   - string of JSON-object format
- * @param[out] msg     - error message buffer
- * @param[in]  msg_len - size of 'msg' buffer
- *
- * @return PyObject *
- * @retval !NULL - dictionary representation of 'value'
- * @retval NULL  - if not successful, filling out 'msg' with the actual error message.
- */
-static PyObject *
-json_loads(char *value, char *msg, size_t msg_len)
-{
-	PyObject *py_value = NULL;
-	PyObject *py_result = NULL;
-
-	if (value == NULL)
-		return NULL;
-
-	if (msg != NULL) {
-		if (msg_len <= 0)
-			return NULL;
-		msg[0] = '\0';
-	}
-
-	if (py_json_name == NULL) {
-		py_json_name = PyUnicode_FromString("json");
-		if (py_json_name == NULL) {
-			if (msg != NULL)
-				snprintf(msg, msg_len, "failed to construct json name");
-			return NULL;
-		}
-	}
-
-	if (py_json_module == NULL) {
-		py_json_module = PyImport_Import(py_json_name);
-		if (py_json_module == NULL) {
-			if (msg != NULL)
-				snprintf(msg, msg_len, "failed to import json");
-			return NULL;
-		}
-	}
-
-	if (py_json_dict == NULL) {
-		py_json_dict = PyModule_GetDict(py_json_module);
-		if (py_json_dict == NULL) {
-			if (msg != NULL)
-				snprintf(msg, msg_len, "failed to get json module dictionary");
-			return NULL;
-		}
-	}
-
-	if (py_json_func_loads == NULL) {
-		py_json_func_loads = PyDict_GetItemString(py_json_dict, (char *) "loads");
-		if ((py_json_func_loads == NULL) || !PyCallable_Check(py_json_func_loads)) {
-			if (msg != NULL)
-				snprintf(msg, msg_len, "did not find json.loads() function");
-			return NULL;
-		}
-	}
-
-	py_value = Py_BuildValue("(z)", (char *) value);
-	if (py_value == NULL) {
-		if (msg != NULL)
-			snprintf(msg, msg_len, "failed to build python arg %s", value);
-		return NULL;
-	}
-
-	PyErr_Clear(); /* clear any exception */
-	py_result = PyObject_CallObject(py_json_func_loads, py_value);
-
-	if (PyErr_Occurred()) {
-		if (msg != NULL) {
-			PyObject *exc_string = NULL;
-			PyObject *exc_type = NULL;
-			PyObject *exc_value = NULL;
-			PyObject *exc_traceback = NULL;
-
-			PyErr_Fetch(&exc_type, &exc_value, &exc_traceback);
-
-			/* get the exception */
-			if (exc_type != NULL && (exc_string = PyObject_Str(exc_type)) != NULL && PyUnicode_Check(exc_string))
-				snprintf(msg, msg_len, "%s", PyUnicode_AsUTF8(exc_string));
-			Py_XDECREF(exc_string);
-			Py_XDECREF(exc_type);
-			Py_XDECREF(exc_value);
-#if !defined(WIN32)
-			Py_XDECREF(exc_traceback);
-#elif !defined(_DEBUG)
-			/* for some reason this crashes on Windows Debug */
-			Py_XDECREF(exc_traceback);
-#endif
-		}
-		goto json_loads_fail;
-	} else if (!PyDict_Check(py_result)) {
-		if (msg != NULL)
-			snprintf(msg, msg_len, "value is not a dictionary");
-		goto json_loads_fail;
-	}
-
-	Py_XDECREF(py_value);
-	return (py_result);
-
-json_loads_fail:
-	Py_XDECREF(py_value);
-	Py_XDECREF(py_result);
-	return NULL;
-}
-
 /**
  * @brief
- * 	Returns a JSON-formatted string representing the Python object 'py_val'.
+ * 	Returns the JSON-formatted string of the object 'obj', within single
+ *	quotes as resource values holding JSON are sent.
  *
- * @param[in]  py_val  - Python object
+ * @param[in]  obj     - JSON object
  * @param[out] msg     - error message buffer
  * @param[in]  msg_len - size of 'msg' buffer
  *
@@ -198,15 +86,13 @@ json_loads_fail:
  *	The returned string is malloced space that must be freed later when no longer needed.
  */
 static char *
-json_dumps(PyObject *py_val, char *msg, size_t msg_len)
+json_dumps(JsonObject *obj, char *msg, size_t msg_len)
 {
-	PyObject *py_value = NULL;
-	PyObject *py_result = NULL;
-	const char *tmp_str = NULL;
-	char *ret_string = NULL;
+	char *tmp_str;
+	char *ret_string;
 	int slen;
 
-	if (py_val == NULL)
+	if (obj == NULL)
 		return NULL;
 
 	if (msg != NULL) {
@@ -215,105 +101,23 @@ json_dumps(PyObject *py_val, char *msg, size_t msg_len)
 		msg[0] = '\0';
 	}
 
-	if (py_json_name == NULL) {
-		py_json_name = PyUnicode_FromString("json");
-		if (py_json_name == NULL) {
-			if (msg != NULL)
-				snprintf(msg, msg_len, "failed to construct json name");
-			return NULL;
-		}
-	}
-
-	if (py_json_module == NULL) {
-		py_json_module = PyImport_Import(py_json_name);
-		if (py_json_module == NULL) {
-			if (msg != NULL)
-				snprintf(msg, msg_len, "failed to import json");
-			return NULL;
-		}
-	}
-
-	if (py_json_dict == NULL) {
-		py_json_dict = PyModule_GetDict(py_json_module);
-		if (py_json_dict == NULL) {
-			if (msg != NULL)
-				snprintf(msg, msg_len, "failed to get json module dictionary");
-			return NULL;
-		}
-	}
-
-	if (py_json_func_dumps == NULL) {
-		py_json_func_dumps = PyDict_GetItemString(py_json_dict, (char *) "dumps");
-		if ((py_json_func_dumps == NULL) || !PyCallable_Check(py_json_func_dumps)) {
-			if (msg != NULL)
-				snprintf(msg, msg_len, "did not find json.dumps() function");
-			return NULL;
-		}
-	}
-
-	py_value = Py_BuildValue("(O)", py_val);
-	if (py_value == NULL) {
+	if ((tmp_str = json_object_dump(obj)) == NULL) {
 		if (msg != NULL)
-			snprintf(msg, msg_len, "failed to build python arg %p", (void *) py_val);
+			snprintf(msg, msg_len, "json_object_dump failed");
 		return NULL;
 	}
-	PyErr_Clear(); /* clear any exception */
-	py_result = PyObject_CallObject(py_json_func_dumps, py_value);
-
-	if (PyErr_Occurred()) {
-		if (msg != NULL) {
-			PyObject *exc_string = NULL;
-			PyObject *exc_type = NULL;
-			PyObject *exc_value = NULL;
-			PyObject *exc_traceback = NULL;
-
-			PyErr_Fetch(&exc_type, &exc_value, &exc_traceback);
-
-			/* get the exception */
-			if (exc_type != NULL && (exc_string = PyObject_Str(exc_type)) != NULL && PyUnicode_Check(exc_string))
-				snprintf(msg, msg_len, "%s", PyUnicode_AsUTF8(exc_string));
-			Py_XDECREF(exc_string);
-			Py_XDECREF(exc_type);
-			Py_XDECREF(exc_value);
-#if !defined(WIN32)
-			Py_XDECREF(exc_traceback);
-#elif !defined(_DEBUG)
-			/* for some reason this crashes on Windows Debug */
-			Py_XDECREF(exc_traceback);
-#endif
-		}
-		goto json_dumps_fail;
-	} else if (!PyUnicode_Check(py_result)) {
-		if (msg != NULL)
-			snprintf(msg, msg_len, "value is not a string");
-		goto json_dumps_fail;
-	}
-
-	tmp_str = PyUnicode_AsUTF8(py_result);
-	/* returned tmp_str points to an internal buffer of 'py_result' */
-	if (tmp_str == NULL) {
-		if (msg != NULL)
-			snprintf(msg, msg_len, "PyUnicode_AsUTF8 failed");
-		goto json_dumps_fail;
-	}
 	slen = strlen(tmp_str) + 3; /* for null character + 2 single quotes */
 	ret_string = (char *) malloc(slen);
 	if (ret_string == NULL) {
 		if (msg != NULL)
 			snprintf(msg, msg_len, "malloc of ret_string failed");
-		goto json_dumps_fail;
+		free(tmp_str);
+		return NULL;
 	}
 	snprintf(ret_string, slen, "'%s'", tmp_str);
-	Py_XDECREF(py_value);
-	Py_XDECREF(py_result);
+	free(tmp_str);
 	return (ret_string);
-
-json_dumps_fail:
-	Py_XDECREF(py_value);
-	Py_XDECREF(py_result);
-	return NULL;
 }
-#endif
 
 /**
  * @brief
@@ -350,7 +154,7 @@ encode_used(job *pjob, pbs_list_head *phead)
 		int i;
 		attribute val;	/* holds the final accumulated resources_used values from Moms including those released from the job */
 		attribute val3; /* holds the final accumulated resources_used values from Moms, which does not include the released moms from job */
-		PyObject *py_jvalue;
+		JsonObject *jvalue;
 		char *sval;
 		char *dumps;
 		char emsg[HOOK_BUF_SIZE];
@@ -398,7 +202,6 @@ encode_used(job *pjob, pbs_list_head *phead)
 				val.at_val.at_long += lnum;
 				val3.at_val.at_long += lnum3;
 			}
-#ifdef PYTHON
 			else if (strcmp(rd->rs_name, RESOURCE_UNKNOWN) != 0 &&
 				   (val.at_type == ATR_TYPE_LONG ||
 				    val.at_type == ATR_TYPE_FLOAT ||
@@ -406,8 +209,8 @@ encode_used(job *pjob, pbs_list_head *phead)
 				    val.at_type == ATR_TYPE_STR)) {
 
 
-				PyObject *py_accum = NULL;  /* holds accum resources_used values from all moms (including the released sister moms from job) */
-				PyObject *py_accum3 = NULL; /* holds accum resources_used values from all moms (NOT including the released sister moms from job) */
+				JsonObject *accum = NULL;  /* holds accum resources_used values from all moms (including the released sister moms from job) */
+				JsonObject *accum3 = NULL; /* holds accum resources_used values from all moms (NOT including the released sister moms from job) */
 
 
 				/* The following 2 temp variables will be set to 1
@@ -420,22 +223,22 @@ encode_used(job *pjob, pbs_list_head *phead)
 				int fail = 0;
 				int fail2 = 0;
 
-				py_jvalue = NULL;
+				jvalue = NULL;
 				tmpatr.at_type = tmpatr3.at_type = val.at_type;
 
 				if (val.at_type != ATR_TYPE_STR) {
 					rd->rs_set(&tmpatr, &val, SET);
 					rd->rs_set(&tmpatr3, &val, SET);
 				} else {
-					py_accum = PyDict_New();
-					if (py_accum == NULL) {
+					accum = calloc(1, sizeof(JsonObject));
+					if (accum == NULL) {
 						log_err(-1, __func__, "error creating accumulation dictionary");
 						continue;
 					}
-					py_accum3 = PyDict_New();
-					if (py_accum3 == NULL) {
+					accum3 = calloc(1, sizeof(JsonObject));
+					if (accum3 == NULL) {
 						log_err(-1, __func__, "error creating accumulation dictionary 3");
-						Py_CLEAR(py_accum);
+						JSON_CLEAR(accum);
 						continue;
 					}
 				}
@@ -478,29 +281,29 @@ encode_used(job *pjob, pbs_list_head *phead)
 
 						if (val2.at_type == ATR_TYPE_STR) {
 							sval = val2.at_val.at_str;
-							py_jvalue = json_loads(sval, emsg, HOOK_BUF_SIZE - 1);
-							if (py_jvalue == NULL) {
+							jvalue = json_object_parse(sval, emsg, HOOK_BUF_SIZE - 1);
+							if (jvalue == NULL) {
 								log_errf(-1, __func__,
 									 "Job %s resources_used.%s cannot be accumulated: value '%s' from mom %s not JSON-format: %s",
 									 pjob->ji_qs.ji_jobid, rd2->rs_name, sval, mom_hname, emsg);
 								fail = 1;
-							} else if (PyDict_Merge(py_accum, py_jvalue, 1) != 0) {
+							} else if (json_object_merge(accum, jvalue) != 0) {
 								log_errf(-1, __func__,
 									 "Job %s resources_used.%s cannot be accumulated: value '%s' from mom %s: error merging values",
 									 pjob->ji_qs.ji_jobid, rd2->rs_name, sval, mom_hname);
-								Py_CLEAR(py_jvalue);
+								JSON_CLEAR(jvalue);
 								fail = 1;
 							} else {
 								if (pjob->ji_resources[i].nr_status != PBS_NODERES_DELETE) {
-									if (PyDict_Merge(py_accum3, py_jvalue, 1) != 0) {
+									if (json_object_merge(accum3, jvalue) != 0) {
 										log_errf(-1, __func__,
 											 "Job %s resources_used.%s cannot be accumulated: value '%s' from mom %s: error merging values",
 											 pjob->ji_qs.ji_jobid, rd2->rs_name, sval, mom_hname);
 										fail2 = 1;
 									}
-									Py_CLEAR(py_jvalue);
+									JSON_CLEAR(jvalue);
 								} else {
-									Py_CLEAR(py_jvalue);
+									JSON_CLEAR(jvalue);
 								}
 							}
 
@@ -518,8 +321,8 @@ encode_used(job *pjob, pbs_list_head *phead)
 				if (val.at_type == ATR_TYPE_STR) {
 
 					if (fail) {
-						Py_CLEAR(py_accum);
-						Py_CLEAR(py_accum3);
+						JSON_CLEAR(accum);
+						JSON_CLEAR(accum3);
 						/* unset resc */
 						(void) add_to_svrattrl_list(phead, ad->at_name, rd->rs_name, "", SET, NULL);
 						/* go to next resource to encode_used */
@@ -527,8 +330,8 @@ encode_used(job *pjob, pbs_list_head *phead)
 					}
 
 					if (fail2) {
-						Py_CLEAR(py_accum);
-						Py_CLEAR(py_accum3);
+						JSON_CLEAR(accum);
+						JSON_CLEAR(accum3);
 						/* unset resc */
 						(void) add_to_svrattrl_list(phead, ad3->at_name, rd->rs_name, "", SET, NULL);
 						/* go to next resource to encode_used */
@@ -536,76 +339,76 @@ encode_used(job *pjob, pbs_list_head *phead)
 					}
 
 					sval = val.at_val.at_str;
-					if (PyDict_Size(py_accum) == 0) {
+					if (accum->count == 0) {
 						/* no other values seen
 						 * except from MS...use as is
 						 * don't JSONify
 						 */
 						rd->rs_decode(&tmpatr, ATTR_used, rd->rs_name, sval);
-						Py_CLEAR(py_accum);
-						Py_CLEAR(py_accum3);
-					} else if ((py_jvalue = json_loads(sval, emsg, HOOK_BUF_SIZE - 1)) == NULL) {
+						JSON_CLEAR(accum);
+						JSON_CLEAR(accum3);
+					} else if ((jvalue = json_object_parse(sval, emsg, HOOK_BUF_SIZE - 1)) == NULL) {
 						log_errf(-1, __func__,
 							 "Job %s resources_used.%s cannot be accumulated: value '%s' from mom %s not JSON-format: %s",
 							 pjob->ji_qs.ji_jobid, rd->rs_name, sval, mom_short_name, emsg);
-						Py_CLEAR(py_accum);
-						Py_CLEAR(py_accum3);
+						JSON_CLEAR(accum);
+						JSON_CLEAR(accum3);
 						/* unset resc */
 						(void) add_to_svrattrl_list(phead, ad->at_name, rd->rs_name, "", SET, NULL);
 						/* go to next resource to encode */
 						continue;
-					} else if (PyDict_Merge(py_accum, py_jvalue, 1) != 0) {
+					} else if (json_object_merge(accum, jvalue) != 0) {
 						log_errf(-1, __func__,
 							 "Job %s resources_used.%s cannot be accumulated: value '%s' from mom %s: error merging values",
 							 pjob->ji_qs.ji_jobid, rd->rs_name, sval, mom_short_name);
-						Py_CLEAR(py_jvalue);
-						Py_CLEAR(py_accum);
-						Py_CLEAR(py_accum3);
+						JSON_CLEAR(jvalue);
+						JSON_CLEAR(accum);
+						JSON_CLEAR(accum3);
 						/* unset resc */
 						(void) add_to_svrattrl_list(phead, ad->at_name, rd->rs_name, "", SET, NULL);
 						/* go to next resource to encode */
 						continue;
 					} else {
-						dumps = json_dumps(py_accum, emsg, HOOK_BUF_SIZE - 1);
+						dumps = json_dumps(accum, emsg, HOOK_BUF_SIZE - 1);
 						if (dumps == NULL) {
 							log_errf(-1, __func__,
 								 "Job %s resources_used.%s cannot be accumulated: %s",
 								 pjob->ji_qs.ji_jobid, rd->rs_name, emsg);
-							Py_CLEAR(py_jvalue);
-							Py_CLEAR(py_accum);
-							Py_CLEAR(py_accum3);
+							JSON_CLEAR(jvalue);
+							JSON_CLEAR(accum);
+							JSON_CLEAR(accum3);
 							/* unset resc */
 							(void) add_to_svrattrl_list(phead, ad->at_name, rd->rs_name, "", SET, NULL);
 							continue;
 						}
 
 						rd->rs_decode(&tmpatr, ATTR_used, rd->rs_name, dumps);
-						Py_CLEAR(py_accum);
+						JSON_CLEAR(accum);
 						free(dumps);
 
-						if (PyDict_Merge(py_accum3, py_jvalue, 1) != 0) {
+						if (json_object_merge(accum3, jvalue) != 0) {
 							log_errf(-1, __func__,
 								 "Job %s resources_used_update.%s cannot be accumulated: value '%s' from mom %s: error merging values",
 								 pjob->ji_qs.ji_jobid, rd->rs_name, sval, mom_short_name);
-							Py_CLEAR(py_jvalue);
-							Py_CLEAR(py_accum3);
+							JSON_CLEAR(jvalue);
+							JSON_CLEAR(accum3);
 							/* unset resc */
 							(void) add_to_svrattrl_list(phead, ad3->at_name, rd->rs_name, "", SET, NULL);
 							/* go to next resource to encode */
 							continue;
-						} else if ((dumps = json_dumps(py_accum3, emsg, HOOK_BUF_SIZE - 1)) == NULL) {
+						} else if ((dumps = json_dumps(accum3, emsg, HOOK_BUF_SIZE - 1)) == NULL) {
 							log_errf(-1, __func__,
 								 "Job %s resources_used_update.%s cannot be accumulated: %s",
 								 pjob->ji_qs.ji_jobid, rd->rs_name, emsg);
-							Py_CLEAR(py_jvalue);
-							Py_CLEAR(py_accum3);
+							JSON_CLEAR(jvalue);
+							JSON_CLEAR(accum3);
 							/* unset resc */
 							(void) add_to_svrattrl_list(phead, ad3->at_name, rd->rs_name, "", SET, NULL);
 							continue;
 						} else {
 							rd->rs_decode(&tmpatr3, ATTR_used_update, rd->rs_name, dumps);
-							Py_CLEAR(py_jvalue);
-							Py_CLEAR(py_accum3);
+							JSON_CLEAR(jvalue);
+							JSON_CLEAR(accum3);
 							free(dumps);
 						}
 					}
@@ -613,7 +416,6 @@ encode_used(job *pjob, pbs_list_head *phead)
 				val = tmpatr;
 				val3 = tmpatr3;
 			}
-#endif
 			/* no resource to accumulate and yet a multinode job */
 		}
 
@@ -631,14 +433,14 @@ encode_used(job *pjob, pbs_list_head *phead)
 				 */
 
 				sval = val.at_val.at_str;
-				if ((py_jvalue = json_loads(sval, emsg, HOOK_BUF_SIZE - 1)) != NULL) {
-					dumps = json_dumps(py_jvalue, emsg, HOOK_BUF_SIZE - 1);
+				if ((jvalue = json_object_parse(sval, emsg, HOOK_BUF_SIZE - 1)) != NULL) {
+					dumps = json_dumps(jvalue, emsg, HOOK_BUF_SIZE - 1);
 					if (dumps == NULL)
-						Py_CLEAR(py_jvalue);
+						JSON_CLEAR(jvalue);
 					else {
 						rd->rs_decode(&tmpatr, ATTR_used, rd->rs_name, dumps);
 						val = tmpatr;
-						Py_CLEAR(py_jvalue);
+						JSON_CLEAR(jvalue);
 						free(dumps);
 						dumps = NULL;
 					}
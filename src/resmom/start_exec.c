@@ -2902,6 +2902,11 @@ finish_exec(job *pjob)
 		port_err = (int)ntohs(saddr.sin_port);
 	}
 
+	if (cgroup_job_create(pjob) == -1) {
+		exec_bail(pjob, JOB_EXEC_RETRY, "Unable to create job cgroup");
+		return;
+	}
+
 	pattri = &pjob->ji_wattr[(int)JOB_ATR_interactive];
 	if (is_attr_set(pattri) && pattri->at_val.at_long != 0) {
 
@@ -4668,6 +4673,9 @@ start_process(task *ptask, char **argv, char **envp, bool nodemux)
 		ipaddr = ap->sin_addr.s_addr;
 	}
 
+	if (cgroup_job_create(pjob) == -1)
+		return PBSE_SYSTEM;
+
 	/*
 	 ** Begin a new process for the fledgling task.
 	 */
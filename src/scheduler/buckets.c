@@ -866,6 +866,40 @@ bucket_to_nspecs(status *policy, chunk_map **cb_map, resource_resv *resresv)
 	return ns_arr;
 }
 
+/**
+ * @brief check if any busy node in the buckets can still be shared by
+ *	  another job.  Such nodes are not in the free pools, so a job which
+ *	  does not need whole nodes might fit on them even if bucket_match()
+ *	  failed.
+ * @param[in] buckets - buckets to check
+ * @param[in] sinfo - the server the buckets belong to
+ * @return int
+ * @retval 1 if there is a busy node which can be shared
+ * @retval 0 if not
+ */
+int
+bucket_has_shared_nodes(node_bucket **buckets, server_info *sinfo)
+{
+	int i;
+	int k;
+
+	if (buckets == NULL || sinfo == NULL)
+		return 0;
+
+	for (i = 0; buckets[i] != NULL; i++) {
+		pbs_bitmap *busy = buckets[i]->busy_pool->truth;
+
+		for (k = pbs_bitmap_first_on_bit(busy); k >= 0; k = pbs_bitmap_next_on_bit(busy, k)) {
+			node_info *node = sinfo->unordered_nodes[k];
+
+			if (node->is_free && !node->is_job_exclusive && !node->is_resv_exclusive)
+				return 1;
+		}
+	}
+
+	return 0;
+}
+
 /**
  * @brief decide if a job should use the node bucket algorithm
  * @param resresv - the job
@@ -896,10 +930,15 @@ int job_should_use_buckets(resource_resv *resresv) {
 			return 0;
 	}
 
-	/* Only excl jobs use buckets */
+	/* Jobs which explicitly ask to share nodes use the standard path */
 	if (resresv->place_spec->share)
 		return 0;
-	if (!resresv->place_spec->excl)
+	/* Buckets only hold completely free nodes.  That is all an excl job can use.
+	 * A scatter job only needs one chunk per node, so free nodes are a good fit.
+	 * If there aren't enough free nodes, check_nodes() falls back to the standard
+	 * path to look at the partially used nodes.
+	 */
+	if (!resresv->place_spec->excl && !resresv->place_spec->scatter)
 		return 0;
 
 	/* place=pack jobs do not use buckets */
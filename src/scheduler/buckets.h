@@ -87,6 +87,9 @@ void free_chunk_map(chunk_map *cmap);
 void free_chunk_map_array(chunk_map **cmap_arr);
 chunk_map **dup_chunk_map_array(chunk_map **ocmap_arr);
 
+/* are there busy nodes in the buckets which can be shared */
+int bucket_has_shared_nodes(node_bucket **buckets, server_info *sinfo);
+
 /* decide of a job should use the node_bucket path */
 int job_should_use_buckets(resource_resv *resresv);
 
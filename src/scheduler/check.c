@@ -1485,9 +1485,19 @@ check_nodes(status *policy, server_info *sinfo, queue_info *qinfo, resource_resv
 	if (sinfo->pset_metadata_stale)
 		update_all_nodepart(policy, sinfo, (flags & NO_ALLPART));
 
-	if (flags & USE_BUCKETS)
+	if (flags & USE_BUCKETS) {
 		ns_arr = check_node_buckets(policy, sinfo, qinfo, resresv, err);
-	else
+		/* Buckets only know about free nodes.  A non-excl job might still fit on
+		 * nodes which are partially in use, so check those the standard way.
+		 */
+		if (ns_arr == NULL && err->status_code == NOT_RUN && !resresv->place_spec->excl &&
+		    bucket_has_shared_nodes(sinfo->buckets, sinfo)) {
+			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_DEBUG, resresv->name,
+				"Not enough free nodes in node buckets, using standard node search");
+			clear_schd_error(err);
+			ns_arr = check_normal_node_path(policy, sinfo, qinfo, resresv, flags, err);
+		}
+	} else
 		ns_arr = check_normal_node_path(policy, sinfo, qinfo, resresv, flags, err);
 
 	return ns_arr;
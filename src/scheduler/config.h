@@ -58,6 +58,8 @@
 #define HOLIDAYS_FILE "holidays"
 #define RESGROUP_FILE "resource_group"
 #define DEDTIME_FILE "dedicated_time"
+#define ESTIMATES_FILE "estimates"
+#define ESTIMATES_TMP_FILE ESTIMATES_FILE ".tmp"
 
 /* usage file "magic number" - needs to be 8 chars */
 #define USAGE_MAGIC "PBS_MAG!"
@@ -142,6 +144,7 @@
 #define PARSE_STRICT_ORDERING "strict_ordering"
 #define PARSE_RES_UNSET_INFINITE "resource_unset_infinite"
 #define PARSE_SELECT_PROVISION "provision_policy"
+#define PARSE_BACKGROUND_ESTIMATES "background_estimates"
 
 #ifdef NAS
 /* localmod 034 */
@@ -63,7 +63,9 @@
 #include <pwd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <fcntl.h>
+#include <signal.h>
 #include "fifo.h"
 #include "queue_info.h"
 #include "server_info.h"
@@ -635,6 +637,8 @@ scheduling_cycle(sched_svrconn *sconn, sched_cmd *cmd)
 	}
 	policy = sinfo->policy;
 
+	/* send the estimates of a finished estimates helper from a previous cycle */
+	publish_background_estimates(sconn->primary_sock, sinfo);
 
 	/* don't confirm reservations if we're handling a qrun request */
 	if (cmd->jid == NULL) {
@@ -736,6 +740,9 @@ scheduling_cycle(sched_svrconn *sconn, sched_cmd *cmd)
 	/* localmod 034 */
 	site_list_shares(stdout, sinfo, "eoc_", 1);
 #endif
+	if (conf.background_estimates && cmd->jid == NULL && send_job_attr_updates && !got_sigpipe)
+		start_background_estimates(sinfo);
+
 	end_cycle_tasks(sinfo);
 
 	free_schd_error(err);
@@ -1145,6 +1152,8 @@ schedexit(void)
 		}
 	}
 
+	kill_background_estimates();
+
 	/* Kill all worker threads */
 	if (num_threads > 1) {
 		int *thid;
@@ -2155,6 +2164,224 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 	return 1;
 }
 
+/**
+ * @brief
+ * 		Calendar every job which was not started or calendared in the
+ *		main loop and write the resulting estimates to ESTIMATES_FILE.
+ *		This is run in the estimates helper process on its private copy
+ *		of the post-cycle universe.
+ *
+ * @param[in]	sinfo	-	the post-cycle universe
+ *
+ * @return	int
+ * @retval	number of estimates written
+ * @retval	-1	: on error
+ */
+static int
+write_all_estimates(server_info *sinfo)
+{
+	FILE *fp;
+	int num_jobs;
+	int num_est = 0;
+	int i;
+
+	if ((fp = fopen(ESTIMATES_TMP_FILE, "w")) == NULL) {
+		log_err(errno, __func__, "Unable to open " ESTIMATES_TMP_FILE);
+		return -1;
+	}
+
+	/* add_job_to_calendar() appends subjobs to sinfo->jobs, only look at the original jobs */
+	num_jobs = count_array(sinfo->jobs);
+	for (i = 0; i < num_jobs; i++) {
+		resource_resv *resresv = sinfo->jobs[i];
+		resource_resv *ejob = resresv;
+		char *subjob_name = NULL;
+
+		if (!in_runnable_state(resresv) || resresv->can_never_run ||
+		    resresv->job->resv != NULL || resresv->job->topjob_ineligible)
+			continue;
+		if (!conf.allow_aoe_calendar && resresv->aoename != NULL)
+			continue;
+		if (find_timed_event(get_next_event(sinfo->calendar), IGNORE_DISABLED_EVENTS, resresv->name, TIMED_NOEVENT, 0) != NULL)
+			continue;
+
+		if (resresv->job->is_array) {
+			subjob_name = create_subjob_name(resresv->name,
+				range_next_value(resresv->job->queued_subjobs, -1));
+			if (subjob_name == NULL)
+				continue;
+		}
+
+		if (add_job_to_calendar(SIMULATE_SD, sinfo->policy, sinfo, resresv, job_should_use_buckets(resresv)) > 0) {
+			if (subjob_name != NULL)
+				ejob = find_resource_resv(sinfo->jobs, subjob_name);
+
+			if (ejob != NULL && ejob->job->est_execvnode != NULL &&
+			    find_timed_event(get_next_event(sinfo->calendar), IGNORE_DISABLED_EVENTS, ejob->name, TIMED_NOEVENT, 0) != NULL) {
+				fprintf(fp, "%s %ld %s\n", resresv->name,
+					(long) ejob->job->est_start_time, ejob->job->est_execvnode);
+				num_est++;
+			}
+		}
+		free(subjob_name);
+	}
+
+	if (fclose(fp) != 0 || rename(ESTIMATES_TMP_FILE, ESTIMATES_FILE) == -1) {
+		log_err(errno, __func__, "Unable to write " ESTIMATES_FILE);
+		unlink(ESTIMATES_TMP_FILE);
+		return -1;
+	}
+
+	return num_est;
+}
+
+/**
+ * @brief
+ * 		Fork a helper process which calculates the estimated start times
+ *		of all jobs in the post-cycle universe.  The helper gets its own
+ *		copy-on-write snapshot of sinfo, so the main scheduler can free
+ *		sinfo and start the next cycle right away.  The results are
+ *		picked up by publish_background_estimates().
+ *
+ * @param[in]	sinfo	-	the post-cycle universe
+ *
+ * @return	int
+ * @retval	1	: helper started
+ * @retval	0	: helper not started (one is still running or fork failed)
+ */
+int
+start_background_estimates(server_info *sinfo)
+{
+	pid_t pid;
+
+	if (sinfo == NULL)
+		return 0;
+
+	if (est_helper_pid > 0) {
+		log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+			"Previous estimates helper still running, not starting a new one");
+		return 0;
+	}
+
+	pid = fork();
+	if (pid == -1) {
+		log_err(errno, __func__, "fork failed");
+		return 0;
+	}
+
+	if (pid == 0) {
+		int num_est;
+		/* The worker threads did not survive the fork, do all the work ourselves */
+		num_threads = 1;
+		num_est = write_all_estimates(sinfo);
+		if (num_est >= 0)
+			log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+				"Estimated start times of %d jobs", num_est);
+		_exit(num_est >= 0 ? 0 : 1);
+	}
+
+	est_helper_pid = pid;
+	log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+		"Started estimates helper %d", (int) pid);
+
+	return 1;
+}
+
+/**
+ * @brief
+ * 		If the estimates helper has finished, send all of its estimates
+ *		to the server in one batch of asynchronous alterjob requests.
+ *		Jobs which have started or left the system since the helper was
+ *		forked are skipped.
+ *
+ * @param[in]	pbs_sd	-	connection descriptor to pbs server
+ * @param[in]	sinfo	-	the current universe
+ *
+ * @return	int
+ * @retval	number of jobs updated
+ */
+int
+publish_background_estimates(int pbs_sd, server_info *sinfo)
+{
+	FILE *fp;
+	char *buf = NULL;
+	int buf_size = 0;
+	int num_sent = 0;
+	int status;
+	pid_t pid;
+
+	if (est_helper_pid <= 0 || sinfo == NULL)
+		return 0;
+
+	pid = waitpid(est_helper_pid, &status, WNOHANG);
+	if (pid == 0)
+		return 0;	/* still running */
+
+	est_helper_pid = 0;
+	if (pid == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		log_event(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING, __func__,
+			"Estimates helper failed, no estimates to publish");
+		return 0;
+	}
+
+	if ((fp = fopen(ESTIMATES_FILE, "r")) == NULL)
+		return 0;
+
+	while (pbs_fgets_extend(&buf, &buf_size, fp) != NULL) {
+		struct attrl est_attrs[2] = {{0}};
+		resource_resv *resresv;
+		char *jobid;
+		char *start;
+		char *exec_vnode;
+		char *saveptr;
+
+		jobid = strtok_r(buf, " ", &saveptr);
+		start = strtok_r(NULL, " ", &saveptr);
+		exec_vnode = strtok_r(NULL, " \n", &saveptr);
+		if (jobid == NULL || start == NULL || exec_vnode == NULL)
+			continue;
+
+		resresv = find_resource_resv(sinfo->jobs, jobid);
+		if (resresv == NULL || !in_runnable_state(resresv))
+			continue;
+
+		est_attrs[0].name = ATTR_estimated;
+		est_attrs[0].resource = "start_time";
+		est_attrs[0].value = start;
+		est_attrs[0].next = &est_attrs[1];
+		est_attrs[1].name = ATTR_estimated;
+		est_attrs[1].resource = "exec_vnode";
+		est_attrs[1].value = exec_vnode;
+
+		if (send_attr_updates(pbs_sd, jobid, est_attrs))
+			num_sent++;
+	}
+	free(buf);
+	fclose(fp);
+	unlink(ESTIMATES_FILE);
+
+	log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+		"Published estimated start times of %d jobs", num_sent);
+
+	return num_sent;
+}
+
+/**
+ * @brief
+ * 		stop a running estimates helper
+ *
+ * @return	void
+ */
+void
+kill_background_estimates(void)
+{
+	if (est_helper_pid > 0) {
+		kill(est_helper_pid, SIGKILL);
+		waitpid(est_helper_pid, NULL, 0);
+		est_helper_pid = 0;
+	}
+}
+
 
 /**
  * @brief
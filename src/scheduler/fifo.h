@@ -198,6 +198,21 @@ void end_cycle_tasks(server_info *sinfo);
  */
 int add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo, resource_resv *topjob, int use_buckets);
 
+/*
+ *	start_background_estimates - fork a helper to estimate the start times of all jobs
+ */
+int start_background_estimates(server_info *sinfo);
+
+/*
+ *	publish_background_estimates - send the estimates of a finished helper to the server
+ */
+int publish_background_estimates(int pbs_sd, server_info *sinfo);
+
+/*
+ *	kill_background_estimates - stop a running estimates helper
+ */
+void kill_background_estimates(void);
+
 /*
  * 	run_job - handle the running of a pbs job.  If it's a peer job
  *	       first move it to the local server and then run it.
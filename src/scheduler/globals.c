@@ -175,3 +175,5 @@ struct schedattrs sc_attrs;
 time_t last_attr_updates = 0;
 
 int send_job_attr_updates = 1;
+
+pid_t est_helper_pid = 0;
@@ -43,6 +43,7 @@
 extern "C" {
 #endif
 #include <pthread.h>
+#include <sys/types.h>
 
 #include "data_types.h"
 #include "limits.h"
@@ -112,6 +113,8 @@ extern time_t last_attr_updates;    /* timestamp of the last time attr updates w
 
 extern int send_job_attr_updates;
 
+extern pid_t est_helper_pid;	/* pid of the background estimates helper */
+
 /**
  * @brief
  * It is used as a placeholder to store aoe name. This aoe name will be
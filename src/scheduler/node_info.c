@@ -1948,7 +1948,9 @@ update_node_on_run(nspec *ns, resource_resv *resresv, char *job_state)
 	if (resresv->run_event != NULL)
 		remove_te_list(&ninfo->node_events, resresv->run_event);
 
-	if (ninfo->node_ind != -1 && ninfo->bucket_ind != -1) {
+	/* A node running a shared job might already be in the busy pool */
+	if (ninfo->node_ind != -1 && ninfo->bucket_ind != -1 &&
+	    !pbs_bitmap_get_bit(ninfo->server->buckets[ninfo->bucket_ind]->busy_pool->truth, ninfo->node_ind)) {
 		node_bucket *bkt = ninfo->server->buckets[ninfo->bucket_ind];
 		int ind = ninfo->node_ind;
 
@@ -274,6 +274,8 @@ parse_config(char *fname)
 					conf.enforce_no_shares = num ? 1 : 0;
 				else if (!strcmp(config_name, PARSE_ALLOW_AOE_CALENDAR))
 					conf.allow_aoe_calendar = 1;
+				else if (!strcmp(config_name, PARSE_BACKGROUND_ESTIMATES))
+					conf.background_estimates = num ? 1 : 0;
 				else if (!strcmp(config_name, PARSE_PRIME_SPILL)) {
 					if (prime == PRIME || prime == ALL)
 						conf.prime_spill = res_to_num(config_value, &type);
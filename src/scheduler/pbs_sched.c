@@ -1214,6 +1214,9 @@ main(int argc, char *argv[])
 
 	pthread_mutex_init(&cleanup_lock, &attr);
 
+	if (log_async_start(pbs_conf.pbs_log_async) != 0)
+		log_err(errno, __func__, "unable to start asynchronous logging");
+
 	connect_servers();
 
 	for (go=1; go;) {
@@ -48,6 +48,7 @@
  *	acct_open()
  *	acct_record()
  *	acct_close()
+ *	acct_flush()
  */
 
 
@@ -62,6 +63,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include "list_link.h"
 #include "attribute.h"
 #include "resource.h"
@@ -76,10 +79,26 @@
 #include "server.h"
 #include "svrfunc.h"
 #include "libutil.h"
+#include "work_task.h"
+#include "pbs_internal.h"
+
+/* size of the buffer holding the records not yet written to a file */
+#define ACCT_OUT_BUFSZ	(256 * 1024)
+
+/* an accounting file and the records waiting to be written to it */
+typedef struct acct_out {
+	int	ao_fd;		/* open file, -1 if none */
+	char	*ao_buf;	/* records not yet written */
+	size_t	ao_len;		/* bytes used in ao_buf */
+} acct_out;
 
 /* Local Data */
 
-static FILE *acctfile;		/* open stream for log file */
+static acct_out acctfile = {-1, NULL, 0};	/* the accounting log */
+static acct_out acctjson = {-1, NULL, 0};	/* the JSON lines sidecar */
+static pid_t acct_pid;		/* process owning the unwritten records */
+static int acct_batching = 0;	/* records are written by acct_flush_task */
+static struct work_task *acct_flush_wt = NULL;
 static volatile int acct_opened = 0;
 static int acct_opened_day;
 static int acct_auto_switch = 0;
@@ -123,6 +142,8 @@ grow_acct_buf(char **pb, int *avail, int need)
 	char *new;
 
 	ln = acct_bufsize + need + need + PBS_ACCT_LEAVE_EXTRA;
+	if (ln < (size_t)acct_bufsize * 2)
+		ln = (size_t)acct_bufsize * 2;	/* keep regrowth rare */
 	new = realloc(acct_buf, (size_t)(ln+1));
 	if (new == NULL) {
 		log_err(errno, __func__, "realloc failure");
@@ -911,12 +932,170 @@ acct_resv(resc_resv *presv, char *buf, int len)
 	return (pb);
 }
 
+/**
+ * @brief
+ *	acct_out_write - write out the records held for an accounting file
+ *
+ * @param[in,out]	ao - accounting file
+ *
+ * @return	void
+ */
+static void
+acct_out_write(acct_out *ao)
+{
+	char *p = ao->ao_buf;
+	ssize_t n;
+
+	while (ao->ao_len > 0) {
+		n = write(ao->ao_fd, p, ao->ao_len);
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			log_err(errno, __func__, "accounting records lost");
+			break;
+		}
+		p += n;
+		ao->ao_len -= n;
+	}
+	ao->ao_len = 0;
+}
+
+/**
+ * @brief
+ *	acct_out_append - add data to the records held for an accounting file,
+ *	writing out what is held first when the buffer fills up
+ *
+ * @param[in,out]	ao - accounting file
+ * @param[in]	data - data to add
+ * @param[in]	len - length of data
+ *
+ * @return	void
+ */
+static void
+acct_out_append(acct_out *ao, const char *data, size_t len)
+{
+	size_t n;
+
+	if (ao->ao_fd == -1)
+		return;
+	while (len > 0) {
+		if (ao->ao_len == ACCT_OUT_BUFSZ)
+			acct_out_write(ao);
+		n = ACCT_OUT_BUFSZ - ao->ao_len;
+		if (n > len)
+			n = len;
+		memcpy(ao->ao_buf + ao->ao_len, data, n);
+		ao->ao_len += n;
+		data += n;
+		len -= n;
+	}
+}
+
+/**
+ * @brief
+ *	acct_out_open - open an accounting file for append
+ *	If the file is already open and the new one is successfully opened,
+ *	the held records are written out and the old file is closed.
+ *
+ * @param[in,out]	ao - accounting file
+ * @param[in]	filename - abs pathname
+ *
+ * @return      Error code
+ * @retval	 0  - Success
+ * @retval	-1  - Failure
+ */
+static int
+acct_out_open(acct_out *ao, char *filename)
+{
+	int fd;
+
+	if (ao->ao_buf == NULL) {
+		ao->ao_buf = malloc(ACCT_OUT_BUFSZ);
+		if (ao->ao_buf == NULL) {
+			log_err(errno, __func__, "malloc failure");
+			return (-1);
+		}
+	}
+	if ((fd = open(filename, O_WRONLY | O_APPEND | O_CREAT, 0666)) == -1) {
+		log_err(errno, "acct_open", filename);
+		return (-1);
+	}
+	(void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+	if (ao->ao_fd != -1) {
+		acct_out_write(ao);
+		(void)close(ao->ao_fd);
+	}
+	ao->ao_fd = fd;
+	return (0);
+}
+
+/**
+ * @brief
+ *	acct_out_close - write out the held records and close an accounting file
+ *
+ * @param[in,out]	ao - accounting file
+ *
+ * @return	void
+ */
+static void
+acct_out_close(acct_out *ao)
+{
+	if (ao->ao_fd == -1)
+		return;
+	acct_out_write(ao);
+	(void)close(ao->ao_fd);
+	ao->ao_fd = -1;
+}
+
+/**
+ * @brief
+ *	acct_flush - write out the accounting records held in memory
+ *
+ * @param[in]	sync - if non-zero, also commit the files to disk
+ *
+ * @return	void
+ */
+void
+acct_flush(int sync)
+{
+	if (acct_opened == 0)
+		return;
+	acct_out_write(&acctfile);
+	if (acctjson.ao_fd != -1)
+		acct_out_write(&acctjson);
+	if (sync) {
+		(void)fsync(acctfile.ao_fd);
+		if (acctjson.ao_fd != -1)
+			(void)fsync(acctjson.ao_fd);
+	}
+}
+
+/**
+ * @brief
+ *	acct_flush_task - work task writing out and syncing the accounting
+ *	records every PBS_ACCT_FLUSH_INTERVAL seconds
+ *
+ * @param[in]	ptask - work task
+ *
+ * @return	void
+ */
+static void
+acct_flush_task(struct work_task *ptask)
+{
+	acct_flush(1);
+	acct_flush_wt = set_task(WORK_Timed,
+		time_now + pbs_conf.pbs_acct_flush_interval, acct_flush_task, NULL);
+}
+
 /**
  * @brief
  * acct_open() - open the acct file for append.
  * Opens a (new) acct file.
  * If a acct file is already open, and the new file is successfully opened,
  * the old file is closed.  Otherwise the old file is left open.
+ * With PBS_ACCT_JSON set, the records are also written as JSON lines to
+ * the file of the same name with a ".json" suffix.
  *
  * @param[in]	filename - abs pathname or NULL
  *
@@ -927,9 +1106,9 @@ acct_resv(resc_resv *presv, char *buf, int len)
 int
 acct_open(char *filename)
 {
-    char  filen[_POSIX_PATH_MAX];
+	char  filen[_POSIX_PATH_MAX];
+	char  jsonfilen[_POSIX_PATH_MAX + 6];
 	char  logmsg[_POSIX_PATH_MAX+80];
-	FILE *newacct;
 	time_t now;
 	struct tm *ptm;
 
@@ -953,17 +1132,22 @@ acct_open(char *filename)
 	} else if (*filename != '/') {
 		return (-1);		/* not absolute */
 	}
-	if ((newacct = fopen(filename, "a")) == NULL) {
-		log_err(errno, "acct_open", filename);
+	if (acct_out_open(&acctfile, filename) == -1)
 		return (-1);
-	}
 
-	(void)setvbuf(newacct, NULL, _IOLBF, 0); /* set line buffering */
+	if (pbs_conf.pbs_acct_json) {
+		(void)snprintf(jsonfilen, sizeof(jsonfilen), "%s.json", filename);
+		if (acct_out_open(&acctjson, jsonfilen) == -1)
+			acct_out_close(&acctjson);
+	}
 
-	if (acct_opened > 0) 		/* if acct was open, close it */
-		(void)fclose(acctfile);
+	acct_pid = getpid();
+	acct_batching = (pbs_conf.pbs_acct_flush_interval > 0);
+	if (acct_batching && acct_flush_wt == NULL)
+		acct_flush_wt = set_task(WORK_Timed,
+			time_now + pbs_conf.pbs_acct_flush_interval,
+			acct_flush_task, NULL);
 
-	acctfile = newacct;
 	acct_opened = 1;			/* note that file is open */
 	(void)sprintf(logmsg, "Account file %s opened", filename);
 	log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_INFO,
@@ -982,14 +1166,150 @@ void
 acct_close()
 {
 	if (acct_opened == 1) {
-		(void)fclose(acctfile);
+		if (acct_pid != getpid()) {
+			/* held records were inherited, the parent writes them */
+			acctfile.ao_len = 0;
+			acctjson.ao_len = 0;
+		}
+		acct_out_close(&acctfile);
+		acct_out_close(&acctjson);
 		acct_opened = 0;
 	}
 }
 
+/**
+ * @brief
+ *	acct_json_str - append a string to the JSON sidecar as a JSON string
+ *
+ * @param[in]	str - string
+ * @param[in]	len - length of str
+ *
+ * @return	void
+ */
+static void
+acct_json_str(const char *str, size_t len)
+{
+	char buf[256];
+	size_t n = 0;
+	size_t i;
+	unsigned char c;
+
+	buf[n++] = '"';
+	for (i = 0; i < len; i++) {
+		if (n > sizeof(buf) - 8) {
+			acct_out_append(&acctjson, buf, n);
+			n = 0;
+		}
+		c = (unsigned char)str[i];
+		if (c == '"' || c == '\\') {
+			buf[n++] = '\\';
+			buf[n++] = c;
+		} else if (c < 0x20) {
+			n += sprintf(buf + n, "\\u%04x", c);
+		} else {
+			buf[n++] = c;
+		}
+	}
+	buf[n++] = '"';
+	acct_out_append(&acctjson, buf, n);
+}
+
+/**
+ * @brief
+ *	acct_json_next - find the next key=value pair in an accounting record
+ *
+ * @param[in]	p - where to start looking
+ * @param[out]	key - start of the key
+ * @param[out]	val - start of the value, without its quotes
+ * @param[out]	vlen - length of the value
+ *
+ * @return	char *
+ * @retval	where the pair ends
+ * @retval	NULL if there is no pair left or the text is not a pair
+ */
+static char *
+acct_json_next(char *p, char **key, char **val, size_t *vlen)
+{
+	char *end;
+
+	while (*p == ' ')
+		p++;
+	if (*p == '\0')
+		return NULL;
+	*key = p;
+	while (*p != '\0' && *p != ' ' && *p != '=')
+		p++;
+	if (*p != '=' || p == *key)
+		return NULL;
+	p++;
+	if ((*p == '"' || *p == '\'') && (end = strchr(p + 1, *p)) != NULL &&
+		(end[1] == ' ' || end[1] == '\0')) {
+		*val = p + 1;
+		*vlen = end - *val;
+		return end + 1;
+	}
+	*val = p;
+	while (*p != '\0' && *p != ' ')
+		p++;
+	*vlen = p - *val;
+	return p;
+}
+
+/**
+ * @brief
+ *	acct_json_record - write an accounting record to the JSON sidecar
+ *	The key=value pairs of the record become members of a JSON object;
+ *	text that is not made of such pairs is kept whole as "text".
+ *
+ * @param[in]	acctype - accounting record type
+ * @param[in]	id - accounting record id
+ * @param[in]	text - record text
+ *
+ * @return	void
+ */
+static void
+acct_json_record(int acctype, const char *id, char *text)
+{
+	char hdr[80];
+	char *p;
+	char *q;
+	char *key;
+	char *val;
+	size_t vlen;
+	int pairs;
+
+	/* does the whole text split into pairs? */
+	q = text;
+	while ((p = acct_json_next(q, &key, &val, &vlen)) != NULL)
+		q = p;
+	while (*q == ' ')
+		q++;
+	pairs = (*q == '\0');
+
+	(void)snprintf(hdr, sizeof(hdr), "{\"time\":%ld,\"type\":\"%c\",\"id\":",
+		(long)time_now, (char)acctype);
+	acct_out_append(&acctjson, hdr, strlen(hdr));
+	acct_json_str(id, strlen(id));
+
+	if (!pairs) {
+		acct_out_append(&acctjson, ",\"text\":", 8);
+		acct_json_str(text, strlen(text));
+	} else {
+		for (p = text; (p = acct_json_next(p, &key, &val, &vlen)) != NULL;) {
+			acct_out_append(&acctjson, ",", 1);
+			acct_json_str(key, strchr(key, '=') - key);
+			acct_out_append(&acctjson, ":", 1);
+			acct_json_str(val, vlen);
+		}
+	}
+	acct_out_append(&acctjson, "}\n", 2);
+}
+
 /**
  * @brief
  * write_account_record - write basic accounting record
+ *	With PBS_ACCT_FLUSH_INTERVAL set the record is held in memory and
+ *	written out by acct_flush_task, otherwise it is written right away.
  *
  * @param[in]	acctype - accounting record type
  * @param[in]	id - accounting record id
@@ -1001,10 +1321,23 @@ void
 write_account_record(int acctype, const char *id, char *text)
 {
 	struct tm *ptm;
+	char hdr[64];
+	int len;
 
 	if (acct_opened == 0)
 		return;		/* file not open, don't bother */
 
+	if (acct_pid != getpid()) {
+		/*
+		 * A forked child has no flush task and leaves the records
+		 * it inherited to the parent.
+		 */
+		acctfile.ao_len = 0;
+		acctjson.ao_len = 0;
+		acct_pid = getpid();
+		acct_batching = 0;
+	}
+
 	ptm = localtime(&time_now);
 
 	/* Do we need to switch files */
@@ -1012,15 +1345,26 @@ write_account_record(int acctype, const char *id, char *text)
 	if (acct_auto_switch && (acct_opened_day != ptm->tm_yday)) {
 		acct_close();
 		acct_open(NULL);
+		if (acct_opened == 0)
+			return;
 	}
 	if (text == NULL)
 		text = "";
 
-	(void)fprintf(acctfile,
-		"%02d/%02d/%04d %02d:%02d:%02d;%c;%s;%s\n",
+	len = snprintf(hdr, sizeof(hdr), "%02d/%02d/%04d %02d:%02d:%02d;%c;",
 		ptm->tm_mon+1, ptm->tm_mday, ptm->tm_year+1900,
-		ptm->tm_hour, ptm->tm_min, ptm->tm_sec,
-		(char)acctype, id, text);
+		ptm->tm_hour, ptm->tm_min, ptm->tm_sec, (char)acctype);
+	acct_out_append(&acctfile, hdr, len);
+	acct_out_append(&acctfile, id, strlen(id));
+	acct_out_append(&acctfile, ";", 1);
+	acct_out_append(&acctfile, text, strlen(text));
+	acct_out_append(&acctfile, "\n", 1);
+
+	if (acctjson.ao_fd != -1)
+		acct_json_record(acctype, id, text);
+
+	if (!acct_batching)
+		acct_flush(0);
 }
 
 /**
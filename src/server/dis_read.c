@@ -342,7 +342,7 @@ decode_DIS_replySvr_inner(int sock, struct batch_reply *reply)
 			reply->brp_count = ct;
 
 			while (ct--) {
-				pstsvr = (struct brp_status *)malloc(sizeof(struct brp_status));
+				pstsvr = (struct brp_status *)calloc(1, sizeof(struct brp_status));
 				if (pstsvr == 0) return DIS_NOMALLOC;
 
 				CLEAR_LINK(pstsvr->brp_stlink);
@@ -2302,7 +2302,7 @@ status_hook(hook *phook, struct batch_request *preq, pbs_list_head *pstathd, cha
 	}
 	memset(hook_msg, '\0', msg_len);
 
-	pstat = (struct brp_status *)malloc(sizeof(struct brp_status));
+	pstat = (struct brp_status *)calloc(1, sizeof(struct brp_status));
 	if (pstat == NULL)
 		return (PBSE_SYSTEM);
 
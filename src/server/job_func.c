@@ -358,6 +358,7 @@ job_alloc(void)
 	pj->ji_prunreq = NULL;
 	pj->ji_pmt_preq = NULL;
 	CLEAR_HEAD(pj->ji_svrtask);
+	CLEAR_LINK(pj->ji_dirtyjobs);
 	CLEAR_HEAD(pj->ji_rejectdest);
 	pj->ji_terminated = 0;
 	pj->ji_deletehistory = 0;
@@ -500,6 +501,9 @@ job_free(job *pj)
 		badplace		*bp;
 
 		free_job_work_tasks(pj);
+		job_statcache_free(pj);
+		free(pj->ji_packed);
+		pj->ji_packed = NULL;
 
 		/* free any bad destination structs */
 
@@ -535,11 +539,14 @@ job_free(job *pj)
 		free(pj->ji_script);
 	if (pj->ji_prov_startjob_task)
 		delete_task(pj->ji_prov_startjob_task);
+	delete_link(&pj->ji_dirtyjobs);
 
 #else	/* PBS_MOM  Mom Only */
 
 	if (pj->ji_grpcache)
 		(void)free(pj->ji_grpcache);
+	if (pj->ji_cgroup)
+		free(pj->ji_cgroup);
 
 	assert(pj->ji_preq == NULL);
 	nodes_free(pj);
@@ -1025,6 +1032,9 @@ job_purge(job *pjob)
 		pjob->ji_rerun_preq = NULL;
 	}
 #ifndef PBS_MOM
+	/* the limits and the queue are updated from the values */
+	(void)svr_histjob_unpack(pjob);
+
 	if (pjob->ji_pmt_preq != NULL) {
 		log_joberr(PBSE_INTERNAL, __func__, "preempt request outstanding",
 			   pjob->ji_qs.ji_jobid);
@@ -1205,6 +1215,9 @@ job_purge(job *pjob)
 #endif
 
 #else
+	/* drop any deferred save, the job is leaving the database */
+	delete_link(&pjob->ji_dirtyjobs);
+
 	/* delete job and dependants from database */
 	obj.pbs_db_obj_type = PBS_DB_JOB;
 	obj.pbs_db_un.pbs_db_job = &dbjob;
@@ -1352,10 +1365,16 @@ find_job(char *jobid)
 		strcat(buf, server_name);
 	}
 
-#endif
+	if (pbs_idx_find(jobs_idx, &pbuf, (void **)&pj, NULL) != PBS_IDX_RET_OK)
+		return NULL;
+	/* callers look at the values */
+	(void)svr_histjob_borrow(pj);
+	return pj;
+#else
 	if (pbs_idx_find(jobs_idx, &pbuf, (void **)&pj, NULL) == PBS_IDX_RET_OK)
 		return pj;
 	return NULL;
+#endif
 }
 
 /**
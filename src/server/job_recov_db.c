@@ -42,6 +42,7 @@
 #include <stdio.h>
 #include <sys/types.h>
 #include <sys/param.h>
+#include <sys/time.h>
 #include <execinfo.h>
 
 #include "pbs_ifl.h"
@@ -64,19 +65,27 @@
 #include <memory.h>
 #include "libutil.h"
 #include "pbs_db.h"
+#include "work_task.h"
+#include "pbs_error.h"
 
 
 #define MAX_SAVE_TRIES 3
+#define RECOV_PROGRESS_JOBS 50000	/* log recovery progress every so many jobs */
 
 extern void *svr_db_conn;
 extern int server_init_type;
 extern pbs_list_head svr_allresvs;
+extern pbs_list_head svr_dirtyjobs;
 #define BACKTRACE_BUF_SIZE 50
 void print_backtrace(char *);
 
 /* global data items */
 extern time_t time_now;
 
+/* seconds a job save may be held back so that saves get batched, 0 = off */
+long svr_job_save_delay = 0;
+static struct work_task *job_save_flush_task = NULL;
+
 job *recov_job_cb(pbs_db_obj_info_t *dbobj, int *refreshed);
 resc_resv *recov_resv_cb(pbs_db_obj_info_t *dbobj, int *refreshed);
 
@@ -217,7 +226,7 @@ db_to_job(job *pjob,  pbs_db_job_info_t *dbjob)
 
 /**
  * @brief
- *		Save job to database
+ *		Write a job to the database right away
  *
  * @param[in]	pjob - The job to save
  *
@@ -227,8 +236,8 @@ db_to_job(job *pjob,  pbs_db_job_info_t *dbjob)
  * @retval	 1 - Jobid clash, retry with new jobid
  *
  */
-int
-job_save_db(job *pjob)
+static int
+job_save_db_now(job *pjob)
 {
 	pbs_db_job_info_t dbjob = {{0}};
 	pbs_db_obj_info_t obj;
@@ -275,6 +284,135 @@ done:
 	return (rc);
 }
 
+/**
+ * @brief
+ *		Work task which writes out the deferred job saves
+ *
+ * @param[in]	ptask - the work task
+ */
+static void
+job_save_flush_work(struct work_task *ptask)
+{
+	job_save_flush_task = NULL;
+	job_save_flush();
+}
+
+/**
+ * @brief
+ *		Save job to database
+ *
+ * @par Functionality:
+ *		If job_save_delay is set, a job which is already in the database
+ *		is only put on svr_dirtyjobs and written, along with every other
+ *		job saved in the meantime, in one transaction by job_save_flush()
+ *		at most job_save_delay seconds later.  Several saves of the same
+ *		job in that window become a single write.  A new job is always
+ *		written at once, so the reply to its submission is only sent once
+ *		the job is durable, and the jobid clash can be reported.
+ *
+ * @param[in]	pjob - The job to save
+ *
+ * @return      Error code
+ * @retval	 0 - Success
+ * @retval	-1 - Failure
+ * @retval	 1 - Jobid clash, retry with new jobid
+ *
+ */
+int
+job_save_db(job *pjob)
+{
+	if ((svr_job_save_delay > 0) && !pjob->newobj) {
+		/* CLEAR_LINK points an unlinked link at itself */
+		if (pjob->ji_dirtyjobs.ll_next == &pjob->ji_dirtyjobs)
+			append_link(&svr_dirtyjobs, &pjob->ji_dirtyjobs, pjob);
+		if (job_save_flush_task == NULL)
+			job_save_flush_task = set_task(WORK_Timed, time_now + svr_job_save_delay, job_save_flush_work, NULL);
+		if (job_save_flush_task != NULL)
+			return 0;
+	}
+
+	/* this save covers any deferred one */
+	delete_link(&pjob->ji_dirtyjobs);
+
+	return (job_save_db_now(pjob));
+}
+
+/**
+ * @brief
+ *		Write all deferred job saves to the database in one transaction.
+ *		Callers which need the jobs saved so far to be durable before they
+ *		go on (e.g. at shutdown) call this as a commit barrier.
+ */
+void
+job_save_flush(void)
+{
+	job *pjob;
+	int count = 0;
+	int trx;
+
+	if (job_save_flush_task != NULL) {
+		delete_task(job_save_flush_task);
+		job_save_flush_task = NULL;
+	}
+
+	if (GET_NEXT(svr_dirtyjobs) == NULL)
+		return;
+
+	trx = (pbs_db_begin_trx(svr_db_conn) == 0);
+
+	while ((pjob = (job *) GET_NEXT(svr_dirtyjobs)) != NULL) {
+		delete_link(&pjob->ji_dirtyjobs);
+		job_save_db_now(pjob);
+		count++;
+	}
+
+	if (trx && pbs_db_end_trx(svr_db_conn, PBS_DB_COMMIT) != 0) {
+		log_errf(PBSE_INTERNAL, __func__, "Failed to commit saves of %d jobs", count);
+		panic_stop_db();
+	}
+
+	log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SERVER, LOG_DEBUG, msg_daemonname,
+		"Saved %d jobs in one transaction", count);
+}
+
+/**
+ * @brief
+ *		Action routine for the server's job_save_delay attribute
+ *
+ * @param[in]	pattr	-	pointer to attribute structure
+ * @param[in]	pobject -	pointer to some parent object.(not used here)
+ * @param[in]	actmode	-	the action to take (e.g. ATR_ACTION_ALTER)
+ *
+ * @return	int
+ * @retval	PBSE_NONE on success
+ * @retval	PBSE_BADATVAL if the value is negative
+ */
+int
+set_job_save_delay(attribute *pattr, void *pobject, int actmode)
+{
+	if ((actmode == ATR_ACTION_ALTER) ||
+		(actmode == ATR_ACTION_RECOV)) {
+		if (is_attr_set(pattr) && pattr->at_val.at_long < 0)
+			return PBSE_BADATVAL;
+
+		svr_job_save_delay = is_attr_set(pattr) ? pattr->at_val.at_long : 0;
+		if (svr_job_save_delay == 0)
+			job_save_flush();
+	}
+	return PBSE_NONE;
+}
+
+/**
+ * @brief
+ *		Unset the server's job_save_delay: go back to saving jobs at once
+ */
+void
+unset_job_save_delay(void)
+{
+	svr_job_save_delay = 0;
+	job_save_flush();
+}
+
 /**
  * @brief
  *	Utility function called inside job_recov_db
@@ -564,6 +702,12 @@ recov_job_cb(pbs_db_obj_info_t *dbobj, int *refreshed)
 	job *pj = NULL;
 	pbs_db_job_info_t *dbjob = dbobj->pbs_db_un.pbs_db_job;
 	static int numjobs = 0;
+	static struct timeval start;
+	struct timeval now;
+	double secs;
+
+	if (numjobs == 0)
+		gettimeofday(&start, NULL);
 
 	*refreshed = 0;
 	if ((pj = job_recov_db_spl(dbjob, NULL)) == NULL) {
@@ -584,6 +728,13 @@ recov_job_cb(pbs_db_obj_info_t *dbobj, int *refreshed)
 		update_svrlive();
 	}
 
+	if ((numjobs % RECOV_PROGRESS_JOBS) == 0) {
+		gettimeofday(&now, NULL);
+		secs = (now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec) / 1000000.0;
+		log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_INFO, msg_daemonname,
+			"Recovered %d jobs so far, %.0f jobs/sec", numjobs, secs > 0 ? numjobs / secs : 0.0);
+	}
+
 err:
 	free_db_attr_list(&dbjob->db_attr_list);
 	if (pj == NULL)
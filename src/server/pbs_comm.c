@@ -589,6 +589,9 @@ main(int argc, char **argv)
 	/* Protect from being killed by kernel */
 	daemon_protect(0, PBS_DAEMON_PROTECT_ON);
 
+	if (log_async_start(pbs_conf.pbs_log_async) != 0)
+		log_err(errno, __func__, "unable to start asynchronous logging");
+
 	/* go in a while loop */
 	while (get_out == 0) {
 
@@ -333,6 +333,9 @@ pbsd_init(int type)
 	pbs_db_sched_info_t	dbsched = {{0}};
 	pbs_db_obj_info_t	obj = {0};
 	void	*conn = (void *) svr_db_conn;
+	struct timeval	recov_start;
+	struct timeval	recov_end;
+	double	recov_secs;
 	char *buf = NULL;
 	int buf_len = 0;
 
@@ -746,6 +749,7 @@ pbsd_init(int type)
 	/* get jobs from DB */
 	obj.pbs_db_obj_type = PBS_DB_JOB;
 	obj.pbs_db_un.pbs_db_job = &dbjob;
+	gettimeofday(&recov_start, NULL);
 	rc = pbs_db_search(conn, &obj, NULL, (query_cb_t)&recov_job_cb);
 	if (rc == -1) {
 		pbs_db_get_errmsg(PBS_DB_ERR, &conn_db_err);
@@ -761,6 +765,13 @@ pbsd_init(int type)
 	}
 
 	log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_NOTICE, msg_daemonname, msg_init_exptjobs, server.sv_qs.sv_numjobs);
+	if (rc > 0) {
+		gettimeofday(&recov_end, NULL);
+		recov_secs = (recov_end.tv_sec - recov_start.tv_sec) + (recov_end.tv_usec - recov_start.tv_usec) / 1000000.0;
+		log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_INFO, msg_daemonname,
+			"Recovered %d jobs in %.2f seconds, %.0f jobs/sec", rc, recov_secs,
+			recov_secs > 0 ? rc / recov_secs : 0.0);
+	}
 
 	/* Now, cause any reservations marked RESV_FINISHED to be
 	 * removed and place "begin" and "end" tasks onto the
@@ -217,6 +217,7 @@ pbs_list_head	svr_deferred_req;
 pbs_list_head	svr_queues;            /* list of queues                   */
 pbs_list_head	svr_alljobs;           /* list of all jobs in server       */
 pbs_list_head	svr_newjobs;           /* list of incomming new jobs       */
+pbs_list_head	svr_dirtyjobs;         /* jobs waiting for a deferred save */
 pbs_list_head	svr_allresvs;          /* all reservations in server */
 pbs_list_head	task_list_immed;
 pbs_list_head	task_list_timed;
@@ -954,6 +955,7 @@ main(int argc, char **argv)
 	CLEAR_HEAD(svr_queues);
 	CLEAR_HEAD(svr_alljobs);
 	CLEAR_HEAD(svr_newjobs);
+	CLEAR_HEAD(svr_dirtyjobs);
 	CLEAR_HEAD(svr_allresvs);
 	CLEAR_HEAD(svr_deferred_req);
 	CLEAR_HEAD(svr_allhooks);
@@ -1346,6 +1348,9 @@ main(int argc, char **argv)
 	 * following section constitutes the "main" loop of the server
 	 */
 
+	if (log_async_start(pbs_conf.pbs_log_async) != 0)
+		log_err(errno, msg_daemonname, "unable to start asynchronous logging");
+
 	state  = &server.sv_attr[(int)SVR_ATR_State].at_val.at_long;
 	if (server_init_type == RECOV_HOT)
 		*state = SV_STATE_HOT;
@@ -1526,6 +1531,7 @@ main(int argc, char **argv)
 
 	/* set the current seq id to the last id before final save */
 	server.sv_qs.sv_lastid = server.sv_qs.sv_jobidnumber;
+	job_save_flush();	/* write out any deferred job saves */
 	svr_save_db(&server);	/* final recording of server */
 	track_save(NULL);	/* save tracking data	     */
 
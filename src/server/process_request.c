@@ -58,6 +58,8 @@
  *	process_request()
  *	set_to_non_blocking()
  *	clear_non_blocking()
+ *	post_stat_child()
+ *	stat_in_child()
  *	dispatch_request()
  *	close_client()
  *	alloc_br()
@@ -115,6 +117,13 @@
 
 pbs_list_head svr_requests;
 
+#ifndef PBS_MOM
+/* large status requests served by forked children, see stat_in_child() */
+#define STAT_CHILD_MAX		4
+#define STAT_CHILD_MIN_OBJS	5000
+static int stat_children = 0;
+#endif
+
 
 extern struct server server;
 extern char      server_host[];
@@ -259,6 +268,14 @@ req_authenticate(conn_t *conn, struct batch_request *request)
 	if (strcmp(request->rq_ind.rq_auth.rq_auth_method, AUTH_RESVPORT_NAME) == 0) {
 		transport_chan_set_ctx_status(cp->cn_sock, AUTH_STATUS_CTX_READY, FOR_AUTH);
 	}
+	if (cp == conn && request->rq_extend != NULL && strcmp(request->rq_extend, DIS_BINARY_EXTEND) == 0) {
+		int sock = conn->cn_sock;
+
+		/* reply in DIS text, everything after it is binary */
+		if (reply_text(request, PBSE_NONE, DIS_BINARY_EXTEND) == 0)
+			transport_chan_set_binary(sock, 1);
+		return;
+	}
 	reply_ack(request);
 }
 
@@ -751,6 +768,113 @@ clear_non_blocking(conn_t *conn)
 		conn->cn_sockflgs = 0;
 	}
 }
+
+/**
+ * @brief
+ *		Work task run when a status child exits.
+ *
+ * @param[in] ptask - the deferred child work task
+ */
+static void
+post_stat_child(struct work_task *ptask)
+{
+	if (stat_children > 0)
+		stat_children--;
+	if (ptask->wt_aux != 0)
+		log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_REQUEST, LOG_NOTICE, __func__,
+			"status child %ld exited with status %d", ptask->wt_event, ptask->wt_aux);
+}
+
+/**
+ * @brief
+ *		Hand a large read-only status request to a forked child.
+ *
+ *		The child answers the request from its copy-on-write image of the
+ *		server, which is a consistent snapshot taken at fork time, while the
+ *		main process goes on with job starts and MoM updates.  Only requests
+ *		that walk all jobs or all nodes of a big complex are handed off, and
+ *		no more than STAT_CHILD_MAX children run at once.  Encrypted
+ *		connections stay in the main process as the cipher state moves with
+ *		every message.
+ *
+ * @param[in] conn - connection the request came in on
+ * @param[in] preq - the decoded request
+ *
+ * @return	int
+ * @retval	1	request handed to a child and freed
+ * @retval	0	process the request here
+ */
+static int
+stat_in_child(conn_t *conn, struct batch_request *preq)
+{
+	char *id = NULL;
+	int nobjs;
+	pid_t pid;
+
+	if (conn == NULL || preq->prot != PROT_TCP || stat_children >= STAT_CHILD_MAX)
+		return 0;
+
+	switch (preq->rq_type) {
+		case PBS_BATCH_StatusJob:
+			id = preq->rq_ind.rq_status.rq_id;
+			/* a list of job ids is cheap, whole queues and the server are not */
+			if (id != NULL && isdigit((int) *id))
+				return 0;
+			nobjs = server.sv_qs.sv_numjobs;
+			break;
+		case PBS_BATCH_SelectJobs:
+		case PBS_BATCH_SelStat:
+			nobjs = server.sv_qs.sv_numjobs;
+			break;
+		case PBS_BATCH_StatusNode:
+			id = preq->rq_ind.rq_status.rq_id;
+			if (id != NULL && *id != '\0')
+				return 0;
+			nobjs = svr_totnodes;
+			break;
+		default:
+			return 0;
+	}
+	if (nobjs < STAT_CHILD_MIN_OBJS)
+		return 0;
+	if (transport_chan_get_ctx_status(conn->cn_sock, FOR_ENCRYPT) == AUTH_STATUS_CTX_READY)
+		return 0;
+
+	pid = fork();
+	if (pid == -1) {
+		log_err(errno, __func__, "fork failed, serving status request in server");
+		return 0;
+	}
+
+	if (pid != 0) {
+		/* parent: the child owns the reply */
+		if (set_task(WORK_Deferred_Child, (long) pid, post_stat_child, NULL) == NULL)
+			log_err(errno, __func__, msg_err_malloc);
+		stat_children++;
+		log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_REQUEST, LOG_DEBUG, __func__,
+			"Type %d request on socket %d handed to child %d", preq->rq_type, conn->cn_sock, pid);
+		free_br(preq);
+		return 1;
+	}
+
+	/* child: reply from the snapshot and go away */
+	tpp_terminate();
+	daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
+	job_statcache_nofill();
+
+	switch (preq->rq_type) {
+		case PBS_BATCH_StatusJob:
+			req_stat_job(preq);
+			break;
+		case PBS_BATCH_StatusNode:
+			req_stat_node(preq);
+			break;
+		default:
+			req_selectjobs(preq);
+			break;
+	}
+	exit(0);
+}
 #endif	/* !PBS_MOM */
 
 /**
@@ -785,6 +909,11 @@ dispatch_request(int sfds, struct batch_request *request)
 		}
 	}
 
+#ifndef PBS_MOM
+	if (stat_in_child(conn, request))
+		return;
+#endif
+
 	switch (request->rq_type) {
 
 		case PBS_BATCH_QueueJob:
@@ -271,6 +271,60 @@ reply_send_status_part(struct batch_request *preq)
 	return rc;
 }
 
+/**
+ * @brief
+ * 		reply_send_status_stream - encode the status objects built so far
+ * 		for a request as a partial reply straight into the write buffer of
+ * 		the client connection and free them.
+ *
+ * @par
+ *		The buffer is only flushed once it holds STATUS_STREAM_FLUSH bytes,
+ *		so the reply goes out in large writes while the server never holds
+ *		more than a few status objects in memory.  Requests which did not
+ *		arrive over TCP are still sent in parts of MAX_JOBS_PER_REPLY.
+ *
+ * @param[in]	preq - batch_request which contains the reply for the request
+ *
+ * @return	error code
+ * @retval	PBSE_NONE	- success
+ * @retval	!PBSE_NONE	- failure, the connection has been closed
+ */
+int
+reply_send_status_stream(struct batch_request *preq)
+{
+	struct batch_reply *preply = &preq->rq_reply;
+	int sfds = preq->rq_conn;
+	int rc;
+
+	if (preq->prot != PROT_TCP) {
+		if (preply->brp_count >= MAX_JOBS_PER_REPLY)
+			return reply_send_status_part(preq);
+		return PBSE_NONE;
+	}
+	if (preply->brp_count == 0)
+		return PBSE_NONE;
+
+	if (dis_write_mark(sfds) >= STATUS_STREAM_FLUSH)
+		return reply_send_status_part(preq);
+
+	preply->brp_is_part = 1;
+	pbs_tcp_errno = 0;
+	DIS_tcp_funcs();
+	rc = encode_DIS_reply(sfds, preply);
+	reply_free(preply);
+	preply->brp_choice = BATCH_REPLY_CHOICE_Status;
+	CLEAR_HEAD(preply->brp_un.brp_status);
+	preply->brp_count = 0;
+	if (rc) {
+		sprintf(log_buffer, "DIS reply failure, %d, errno=%d", rc, pbs_tcp_errno);
+		log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_REQUEST, LOG_WARNING,
+			"reply_send_status_stream", log_buffer);
+		close_client(sfds);
+		return PBSE_SYSTEM;
+	}
+	return PBSE_NONE;
+}
+
 /**
  * @brief
  * 		Send a reply to a batch request, reply either goes to a
@@ -108,6 +108,7 @@ extern	void unset_license_linger(void);
 extern	void unset_job_history_enable(void);
 extern	void unset_job_history_duration(void);
 extern	void unset_max_job_sequence_id(void);
+extern	void unset_job_save_delay(void);
 extern	void force_qsub_daemons_update(void);
 extern  void unset_node_fail_requeue(void);
 extern pbs_sched *sched_alloc(char *sched_name);
@@ -1472,6 +1473,9 @@ mgr_server_unset(struct batch_request *preq, conn_t *conn)
 		} else if (strcasecmp(plist->al_name,
 			ATTR_max_job_sequence_id) == 0) {
 			unset_max_job_sequence_id();
+		} else if (strcasecmp(plist->al_name,
+			ATTR_job_save_delay) == 0) {
+			unset_job_save_delay();
 		} else if (strcasecmp(plist->al_name,
 			ATTR_max_concurrent_prov) == 0) {
 			max_concurrent_prov = PBS_MAX_CONCURRENT_PROV;
@@ -3544,28 +3548,37 @@ check_resource_set_on_jobs_or_resvs(struct batch_request *preq, resource_def *pr
 	int rlen;
 	attribute *pattr;
 	resource *presc;
+	int packed;
+	int busy;
 
 	/* Reject if resource is on a job and the type or flag are being modified */
 
 	for (pj = (job *)GET_NEXT(svr_alljobs); pj != NULL; pj = (job *)GET_NEXT(pj->ji_alljobs)) {
+		/* one history job unpacked at a time */
+		packed = pj->ji_packed != NULL;
+		if (packed && svr_histjob_unpack(pj) != 0)
+			continue;
+		busy = 0;
 		pattr = &pj->ji_wattr[JOB_ATR_resource];
 		presc = get_resource(pattr, prdef);
-		if ((presc != NULL) && (mod == 1)) {
-			reply_text(preq, PBSE_RESCBUSY, "Resource busy on job");
-			return 1;
-		}
+		if ((presc != NULL) && (mod == 1))
+			busy = 1;
 		pattr = &pj->ji_wattr[JOB_ATR_SchedSelect];
-		if (is_attr_set(pattr)) {
+		if (!busy && is_attr_set(pattr)) {
 			rmatch = strstr(pattr->at_val.at_str, prdef->rs_name);
 			if (rmatch != NULL) {
 				rlen = strlen(prdef->rs_name);
 				if (((mod == 1) && (*(rmatch+rlen) == '=')) &&
-				    ((rmatch == pattr->at_val.at_str) || *(rmatch-1) == ':')) {
-					reply_text(preq, PBSE_RESCBUSY, "Resource busy on job");
-					return 1;
-				}
+				    ((rmatch == pattr->at_val.at_str) || *(rmatch-1) == ':'))
+					busy = 1;
 			}
 		}
+		if (packed)
+			(void)svr_histjob_pack(pj);
+		if (busy) {
+			reply_text(preq, PBSE_RESCBUSY, "Resource busy on job");
+			return 1;
+		}
 	}
 
 	/* Reject if resource is on a job and the type or flag are being modified */
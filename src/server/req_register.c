@@ -58,6 +58,9 @@
  * 	register_dep()
  * 	unregister_dep()
  * 	find_dependjob()
+ * 	depend_idx_build()
+ * 	depend_idx_add()
+ * 	depend_idx_drop()
  * 	make_dependjob()
  * 	send_depend_req()
  * 	decode_depend()
@@ -98,6 +101,7 @@
 #include "pbs_nodes.h"
 #include "svrfunc.h"
 #include "net_connect.h"
+#include "pbs_idx.h"
 
 
 
@@ -117,6 +121,9 @@ static int    build_depend(attribute *, char *);
 static void   clear_depend(struct depend *, int type, int exists);
 static void   del_depend(struct depend *);
 static void update_depend(job *, char *, char *, int, int);
+static void depend_idx_build(struct depend *);
+static void depend_idx_add(struct depend *, struct depend_job *);
+static void depend_idx_drop(struct depend *);
 
 /* External Global Data Items */
 
@@ -139,6 +146,9 @@ extern char  log_buffer[];
 
 #define DEPEND_ADD	1
 #define DEPEND_REMOVE	2
+
+/* a dependency set gets an index of its jobs once a lookup walks this many */
+#define DEPEND_IDX_MIN	16
 /**
  * @brief
  * 		post_run_depend - this function is called via a work task when a
@@ -1322,20 +1332,93 @@ unregister_dep(attribute *pattr, struct batch_request *preq)
 struct depend_job *find_dependjob(struct depend *pdep, char *name)
 {
 	struct depend_job *pdj;
+	void *pkey;
+	int walked = 0;
 
 	if ((pdep == NULL) || (name == NULL))
 		return NULL;
 
+	if (pdep->dp_idx != NULL) {
+		pkey = name;
+		if (pbs_idx_find(pdep->dp_idx, &pkey, (void **)&pdj, NULL) != PBS_IDX_RET_OK)
+			return NULL;
+		return (pdj);
+	}
+
 	pdj = (struct depend_job *)GET_NEXT(pdep->dp_jobs);
 	while (pdj) {
 		if (!strcmp(name, pdj->dc_child))
 			break;
 
+		walked++;
 		pdj = (struct depend_job *)GET_NEXT(pdj->dc_link);
 	}
+	if (walked >= DEPEND_IDX_MIN)
+		depend_idx_build(pdep);
 	return (pdj);
 }
 
+/**
+ * @brief
+ * 		depend_idx_build - index the jobs of a dependency set by job id, so
+ *		that registering or releasing one of many jobs depending on the
+ *		same job does not walk the whole list.
+ *
+ * @par
+ *		A job named twice in the set is indexed at its first entry, the
+ *		one a walk of the list would find.
+ *
+ * @param[in,out]	pdep	-	dependency set
+ */
+static void
+depend_idx_build(struct depend *pdep)
+{
+	struct depend_job *pdj;
+
+	if ((pdep->dp_idx = pbs_idx_create(0, 0)) == NULL)
+		return;
+	pdep->dp_idxdups = 0;
+	for (pdj = (struct depend_job *)GET_NEXT(pdep->dp_jobs); pdj && pdep->dp_idx;
+		pdj = (struct depend_job *)GET_NEXT(pdj->dc_link))
+		depend_idx_add(pdep, pdj);
+}
+
+/**
+ * @brief
+ * 		depend_idx_add - index a job appended to a dependency set, unless
+ *		the set already names it, and drop the index if it cannot grow.
+ *
+ * @param[in,out]	pdep	-	dependency set with an index
+ * @param[in]	pdj	-	job appended to the set
+ */
+static void
+depend_idx_add(struct depend *pdep, struct depend_job *pdj)
+{
+	void *pkey = pdj->dc_child;
+	void *pdata;
+
+	if (pbs_idx_find(pdep->dp_idx, &pkey, &pdata, NULL) == PBS_IDX_RET_OK)
+		pdep->dp_idxdups++;
+	else if (pbs_idx_insert(pdep->dp_idx, pdj->dc_child, pdj) != PBS_IDX_RET_OK)
+		depend_idx_drop(pdep);
+}
+
+/**
+ * @brief
+ * 		depend_idx_drop - discard the job index of a dependency set
+ *
+ * @param[in,out]	pdep	-	dependency set
+ */
+static void
+depend_idx_drop(struct depend *pdep)
+{
+	if (pdep->dp_idx != NULL) {
+		pbs_idx_destroy(pdep->dp_idx);
+		pdep->dp_idx = NULL;
+	}
+	pdep->dp_idxdups = 0;
+}
+
 /**
  * @brief
  * 		make_dependjob - add a depend_job structure
@@ -1359,7 +1442,10 @@ static struct depend_job *make_dependjob(struct depend *pdep, char *jobid, char
 		pdj->dc_cost    = 0;
 		(void)strcpy(pdj->dc_child, jobid);
 		(void)strcpy(pdj->dc_svr, host);
+		pdj->dc_depend = pdep;
 		append_link(&pdep->dp_jobs, &pdj->dc_link, pdj);
+		if (pdep->dp_idx != NULL)
+			depend_idx_add(pdep, pdj);
 	}
 	return (pdj);
 }
@@ -1772,6 +1858,7 @@ free_depend(struct attribute *attr)
 			delete_link(&pdjb->dc_link);
 			(void)free(pdjb);
 		}
+		depend_idx_drop(pdp);
 		delete_link(&pdp->dp_link);
 		(void)free(pdp);
 	}
@@ -1923,7 +2010,10 @@ build_depend(attribute *pattr, char *value)
 					}
 				}
 
+				pdjb->dc_depend = pd;
 				append_link(&pd->dp_jobs, &pdjb->dc_link, pdjb);
+				if (pd->dp_idx != NULL)
+					depend_idx_add(pd, pdjb);
 			} else {
 				return (PBSE_SYSTEM);
 			}
@@ -1959,6 +2049,8 @@ clear_depend(struct depend *pd, int type, int exist)
 	} else {
 		CLEAR_HEAD(pd->dp_jobs);
 		CLEAR_LINK(pd->dp_link);
+		pd->dp_idx = NULL;
+		pd->dp_idxdups = 0;
 	}
 	pd->dp_type = type;
 	pd->dp_numexp = 0;
@@ -1979,6 +2071,7 @@ del_depend(struct depend *pd)
 {
 	struct depend_job *pdj;
 
+	depend_idx_drop(pd);
 	while ((pdj = (struct depend_job *)GET_NEXT(pd->dp_jobs)) != NULL) {
 		del_depend_job(pdj);
 	}
@@ -1996,6 +2089,30 @@ del_depend(struct depend *pd)
 static void
 del_depend_job(struct depend_job *pdj)
 {
+	struct depend *pdep = pdj->dc_depend;
+	struct depend_job *pnext;
+	void *pkey = pdj->dc_child;
+	void *pdata;
+
+	if ((pdep->dp_idx != NULL) &&
+		(pbs_idx_find(pdep->dp_idx, &pkey, &pdata, NULL) == PBS_IDX_RET_OK)) {
+		if (pdata != pdj) {
+			pdep->dp_idxdups--;	/* a repeat, not indexed */
+		} else {
+			(void)pbs_idx_delete(pdep->dp_idx, pdj->dc_child);
+			/* index the next entry naming the same job, if any */
+			pnext = (struct depend_job *)GET_NEXT(pdj->dc_link);
+			while ((pdep->dp_idxdups > 0) && pnext) {
+				if (strcmp(pnext->dc_child, pdj->dc_child) == 0) {
+					pdep->dp_idxdups--;
+					if (pbs_idx_insert(pdep->dp_idx, pnext->dc_child, pnext) != PBS_IDX_RET_OK)
+						depend_idx_drop(pdep);
+					break;
+				}
+				pnext = (struct depend_job *)GET_NEXT(pnext->dc_link);
+			}
+		}
+	}
 	delete_link(&pdj->dc_link);
 	(void)free(pdj);
 }
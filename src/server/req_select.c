@@ -318,6 +318,7 @@ req_selectjobs(struct batch_request *preq)
 	int dosubjobs = 0;
 	int dohistjobs = 0;
 	char *pstate = NULL;
+	int packed;
 	int rc;
 	struct select_list *selistp;
 	pbs_sched *psched;
@@ -386,7 +387,11 @@ req_selectjobs(struct batch_request *preq)
 	else
 		pjob = (job *) GET_NEXT(svr_alljobs);
 	while (pjob) {
-		if (server.sv_attr[SVR_ATR_query_others].at_val.at_long || svr_authorize_jobreq(preq, pjob) == 0) {
+		/* a history job is selected on its values, packed again after */
+		packed = dohistjobs && pjob->ji_packed != NULL;
+		if (packed && svr_histjob_unpack(pjob) != 0)
+			packed = 0;
+		else if (server.sv_attr[SVR_ATR_query_others].at_val.at_long || svr_authorize_jobreq(preq, pjob) == 0) {
 
 			/*
 			 * either job owner or has special permission to see job
@@ -434,6 +439,8 @@ req_selectjobs(struct batch_request *preq)
 				}
 			}
 		}
+		if (packed)
+			(void)svr_histjob_pack(pjob);
 		if (pque)
 			pjob = (job *) GET_NEXT(pjob->ji_jobque);
 		else
@@ -164,11 +164,9 @@ do_stat_of_a_job(struct batch_request *preq, job *pjob, int dohistjobs, int dosu
 		rc = status_job(pjob, preq, pal, &preply->brp_un.brp_status, &bad);
 		if (dosubjobs && (pjob->ji_qs.ji_svrflags & JOB_SVFLG_ArrayJob) && (rc == PBSE_NONE || rc != PBSE_PERM) && pjob->ji_ajtrk != NULL) {
 			for (indx = 0; indx < pjob->ji_ajtrk->tkm_ct; ++indx) {
-				if (preply->brp_count >= MAX_JOBS_PER_REPLY) {
-					rc = reply_send_status_part(preq);
-					if (rc != PBSE_NONE)
-						return rc;
-				}
+				rc = reply_send_status_stream(preq);
+				if (rc != PBSE_NONE)
+					return rc;
 				rc = status_subjob(pjob, preq, pal, indx, &preply->brp_un.brp_status, &bad);
 				if (rc && rc != PBSE_PERM)
 					break;
@@ -256,11 +254,9 @@ stat_a_jobidname(struct batch_request *preq, char *name, int dohistjobs, int dos
 				int idx = numindex_to_offset(pjob, i);
 				if (idx == -1)
 					continue;
-				if (preply->brp_count >= MAX_JOBS_PER_REPLY) {
-					rc = reply_send_status_part(preq);
-					if (rc != PBSE_NONE)
-						return rc;
-				}
+				rc = reply_send_status_stream(preq);
+				if (rc != PBSE_NONE)
+					return rc;
 				rc = status_subjob(pjob, preq, pal, idx, &preply->brp_un.brp_status, &bad);
 				if (rc && rc != PBSE_PERM)
 					return rc;
@@ -390,8 +386,9 @@ req_stat_job(struct batch_request *preq)
 				return;
 			}
 			pjob = (job *) GET_NEXT(type == 2 ? pjob->ji_jobque : pjob->ji_alljobs);
-			if (preply->brp_count >= MAX_JOBS_PER_REPLY && pjob) {
-				rc = reply_send_status_part(preq);
+			if (pjob) {
+				/* hand each job to the connection as soon as it is built */
+				rc = reply_send_status_stream(preq);
 				if (rc != PBSE_NONE)
 					return;
 			}
@@ -512,7 +509,7 @@ status_que(pbs_queue *pque, struct batch_request *preq, pbs_list_head *pstathd)
 
 	/* allocate status sub-structure and fill in header portion */
 
-	pstat = (struct brp_status *)malloc(sizeof(struct brp_status));
+	pstat = (struct brp_status *)calloc(1, sizeof(struct brp_status));
 	if (pstat == NULL)
 		return (PBSE_SYSTEM);
 	pstat->brp_objtype = MGR_OBJ_QUEUE;
@@ -599,6 +596,8 @@ req_stat_node(struct batch_request *preq)
 				&preply->brp_un.brp_status);
 			if (rc)
 				break;
+			if (i + 1 < svr_totnodes && (rc = reply_send_status_stream(preq)) != PBSE_NONE)
+				return;
 		}
 	}
 
@@ -665,7 +664,7 @@ status_node(struct pbsnode *pnode, struct batch_request *preq, pbs_list_head *ps
 
 	/*allocate status sub-structure and fill in header portion*/
 
-	pstat = (struct brp_status *)malloc(sizeof(struct brp_status));
+	pstat = (struct brp_status *)calloc(1, sizeof(struct brp_status));
 	if (pstat == NULL)
 		return (PBSE_SYSTEM);
 
@@ -773,7 +772,7 @@ req_stat_svr(struct batch_request *preq)
 	CLEAR_HEAD(preply->brp_un.brp_status);
 	preply->brp_count = 0;
 
-	pstat = (struct brp_status *)malloc(sizeof(struct brp_status));
+	pstat = (struct brp_status *)calloc(1, sizeof(struct brp_status));
 	if (pstat == NULL) {
 		reply_free(preply);
 		req_reject(PBSE_SYSTEM, 0, preq);
@@ -816,7 +815,7 @@ status_sched(pbs_sched *psched, struct batch_request *preq, pbs_list_head *pstat
 	struct brp_status *pstat;
 	svrattrl	  *pal;
 
-	pstat = (struct brp_status *)malloc(sizeof(struct brp_status));
+	pstat = (struct brp_status *)calloc(1, sizeof(struct brp_status));
 	if (pstat == NULL)
 		return (PBSE_SYSTEM);
 
@@ -1038,7 +1037,7 @@ status_resv(resc_resv *presv, struct batch_request *preq, pbs_list_head *pstathd
 
 	/*now allocate status sub-structure and fill header portion*/
 
-	pstat = (struct brp_status *)malloc(sizeof(struct brp_status));
+	pstat = (struct brp_status *)calloc(1, sizeof(struct brp_status));
 	if (pstat == NULL)
 		return (PBSE_SYSTEM);
 
@@ -1092,7 +1091,7 @@ status_resc(struct resource_def *prd, struct batch_request *preq, pbs_list_head
 
 	/* allocate status sub-structure and fill in header portion */
 
-	pstat = (struct brp_status *)malloc(sizeof(struct brp_status));
+	pstat = (struct brp_status *)calloc(1, sizeof(struct brp_status));
 	if (pstat == NULL)
 		return (PBSE_SYSTEM);
 	pstat->brp_objtype = MGR_OBJ_RSC;
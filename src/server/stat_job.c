@@ -71,6 +71,7 @@
 #include "pbs_nodes.h"
 #include "svrfunc.h"
 #include "pbs_ifl.h"
+#include "dis.h"
 
 
 /* Global Data Items: */
@@ -81,6 +82,178 @@ extern struct server server;
 extern char	     statechars[];
 extern time_t time_now;
 
+#define STAT_CACHE_SLOTS	2		/* privilege levels cached per job */
+#define STAT_CACHE_HIDDEN	0x10000000	/* key: hidden attributes shown */
+#define STAT_CACHE_ELIGIBLE	0x20000000	/* key: eligible time enabled */
+#define STAT_CACHE_BINARY	0x40000000	/* key: binary wire encoding */
+#define STAT_CACHE_STALE	-1		/* key: out of date, never matched */
+
+/*
+ * History jobs no longer change and are served from their encoded status
+ * record, so svrcached() does not keep the svrattrl of each of their
+ * attributes, see svr_compact_histjob().
+ */
+static int svrcache_retain = 1;
+
+/*
+ * Status records are only filled in the main server process.  A forked
+ * status child (see stat_in_child()) uses those already there, but a record
+ * it filled would be gone with it when it exits.
+ */
+static int statcache_fill = 1;
+
+/**
+ * @brief
+ * 		job_statcache_free - drop the encoded status records of a job.
+ *
+ * @param[in,out]	pjob	-	job whose records are dropped
+ */
+void
+job_statcache_free(job *pjob)
+{
+	int i;
+
+	if (pjob->ji_statcache == NULL)
+		return;
+	for (i = 0; i < STAT_CACHE_SLOTS; i++)
+		free(pjob->ji_statcache[i].bc_data);
+	free(pjob->ji_statcache);
+	pjob->ji_statcache = NULL;
+}
+
+/**
+ * @brief
+ * 		job_statcache_nofill - stop filling status records, called in a
+ *		forked status child.
+ */
+void
+job_statcache_nofill(void)
+{
+	statcache_fill = 0;
+}
+
+/**
+ * @brief
+ * 		job_statcache_check - mark the encoded status records of a job as
+ *		stale if any attribute visible at the given privilege has been
+ *		modified.
+ *
+ * @par
+ *		Must be called before status_attrib() walks the job, as svrcached()
+ *		clears ATR_VFLAG_MODCACHE which is what tells a record is stale.
+ *		Any change marks the records of every privilege level, since the
+ *		flag is cleared by whichever level looks first.
+ *
+ * @par
+ *		The records are not freed here: a reply still being built may point
+ *		at one, e.g. the array parent of the subjobs status_subjob() walks
+ *		next.  A stale slot is reused by job_statcache_slot().
+ *
+ * @param[in,out]	pjob	-	job to check
+ * @param[in]	priv	-	user-client privilege
+ */
+static void
+job_statcache_check(job *pjob, int priv)
+{
+	long hidden = server.sv_attr[(int)SVR_ATR_show_hidden_attribs].at_val.at_long;
+	long elig = server.sv_attr[(int)SVR_ATR_EligibleTimeEnable].at_val.at_long;
+	int i;
+
+	if (pjob->ji_statcache == NULL)
+		return;
+	priv &= (ATR_DFLAG_RDACC | ATR_DFLAG_SvWR);
+	for (i = 0; i < (int)JOB_ATR_LAST; i++) {
+		if ((job_attr_def[i].at_flags & priv) == 0)
+			continue;
+		if ((job_attr_def[i].at_flags & ATR_DFLAG_HIDDEN) && hidden == 0)
+			continue;
+		/* not shown when eligible time is off, status_job() flags them anyway */
+		if (elig == 0 && (i == (int)JOB_ATR_eligible_time || i == (int)JOB_ATR_accrue_type))
+			continue;
+		if (pjob->ji_wattr[i].at_flags & ATR_VFLAG_MODCACHE) {
+			for (i = 0; i < STAT_CACHE_SLOTS; i++)
+				pjob->ji_statcache[i].bc_key = STAT_CACHE_STALE;
+			return;
+		}
+	}
+}
+
+/**
+ * @brief
+ * 		job_statcache_slot - find the encoded status record of a job for
+ *		this request, or a free slot for the reply to fill in.
+ *
+ * @par
+ *		Only the default attribute set over a tcp connection is cached.
+ *		Jobs whose status is computed on the fly (accruing eligible time,
+ *		suspended) are never cached.  The record is keyed on the client
+ *		privilege, the server settings that change what is shown and the
+ *		wire encoding of the connection.
+ *
+ * @param[in,out]	pjob	-	job to status
+ * @param[in]	preq	-	status request
+ * @param[in]	pal	-	specific attributes to status
+ *
+ * @return	struct brp_cache *
+ * @retval	slot to use, bc_data is NULL if it is still to be filled
+ * @retval	NULL	if the status of this job must be built afresh
+ */
+static struct brp_cache *
+job_statcache_slot(job *pjob, struct batch_request *preq, svrattrl *pal)
+{
+	struct brp_cache *pcache;
+	int key;
+	int i;
+
+	job_statcache_check(pjob, preq->rq_perm);
+
+	if (pal != NULL || preq->prot != PROT_TCP || preq->rq_conn < 0)
+		return NULL;
+	if (server.sv_attr[(int)SVR_ATR_EligibleTimeEnable].at_val.at_long &&
+		get_jattr_long(pjob, JOB_ATR_accrue_type) == JOB_ELIGIBLE)
+		return NULL;
+	if (check_job_state(pjob, JOB_STATE_LTR_RUNNING) &&
+		(pjob->ji_qs.ji_svrflags & (JOB_SVFLG_Suspend | JOB_SVFLG_Actsuspd)))
+		return NULL;
+
+	key = preq->rq_perm & (ATR_DFLAG_RDACC | ATR_DFLAG_SvWR);
+	if (server.sv_attr[(int)SVR_ATR_show_hidden_attribs].at_val.at_long)
+		key |= STAT_CACHE_HIDDEN;
+	if (server.sv_attr[(int)SVR_ATR_EligibleTimeEnable].at_val.at_long)
+		key |= STAT_CACHE_ELIGIBLE;
+	if (transport_chan_is_binary(preq->rq_conn))
+		key |= STAT_CACHE_BINARY;
+
+	if (pjob->ji_statcache == NULL) {
+		if (!statcache_fill)
+			return NULL;
+		pjob->ji_statcache = calloc(STAT_CACHE_SLOTS, sizeof(struct brp_cache));
+		if (pjob->ji_statcache == NULL)
+			return NULL;
+	}
+	for (i = 0; i < STAT_CACHE_SLOTS; i++) {
+		pcache = &pjob->ji_statcache[i];
+		if (pcache->bc_data != NULL && pcache->bc_key == key)
+			return pcache;
+	}
+
+	if (!statcache_fill)
+		return NULL;
+
+	/* take an empty or stale slot, or else the last one */
+	for (i = 0; i < STAT_CACHE_SLOTS - 1; i++) {
+		if (pjob->ji_statcache[i].bc_data == NULL ||
+			pjob->ji_statcache[i].bc_key == STAT_CACHE_STALE)
+			break;
+	}
+	pcache = &pjob->ji_statcache[i];
+	free(pcache->bc_data);
+	pcache->bc_data = NULL;
+	pcache->bc_len = 0;
+	pcache->bc_key = key;
+	return pcache;
+}
+
 /**
  * @brief
  * 		svrcached - either link in (to phead) a cached svrattrl struct which is
@@ -129,17 +302,20 @@ svrcached(attribute *pat, pbs_list_head *phead, attribute_def *pdef)
 			/* encode and cache new svrattrl structure */
 			(void)pdef->at_encode(pat, phead, pdef->at_name,
 				NULL, ATR_ENCODE_CLIENT, &working);
-			if (resc_access_perm & PRIV_READ)
+			if (!svrcache_retain)
+				working = NULL;	/* the reply owns it */
+			else if (resc_access_perm & PRIV_READ)
 				pat->at_priv_encoded = working;
 			else
 				pat->at_user_encoded = working;
 
-			pat->at_flags &= ~ATR_VFLAG_MODCACHE;
 			while (working) {
 				working->al_refct++;	/* incr ref count */
 				working = working->al_sister;
 			}
 		}
+		/* an unset attribute has nothing to cache, it is up to date too */
+		pat->at_flags &= ~ATR_VFLAG_MODCACHE;
 	} else {
 		/* can use the existing cached svrattrl struture */
 
@@ -249,10 +425,13 @@ int
 status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *pstathd, int *bad)
 {
 	struct brp_status *pstat;
+	struct brp_cache *pcache;
 	long oldtime = 0;
 	int old_elig_flags = 0;
 	int old_atyp_flags = 0;
 	int revert_state_r = 0;
+	int packed;
+	int rc;
 
 	/* see if the client is authorized to status this job */
 
@@ -266,6 +445,28 @@ status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *
 		update_array_indices_remaining_attr(pjob);
 	}
 
+	pcache = job_statcache_slot(pjob, preq, pal);
+	if (pcache != NULL && pcache->bc_data != NULL) {
+		/* unchanged since the last reply, send the encoded record */
+		pstat = (struct brp_status *)calloc(1, sizeof(struct brp_status));
+		if (pstat == NULL)
+			return (PBSE_SYSTEM);
+		CLEAR_LINK(pstat->brp_stlink);
+		pstat->brp_objtype = MGR_OBJ_JOB;
+		(void)strcpy(pstat->brp_objname, pjob->ji_qs.ji_jobid);
+		CLEAR_HEAD(pstat->brp_attr);
+		pstat->brp_cache = pcache;
+		append_link(pstathd, &pstat->brp_stlink, pstat);
+		preq->rq_reply.brp_count++;
+		*bad = 0;
+		return (0);
+	}
+
+	/* a history job is unpacked only to build its status record */
+	packed = pjob->ji_packed != NULL;
+	if (svr_histjob_unpack(pjob) != 0)
+		return (PBSE_SYSTEM);
+
 	/* calc eligible time on the fly and return, don't save. */
 	if (server.sv_attr[SVR_ATR_EligibleTimeEnable].at_val.at_long == TRUE) {
 		if (get_jattr_long(pjob, JOB_ATR_accrue_type) == JOB_ELIGIBLE) {
@@ -293,13 +494,14 @@ status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *
 
 	/* allocate reply structure and fill in header portion */
 
-	pstat = (struct brp_status *)malloc(sizeof(struct brp_status));
+	pstat = (struct brp_status *)calloc(1, sizeof(struct brp_status));
 	if (pstat == NULL)
 		return (PBSE_SYSTEM);
 	CLEAR_LINK(pstat->brp_stlink);
 	pstat->brp_objtype = MGR_OBJ_JOB;
 	(void)strcpy(pstat->brp_objname, pjob->ji_qs.ji_jobid);
 	CLEAR_HEAD(pstat->brp_attr);
+	pstat->brp_cache = pcache;	/* filled in when the reply is encoded */
 	append_link(pstathd, &pstat->brp_stlink, pstat);
 	preq->rq_reply.brp_count++;
 
@@ -317,8 +519,16 @@ status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *
 	/* add attributes to the status reply */
 
 	*bad = 0;
-	if (status_attrib(pal, job_attr_idx, job_attr_def, pjob->ji_wattr, JOB_ATR_LAST, preq->rq_perm, &pstat->brp_attr, bad))
+	svrcache_retain = !(check_job_state(pjob, JOB_STATE_LTR_FINISHED) ||
+		check_job_state(pjob, JOB_STATE_LTR_EXPIRED) ||
+		check_job_state(pjob, JOB_STATE_LTR_MOVED));
+	rc = status_attrib(pal, job_attr_idx, job_attr_def, pjob->ji_wattr, JOB_ATR_LAST, preq->rq_perm, &pstat->brp_attr, bad);
+	svrcache_retain = 1;
+	if (rc) {
+		if (packed)
+			(void)svr_histjob_pack(pjob);
 		return (PBSE_NOATTR);
+	}
 
 	/* reset eligible time, it was calctd on the fly, real calctn only when accrue_type changes */
 
@@ -339,6 +549,9 @@ status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *
 	if (revert_state_r)
 		set_job_state(pjob, JOB_STATE_LTR_RUNNING);
 
+	if (packed)
+		(void)svr_histjob_pack(pjob);
+
 	return (0);
 }
 
@@ -398,7 +611,7 @@ status_subjob(job *pjob, struct batch_request *preq, svrattrl *pal, int subj, pb
 	/* array related attrbutes as they belong only to the Array    */
 	if (pal == NULL)
 		limit = JOB_ATR_array;
-	pstat = (struct brp_status *)malloc(sizeof(struct brp_status));
+	pstat = (struct brp_status *)calloc(1, sizeof(struct brp_status));
 	if (pstat == NULL)
 		return (PBSE_SYSTEM);
 	CLEAR_LINK(pstat->brp_stlink);
@@ -466,6 +679,7 @@ status_subjob(job *pjob, struct batch_request *preq, svrattrl *pal, int subj, pb
 		/* 	 not correctly check ATR_VFLAG_SET */
 	}
 
+	job_statcache_check(pjob, preq->rq_perm);
 	if (status_attrib(pal, job_attr_idx, job_attr_def, pjob->ji_wattr, limit, preq->rq_perm, &pstat->brp_attr, bad))
 		rc =  PBSE_NOATTR;
 
@@ -91,6 +91,7 @@
 #include "pbs_license.h"
 #include "pbs_reliable.h"
 #include <sys/wait.h>
+#include <zlib.h>
 
 #define MIN_WALLTIME_LIMIT 0
 #define MAX_WALLTIME_LIMIT 1
@@ -1557,7 +1558,7 @@ job_set_wait(attribute *pattr, void *pjob, int mode)
 			if ((ptask->wt_event == WORK_Timed) &&
 				(ptask->wt_func == job_wait_over) &&
 				(ptask->wt_parm1 == pjob)) {
-				ptask->wt_event = when;
+				set_task_time(ptask, when);
 				return (0);
 			}
 			ptask = (struct work_task *)GET_NEXT(ptask->wt_linkobj);
@@ -4710,7 +4711,8 @@ svr_clean_job_history(struct work_task *pwt)
 			if (time_now >= (get_jattr_long(pjob,  JOB_ATR_history_timestamp) + svr_history_duration)) {
 				job_purge(pjob);
 				pjob = NULL;
-			}
+			} else
+				(void)svr_histjob_pack(pjob); /* saved since, or left unpacked */
 		}
 		/* restore the saved next in pjob */
 		pjob = nxpjob;
@@ -4905,6 +4907,362 @@ update_job_finish_comment(job *pjob, int newsubstate, char *user)
 	}
 }
 
+extern char *msg_err_malloc;
+
+/*
+ * Layout of the attributes of a history job packed by svr_histjob_pack(),
+ * before it is compressed: for each packed attribute its index, flags and
+ * number of values as ints, then for each value the name, resource and
+ * value strings, NUL terminated, an empty resource standing for none.
+ * An index of -1 ends the list.  The compressed data is preceded by the
+ * lengths of the uncompressed layout and of the compressed data.
+ */
+#define HISTJOB_PACK_HDR	(2 * sizeof(size_t))
+
+/**
+ * @brief
+ *		svr_histjob_packable - tell whether an attribute of a history job
+ *		is packed by svr_histjob_pack().
+ *
+ * @par
+ *		Values held outside the attribute structure are packed.  The owner
+ *		and the effective user and group stay out, as the authorization
+ *		of requests on all jobs looks at them before anything else.
+ *
+ * @param[in]	pjob	-	history job
+ * @param[in]	i	-	attribute index
+ *
+ * @return	int
+ * @retval	1	pack it
+ * @retval	0	leave it as it is
+ */
+static int
+svr_histjob_packable(job *pjob, int i)
+{
+	switch (job_attr_def[i].at_type) {
+		case ATR_TYPE_STR:
+		case ATR_TYPE_ARST:
+		case ATR_TYPE_RESC:
+		case ATR_TYPE_LIST:
+		case ATR_TYPE_ACL:
+		case ATR_TYPE_ENTITY:
+			break;
+		default:
+			return 0;
+	}
+	if (i == (int)JOB_ATR_job_owner || i == (int)JOB_ATR_euser || i == (int)JOB_ATR_egroup)
+		return 0;
+	/*
+	 * job_to_db() saves only the modified values, so changes not saved yet
+	 * stay out until svr_clean_job_history() packs the job after the save
+	 */
+	if ((pjob->ji_wattr[i].at_flags & ATR_VFLAG_MODIFY) || !is_jattr_set(pjob, i))
+		return 0;
+	return 1;
+}
+
+/**
+ * @brief
+ *		svr_histjob_pack - pack the attribute values of a history job into
+ *		a single compressed buffer and free them.
+ *
+ * @par
+ *		A history job no longer changes, and apart from being statused its
+ *		values are only looked at through find_job() and on purge, which
+ *		unpack it again, see svr_histjob_unpack().  Status requests mostly
+ *		go to the encoded status record of the job and unpack it only to
+ *		build that record.  Array jobs and subjobs are left alone, as the
+ *		status of a subjob is built from its parent.
+ *
+ * @param[in,out]	pjob	-	history job
+ *
+ * @return	int
+ * @retval	0	packed, or nothing to pack
+ * @retval	-1	out of memory, the job is left as it was
+ */
+int
+svr_histjob_pack(job *pjob)
+{
+	pbs_list_head lhead[JOB_ATR_LAST];
+	int nvals[JOB_ATR_LAST];
+	svrattrl *pal;
+	char *raw;
+	char *p;
+	char *packed;
+	size_t rawlen = sizeof(int);
+	size_t len;
+	uLongf cmprlen;
+	int i;
+	int n;
+	int npacked = 0;
+
+	if (pjob->ji_packed != NULL ||
+		(pjob->ji_qs.ji_svrflags & (JOB_SVFLG_ArrayJob | JOB_SVFLG_SubJob)))
+		return 0;
+
+	for (i = 0; i < (int)JOB_ATR_LAST; i++) {
+		CLEAR_HEAD(lhead[i]);
+		nvals[i] = 0;
+		if (!svr_histjob_packable(pjob, i))
+			continue;
+		n = job_attr_def[i].at_encode(&pjob->ji_wattr[i], &lhead[i],
+			job_attr_def[i].at_name, NULL, ATR_ENCODE_DB, NULL);
+		if (n <= 0) {
+			free_attrlist(&lhead[i]);
+			continue;
+		}
+		nvals[i] = n;
+		npacked++;
+		rawlen += 3 * sizeof(int);
+		for (pal = (svrattrl *)GET_NEXT(lhead[i]); pal; pal = (svrattrl *)GET_NEXT(pal->al_link)) {
+			rawlen += strlen(pal->al_name) + 1;
+			rawlen += (pal->al_resc ? strlen(pal->al_resc) : 0) + 1;
+			rawlen += (pal->al_value ? strlen(pal->al_value) : 0) + 1;
+		}
+	}
+	if (npacked == 0)
+		return 0;
+
+	raw = malloc(rawlen);
+	cmprlen = compressBound(rawlen);
+	packed = malloc(HISTJOB_PACK_HDR + cmprlen);
+	if (raw == NULL || packed == NULL) {
+		log_err(errno, __func__, msg_err_malloc);
+		goto err;
+	}
+
+	p = raw;
+	for (i = 0; i < (int)JOB_ATR_LAST; i++) {
+		if (nvals[i] == 0)
+			continue;
+		memcpy(p, &i, sizeof(int));
+		n = pjob->ji_wattr[i].at_flags;
+		memcpy(p + sizeof(int), &n, sizeof(int));
+		memcpy(p + 2 * sizeof(int), &nvals[i], sizeof(int));
+		p += 3 * sizeof(int);
+		for (pal = (svrattrl *)GET_NEXT(lhead[i]); pal; pal = (svrattrl *)GET_NEXT(pal->al_link)) {
+			p += sprintf(p, "%s", pal->al_name) + 1;
+			p += sprintf(p, "%s", pal->al_resc ? pal->al_resc : "") + 1;
+			p += sprintf(p, "%s", pal->al_value ? pal->al_value : "") + 1;
+		}
+	}
+	n = -1;
+	memcpy(p, &n, sizeof(int));
+
+	if (compress2((Bytef *)packed + HISTJOB_PACK_HDR, &cmprlen, (Bytef *)raw, rawlen, Z_BEST_SPEED) != Z_OK) {
+		log_err(-1, __func__, "compression of job attributes failed");
+		goto err;
+	}
+	free(raw);
+	memcpy(packed, &rawlen, sizeof(size_t));
+	len = cmprlen;
+	memcpy(packed + sizeof(size_t), &len, sizeof(size_t));
+	if ((p = realloc(packed, HISTJOB_PACK_HDR + cmprlen)) != NULL)
+		packed = p;
+
+	for (i = 0; i < (int)JOB_ATR_LAST; i++) {
+		if (nvals[i] == 0)
+			continue;
+		free_attrlist(&lhead[i]);
+		n = pjob->ji_wattr[i].at_flags;
+		free_svrcache(&pjob->ji_wattr[i]);
+		free_jattr(pjob, i);
+		/* a change not yet in the status record must still be seen, see stat_job.c */
+		pjob->ji_wattr[i].at_flags = n & ATR_VFLAG_MODCACHE;
+	}
+	pjob->ji_packed = packed;
+	return 0;
+
+err:
+	for (i = 0; i < (int)JOB_ATR_LAST; i++)
+		free_attrlist(&lhead[i]);
+	free(raw);
+	free(packed);
+	return -1;
+}
+
+/**
+ * @brief
+ *		svr_histjob_unpack - restore the attribute values of a history job
+ *		packed by svr_histjob_pack().
+ *
+ * @param[in,out]	pjob	-	history job
+ *
+ * @return	int
+ * @retval	0	unpacked, or not packed
+ * @retval	-1	out of memory or corrupt data, the job stays packed
+ */
+int
+svr_histjob_unpack(job *pjob)
+{
+	attribute_def *pdef;
+	attribute *pattr;
+	attribute tmpa;
+	size_t rawlen;
+	size_t cmprlen;
+	uLongf len;
+	char *raw;
+	char *p;
+	char *name;
+	char *resc;
+	char *val;
+	int i;
+	int flags;
+	int nvals;
+	int k;
+	int skip;
+
+	if (pjob->ji_packed == NULL)
+		return 0;
+
+	memcpy(&rawlen, pjob->ji_packed, sizeof(size_t));
+	memcpy(&cmprlen, pjob->ji_packed + sizeof(size_t), sizeof(size_t));
+	if ((raw = malloc(rawlen)) == NULL) {
+		log_err(errno, __func__, msg_err_malloc);
+		return -1;
+	}
+	len = rawlen;
+	if (uncompress((Bytef *)raw, &len, (Bytef *)pjob->ji_packed + HISTJOB_PACK_HDR, cmprlen) != Z_OK ||
+		len != rawlen) {
+		log_joberr(-1, __func__, "corrupt packed attributes", pjob->ji_qs.ji_jobid);
+		free(raw);
+		return -1;
+	}
+
+	/* as on recovery, see decode_attr_db() */
+	resc_access_perm = ATR_DFLAG_ACCESS;
+
+	for (p = raw;;) {
+		memcpy(&i, p, sizeof(int));
+		if (i < 0)
+			break;
+		memcpy(&flags, p + sizeof(int), sizeof(int));
+		memcpy(&nvals, p + 2 * sizeof(int), sizeof(int));
+		p += 3 * sizeof(int);
+		pdef = &job_attr_def[i];
+		pattr = &pjob->ji_wattr[i];
+		/* set again while packed, the new value wins */
+		skip = is_attr_set(pattr);
+		for (k = 0; k < nvals; k++) {
+			name = p;
+			p += strlen(p) + 1;
+			resc = p;
+			p += strlen(p) + 1;
+			val = p;
+			p += strlen(p) + 1;
+			if (skip)
+				continue;
+			if (k > 0 && pdef->at_type == ATR_TYPE_ENTITY) {
+				/* the entity limits after the first are added to it */
+				memset(&tmpa, 0, sizeof(attribute));
+				pdef->at_decode(&tmpa, name, *resc ? resc : NULL, val);
+				pdef->at_set(pattr, &tmpa, INCR);
+				pdef->at_free(&tmpa);
+			} else
+				pdef->at_decode(pattr, name, *resc ? resc : NULL, val);
+		}
+		if (!skip)
+			pattr->at_flags = flags;
+	}
+	free(raw);
+	free(pjob->ji_packed);
+	pjob->ji_packed = NULL;
+	return 0;
+}
+
+/**
+ * @brief
+ *		svr_histjob_repack_task - pack a history job again once the event
+ *		which unpacked it has been processed, see svr_histjob_borrow().
+ *
+ * @param[in]	ptask	-	work task, parm1 is the job
+ *
+ * @return	void
+ */
+static void
+svr_histjob_repack_task(struct work_task *ptask)
+{
+	(void)svr_histjob_pack((job *)ptask->wt_parm1);
+}
+
+/**
+ * @brief
+ *		svr_histjob_borrow - unpack a history job for the event being
+ *		processed, it is packed again right after.
+ *
+ * @par
+ *		For callers that cannot tell when they are done with the values,
+ *		such as those of find_job().  The job is packed again by an
+ *		immediate work task, which goes with the job if it is purged first.
+ *
+ * @param[in,out]	pjob	-	history job
+ *
+ * @return	int
+ * @retval	0	unpacked, or not packed
+ * @retval	-1	out of memory or corrupt data, the job stays packed
+ */
+int
+svr_histjob_borrow(job *pjob)
+{
+	struct work_task *ptask;
+
+	if (pjob->ji_packed == NULL)
+		return 0;
+	if (svr_histjob_unpack(pjob) != 0)
+		return -1;
+
+	/* still there if repacked by status_job() since the last borrow */
+	for (ptask = (struct work_task *)GET_NEXT(pjob->ji_svrtask); ptask != NULL;
+		ptask = (struct work_task *)GET_NEXT(ptask->wt_linkobj)) {
+		if (ptask->wt_func == svr_histjob_repack_task)
+			return 0;
+	}
+	/* else left to svr_clean_job_history() */
+	if ((ptask = set_task(WORK_Immed, 0, svr_histjob_repack_task, pjob)) != NULL)
+		append_link(&pjob->ji_svrtask, &ptask->wt_linkobj, ptask);
+	return 0;
+}
+
+/**
+ * @brief
+ *		svr_compact_histjob - release what a job kept in memory while it
+ *		was live and that is of no use once it is a history job.
+ *
+ * @par
+ *		The cached svrattrl copy of each attribute, the encoded status
+ *		record, the rejected routing destinations and the accounting
+ *		string go, and the attribute values are packed, see
+ *		svr_histjob_pack().
+ *
+ * @param[in,out]	pjob	-	job which became a history job
+ *
+ * @return	void
+ */
+static void
+svr_compact_histjob(job *pjob)
+{
+	badplace *bp;
+	int i;
+
+	for (i = 0; i < (int)JOB_ATR_LAST; i++)
+		free_svrcache(&pjob->ji_wattr[i]);
+	job_statcache_free(pjob);
+
+	/* no more routing for this job */
+	bp = (badplace *)GET_NEXT(pjob->ji_rejectdest);
+	while (bp) {
+		delete_link(&bp->bp_link);
+		free(bp);
+		bp = (badplace *)GET_NEXT(pjob->ji_rejectdest);
+	}
+
+	/* rebuilt from resources_used by account_jobend() if ever needed */
+	free(pjob->ji_acctrec);
+	pjob->ji_acctrec = NULL;
+
+	(void)svr_histjob_pack(pjob);
+}
+
 /**
  * @brief
  *		Set the history info for the job and keep until cleaned up by the
@@ -5079,6 +5437,7 @@ pjob->ji_wattr[(int) JOB_ATR_history_timestamp].at_flags |= ATR_SET_MOD_MCACHE;
 	 */
 	free_job_work_tasks(pjob);
 
+	svr_compact_histjob(pjob);
 }
 
 /**
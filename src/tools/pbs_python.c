@@ -78,6 +78,14 @@
 #include <string.h>
 #include <errno.h>
 #include <fcntl.h>
+#ifndef WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+#endif
 #include <pbs_python.h>
 #include <pbs_error.h>
 #include <pbs_entlim.h>
@@ -98,6 +106,7 @@
 #include "cmds.h"
 #include "svrfunc.h"
 #include "pbs_sched.h"
+#include "pbs_idx.h"
 
 #define MAXBUF	4096
 #define PYHOME "PYTHONHOME"
@@ -105,8 +114,16 @@
 
 #define HOOK_MODE "--hook"
 
+#define	HOOK_SERVER_MAXRUN	256	/* events run at once by the hook server */
+
 struct python_interpreter_data  svr_interp_data;
 
+/* hook script compiled by the hook server, for the event run in the child */
+static struct python_script *hook_server_script = NULL;
+#ifndef WIN32
+static int	hook_server_sigfd = -1;	/* write end of the SIGCHLD self-pipe */
+#endif
+
 extern 	char		*vnode_state_to_str(int state_bit);
 extern	char		*vnode_sharing_to_str(enum vnode_sharing vns);
 extern	char		*vnode_ntype_to_str(int type);
@@ -197,6 +214,18 @@ find_job(char *jobid)
 	return NULL;
 }
 
+int
+svr_histjob_pack(job *pjob)
+{
+	return 0;
+}
+
+int
+svr_histjob_unpack(job *pjob)
+{
+	return 0;
+}
+
 resc_resv *
 find_resv(char *resvid)
 {
@@ -742,6 +771,11 @@ set_cred_renew_cache_period(attribute *pattr, void *pobj, int actmode) {
 	return PBSE_NONE;
 }
 
+int
+set_job_save_delay(attribute *pattr, void *pobj, int actmode) {
+	return PBSE_NONE;
+}
+
 /**
  * @brief
  * 		encode_svrstate - encode string into svrstate value
@@ -2237,6 +2271,346 @@ argv_list_to_str(pbs_list_head *argv_list)
 
 }
 
+#ifndef WIN32
+/* an event being run for MoM by the hook server */
+typedef struct hook_server_run {
+	pid_t	hs_pid;		/* child running the event */
+	int	hs_fd;		/* socket to return its wait status on */
+} hook_server_run_t;
+
+/**
+ * @brief
+ *		SIGCHLD handler of the hook server, wakes up its poll().
+ *
+ * @param[in]	sig	-	signal number
+ *
+ * @return	void
+ */
+static void
+hook_server_sigchld(int sig)
+{
+	int	save_errno = errno;
+
+	(void)write(hook_server_sigfd, "c", 1);
+	errno = save_errno;
+}
+
+/**
+ * @brief
+ *		Receive one event from MoM on stdin.
+ *
+ * @param[out]	buf	-	buffer of HOOK_SERVER_MSGMAX bytes for the message
+ * @param[out]	pfd	-	socket on which to return the wait status of the run
+ *
+ * @return	ssize_t
+ * @retval	>0	-	length of the message
+ * @retval	0	-	MoM closed the socket
+ * @retval	-1	-	bad message, to be ignored
+ */
+static ssize_t
+hook_server_recv(char *buf, int *pfd)
+{
+	struct msghdr	msg;
+	struct iovec	iov;
+	struct cmsghdr	*cmsg;
+	union {
+		struct cmsghdr	cm;
+		char		space[CMSG_SPACE(sizeof(int))];
+	} cbuf;
+	ssize_t		len;
+
+	*pfd = -1;
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = buf;
+	iov.iov_len = HOOK_SERVER_MSGMAX;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf.space;
+	msg.msg_controllen = sizeof(cbuf.space);
+
+	do {
+		len = recvmsg(0, &msg, MSG_CMSG_CLOEXEC);
+	} while ((len == -1) && (errno == EINTR));
+	if (len <= 0)
+		return 0;
+
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_RIGHTS))
+			memcpy(pfd, CMSG_DATA(cmsg), sizeof(int));
+	}
+	if ((*pfd == -1) || (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC))) {
+		log_err(-1, __func__, "malformed event message");
+		if (*pfd != -1)
+			close(*pfd);
+		return -1;
+	}
+	return len;
+}
+
+/**
+ * @brief
+ *		Split an event message into its strings.
+ *
+ * @param[in]	buf	-	the message
+ * @param[in]	len	-	length of the message
+ * @param[out]	pnstr	-	number of strings
+ *
+ * @return	char **
+ * @retval	malloc-ed NULL terminated array pointing into buf
+ * @retval	NULL	: bad message
+ */
+static char **
+hook_server_decode(char *buf, ssize_t len, int *pnstr)
+{
+	struct hook_server_req	hr;
+	char	**strs;
+	char	*p;
+	char	*end = buf + len;
+	int	i;
+
+	if (len <= (ssize_t)sizeof(hr))
+		return NULL;
+	memcpy(&hr, buf, sizeof(hr));
+	/* at least the cwd, config, program and --hook */
+	if ((hr.hr_version != HOOK_SERVER_VERSION) || (hr.hr_nstr < 4) ||
+		(hr.hr_nstr > len) || (buf[len - 1] != '\0'))
+		return NULL;
+	if ((strs = calloc(hr.hr_nstr + 1, sizeof(char *))) == NULL)
+		return NULL;
+	for (i = 0, p = buf + sizeof(hr); i < hr.hr_nstr; i++) {
+		if (p >= end) {
+			free(strs);
+			return NULL;
+		}
+		strs[i] = p;
+		p += strlen(p) + 1;
+	}
+	*pnstr = hr.hr_nstr;
+	return strs;
+}
+
+/**
+ * @brief
+ *		Get the compiled code of a hook script, compiling it only the first
+ *		time and when the file changed, so the children running the events
+ *		inherit it ready to run.
+ *
+ * @param[in]	idx	-	index of the scripts by path
+ * @param[in]	path	-	path of the script
+ *
+ * @return	struct python_script *
+ * @retval	the script, possibly not compiled if it has errors, which the
+ *		child then reports
+ * @retval	NULL	: the script could not be read
+ */
+static struct python_script *
+hook_server_compile(void *idx, char *path)
+{
+	struct python_script	*py_script = NULL;
+	void			*key = path;
+
+	if (pbs_idx_find(idx, &key, (void **)&py_script, NULL) != PBS_IDX_RET_OK) {
+		if (pbs_python_ext_alloc_python_script(path, &py_script) != 0)
+			return NULL;
+		if (pbs_idx_insert(idx, path, py_script) != PBS_IDX_RET_OK) {
+			pbs_python_ext_free_python_script(py_script);
+			free(py_script);
+			return NULL;
+		}
+	}
+	(void)pbs_python_check_and_compile_script(&svr_interp_data, py_script);
+	return py_script;
+}
+
+/**
+ * @brief
+ *		Serve the hook events of MoM ("pbs_python --hook-server"), with the
+ *		interpreter started, the pbs module loaded and the hook scripts
+ *		compiled once.  Each event runs in a child forked from here in a
+ *		session of its own, so a hook can neither crash the server nor leave
+ *		state behind for the next one, and the child is killed if the MoM
+ *		process that asked for it goes away, e.g. on the hook alarm.  The
+ *		child returns to run the event just like "pbs_python --hook".
+ *
+ * @param[in,out]	pargc	-	argument count, that of the event in the child
+ * @param[in,out]	pargv	-	arguments, those of the event in the child
+ *
+ * @return	int
+ * @retval	0	-	in the child, the event is to be run
+ * @retval	1	-	the server is done, MoM closed its socket or error
+ */
+static int
+hook_server(int *pargc, char ***pargv)
+{
+	extern void pbs_python_svr_initialize_interpreter_data(struct python_interpreter_data *interp_data);
+	extern void pbs_python_svr_destroy_interpreter_data(struct python_interpreter_data *interp_data);
+	char			**argv = *pargv;
+	char			path_log[MAXPATHLEN + 1] = ".";
+	hook_server_run_t	runs[HOOK_SERVER_MAXRUN];
+	struct pollfd		pfds[HOOK_SERVER_MAXRUN + 2];
+	struct sigaction	act;
+	int			sigpipe[2];
+	int			nrun = 0;
+	void			*idx;
+	char			*buf;
+	char			**strs;
+	int			nstr;
+	int			fd;
+	int			st;
+	ssize_t			len;
+	pid_t			pid;
+	int			i, j;
+
+	for (i = 2; argv[i] != NULL && argv[i + 1] != NULL; i += 2) {
+		if (strcmp(argv[i], "-L") == 0)
+			snprintf(path_log, sizeof(path_log), "%s", argv[i + 1]);
+		else if (strcmp(argv[i], "-e") == 0)
+			*log_event_mask = strtol(argv[i + 1], NULL, 0);
+	}
+	if (log_open_main(NULL, path_log, 1) != 0) {
+		fprintf(stderr, "pbs_python: Unable to open logfile\n");
+		return 1;
+	}
+
+	svr_interp_data.data_initialized = 0;
+	svr_interp_data.init_interpreter_data = pbs_python_svr_initialize_interpreter_data;
+	svr_interp_data.destroy_interpreter_data = pbs_python_svr_destroy_interpreter_data;
+	if ((svr_interp_data.daemon_name = strdup(PBS_PYTHON_PROGRAM)) == NULL) {
+		log_err(errno, __func__, "strdup");
+		return 1;
+	}
+	if (pbs_python_ext_start_interpreter(&svr_interp_data) != 0) {
+		log_err(-1, __func__, "Failed to start Python interpreter");
+		return 1;
+	}
+
+	if (((idx = pbs_idx_create(0, 0)) == NULL) ||
+		((buf = malloc(HOOK_SERVER_MSGMAX)) == NULL) ||
+		(pipe2(sigpipe, O_CLOEXEC | O_NONBLOCK) == -1)) {
+		log_err(errno, __func__, "setup");
+		return 1;
+	}
+	hook_server_sigfd = sigpipe[1];
+	memset(&act, 0, sizeof(act));
+	act.sa_handler = hook_server_sigchld;
+	act.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+	sigemptyset(&act.sa_mask);
+	sigaction(SIGCHLD, &act, NULL);
+
+	log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_HOOK, LOG_INFO, __func__,
+		"hook server ready");
+
+	for (;;) {
+		pfds[0].fd = (nrun < HOOK_SERVER_MAXRUN) ? 0 : -1;
+		pfds[0].events = POLLIN;
+		pfds[1].fd = sigpipe[0];
+		pfds[1].events = POLLIN;
+		for (i = 0; i < nrun; i++) {
+			pfds[i + 2].fd = runs[i].hs_fd;
+			pfds[i + 2].events = POLLIN;
+		}
+		if (poll(pfds, nrun + 2, -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			log_err(errno, __func__, "poll");
+			break;
+		}
+
+		/* the asker went away, e.g. killed on the hook alarm */
+		for (i = 0; i < nrun; i++) {
+			if ((runs[i].hs_fd != -1) && (pfds[i + 2].revents != 0)) {
+				kill(-runs[i].hs_pid, SIGKILL);
+				close(runs[i].hs_fd);
+				runs[i].hs_fd = -1;
+			}
+		}
+
+		if (pfds[1].revents & POLLIN) {
+			char	drain[64];
+
+			while (read(sigpipe[0], drain, sizeof(drain)) > 0)
+				;
+			while ((pid = waitpid(-1, &st, WNOHANG)) > 0) {
+				for (i = 0; i < nrun && runs[i].hs_pid != pid; i++)
+					;
+				if (i == nrun)
+					continue;
+				if (runs[i].hs_fd != -1) {
+					(void)send(runs[i].hs_fd, &st, sizeof(st), MSG_NOSIGNAL);
+					close(runs[i].hs_fd);
+				}
+				runs[i] = runs[--nrun];
+			}
+		}
+
+		if ((pfds[0].fd == -1) || (pfds[0].revents == 0))
+			continue;
+		if ((len = hook_server_recv(buf, &fd)) == 0)
+			break;
+		if (len == -1)
+			continue;
+		if ((strs = hook_server_decode(buf, len, &nstr)) == NULL) {
+			log_err(-1, __func__, "malformed event message");
+			close(fd);	/* the asker then runs the hook itself */
+			continue;
+		}
+
+		/* the script is the last argument */
+		hook_server_script = hook_server_compile(idx, strs[nstr - 1]);
+
+		if ((pid = fork()) == -1) {
+			log_err(errno, __func__, "fork");
+			close(fd);
+			free(strs);
+			continue;
+		}
+		if (pid == 0) {
+			act.sa_handler = SIG_DFL;
+			sigaction(SIGCHLD, &act, NULL);
+			close(sigpipe[0]);
+			close(sigpipe[1]);
+			close(0);
+			close(fd);
+			for (j = 0; j < nrun; j++) {
+				if (runs[j].hs_fd != -1)
+					close(runs[j].hs_fd);
+			}
+			(void)setsid();
+#ifdef __linux__
+			/* the event dies with the server */
+			(void)prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+#if PY_VERSION_HEX >= 0x03070000
+			PyOS_AfterFork_Child();
+#else
+			PyOS_AfterFork();
+#endif
+			log_close(0);
+
+			if (chdir(strs[0]) == -1)
+				log_err(errno, __func__, strs[0]);
+			if (strs[1][0] != '\0')
+				setenv(PBS_HOOK_CONFIG_FILE, strs[1], 1);
+			else
+				unsetenv(PBS_HOOK_CONFIG_FILE);
+			*pargc = nstr - 2;
+			*pargv = strs + 2;
+			return 0;
+		}
+		runs[nrun].hs_pid = pid;
+		runs[nrun].hs_fd = fd;
+		nrun++;
+		free(strs);
+	}
+
+	for (i = 0; i < nrun; i++)
+		kill(-runs[i].hs_pid, SIGKILL);
+	log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_HOOK, LOG_INFO, __func__,
+		"hook server exiting");
+	return 1;
+}
+#endif
+
 /**
  *
  * @brief
@@ -2340,6 +2714,14 @@ main(int argc, char *argv[], char *envp[])
 		svr_resc_def[i].rs_next = &svr_resc_def[i+1];
 	/* last entry is left with null pointer */
 
+#ifndef WIN32
+	if ((argv[1] != NULL) && (strcmp(argv[1], HOOK_SERVER_MODE) == 0)) {
+		/* returns only in the child running an event, as "--hook" */
+		if (hook_server(&argc, &argv) != 0)
+			return 1;
+	}
+#endif
+
 	if ((argv[1] == NULL) || (strcmp(argv[1], HOOK_MODE) != 0)) {
 		char *python_path = NULL;
 		if (get_py_progname(&python_path)) {
@@ -2832,20 +3214,26 @@ main(int argc, char *argv[], char *envp[])
 			snprintf(logname, sizeof(logname), "%s", full_logname);
 		}
 
-		/* set python interp data */
-		svr_interp_data.data_initialized = 0;
-		svr_interp_data.init_interpreter_data = pbs_python_svr_initialize_interpreter_data;
-		svr_interp_data.destroy_interpreter_data = pbs_python_svr_destroy_interpreter_data;
+		/* set python interp data, unless started by the hook server */
+		if (!svr_interp_data.interp_started) {
+			svr_interp_data.data_initialized = 0;
+			svr_interp_data.init_interpreter_data = pbs_python_svr_initialize_interpreter_data;
+			svr_interp_data.destroy_interpreter_data = pbs_python_svr_destroy_interpreter_data;
 
-		svr_interp_data.daemon_name = strdup(PBS_PYTHON_PROGRAM);
+			svr_interp_data.daemon_name = strdup(PBS_PYTHON_PROGRAM);
 
-		if (svr_interp_data.daemon_name == NULL) { /* should not happen */
-			fprintf(stderr, "strdup failed");
-			exit(1);
+			if (svr_interp_data.daemon_name == NULL) { /* should not happen */
+				fprintf(stderr, "strdup failed");
+				exit(1);
+			}
 		}
 
-		(void)pbs_python_ext_alloc_python_script(hook_script,
-			(struct python_script **) &py_script);
+		if ((hook_server_script != NULL) &&
+			(strcmp(hook_server_script->path, hook_script) == 0))
+			py_script = hook_server_script;
+		else
+			(void)pbs_python_ext_alloc_python_script(hook_script,
+				(struct python_script **) &py_script);
 
 		hook_perf_stat_start(perf_label, HOOK_PERF_START_PYTHON, 0);
 		if (pbs_python_ext_start_interpreter(&svr_interp_data) != 0) {
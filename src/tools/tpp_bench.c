@@ -0,0 +1,871 @@
+/*
+ * Copyright (C) 1994-2020 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file	tpp_bench.c
+ *
+ * @brief
+ *	tpp_bench - measure the throughput and latency of TPP on a single host.
+ *
+ *	Starts a pbs_comm router, a number of receiving leaves and a sending
+ *	leaf, each in its own process since TPP keeps its state per process.
+ *	Every receiving leaf answers to many names (one per stream), so that
+ *	thousands of streams can be driven from a handful of processes. The
+ *	sender then drives messages through tpp_send/tpp_recv in one of the
+ *	patterns:
+ *	  unicast - messages go round robin over all the streams
+ *	  mcast   - every message is multicast to all the streams
+ *	  rr      - request/response, the leaves echo every message back
+ *
+ *	Reports messages per second, p50/p99 latency, read and write system
+ *	calls per message and the counters of the TPP object pools.
+ *
+ * Functions included are:
+ * 	main()
+ * 	usage()
+ * 	now_ns()
+ * 	proc_syscalls()
+ * 	pool_totals()
+ * 	bench_config()
+ * 	wait_fd()
+ * 	read_msg()
+ * 	add_sample()
+ * 	put_result()
+ * 	get_result()
+ * 	run_router()
+ * 	run_leaf()
+ * 	run_sender()
+ * 	cmp_samples()
+ * 	report()
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "pbs_internal.h"
+#include "pbs_version.h"
+#include "log.h"
+#include "auth.h"
+#include "tpp.h"
+
+#define BENCH_UNICAST		0
+#define BENCH_MCAST		1
+#define BENCH_RR		2
+
+#define BENCH_TIMEOUT		30	/* seconds without progress before giving up */
+#define BENCH_MAX_SAMPLES	(1 << 20) /* latency samples kept per process */
+#define BENCH_DRAIN_EVERY	64	/* sends between draining the sender's events */
+#define BENCH_MAX_NAMES		128	/* addresses a leaf can join with */
+
+/* header at the start of every message */
+struct bench_msg {
+	unsigned int seq;
+	unsigned int stream;
+	unsigned long long sent;	/* CLOCK_MONOTONIC of the send, in ns */
+};
+
+/* what each process reports back to the parent */
+struct bench_result {
+	unsigned long msgs;		/* messages received */
+	unsigned long long first;	/* ns of the first message received */
+	unsigned long long last;	/* ns of the last message received */
+	unsigned long syscalls;		/* read and write system calls */
+	unsigned long pool_hits;
+	unsigned long pool_misses;
+	unsigned long nsamples;		/* latency samples that follow */
+};
+
+static char *host;
+static int pattern = BENCH_UNICAST;
+static int nleaves = 8;
+static int nstreams = 128;	/* streams per leaf */
+static int msgsize = 1024;
+static int nmsgs = 100000;
+static int port = 17101;
+static int nthreads = 2;
+static int window = 0;		/* outstanding requests in rr, 0 for one per stream */
+static int compress = 0;
+
+static unsigned long long *samples;
+static unsigned long nsamples;
+
+/**
+ * @brief
+ *	usage - print the usage of tpp_bench
+ *
+ * @param[in]	prog - program name
+ *
+ * @return	void
+ */
+static void
+usage(char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-p unicast|mcast|rr] [-l leaves] [-s streams_per_leaf]\n"
+		"       [-m msg_size] [-n messages] [-w window] [-t router_threads]\n"
+		"       [-H host] [-P port] [-W highwater] [-c] [-L logfile]\n"
+		"       %s --version\n"
+		"  -p : message pattern, default unicast\n"
+		"  -l : number of receiving leaves, default %d\n"
+		"  -s : streams (names) per receiving leaf, at most %d, default %d\n"
+		"  -m : message size in bytes, default %d\n"
+		"  -n : messages to send, default %d\n"
+		"  -w : requests outstanding in rr, default one per stream\n"
+		"  -t : pbs_comm threads, default %d\n"
+		"  -H : address to run on, default this host, TPP does not use loopback\n"
+		"  -P : pbs_comm port, the leaves use the ports after it, default %d\n"
+		"  -W : unacknowledged packets per stream before throttling, default %d\n"
+		"  -c : compress messages\n"
+		"  -L : write the TPP log to logfile\n"
+		"Must run as root, TPP connections bind reserved ports.\n",
+		prog, prog, nleaves, BENCH_MAX_NAMES, nstreams, msgsize, nmsgs, nthreads, port, RPP_HIGHWATER);
+	exit(2);
+}
+
+/**
+ * @brief
+ *	now_ns - current CLOCK_MONOTONIC time, comparable between processes
+ *
+ * @return	unsigned long long
+ * @retval	time in ns
+ */
+static unsigned long long
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief
+ *	proc_syscalls - read and write system calls made by a process so far,
+ *	from /proc/<pid>/io
+ *
+ * @param[in]	pid - process id
+ *
+ * @return	unsigned long
+ * @retval	number of system calls, 0 if not known
+ */
+static unsigned long
+proc_syscalls(pid_t pid)
+{
+	char path[64];
+	char line[128];
+	unsigned long v;
+	unsigned long n = 0;
+	FILE *fp;
+
+	snprintf(path, sizeof(path), "/proc/%d/io", (int) pid);
+	if ((fp = fopen(path, "r")) == NULL)
+		return 0;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (sscanf(line, "syscr: %lu", &v) == 1 || sscanf(line, "syscw: %lu", &v) == 1)
+			n += v;
+	}
+	fclose(fp);
+	return n;
+}
+
+/**
+ * @brief
+ *	pool_totals - add up the counters of the TPP object pools
+ *
+ * @param[out]	res - result to add them to
+ *
+ * @return	void
+ */
+static void
+pool_totals(struct bench_result *res)
+{
+	struct tpp_pool_stats stats[16];
+	int n;
+	int i;
+
+	n = tpp_get_pool_stats(stats, 16);
+	for (i = 0; i < n; i++) {
+		res->pool_hits += stats[i].hits;
+		res->pool_misses += stats[i].misses;
+	}
+}
+
+/**
+ * @brief
+ *	bench_config - fill in the TPP configuration of one process
+ *
+ * @param[out]	conf - TPP configuration
+ * @param[in]	type - TPP_ROUTER_NODE or TPP_LEAF_NODE
+ * @param[in]	first - port of the first name of the node
+ * @param[in]	nnames - number of names, at consecutive ports
+ *
+ * @return	void
+ */
+static void
+bench_config(struct tpp_config *conf, int type, int first, int nnames)
+{
+	char routers[PBS_MAXHOSTNAME + 16];
+	char *names;
+	int len;
+	int i;
+
+	snprintf(routers, sizeof(routers), "%s:%d", host, port);
+	memset(conf, 0, sizeof(struct tpp_config));
+	if (set_tpp_config(NULL, &pbs_conf, conf, host, first,
+		(type == TPP_ROUTER_NODE) ? NULL : routers) == -1) {
+		fprintf(stderr, "tpp_bench: failed to set up TPP\n");
+		exit(1);
+	}
+	conf->node_type = type;
+	conf->compress = compress;
+	if (type == TPP_ROUTER_NODE) {
+		conf->numthreads = nthreads;
+		return;
+	}
+
+	/* a leaf answers to one name per stream */
+	len = nnames * (strlen(host) + 8) + 1;
+	if ((names = malloc(len)) == NULL) {
+		fprintf(stderr, "tpp_bench: out of memory\n");
+		exit(1);
+	}
+	names[0] = '\0';
+	for (i = 0; i < nnames; i++)
+		sprintf(names + strlen(names), "%s%s:%d", i ? "," : "", host, first + i);
+	free(conf->node_name);
+	conf->node_name = names;
+}
+
+/**
+ * @brief
+ *	wait_fd - wait for a file descriptor to become readable
+ *
+ * @param[in]	fd - file descriptor
+ * @param[in]	ms - timeout in ms
+ *
+ * @return	int
+ * @retval	>0 readable
+ * @retval	0 timed out
+ */
+static int
+wait_fd(int fd, int ms)
+{
+	struct pollfd pfd;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	return poll(&pfd, 1, ms);
+}
+
+/**
+ * @brief
+ *	read_msg - read the next message of a stream
+ *
+ * @param[in]	sd - stream
+ * @param[out]	buf - buffer of msgsize bytes
+ *
+ * @return	int
+ * @retval	length of the message
+ */
+static int
+read_msg(int sd, char *buf)
+{
+	int len = 0;
+	int n;
+
+	while (len < msgsize && (n = tpp_recv(sd, buf + len, msgsize - len)) > 0)
+		len += n;
+	tpp_eom(sd);
+	return len;
+}
+
+/**
+ * @brief
+ *	add_sample - keep a latency sample
+ *
+ * @param[in]	sent - ns the message was sent at
+ *
+ * @return	void
+ */
+static void
+add_sample(unsigned long long sent)
+{
+	if (nsamples < BENCH_MAX_SAMPLES)
+		samples[nsamples++] = now_ns() - sent;
+}
+
+/**
+ * @brief
+ *	put_result - send the result of this process to the parent
+ *
+ * @param[in]	fd - pipe to the parent
+ * @param[in]	res - result, the kept samples follow it
+ *
+ * @return	void
+ */
+static void
+put_result(int fd, struct bench_result *res)
+{
+	res->nsamples = nsamples;
+	if (write(fd, res, sizeof(*res)) != sizeof(*res) ||
+		(nsamples && write(fd, samples, nsamples * sizeof(*samples)) !=
+		(ssize_t)(nsamples * sizeof(*samples))))
+		fprintf(stderr, "tpp_bench: failed to report results\n");
+}
+
+/**
+ * @brief
+ *	get_result - read the result of a child process, adding its samples
+ *	to the ones of this process
+ *
+ * @param[in]	fd - pipe from the child
+ * @param[out]	res - result
+ *
+ * @return	int
+ * @retval	0 success
+ * @retval	-1 the child did not report
+ */
+static int
+get_result(int fd, struct bench_result *res)
+{
+	size_t want;
+	size_t got = 0;
+	ssize_t n;
+	char *p;
+
+	memset(res, 0, sizeof(*res));
+	if (read(fd, res, sizeof(*res)) != sizeof(*res))
+		return -1;
+	if (res->nsamples > BENCH_MAX_SAMPLES)
+		return -1;
+	if ((p = realloc(samples, (nsamples + res->nsamples) * sizeof(*samples) + 1)) == NULL)
+		return -1;
+	samples = (unsigned long long *) p;
+	p = (char *)(samples + nsamples);
+	want = res->nsamples * sizeof(*samples);
+	while (got < want && (n = read(fd, p + got, want - got)) > 0)
+		got += n;
+	if (got != want)
+		return -1;
+	nsamples += res->nsamples;
+	return 0;
+}
+
+/**
+ * @brief
+ *	run_router - run the pbs_comm router until the parent closes ctl
+ *
+ * @param[in]	ctl - pipe from the parent
+ * @param[in]	out - pipe to the parent
+ *
+ * @return	void
+ */
+static void
+run_router(int ctl, int out)
+{
+	struct tpp_config conf;
+	struct bench_result res;
+	char c;
+
+	if (load_auths(AUTH_SERVER) != 0)
+		exit(1);
+	bench_config(&conf, TPP_ROUTER_NODE, port, 1);
+	if (tpp_init_router(&conf) == -1) {
+		fprintf(stderr, "tpp_bench: failed to start pbs_comm\n");
+		exit(1);
+	}
+	while (read(ctl, &c, 1) == -1 && errno == EINTR)
+		;
+	memset(&res, 0, sizeof(res));
+	pool_totals(&res);
+	put_result(out, &res);
+	exit(0);
+}
+
+/**
+ * @brief
+ *	run_leaf - run a receiving leaf, until it received what it expects,
+ *	or for rr until the parent closes ctl
+ *
+ * @param[in]	idx - index of the leaf
+ * @param[in]	ctl - pipe from the parent
+ * @param[in]	out - pipe to the parent
+ *
+ * @return	void
+ */
+static void
+run_leaf(int idx, int ctl, int out)
+{
+	struct tpp_config conf;
+	struct bench_result res;
+	struct pollfd pfd[2];
+	struct bench_msg *hdr;
+	unsigned long expect = 0;
+	unsigned long long start;
+	char *buf;
+	int total = nleaves * nstreams;
+	int fd;
+	int sd;
+	int i;
+
+	if ((buf = malloc(msgsize)) == NULL || (samples = malloc(BENCH_MAX_SAMPLES * sizeof(*samples))) == NULL)
+		exit(1);
+	hdr = (struct bench_msg *) buf;
+	memset(&res, 0, sizeof(res));
+
+	if (pattern == BENCH_UNICAST) {
+		for (i = 0; i < nstreams; i++) {
+			int s = idx * nstreams + i;
+			expect += nmsgs / total + (s < nmsgs % total);
+		}
+	} else if (pattern == BENCH_MCAST)
+		expect = (unsigned long) nmsgs * nstreams;
+
+	if (load_auths(AUTH_SERVER) != 0)
+		exit(1);
+	bench_config(&conf, TPP_LEAF_NODE, port + 2 + idx * nstreams, nstreams);
+	if ((fd = tpp_init(&conf)) == -1) {
+		fprintf(stderr, "tpp_bench: leaf %d failed to start\n", idx);
+		exit(1);
+	}
+	start = proc_syscalls(getpid());
+
+	pfd[0].fd = fd;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = ctl;
+	pfd[1].events = POLLIN;
+	while (pattern == BENCH_RR || res.msgs < expect) {
+		pfd[0].revents = pfd[1].revents = 0;
+		if (poll(pfd, 2, BENCH_TIMEOUT * 1000) <= 0) {
+			fprintf(stderr, "tpp_bench: leaf %d timed out after %lu of %lu messages\n",
+				idx, res.msgs, expect);
+			break;
+		}
+		if (pfd[1].revents)
+			break;
+		while ((sd = tpp_poll()) >= 0) {
+			if (read_msg(sd, buf) < (int) sizeof(struct bench_msg))
+				continue;
+			if (res.msgs++ == 0)
+				res.first = now_ns();
+			if (pattern == BENCH_RR)
+				tpp_send(sd, buf, msgsize);
+			else
+				add_sample(hdr->sent);
+		}
+		res.last = now_ns();
+	}
+	res.syscalls = proc_syscalls(getpid()) - start;
+	pool_totals(&res);
+	put_result(out, &res);
+	tpp_shutdown();
+	exit(0);
+}
+
+/**
+ * @brief
+ *	run_sender - open the streams and drive the messages through them
+ *
+ * @param[out]	res - result of the sender
+ *
+ * @return	int
+ * @retval	0 success
+ * @retval	-1 failure
+ */
+static int
+run_sender(struct bench_result *res)
+{
+	struct tpp_config conf;
+	struct bench_msg *hdr;
+	unsigned long long start;
+	unsigned long long idle;
+	char *buf;
+	int *sds;
+	int total = nleaves * nstreams;
+	int sent = 0;
+	int outstanding = 0;
+	int fd;
+	int sd;
+	int mt = -1;
+	int i;
+
+	if ((buf = calloc(1, msgsize)) == NULL || (sds = malloc(total * sizeof(int))) == NULL ||
+		(samples = malloc(BENCH_MAX_SAMPLES * sizeof(*samples))) == NULL)
+		return -1;
+	/* something for compression to work on */
+	for (i = sizeof(struct bench_msg); i < msgsize; i++)
+		buf[i] = "abcdefgh"[(i * 7) % 8 ^ (i / 512) % 8];
+	hdr = (struct bench_msg *) buf;
+
+	if (load_auths(AUTH_SERVER) != 0)
+		return -1;
+	bench_config(&conf, TPP_LEAF_NODE, port + 1, 1);
+	if ((fd = tpp_init(&conf)) == -1) {
+		fprintf(stderr, "tpp_bench: sender failed to start\n");
+		return -1;
+	}
+	sleep(1); /* let the leaves join */
+
+	for (i = 0; i < total; i++) {
+		if ((sds[i] = tpp_open(host, port + 2 + i)) == -1) {
+			fprintf(stderr, "tpp_bench: failed to open stream %d\n", i);
+			return -1;
+		}
+	}
+	if (pattern == BENCH_MCAST) {
+		if ((mt = tpp_mcast_open()) == -1)
+			return -1;
+		for (i = 0; i < total; i++) {
+			if (tpp_mcast_add_strm(mt, sds[i]) == -1)
+				return -1;
+		}
+	}
+
+	start = proc_syscalls(getpid());
+	res->first = now_ns();
+	if (pattern != BENCH_RR) {
+		for (sent = 0; sent < nmsgs; sent++) {
+			hdr->seq = sent;
+			hdr->stream = sent % total;
+			hdr->sent = now_ns();
+			sd = (pattern == BENCH_MCAST) ? mt : sds[hdr->stream];
+			if (tpp_send(sd, buf, msgsize) == -1) {
+				fprintf(stderr, "tpp_bench: send %d failed\n", sent);
+				return -1;
+			}
+			if ((sent % BENCH_DRAIN_EVERY) == 0) {
+				while (wait_fd(fd, 0) > 0 && tpp_poll() >= 0)
+					;
+			}
+		}
+	} else {
+		if (window <= 0 || window > total)
+			window = total;
+		idle = now_ns();
+		while (res->msgs < (unsigned long) nmsgs) {
+			while (outstanding < window && sent < nmsgs) {
+				hdr->seq = sent;
+				hdr->stream = sent % window;
+				hdr->sent = now_ns();
+				if (tpp_send(sds[hdr->stream], buf, msgsize) == -1) {
+					fprintf(stderr, "tpp_bench: send %d failed\n", sent);
+					return -1;
+				}
+				sent++;
+				outstanding++;
+			}
+			if (wait_fd(fd, 1000) <= 0) {
+				if (now_ns() - idle > BENCH_TIMEOUT * 1000000000ULL) {
+					fprintf(stderr, "tpp_bench: timed out after %lu of %d responses\n",
+						res->msgs, nmsgs);
+					return -1;
+				}
+				continue;
+			}
+			while ((sd = tpp_poll()) >= 0) {
+				if (read_msg(sd, buf) < (int) sizeof(struct bench_msg))
+					continue;
+				add_sample(hdr->sent);
+				res->msgs++;
+				outstanding--;
+				idle = now_ns();
+			}
+		}
+	}
+	res->last = now_ns();
+	res->syscalls = proc_syscalls(getpid()) - start;
+	pool_totals(res);
+	return 0;
+}
+
+/**
+ * @brief
+ *	cmp_samples - qsort comparison of latency samples
+ */
+static int
+cmp_samples(const void *a, const void *b)
+{
+	unsigned long long x = *(const unsigned long long *) a;
+	unsigned long long y = *(const unsigned long long *) b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief
+ *	report - print the results
+ *
+ * @param[in]	snd - result of the sender
+ * @param[in]	rtr - result of the router
+ * @param[in]	rcv - results of the leaves added up
+ *
+ * @return	void
+ */
+static void
+report(struct bench_result *snd, struct bench_result *rtr, struct bench_result *rcv)
+{
+	static char *names[] = {"unicast", "mcast", "rr"};
+	double secs;
+	double msgs;
+
+	printf("pattern=%s leaves=%d streams=%d size=%d messages=%d\n",
+		names[pattern], nleaves, nleaves * nstreams, msgsize, nmsgs);
+
+	if (pattern == BENCH_RR) {
+		msgs = snd->msgs;
+		secs = (snd->last - snd->first) / 1e9;
+	} else {
+		msgs = rcv->msgs;
+		secs = (rcv->last - snd->first) / 1e9;
+	}
+	if (secs <= 0)
+		secs = 1e-9;
+	printf("throughput: %.0f msg/s, %.1f MB/s", msgs / secs, msgs * msgsize / secs / 1e6);
+	if (pattern == BENCH_MCAST)
+		printf(", %.0f mcast/s", nmsgs / secs);
+	printf("\n");
+
+	if (nsamples > 0) {
+		qsort(samples, nsamples, sizeof(*samples), cmp_samples);
+		printf("latency%s: p50=%.1f us, p99=%.1f us, max=%.1f us (%lu samples)\n",
+			(pattern == BENCH_RR) ? " (round trip)" : "",
+			samples[nsamples / 2] / 1e3, samples[nsamples * 99 / 100] / 1e3,
+			samples[nsamples - 1] / 1e3, nsamples);
+	}
+
+	if (msgs > 0)
+		printf("syscalls/msg: sender=%.3f pbs_comm=%.3f leaves=%.3f\n",
+			snd->syscalls / msgs, rtr->syscalls / msgs, rcv->syscalls / msgs);
+	printf("pools (hits/misses): sender=%lu/%lu pbs_comm=%lu/%lu leaves=%lu/%lu\n",
+		snd->pool_hits, snd->pool_misses, rtr->pool_hits, rtr->pool_misses,
+		rcv->pool_hits, rcv->pool_misses);
+}
+
+/**
+ * @brief
+ *	This is main function of tpp_bench.
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: failure
+ */
+int
+main(int argc, char *argv[])
+{
+	static char *auth_methods[] = {"resvport", NULL};
+	char hostname[PBS_MAXHOSTNAME + 1];
+	struct bench_result snd;
+	struct bench_result rtr;
+	struct bench_result rcv;
+	struct bench_result r;
+	int ctl[2];
+	int out[2];
+	int *leaf_out;
+	pid_t router;
+	pid_t *leaves;
+	unsigned long long rtr_start;
+	char *logfile = NULL;
+	int highwater = RPP_HIGHWATER;
+	int rc = 0;
+	int c;
+	int i;
+
+	/*the real deal or output pbs_version and exit?*/
+	PRINT_VERSION_AND_EXIT(argc, argv);
+
+	while ((c = getopt(argc, argv, "p:l:s:m:n:w:t:H:P:W:cL:")) != EOF) {
+		switch (c) {
+			case 'p':
+				if (strcmp(optarg, "unicast") == 0)
+					pattern = BENCH_UNICAST;
+				else if (strcmp(optarg, "mcast") == 0)
+					pattern = BENCH_MCAST;
+				else if (strcmp(optarg, "rr") == 0)
+					pattern = BENCH_RR;
+				else
+					usage(argv[0]);
+				break;
+			case 'l':
+				nleaves = atoi(optarg);
+				break;
+			case 's':
+				nstreams = atoi(optarg);
+				break;
+			case 'm':
+				msgsize = atoi(optarg);
+				break;
+			case 'n':
+				nmsgs = atoi(optarg);
+				break;
+			case 'w':
+				window = atoi(optarg);
+				break;
+			case 't':
+				nthreads = atoi(optarg);
+				break;
+			case 'H':
+				host = optarg;
+				break;
+			case 'P':
+				port = atoi(optarg);
+				break;
+			case 'W':
+				highwater = atoi(optarg);
+				break;
+			case 'c':
+				compress = 1;
+				break;
+			case 'L':
+				logfile = optarg;
+				break;
+			default:
+				usage(argv[0]);
+		}
+	}
+	if (optind != argc || nleaves < 1 || nstreams < 1 || nstreams > BENCH_MAX_NAMES || nmsgs < 1 || nthreads < 2 ||
+		port < 1 || port + 2 + nleaves * nstreams > 65535)
+		usage(argv[0]);
+	if (msgsize < (int) sizeof(struct bench_msg))
+		msgsize = sizeof(struct bench_msg);
+	if (host == NULL) {
+		if (gethostname(hostname, sizeof(hostname)) == -1) {
+			perror("gethostname");
+			return 1;
+		}
+		hostname[PBS_MAXHOSTNAME] = '\0';
+		host = hostname;
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+	rpp_highwater = highwater;
+	strcpy(pbs_conf.auth_method, AUTH_RESVPORT_NAME);
+	pbs_conf.encrypt_method[0] = '\0';
+	pbs_conf.supported_auth_methods = auth_methods;
+	if (pbs_conf.pbs_exec_path == NULL)
+		pbs_conf.pbs_exec_path = "/tmp";
+	if (pbs_conf.pbs_home_path == NULL)
+		pbs_conf.pbs_home_path = "/tmp";
+	if (logfile) {
+		set_log_conf(NULL, NULL, 0, 0, 0, 0);
+		if (log_open(logfile, "/tmp") != 0) {
+			fprintf(stderr, "tpp_bench: cannot open %s\n", logfile);
+			return 1;
+		}
+	}
+
+	/* the parent closing ctl tells the router and the leaves to stop */
+	if (pipe(ctl) == -1 || pipe(out) == -1) {
+		perror("pipe");
+		return 1;
+	}
+	if ((router = fork()) == 0) {
+		close(ctl[1]);
+		run_router(ctl[0], out[1]);
+	}
+	close(out[1]);
+	sleep(1);
+
+	leaves = malloc(nleaves * sizeof(pid_t));
+	leaf_out = malloc(nleaves * sizeof(int));
+	if (leaves == NULL || leaf_out == NULL)
+		return 1;
+	for (i = 0; i < nleaves; i++) {
+		int p[2];
+
+		if (pipe(p) == -1) {
+			perror("pipe");
+			return 1;
+		}
+		if ((leaves[i] = fork()) == 0) {
+			close(ctl[1]);
+			close(p[0]);
+			run_leaf(i, ctl[0], p[1]);
+		}
+		close(p[1]);
+		leaf_out[i] = p[0];
+	}
+	close(ctl[0]);
+	rtr_start = proc_syscalls(router);
+
+	memset(&snd, 0, sizeof(snd));
+	if (run_sender(&snd) != 0)
+		rc = 1;
+	if (pattern == BENCH_RR)
+		close(ctl[1]);
+
+	memset(&rcv, 0, sizeof(rcv));
+	for (i = 0; i < nleaves; i++) {
+		if (get_result(leaf_out[i], &r) != 0) {
+			fprintf(stderr, "tpp_bench: leaf %d did not report\n", i);
+			rc = 1;
+			continue;
+		}
+		rcv.msgs += r.msgs;
+		if (r.last > rcv.last)
+			rcv.last = r.last;
+		rcv.syscalls += r.syscalls;
+		rcv.pool_hits += r.pool_hits;
+		rcv.pool_misses += r.pool_misses;
+	}
+
+	memset(&rtr, 0, sizeof(rtr));
+	rtr.syscalls = proc_syscalls(router) - rtr_start;
+	if (pattern != BENCH_RR)
+		close(ctl[1]);
+	if (get_result(out[0], &r) == 0) {
+		rtr.pool_hits = r.pool_hits;
+		rtr.pool_misses = r.pool_misses;
+	}
+	kill(router, SIGKILL);
+	for (i = 0; i < nleaves; i++)
+		waitpid(leaves[i], NULL, 0);
+	waitpid(router, NULL, 0);
+
+	report(&snd, &rtr, &rcv);
+	return rc;
+}
@@ -39,6 +39,7 @@
 
 
 from tests.functional import *
+import json
 
 
 class TestAcctLog(TestFunctional):
@@ -309,3 +310,50 @@ pbs.event().reject('foo')
             # runjob hook is rejecting the run request
             pass
         self.server.accounting_match(';a;' + jid1 + ';project=abc')
+
+    def set_acct_conf(self, confs):
+        """
+        Set accounting settings in pbs.conf and restart the server
+        """
+        self.du.set_pbs_config(hostname=self.server.hostname, confs=confs,
+                               append=True)
+        self.server.restart()
+        self.assertTrue(self.server.isUp(), 'Failed to restart server')
+
+    def test_acct_flush_interval(self):
+        """
+        With PBS_ACCT_FLUSH_INTERVAL set, accounting records are written
+        out in batches and none are lost across a server restart
+        """
+        self.set_acct_conf({'PBS_ACCT_FLUSH_INTERVAL': 5})
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        jids = [self.server.submit(Job()) for _ in range(10)]
+        for jid in jids:
+            self.server.accounting_match(';Q;' + jid + ';', n=100,
+                                         max_attempts=10, interval=2)
+        for jid in jids:
+            self.server.delete(jid)
+        self.server.restart()
+        for jid in jids:
+            self.server.accounting_match(';D;' + jid + ';', n=100)
+
+    def test_acct_json_sidecar(self):
+        """
+        With PBS_ACCT_JSON set, each accounting record is also written as
+        a JSON object to the .json file next to the accounting log
+        """
+        self.set_acct_conf({'PBS_ACCT_JSON': 1})
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        j = Job(TEST_USER, {ATTR_N: 'json_job'})
+        jid = self.server.submit(j)
+        self.server.accounting_match(';Q;' + jid + ';')
+
+        pbs_home = self.server.pbs_conf['PBS_HOME']
+        jfile = os.path.join(pbs_home, 'server_priv', 'accounting',
+                             time.strftime('%Y%m%d') + '.json')
+        ret = self.du.cat(self.server.hostname, jfile, sudo=True)
+        self.assertEqual(ret['rc'], 0, 'No JSON accounting file')
+        recs = [json.loads(l) for l in ret['out'] if l.strip()]
+        queued = [r for r in recs if r['type'] == 'Q' and r['id'] == jid]
+        self.assertEqual(len(queued), 1)
+        self.assertEqual(queued[0]['queue'], 'workq')
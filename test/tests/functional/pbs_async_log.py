@@ -0,0 +1,103 @@
+# coding: utf-8
+# Copyright (C) 1994-2020 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+from tests.functional import *
+
+
+class TestAsyncLogging(TestFunctional):
+    """
+    TestSuite for asynchronous daemon logging in PBS
+    """
+
+    def switch_async_logging(self, policy=1):
+        """
+        Set PBS_LOG_ASYNC in pbs.conf and restart the daemons
+        """
+        a = {'PBS_LOG_ASYNC': policy}
+        self.du.set_pbs_config(hostname=self.server.hostname, confs=a,
+                               append=True)
+        PBSInitServices().restart()
+        self.assertTrue(self.server.isUp(), 'Failed to restart PBS Daemons')
+
+    def run_jobs(self, njobs=20):
+        """
+        Submit short jobs and check that their life cycle is logged
+        by the server, the scheduler and the mom
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        jids = []
+        for _ in range(njobs):
+            j = Job(TEST_USER)
+            j.set_sleep_time(1)
+            jids.append(self.server.submit(j))
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'True'})
+        for jid in jids:
+            self.server.expect(JOB, 'queue', id=jid, op=UNSET, offset=1,
+                               max_attempts=60)
+            self.server.log_match(jid + ";Exit_status=0")
+            self.scheduler.log_match(jid + ";Job run")
+            self.mom.log_match("Job;%s;Started" % jid)
+
+    def test_async_block(self):
+        """
+        Enable asynchronous logging with the blocking policy and check
+        that every record still reaches the daemon logs
+        """
+        self.switch_async_logging(policy=1)
+        self.run_jobs()
+
+    def test_async_drop(self):
+        """
+        Enable asynchronous logging with the drop policy and check that
+        the daemons log normally when the buffer does not fill up
+        """
+        self.switch_async_logging(policy=2)
+        self.run_jobs()
+
+    def test_async_log_on_shutdown(self):
+        """
+        Records logged just before the server shuts down must not be
+        lost with the asynchronous writer
+        """
+        self.switch_async_logging(policy=1)
+        self.server.stop()
+        self.server.log_match("Log closed")
+        self.server.start()
+        self.assertTrue(self.server.isUp(), 'Failed to restart server')
@@ -232,3 +232,45 @@ class TestCalendaring(TestFunctional):
         est_time = job3[0]['estimated.start_time']
         est_time = time.mktime(time.strptime(est_time, '%c'))
         self.assertAlmostEqual(end_time, est_time, delta=1)
+
+    @skipOnCpuSet
+    def test_background_estimates(self):
+        """
+        In this test we test that with background_estimates turned on,
+        jobs beyond backfill_depth get an estimated start time from the
+        estimates helper
+        """
+
+        self.scheduler.set_sched_config({'strict_ordering': 'true all',
+                                         'background_estimates': 'true'})
+        a = {'resources_available.ncpus': 1}
+        self.server.manager(MGR_CMD_SET, NODE, a, self.mom.shortname)
+        a = {'backfill_depth': '1'}
+        self.server.manager(MGR_CMD_SET, SERVER, a)
+        a = {'opt_backfill_fuzzy': 'off'}
+        self.server.manager(MGR_CMD_SET, SCHED, a)
+
+        jids = []
+        for _ in range(3):
+            res_req = {'Resource_List.select': '1:ncpus=1',
+                       'Resource_List.walltime': 60}
+            j = Job(TEST_USER, attrs=res_req)
+            j.set_sleep_time(60)
+            jids.append(self.server.submit(j))
+
+        self.server.expect(JOB, {'job_state': 'R'}, jids[0])
+        self.scheduler.log_match('Started estimates helper')
+
+        # Only jids[1] is a top job, jids[2] is estimated by the helper
+        # and published in the next cycle
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'True'})
+        self.scheduler.log_match('Published estimated start times of')
+        self.server.expect(JOB, 'estimated.start_time', op=SET, id=jids[2])
+
+        job2 = self.server.status(JOB, id=jids[1])
+        job3 = self.server.status(JOB, id=jids[2])
+        est2 = time.mktime(time.strptime(job2[0]['estimated.start_time'],
+                                         '%c'))
+        est3 = time.mktime(time.strptime(job3[0]['estimated.start_time'],
+                                         '%c'))
+        self.assertAlmostEqual(est3, est2 + 60, delta=1)
@@ -553,3 +553,42 @@ e.accept()
                            max_attempts=3)
         self.check_depend_delete_msg(j3, j4)
         self.server.expect(JOB, {ATTR_state: 'R'}, id=j1)
+
+    def test_many_dependents_on_one_job(self):
+        """
+        Submit many jobs depending on the same job, delete a few of them
+        and check that the rest are released when the job ends
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        job = Job()
+        job.set_sleep_time(5)
+        j1 = self.server.submit(job)
+        children = []
+        for _ in range(50):
+            job = Job(attrs={ATTR_depend: "afterok:" + j1})
+            children.append(self.server.submit(job))
+        for cjid in children[:5]:
+            self.server.delete(cjid)
+        self.server.expect(JOB, {ATTR_state: 'H'}, id=children[-1])
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'True'})
+        self.server.expect(JOB, {ATTR_state: 'R'}, id=j1)
+        for cjid in children[5:]:
+            self.server.expect(JOB, {ATTR_state: (NE, 'H')}, id=cjid)
+
+    def test_many_dependencies_named_twice(self):
+        """
+        Submit a job depending on many jobs, one of them named twice,
+        and check that it is released once all of them end
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        parents = []
+        for _ in range(20):
+            job = Job()
+            job.set_sleep_time(1)
+            parents.append(self.server.submit(job))
+        depend = "afterok:" + ":".join(parents + [parents[0]])
+        child = self.server.submit(Job(attrs={ATTR_depend: depend}))
+        self.server.expect(JOB, {ATTR_state: 'H'}, id=child)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'True'})
+        self.server.expect(JOB, {ATTR_state: (NE, 'H')}, id=child,
+                           max_attempts=60)
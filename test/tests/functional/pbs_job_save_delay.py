@@ -0,0 +1,110 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2020 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+
+from tests.functional import *
+
+
+class TestJobSaveDelay(TestFunctional):
+    """
+    Tests for the server's job_save_delay attribute, which batches the
+    database saves of jobs
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+
+    def test_deferred_saves_written_at_shutdown(self):
+        """
+        Test that job changes held back by job_save_delay are written
+        to the database when the server shuts down
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'job_save_delay': 300})
+        self.server.manager(MGR_CMD_SET, SERVER, {'log_events': 2047})
+
+        jids = []
+        for _ in range(5):
+            jids.append(self.server.submit(Job(TEST_USER)))
+        for jid in jids:
+            self.server.holdjob(jid, USER_HOLD)
+            self.server.expect(JOB, {'job_state': 'H'}, id=jid)
+
+        self.server.restart()
+        for jid in jids:
+            self.server.expect(JOB, {'job_state': 'H',
+                                     'Hold_Types': 'u'}, id=jid)
+        self.server.log_match("Saved 5 jobs in one transaction")
+
+    def test_deferred_saves_flushed_in_window(self):
+        """
+        Test that several changes to a job within the window become
+        one write, made once the window has passed
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'job_save_delay': 5})
+        self.server.manager(MGR_CMD_SET, SERVER, {'log_events': 2047})
+
+        jid = self.server.submit(Job(TEST_USER))
+        self.server.holdjob(jid, USER_HOLD)
+        self.server.alterjob(jid, {ATTR_N: 'renamed'})
+        self.server.expect(JOB, {'job_state': 'H',
+                                 ATTR_N: 'renamed'}, id=jid)
+        self.server.log_match("Saved 1 jobs in one transaction",
+                              max_attempts=10, interval=1)
+
+        # a hard kill now must not lose the change
+        self.server.stop('-KILL')
+        self.server.start()
+        self.server.expect(JOB, {'job_state': 'H',
+                                 ATTR_N: 'renamed'}, id=jid)
+
+    def test_unset_writes_pending_saves(self):
+        """
+        Test that unsetting job_save_delay writes out pending saves
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'job_save_delay': 300})
+        jid = self.server.submit(Job(TEST_USER))
+        self.server.holdjob(jid, USER_HOLD)
+        self.server.manager(MGR_CMD_UNSET, SERVER, 'job_save_delay')
+
+        self.server.stop('-KILL')
+        self.server.start()
+        self.server.expect(JOB, {'job_state': 'H'}, id=jid)
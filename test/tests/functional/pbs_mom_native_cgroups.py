@@ -0,0 +1,133 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2020 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+from tests.functional import *
+
+
+class TestMomNativeCgroups(TestFunctional):
+    """
+    Test MoM making the cgroup v2 of jobs itself ($native_cgroups)
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        ret = self.du.run_cmd(self.mom.shortname,
+                              ['stat', '-f', '-c', '%T', '/sys/fs/cgroup'])
+        if ret['rc'] != 0 or ret['out'] != ['cgroup2fs']:
+            self.skipTest('Test requires the cgroup v2 hierarchy alone '
+                          'mounted on /sys/fs/cgroup')
+        self.mom.add_config({'$native_cgroups': 'True',
+                             '$logevent': '0xffffffff'})
+        self.jobdir = '/sys/fs/cgroup/pbs_jobs.service/jobid/'
+
+    def set_cgroups_conf(self, body):
+        """
+        Install body as the pbs_cgroups.CF read by MoM
+        """
+        conf = os.path.join(self.mom.pbs_conf['PBS_HOME'], 'mom_priv',
+                            'hooks', 'pbs_cgroups.CF')
+        fn = self.du.create_temp_file(body=body)
+        self.du.run_copy(self.mom.shortname, src=fn, dest=conf, sudo=True)
+        self.addCleanup(self.du.rm, self.mom.shortname, conf, sudo=True,
+                        force=True)
+
+    def test_job_cgroup_limits(self):
+        """
+        Test that a job runs in a cgroup of its own limited to its ncpus
+        and mem, and that the cgroup is removed when the job is deleted
+        """
+        self.set_cgroups_conf('{"cgroup": {"cpuset": {"enabled": true}, '
+                              '"memory": {"enabled": true}}}')
+        a = {'Resource_List.select': '1:ncpus=1:mem=100mb'}
+        j = Job(TEST_USER, attrs=a)
+        j.set_sleep_time(1000)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.mom.log_match('%s;created cgroup' % jid)
+
+        cg = self.jobdir + jid
+        self.assertTrue(self.du.isdir(self.mom.shortname, cg))
+        ret = self.du.cat(self.mom.shortname, cg + '/memory.max', sudo=True)
+        self.assertEqual(ret['out'], [str(100 * 1024 * 1024)])
+        ret = self.du.cat(self.mom.shortname, cg + '/cpuset.cpus', sudo=True)
+        cpus = ret['out'][0] if ret['out'] else ''
+        self.assertTrue(cpus.isdigit(),
+                        'expected a single cpu, got "%s"' % cpus)
+        ret = self.du.cat(self.mom.shortname, cg + '/cgroup.procs', sudo=True)
+        self.assertNotEqual(ret['out'], [], 'no process in the job cgroup')
+
+        self.server.delete(jid, wait=True)
+        self.assertFalse(self.du.isdir(self.mom.shortname, cg))
+
+    def test_cgroup_prefix_from_conf(self):
+        """
+        Test that the cgroup_prefix of pbs_cgroups.CF names the directory
+        holding the job cgroups
+        """
+        self.set_cgroups_conf('{"cgroup_prefix": "ptl_jobs", "cgroup": {}}')
+
+        j = Job(TEST_USER)
+        j.set_sleep_time(1000)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.mom.log_match('prefix ptl_jobs')
+        cg = '/sys/fs/cgroup/ptl_jobs.service/jobid/' + jid
+        self.assertTrue(self.du.isdir(self.mom.shortname, cg))
+        self.server.delete(jid, wait=True)
+        self.assertFalse(self.du.isdir(self.mom.shortname, cg))
+
+    def test_controllers_off_by_default(self):
+        """
+        Test that, as with the cgroups hook, no limit is set when
+        pbs_cgroups.CF does not enable the controllers
+        """
+        self.set_cgroups_conf('{"cgroup": {"memory": {"default": "64MB"}}}')
+        a = {'Resource_List.select': '1:ncpus=1:mem=100mb'}
+        j = Job(TEST_USER, attrs=a)
+        j.set_sleep_time(1000)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.mom.log_match('cpuset off, memory off, memsw off')
+        self.mom.log_match('%s;created cgroup' % jid)
+        cg = self.jobdir + jid
+        ret = self.du.cat(self.mom.shortname, cg + '/memory.max', sudo=True)
+        self.assertTrue(ret['rc'] != 0 or ret['out'] == ['max'],
+                        'unexpected memory limit %s' % ret['out'])
+        self.server.delete(jid, wait=True)
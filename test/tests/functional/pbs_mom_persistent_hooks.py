@@ -0,0 +1,106 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2020 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+from tests.functional import *
+
+
+class TestMomPersistentHooks(TestFunctional):
+    """
+    Test MoM running hooks in a persistent pbs_python ($persistent_hooks)
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.mom.add_config({'$persistent_hooks': 'True',
+                             '$logevent': '0xffffffff'})
+
+    def test_hook_server_runs_events(self):
+        """
+        Test that execjob_begin hooks of several jobs run, see their own
+        job and that the hook server is started only once
+        """
+        start_time = time.time()
+        hook_body = """
+import pbs
+e = pbs.event()
+pbs.logmsg(pbs.LOG_DEBUG, "begin hook ran for %s" % e.job.id)
+e.accept()
+"""
+        a = {'event': 'execjob_begin', 'enabled': 'True'}
+        self.server.create_import_hook("persist", a, hook_body)
+
+        jids = []
+        for _ in range(3):
+            j = Job(TEST_USER)
+            j.set_sleep_time(1)
+            jids.append(self.server.submit(j))
+        for jid in jids:
+            self.mom.log_match("begin hook ran for %s" % jid,
+                               starttime=start_time)
+            self.server.expect(JOB, 'queue', op=UNSET, id=jid)
+        matches = self.mom.log_match("hook server ready", allmatch=True,
+                                     starttime=start_time)
+        self.assertEqual(len(matches), 1)
+
+    def test_hook_server_reject_and_alarm(self):
+        """
+        Test that a rejecting hook and a hook that runs past its alarm
+        behave as when pbs_python is started for them
+        """
+        start_time = time.time()
+        hook_body = """
+import pbs
+import time
+e = pbs.event()
+if e.job.Resource_List['walltime'] == pbs.duration(10):
+    time.sleep(60)
+e.reject("rejected by persist")
+"""
+        a = {'event': 'execjob_begin', 'enabled': 'True', 'alarm': 5}
+        self.server.create_import_hook("persist", a, hook_body)
+
+        j = Job(TEST_USER)
+        jid = self.server.submit(j)
+        self.mom.log_match("rejected by persist", starttime=start_time)
+
+        j = Job(TEST_USER, {'Resource_List.walltime': 10})
+        jid = self.server.submit(j)
+        self.mom.log_match("alarm call while running execjob_begin hook "
+                           "'persist'", starttime=start_time)
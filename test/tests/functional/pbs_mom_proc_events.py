@@ -0,0 +1,131 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2020 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+from tests.functional import *
+
+
+class TestMomProcEvents(TestFunctional):
+    """
+    Test MoM following job processes through proc connector events
+    ($proc_events) instead of scanning /proc
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'job_history_enable': 'True'})
+        c = {'$proc_events': 'True', '$logevent': '0xffffffff',
+             '$min_check_poll': '1', '$max_check_poll': '2'}
+        self.mom.add_config(c)
+
+    def test_cput_of_short_processes(self):
+        """
+        Test that a job made of many short lived processes is sampled
+        from the followed pids and gets its cpu time accounted
+        """
+        script = """
+i=0
+while [ $i -lt 300 ]; do
+    (n=0; while [ $n -lt 20000 ]; do n=$((n+1)); done) &
+    wait
+    i=$((i+1))
+done
+"""
+        j = Job(TEST_USER)
+        j.create_script(script)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.mom.log_match(
+            "following job processes through proc connector events")
+        self.mom.log_match("mom_get_sample;tracked:", max_attempts=30)
+        self.server.expect(JOB, {'job_state': 'F'}, id=jid, extend='x',
+                           offset=5, max_attempts=120)
+        self.server.expect(JOB, {'resources_used.cput': '00:00:00'},
+                           op=GT, id=jid, extend='x')
+
+    def test_delete_job_with_children(self):
+        """
+        Test that deleting a job kills the processes it forked, which
+        are found from the followed pids
+        """
+        script = """
+for i in 1 2 3; do
+    sleep 1000 &
+done
+wait
+"""
+        j = Job(TEST_USER)
+        j.create_script(script)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.mom.log_match("mom_get_sample;tracked:", max_attempts=30)
+        self.server.delete(jid)
+        self.server.expect(JOB, {'job_state': 'F'}, id=jid, extend='x')
+        ret = self.du.run_cmd(self.mom.hostname,
+                              ['pgrep', '-u', str(TEST_USER), '-x', 'sleep'])
+        self.assertNotEqual(ret['rc'], 0, "job processes left running")
+
+    def test_rm_query_sees_all_processes(self):
+        """
+        Test that the resource monitor queries about sessions still cover
+        processes which are not part of a job
+        """
+        self.du.run_cmd(self.mom.hostname,
+                        cmd=['setsid sleep 300 >/dev/null 2>&1 &'],
+                        runas=TEST_USER, as_script=True)
+        ret = self.du.run_cmd(self.mom.hostname,
+                              ['pgrep', '-u', str(TEST_USER), '-x', 'sleep'])
+        self.assertEqual(ret['rc'], 0)
+        sid = ret['out'][0].strip()
+        # a job so that MoM follows job processes only
+        j = Job(TEST_USER)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.mom.log_match("mom_get_sample;tracked:", max_attempts=30)
+        rmget = os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                             'unsupported', 'pbs_rmget')
+        ret = self.du.run_cmd(self.mom.hostname,
+                              [rmget, '-m', self.mom.hostname, 'sessions'],
+                              sudo=True)
+        self.du.run_cmd(self.mom.hostname, ['pkill', '-u', str(TEST_USER),
+                                            '-x', 'sleep'], sudo=True)
+        self.assertEqual(ret['rc'], 0)
+        self.assertTrue(re.search(r'\b%s\b' % sid, ' '.join(ret['out'])),
+                        "session %s missing from %s" % (sid, ret['out']))
@@ -137,6 +137,56 @@ class TestNodeBuckets(TestFunctional):
             self.assertTrue('yellow' in
                             n[0]['resources_available.color'])
 
+    @skipOnCpuSet
+    def test_scatter_group_bucket(self):
+        """
+        Test that a multi-chunk place=scatter:group job which does not ask
+        for excl uses the bucket code path and is placed in one group
+        """
+        a = {'Resource_List.select':
+             '4:ncpus=1:color=yellow+4:ncpus=2:color=blue',
+             'Resource_List.place': 'scatter:group=shape'}
+        J = Job(TEST_USER, a)
+        jid = self.server.submit(J)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.scheduler.log_match(jid + ';Chunk: ', n=10000)
+        self.scheduler.log_match(jid + ';Evaluating subchunk', n=10000,
+                                 existence=False, max_attempts=1)
+
+        js = self.server.status(JOB, id=jid)
+        nodes = J.get_vnodes(js[0]['exec_vnode'])
+        self.assertEqual(len(set(nodes)), 8)
+        shapes = set()
+        for node in nodes:
+            n = self.server.status(NODE, 'resources_available.shape',
+                                   id=node)
+            shapes.add(n[0]['resources_available.shape'])
+        self.assertEqual(len(shapes), 1)
+
+    @skipOnCpuSet
+    def test_scatter_bucket_shared_nodes(self):
+        """
+        Test that a non-excl scatter job which can't fit on the free nodes in
+        the buckets falls back to the standard code path and runs on nodes
+        which are partially in use
+        """
+        self.server.manager(MGR_CMD_SET, SCHED, {'log_events': 767})
+        # Run a job on all nodes leaving 1 cpus available on each node
+        j = Job(TEST_USER, {'Resource_List.select': '10010:ncpus=1',
+                            'Resource_List.place': 'scatter'})
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.server.manager(MGR_CMD_SET, SCHED, {'log_events': 2047})
+
+        a = {'Resource_List.select': '2:ncpus=1:color=yellow',
+             'Resource_List.place': 'scatter'}
+        j2 = Job(TEST_USER, a)
+        jid2 = self.server.submit(j2)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid2)
+        self.scheduler.log_match(jid2 + ';Not enough free nodes in node '
+                                 'buckets, using standard node search',
+                                 n=10000)
+
     @skipOnCpuSet
     def test_multi_bucket(self):
         """
@@ -400,7 +450,7 @@ class TestNodeBuckets(TestFunctional):
         self.scheduler.add_resource('color')
         self.server.manager(MGR_CMD_SET, SCHED, {'log_events': 2047})
 
-        # the bucket codepath requires excl
+        # the bucket codepath requires excl or scatter
         self.logger.info('Test different place specs')
         self.check_normal_path(pl='scatter:shared')
         self.check_normal_path(pl='free')
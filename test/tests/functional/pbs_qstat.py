@@ -155,3 +155,113 @@ class TestQstat(TestFunctional):
                             % re.escape(self.mom.shortname),
                             qstat_out), None, "The exec host does not"
                             " contain the task slot number")
+
+    def test_qstat_f_after_modify(self):
+        """
+        Test that repeated qstat -f of an unchanged job gives the same
+        output and that a modified attribute shows up right away, both for
+        a user and for the manager
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        j = Job(TEST_USER)
+        jid = self.server.submit(j)
+        qstat_cmd = os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                                 'bin', 'qstat')
+        for runas in [TEST_USER, ROOT_USER]:
+            outs = []
+            for _ in range(2):
+                ret = self.du.run_cmd(self.server.hostname,
+                                      cmd=[qstat_cmd, '-f', jid],
+                                      runas=runas)
+                self.assertEqual(ret['rc'], 0)
+                outs.append(ret['out'])
+            self.assertEqual(outs[0], outs[1])
+
+        name = 'cached_' + str(int(time.time()))
+        self.server.alterjob(jid, {ATTR_N: name})
+        for runas in [TEST_USER, ROOT_USER]:
+            ret = self.du.run_cmd(self.server.hostname,
+                                  cmd=[qstat_cmd, '-f', jid], runas=runas)
+            self.assertEqual(ret['rc'], 0)
+            self.assertIn('Job_Name = ' + name, '\n'.join(ret['out']))
+
+    def test_qstat_streamed_reply(self):
+        """
+        Test that a status reply streamed out in many parts reports every
+        job and subjob exactly once
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        self.server.manager(MGR_CMD_SET, SERVER, {'max_array_size': 5000})
+        j = Job(TEST_USER, attrs={ATTR_J: '1-3000'})
+        self.server.submit(j)
+        for _ in range(20):
+            self.server.submit(Job(TEST_USER))
+        qstat_cmd = os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                                 'bin', 'qstat')
+        ret = self.du.run_cmd(self.server.hostname,
+                              cmd=[qstat_cmd, '-t', '-f'])
+        self.assertEqual(ret['rc'], 0)
+        ids = [l.split(':', 1)[1].strip() for l in ret['out']
+               if l.startswith('Job Id:')]
+        self.assertEqual(len(ids), len(set(ids)))
+        self.assertEqual(len(ids), 1 + 3000 + 20)
+
+    def test_qstat_t_array_finished_subjobs(self):
+        """
+        Test that repeated qstat -t of an array with finished subjobs
+        reports the parent and every subjob with its own state, as the
+        status of a subjob fakes the state of the parent whose status
+        record the same reply is using
+        """
+        self.server.manager(MGR_CMD_SET, NODE,
+                            {'resources_available.ncpus': 1},
+                            id=self.mom.shortname)
+        j = Job(TEST_USER, attrs={ATTR_J: '1-4'})
+        j.set_sleep_time(5)
+        jid = self.server.submit(j)
+        sjid = j.create_subjob_id(jid, 2)
+        self.server.expect(JOB, {'job_state': 'R'}, id=sjid, offset=4)
+        qstat_cmd = os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                                 'bin', 'qstat')
+        for runas in [TEST_USER, ROOT_USER, TEST_USER]:
+            ret = self.du.run_cmd(self.server.hostname,
+                                  cmd=[qstat_cmd, '-t', '-f', jid],
+                                  runas=runas)
+            self.assertEqual(ret['rc'], 0)
+            out = '\n'.join(ret['out'])
+            ids = re.findall(r'^Job Id: (\S+)', out, re.M)
+            self.assertEqual(len(ids), 5)
+            states = re.findall(r'job_state = (\S+)', out)
+            self.assertEqual(states[0], 'B')
+            self.assertEqual(states[1], 'X')
+        self.server.expect(JOB, {'job_state': 'B'}, id=jid)
+        self.server.expect(JOB, {'job_state': 'X'}, id=sjid,
+                           offset=5, max_attempts=30)
+
+    def test_qstat_x_history_job(self):
+        """
+        Test that a finished job keeps giving the same full status, before
+        and after a server restart
+        """
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'job_history_enable': 'True'})
+        j = Job(TEST_USER)
+        j.set_sleep_time(1)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'F'}, id=jid, extend='x')
+        qstat_cmd = os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                                 'bin', 'qstat')
+        outs = []
+        for _ in range(2):
+            ret = self.du.run_cmd(self.server.hostname,
+                                  cmd=[qstat_cmd, '-xf', jid])
+            self.assertEqual(ret['rc'], 0)
+            outs.append(ret['out'])
+        self.assertEqual(outs[0], outs[1])
+        out = '\n'.join(outs[0])
+        self.assertIn('exec_host = ', out)
+        self.assertIn('resources_used.walltime = ', out)
+
+        self.server.restart()
+        self.server.expect(JOB, {'job_state': 'F', 'exec_host': (MATCH_RE,
+                           '.+')}, id=jid, extend='x')
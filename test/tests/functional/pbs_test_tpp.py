@@ -1090,11 +1090,68 @@ class TestTPP(TestFunctional):
         self.comm4.start()
         self.server.expect(JOB, 'queue', id=jid, op=UNSET, offset=30)
 
+    @requirements(num_moms=4, no_mom_on_server=True, num_comms=5)
+    def test_comm_mcast_fanout(self):
+        """
+        Test that with PBS_COMM_MCAST_FANOUT set, a pbs_comm sends a
+        multicast to no more than that many pbs_comms, which relay it on.
+        The pbs_comms are only connected to the hub, so a relay cannot
+        reach the moms of the pbs_comms folded into its packet and returns
+        them to the hub, which sends them on directly.
+        Configuration:
+        Node 1 : Server, Sched, Comm (self.hostA)
+        Node 2 : Mom (self.hostB)
+        Node 3 : Comm (self.hostF)
+        Node 4 : Mom (self.hostC)
+        Node 5 : Comm (self.hostG)
+        Node 6 : Mom (self.hostD)
+        Node 7 : Comm (self.hostH)
+        Node 8 : Mom (self.hostE)
+        Node 9 : Comm (self.hostI)
+        """
+        self.common_setup(no_mom_on_comm=True, req_moms=4, req_comms=5)
+        a = {'PBS_COMM_ROUTERS': self.hostA, 'PBS_COMM_LOG_EVENTS': 511}
+        comm_hosts = [self.hostF, self.hostG, self.hostH, self.hostI]
+        for host in comm_hosts:
+            self.set_pbs_conf(host_name=host, conf_param=a)
+        mom_hosts = [self.hostB, self.hostC, self.hostD, self.hostE]
+        for mom, comm in zip(mom_hosts, comm_hosts):
+            b = {'PBS_LEAF_ROUTERS': comm}
+            self.set_pbs_conf(host_name=mom, conf_param=b)
+        a = {'PBS_COMM_MCAST_FANOUT': 2, 'PBS_COMM_LOG_EVENTS': 511}
+        self.set_pbs_conf(host_name=self.hostA, conf_param=a)
+        for mom in mom_hosts:
+            self.server.expect(NODE, {'state': 'free'}, id=mom)
+
+        # the server multicasts hooks to all four moms
+        attrs = {'event': 'execjob_begin', 'enabled': 'True'}
+        self.server.create_hook("begin_fanout", attrs)
+        self.server.import_hook("begin_fanout", body="import pbs")
+        self.comm.log_match("Total target comms=2", n='ALL')
+        self.comm.log_match("num_streams=2, num_comms=2", n='ALL')
+        relays = 0
+        for comm in list(self.comms.values())[1:]:
+            try:
+                comm.log_match("Returning MCAST packet to .*, num_streams=1",
+                               regexp=True, n='ALL', max_attempts=5)
+                relays += 1
+            except PtlLogMatchError:
+                pass
+        self.assertEqual(relays, 2)
+        self.comm.log_match("num_streams=1, num_comms=1", n='ALL')
+        self.comm.log_match("Dest not found", existence=False, n='ALL',
+                            max_attempts=5)
+        for mom in self.moms.values():
+            mom.log_match("begin_fanout.HK;copy hook-related file "
+                          "request received", n='ALL')
+        self.server.manager(MGR_CMD_DELETE, HOOK, id="begin_fanout")
+
     def tearDown(self):
         os.environ['PBS_CONF_FILE'] = self.pbs_conf_path
         self.logger.info("Successfully exported PBS_CONF_FILE variable")
         conf_param = ['PBS_LEAF_ROUTERS', 'PBS_COMM_ROUTERS',
-                      'PBS_COMM_THREADS', 'PBS_COMM_LOG_EVENTS']
+                      'PBS_COMM_THREADS', 'PBS_COMM_LOG_EVENTS',
+                      'PBS_COMM_MCAST_FANOUT']
         for host in self.node_list:
             self.unset_pbs_conf(host, conf_param)
         self.node_list.clear()
@@ -0,0 +1,116 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2020 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+from tests.performance import *
+
+
+class TestHistoryJobMemory(TestPerformance):
+    """
+    Memory held by the server for history jobs, whose attribute values are
+    packed once the job finishes
+    """
+
+    njobs = 2000
+
+    def setUp(self):
+        TestPerformance.setUp(self)
+        a = {'job_history_enable': 'True',
+             'job_history_duration': '10:00:00'}
+        self.server.manager(MGR_CMD_SET, SERVER, a)
+
+    def server_rss(self):
+        """
+        Resident set size of the server in kB
+        """
+        ret = self.du.run_cmd(self.server.hostname,
+                              cmd=['ps', '-o', 'rss=', '-p',
+                                   str(self.server.get_pid())])
+        self.assertEqual(ret['rc'], 0)
+        return int(ret['out'][0].strip())
+
+    def submit_held(self):
+        """
+        Submit njobs held jobs carrying a large variable list
+        """
+        var = ','.join(['PERF_VAR_%d=%s' % (i, 'x' * 200)
+                        for i in range(20)])
+        jids = []
+        for _ in range(self.njobs):
+            j = Job(TEST_USER, attrs={ATTR_h: None, ATTR_v: var})
+            jids.append(self.server.submit(j))
+        self.server.expect(SERVER, {'total_jobs': len(jids)}, op=GE)
+        return jids
+
+    @timeout(3600)
+    def test_history_job_memory(self):
+        """
+        Submit held jobs, turn them into history jobs, status each of them
+        by id and submit the same number again.  The values freed by packing the history jobs are
+        reused by the second batch, so the server grows by much less for
+        it than for the first.
+        """
+        rss0 = self.server_rss()
+        jids = self.submit_held()
+        rss1 = self.server_rss()
+        self.server.delete(jids)
+        self.server.expect(JOB, {'job_state': 'F'}, id=jids[-1],
+                           extend='x', max_attempts=120)
+        # let the history clean pass pack what was saved after finishing
+        time.sleep(130)
+        # looking the jobs up by id must leave them packed
+        for jid in jids:
+            self.server.status(JOB, 'Variable_List', id=jid, extend='x')
+        rss2 = self.server_rss()
+        self.submit_held()
+        rss3 = self.server_rss()
+
+        live = rss1 - rss0
+        after = rss3 - rss2
+        self.logger.info('server grew by %d kB for %d live jobs, by %d kB '
+                         'for as many more next to them as history jobs',
+                         live, self.njobs, after)
+        self.perf_test_result(live, "rss_growth_live_jobs", "kB")
+        self.perf_test_result(after, "rss_growth_after_history_jobs", "kB")
+        self.assertLess(after, live / 2)
+
+        # the packed values are still all there
+        st = self.server.status(JOB, 'Variable_List', id=jids[0],
+                                extend='x')
+        self.assertIn('PERF_VAR_19=' + 'x' * 200, st[0]['Variable_List'])
@@ -642,3 +642,44 @@ class TestJobPerf(TestPerformance):
             j = j + 1
             avg_qdel_time.extend(qdel_time)
         self.perf_test_result(avg_qdel_time, "job_deletion_history", 'secs')
+
+    @timeout(7200)
+    def test_server_job_recovery_rate(self):
+        """
+        Measure how fast the server recovers jobs from the database
+        when it starts up
+        Test Params:  'No_of_jobs_per_user': 5000,
+                      'No_of_users': 10,
+                      'No_of_tries': 3
+        """
+        testconfig = {'No_of_jobs_per_user': 5000,
+                      'No_of_users': 10,
+                      'No_of_tries': 3}
+        config = self.set_test_config(testconfig)
+        users = [TEST_USER1, TEST_USER2, TEST_USER3, TEST_USER4,
+                 TEST_USER5, TEST_USER6, TEST_USER7, TEST_USER,
+                 TST_USR, TST_USR1]
+        a = {'scheduling': 'False'}
+        self.server.manager(MGR_CMD_SET, SERVER, a)
+        os.chdir('/tmp')
+        thrds = []
+        for u in range(0, config['No_of_users']):
+            t = multiprocessing.Process(target=self.submit_jobs, args=(
+                                        users[u],
+                                        config['No_of_jobs_per_user']))
+            t.start()
+            thrds.append(t)
+        for t in thrds:
+            t.join()
+        total = config['No_of_jobs_per_user'] * config['No_of_users']
+
+        rates = []
+        for _ in range(config['No_of_tries']):
+            start = time.time()
+            self.server.restart()
+            msg = "Recovered %d jobs in .* seconds, .* jobs/sec" % total
+            line = self.server.log_match(msg, regexp=True,
+                                         starttime=int(start))[1]
+            rate = line.split(', ')[-1].split()[0]
+            rates.append(float(rate))
+        self.perf_test_result(rates, "job_recovery_rate", "jobs/sec")
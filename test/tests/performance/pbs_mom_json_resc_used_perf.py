@@ -0,0 +1,97 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2020 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+from tests.performance import *
+
+
+class TestMomJsonRescUsedPerf(TestPerformance):
+    """
+    Performance test of MoM sending JSON valued resources_used of its jobs,
+    which MoM parses and writes back on every update of every job
+    """
+
+    hook_body = """
+import pbs
+e = pbs.event()
+for jid, j in e.job_list.items():
+    j.resources_used["foo_json"] = \\
+        '{"gpu_util": 12.5, "energy": 4200, "state": "ok", "peak": [1, 2]}'
+"""
+
+    @timeout(7200)
+    def test_json_resc_used_5k_jobs(self):
+        """
+        Time the resources_used updates of 5k running jobs on a MoM, each
+        with a JSON string resource set by an exechost_periodic hook, until
+        the server has the value for all of them
+        """
+        njobs = 5000
+        self.server.manager(MGR_CMD_CREATE, RSC,
+                            {'type': 'string', 'flag': 'h'}, id='foo_json')
+        self.server.manager(MGR_CMD_SET, NODE,
+                            {'resources_available.ncpus': njobs},
+                            id=self.mom.shortname)
+        self.server.manager(MGR_CMD_SET, SERVER, {'log_events': 2047})
+
+        a = {'Resource_List.select': '1:ncpus=1'}
+        j = Job(TEST_USER, attrs=a)
+        j.set_sleep_time(7200)
+        j.set_attributes({ATTR_J: '1-%d' % njobs})
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state=R': njobs}, count=True,
+                           extend='t', interval=10, max_attempts=360)
+
+        a = {'event': 'exechost_periodic', 'enabled': 'True', 'freq': 30}
+        start = time.time()
+        self.server.create_import_hook('json_used', a, self.hook_body)
+        for _ in range(360):
+            st = self.server.status(JOB, 'resources_used.foo_json', id=jid,
+                                    extend='t')
+            n = len([s for s in st if 'resources_used.foo_json' in s])
+            if n >= njobs:
+                break
+            time.sleep(5)
+        done = time.time()
+        self.assertEqual(n, njobs)
+        t = done - start
+        self.logger.info('#' * 80)
+        self.logger.info("Time for the resources_used of %d jobs: %s"
+                         % (njobs, str(t)))
+        self.logger.info('#' * 80)
+        self.perf_test_result(t, "json_resources_used_5k_jobs", "sec")
@@ -152,3 +152,24 @@ class TestQstatPerformance(TestPerformance):
         Submit 1000 job and compute performace of qstat
         """
         self.submit_and_stat_jobs(1000)
+
+    @timeout(3600)
+    def test_stat_in_child(self):
+        """
+        With enough jobs in the server a full qstat -f is served by a
+        forked child and job submission goes on while it runs
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'log_events': 2047})
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        self.submit_jobs(TEST_USER1, 5000)
+        qstat = os.path.join(self.server.client_conf['PBS_EXEC'],
+                             'bin', 'qstat')
+        start = time.time()
+        self.du.run_cmd(self.server.hostname, [qstat, '-f'], logerr=False)
+        elapsed = time.time() - start
+        self.server.log_match("handed to child", starttime=int(start))
+        self.perf_test_result(elapsed, "elapse_time qstat -f 5000 jobs",
+                              "sec")
+        job = Job(TEST_USER1)
+        jid = self.server.submit(job)
+        self.server.expect(JOB, {'job_state': 'Q'}, id=jid)
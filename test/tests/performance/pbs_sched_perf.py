@@ -127,7 +127,7 @@ class TestSchedPerf(TestPerformance):
         # Shared jobs use standard code path
         a = {'Resource_List.select':
              '1429:ncpus=1:color=blue+1429:ncpus=1:color=yellow',
-             "Resource_List.place": place}
+             "Resource_List.place": place + ':shared'}
         jids = self.submit_jobs(a, num_jobs)
 
         cycle1_time = self.run_cycle()
@@ -148,8 +148,8 @@ class TestSchedPerf(TestPerformance):
     def test_node_bucket_perf_scatter(self):
         """
         Submit a large number of jobs which use node buckets.  Run a cycle and
-        compare that to a cycle that doesn't use node buckets.  Jobs require
-        place=excl to use node buckets.
+        compare that to a cycle that doesn't use node buckets.  Jobs
+        requesting place=shared do not use node buckets.
         This test uses place=scatter.  Scatter placement is quicker than free
         """
         self.common_setup1()
@@ -168,6 +168,59 @@ class TestSchedPerf(TestPerformance):
         num_jobs = 3000
         self.compare_normal_path_to_buckets('free', num_jobs)
 
+    def switch_attr_func(self, name, totalnodes, numnode, attribs):
+        """
+        Spread the nodes over 10 switches
+        """
+        a = {'resources_available.switch': 'sw%d' % (numnode % 10)}
+        return {**attribs, **a}
+
+    @timeout(10000)
+    def test_node_bucket_perf_scatter_group(self):
+        """
+        Submit a large number of multi-chunk place=scatter:group=switch jobs
+        on 10000 nodes.  Compare a cycle on the standard node search code
+        path (place=shared) to a cycle which uses node buckets.
+        """
+        self.server.manager(MGR_CMD_CREATE, RSC,
+                            {'type': 'string', 'flag': 'h'}, id='switch')
+        a = {'resources_available.ncpus': 2, 'resources_available.mem': '8gb'}
+        self.server.create_vnodes('vnode', a, 10000, self.mom,
+                                  sharednode=False,
+                                  attrfunc=self.switch_attr_func,
+                                  expect=False)
+        self.server.expect(NODE, {'state=free': (GE, 10000)})
+        self.scheduler.add_resource('switch')
+
+        # Fill up all but a few nodes on each switch so the jobs can't run
+        a = {'Resource_List.select': '9990:ncpus=2',
+             'Resource_List.place': 'scatter:excl',
+             'Resource_List.walltime': '1:00:00'}
+        J = Job(TEST_USER, attrs=a)
+        J.set_sleep_time(3600)
+        jid = self.server.submit(J)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+
+        num_jobs = 1000
+        a = {'Resource_List.select': '50:ncpus=1:mem=1gb+50:ncpus=2',
+             'Resource_List.place': 'scatter:shared:group=switch'}
+        jids = self.submit_jobs(a, num_jobs)
+        cycle1_time = self.run_cycle()
+
+        a = {'Resource_List.place': 'scatter:group=switch'}
+        for jid in jids:
+            self.server.alterjob(jid, a)
+        cycle2_time = self.run_cycle()
+
+        self.logger.info('#' * 80)
+        m = 'Node search for %d scatter:group=switch jobs on 10000 nodes: ' \
+            'standard path %.2fs, node buckets %.2fs' % \
+            (num_jobs, cycle1_time, cycle2_time)
+        self.logger.info(m)
+        self.logger.info('#' * 80)
+        self.perf_test_result(cycle2_time, m, "seconds")
+        self.assertGreater(cycle1_time, cycle2_time)
+
     @timeout(3600)
     def test_run_many_normal_jobs(self):
         """